@@ -0,0 +1,277 @@
+/*____________________________________________________________________
+|
+| File: anim_lod.cpp
+|
+| Description: Animation level of detail.  Objects near the camera are
+|   animated every frame, farther ones every 2nd or 4th frame, and ones
+|   outside the view are paused until they come back into view.
+|
+|   Objects updated at the same rate are given different phases, so
+|   that (for example) half the objects at rate 2 are updated on even
+|   frames and half on odd frames.  The scheduler keeps a count of the
+|   updates falling on each of ANIM_LOD_MAX_RATE consecutive frames and
+|   gives each object the phase with the fewest, so the cost per frame
+|   stays level instead of spiking every 4th frame.
+|
+|   Between updates an object can be drawn with a blend of two poses:
+|   at each update the next pose is sampled ahead, at the time of the
+|   object's following update, so blending from the previous pose to it
+|   tracks the motion without adding any delay.  Objects that can't
+|   blend poses just hold the last one.
+|
+|   Rates change at distances with some hysteresis, so an object near a
+|   boundary doesn't switch back and forth.
+|
+| Functions: Anim_Lod_Init
+|            Anim_Lod_Add
+|            Anim_Lod_Remove
+|            Anim_Lod_Begin_Frame
+|            Anim_Lod_Set_View
+|            Anim_Lod_Update
+|            Anim_Lod_Blend
+|             Change_Load
+|             Pick_Phase
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+/*___________________
+|
+| Include Files
+|__________________*/
+
+#include "anim_lod.h"
+
+/*___________________
+|
+| Constants
+|__________________*/
+
+#define HYSTERESIS  0.1f          // fraction of a distance an object must pass it by to change rate
+
+/*___________________
+|
+| Function Prototypes
+|__________________*/
+
+static void Change_Load (AnimLodScheduler *sched, int rate, int phase, int delta);
+static int  Pick_Phase (AnimLodScheduler *sched, int rate);
+
+/*____________________________________________________________________
+|
+| Function: Anim_Lod_Init
+|
+| Input: Called from ____
+| Output: Sets up a scheduler with no objects.
+|___________________________________________________________________*/
+
+void Anim_Lod_Init (AnimLodScheduler *sched, float full_distance, float half_distance)
+{
+  int i;
+
+  sched->frame = 0;
+  for (i=0; i<ANIM_LOD_MAX_RATE; i++)
+    sched->load[i] = 0;
+  sched->full_distance = full_distance;
+  sched->half_distance = half_distance;
+}
+
+/*____________________________________________________________________
+|
+| Function: Anim_Lod_Add
+|
+| Input: Called from ____
+| Output: Adds an object updated every frame, starting with a restart.
+|___________________________________________________________________*/
+
+void Anim_Lod_Add (AnimLodScheduler *sched, AnimLod *lod)
+{
+  lod->rate      = 1;
+  lod->phase     = 0;
+  lod->restart   = true;
+  lod->prev_time = 0;
+  lod->next_time = 0;
+  Change_Load (sched, lod->rate, lod->phase, 1);
+}
+
+/*____________________________________________________________________
+|
+| Function: Anim_Lod_Remove
+|
+| Input: Called from ____
+| Output: Removes an object's updates from the scheduler.
+|___________________________________________________________________*/
+
+void Anim_Lod_Remove (AnimLodScheduler *sched, AnimLod *lod)
+{
+  Change_Load (sched, lod->rate, lod->phase, -1);
+  lod->rate = 0;
+}
+
+/*____________________________________________________________________
+|
+| Function: Anim_Lod_Begin_Frame
+|
+| Input: Called from ____
+| Output: Moves on to the next frame.
+|___________________________________________________________________*/
+
+void Anim_Lod_Begin_Frame (AnimLodScheduler *sched)
+{
+  sched->frame++;
+}
+
+/*____________________________________________________________________
+|
+| Function: Anim_Lod_Set_View
+|
+| Input: Called from ____
+| Output: Sets an object's rate for its distance, giving it a new phase
+|   if the rate changes.  An object coming out of a pause (or changing
+|   rate, which makes its next pose's time wrong) is restarted.
+|___________________________________________________________________*/
+
+void Anim_Lod_Set_View (AnimLodScheduler *sched, AnimLod *lod, float distance, bool visible)
+{
+  int rate;
+  float full, half;
+
+  if (! visible)
+    rate = 0;
+  else {
+    // Move the boundaries away from the object's current rate
+    full = sched->full_distance * ((lod->rate == 1) ? (1 + HYSTERESIS) : (1 - HYSTERESIS));
+    half = sched->half_distance * (((lod->rate == 1) || (lod->rate == 2)) ? (1 + HYSTERESIS) : (1 - HYSTERESIS));
+    if (distance < full)
+      rate = 1;
+    else if (distance < half)
+      rate = 2;
+    else
+      rate = ANIM_LOD_MAX_RATE;
+  }
+
+  if (rate != lod->rate) {
+    Change_Load (sched, lod->rate, lod->phase, -1);
+    lod->rate    = rate;
+    lod->phase   = Pick_Phase (sched, rate);
+    lod->restart = true;
+    Change_Load (sched, lod->rate, lod->phase, 1);
+  }
+}
+
+/*____________________________________________________________________
+|
+| Function: Anim_Lod_Update
+|
+| Input: Called from ____, after Anim_Lod_Begin_Frame()
+| Output: Returns what to sample this frame and sets the sample times.
+|   A restart is done on the frame it is needed, not in the object's
+|   phase.
+|___________________________________________________________________*/
+
+int Anim_Lod_Update (AnimLodScheduler *sched, AnimLod *lod, float time, float frame_time)
+{
+  int result, frames;
+
+  if (lod->rate == 0)
+    return (ANIM_LOD_HOLD);
+  if ((! lod->restart) && ((int)(sched->frame % lod->rate) != lod->phase))
+    return (ANIM_LOD_HOLD);
+
+  if (lod->restart) {
+    result = ANIM_LOD_RESTART;
+    lod->prev_time = time;
+    lod->restart = false;
+  }
+  else {
+    result = ANIM_LOD_SAMPLE;
+    lod->prev_time = lod->next_time;
+  }
+  // Sample the next pose at the time of the following update
+  if (lod->rate == 1)
+    lod->next_time = time;
+  else {
+    frames = (lod->phase - (int)(sched->frame % lod->rate) + lod->rate) % lod->rate;
+    if (frames == 0)
+      frames = lod->rate;
+    lod->next_time = time + frames * frame_time;
+  }
+
+  return (result);
+}
+
+/*____________________________________________________________________
+|
+| Function: Anim_Lod_Blend
+|
+| Input: Called from ____
+| Output: Returns 0 to draw the previous pose, 1 to draw the next pose,
+|   or a blend between them.
+|___________________________________________________________________*/
+
+float Anim_Lod_Blend (const AnimLod *lod, float time)
+{
+  float t;
+
+  if (lod->next_time <= lod->prev_time)
+    return (1);
+  t = (time - lod->prev_time) / (lod->next_time - lod->prev_time);
+  if (t < 0)
+    t = 0;
+  else if (t > 1)
+    t = 1;
+
+  return (t);
+}
+
+/*____________________________________________________________________
+|
+| Function: Change_Load
+|
+| Input: Called from Anim_Lod_Add(), Anim_Lod_Remove(),
+|   Anim_Lod_Set_View()
+| Output: Adds delta to the count of updates on each frame an object at
+|   this rate and phase is updated.
+|___________________________________________________________________*/
+
+static void Change_Load (AnimLodScheduler *sched, int rate, int phase, int delta)
+{
+  int i;
+
+  if (rate == 0)
+    return;
+  for (i=0; i<ANIM_LOD_MAX_RATE; i++)
+    if (i % rate == phase)
+      sched->load[i] += delta;
+}
+
+/*____________________________________________________________________
+|
+| Function: Pick_Phase
+|
+| Input: Called from Anim_Lod_Set_View()
+| Output: Returns the phase for an object at this rate that falls on
+|   the frames with the fewest updates.
+|___________________________________________________________________*/
+
+static int Pick_Phase (AnimLodScheduler *sched, int rate)
+{
+  int i, p, best, load, best_load;
+
+  if (rate <= 1)
+    return (0);
+
+  best = 0;
+  best_load = -1;
+  for (p=0; p<rate; p++) {
+    for (i=p, load=0; i<ANIM_LOD_MAX_RATE; i+=rate)
+      load += sched->load[i];
+    if ((best_load == -1) || (load < best_load)) {
+      best = p;
+      best_load = load;
+    }
+  }
+
+  return (best);
+}
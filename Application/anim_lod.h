@@ -0,0 +1,81 @@
+/*____________________________________________________________________
+|
+| File: anim_lod.h
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+#ifndef _ANIM_LOD_H_
+#define _ANIM_LOD_H_
+
+/*___________________
+|
+| Constants
+|__________________*/
+
+#define ANIM_LOD_MAX_RATE 4       // frames between updates of the farthest objects
+
+// Returned by Anim_Lod_Update()
+#define ANIM_LOD_HOLD     0       // keep the current poses
+#define ANIM_LOD_SAMPLE   1       // move the next pose to the previous pose, sample the next pose
+#define ANIM_LOD_RESTART  2       // sample both poses
+
+/*___________________
+|
+| Type definitions
+|__________________*/
+
+// Update rate of one animated object
+typedef struct {
+  int   rate;                     // frames between updates, 0 = paused
+  int   phase;                    // updated on frames where frame % rate == phase
+  bool  restart;                  // both poses must be sampled at the next update
+  float prev_time;                // sample times of the two poses (seconds)
+  float next_time;
+} AnimLod;
+
+// Spreads the updates of the objects at each rate evenly over frames
+typedef struct {
+  unsigned frame;
+  int      load [ANIM_LOD_MAX_RATE];      // updates on frames where frame % ANIM_LOD_MAX_RATE == i
+  float    full_distance;                 // nearer objects are updated every frame
+  float    half_distance;                 // nearer objects are updated every 2nd frame, others every 4th
+} AnimLodScheduler;
+
+/*___________________
+|
+| Functions
+|__________________*/
+
+// Sets up a scheduler with no objects
+void Anim_Lod_Init (AnimLodScheduler *sched, float full_distance, float half_distance);
+
+// Adds an object, updated every frame until Anim_Lod_Set_View() is called
+void Anim_Lod_Add (AnimLodScheduler *sched, AnimLod *lod);
+
+// Removes an object
+void Anim_Lod_Remove (AnimLodScheduler *sched, AnimLod *lod);
+
+// Starts a new frame
+void Anim_Lod_Begin_Frame (AnimLodScheduler *sched);
+
+// Picks an object's update rate from its distance to the camera (paused if not visible)
+void Anim_Lod_Set_View (
+  AnimLodScheduler *sched,
+  AnimLod          *lod,
+  float             distance,
+  bool              visible );
+
+// Returns ANIM_LOD_HOLD, _SAMPLE or _RESTART for an object this frame.  Poses to
+//   sample are for lod->prev_time (restart only) and lod->next_time.
+int Anim_Lod_Update (
+  AnimLodScheduler *sched,
+  AnimLod          *lod,
+  float             time,         // current time in seconds
+  float             frame_time ); // seconds per frame, to predict the next update
+
+// Returns how far (0-1) the current time is from the previous pose to the next one
+float Anim_Lod_Blend (const AnimLod *lod, float time);
+
+#endif
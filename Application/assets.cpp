@@ -0,0 +1,853 @@
+/*____________________________________________________________________
+|
+| File: assets.cpp
+|
+| Description: Reference counted asset manager.  Objects and textures
+|   are keyed by filename + load options.  Loading something that is
+|   already resident returns the same handle and bumps a reference
+|   count.  The asset is freed when the last reference is released.
+|
+|   Load options that don't change the result are dropped from the key,
+|   so an object loaded with gx3d_DONT_LOAD_TEXTURES shares its geometry
+|   regardless of texture-only flags like gx3d_DONT_GENERATE_MIPMAPS.
+|
+|   Particle systems are loaded here too so they can be reloaded, but
+|   aren't shared since each one holds its own particles.
+|
+|   With hot reload enabled, the files of loaded assets are watched.
+|   When one changes, the loader reads it in the background and the
+|   asset is reloaded when the job is finalized, which is at the start
+|   of a frame, so nothing is drawn with a freed handle.  The new handle
+|   is written everywhere an async load stored the old one.  Assets
+|   also handed out by a plain load (the caller's copy can't be updated)
+|   and skinned objects (a skeleton is bound to them) aren't reloaded.
+|
+|   Each object or texture load is traced with its resident size.
+|
+| Functions: Asset_Init
+|            Asset_Free
+|            Asset_Load_Object
+|            Asset_Release_Object
+|            Asset_Load_Texture
+|            Asset_Release_Texture
+|            Asset_Report
+|            Asset_Load_Object_Async
+|            Asset_Load_Texture_Async
+|            Asset_Load_Particle_System_Async
+|            Asset_Release_Particle_System
+|            Asset_Enable_Hot_Reload
+|            Asset_Update
+|             Load_Object
+|             Load_Texture
+|             Finalize_Object
+|             Finalize_Texture
+|             Finalize_Particle_System
+|             Finalize_Reload
+|             Add_Handle
+|             Find_Asset
+|             New_Asset
+|             Normalize_Filename
+|             Get_File_Size
+|             Get_Texture_Size
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+/*___________________
+|
+| Include Files
+|__________________*/
+
+#include <first_header.h>
+
+#include "dp.h"
+
+#include "loader.h"
+#include "file_watch.h"
+#include "trace.h"
+#include "assets.h"
+
+/*___________________
+|
+| Constants
+|__________________*/
+
+#define MAX_ASSETS  128
+#define MAX_HANDLES 4             // handle locations updated on reload, per asset
+
+#define ASSET_TYPE_OBJECT          1
+#define ASSET_TYPE_TEXTURE         2
+#define ASSET_TYPE_PARTICLE_SYSTEM 3
+
+// Object load flags that only matter when textures are loaded with the object
+#define OBJECT_TEXTURE_FLAGS (gx3d_DONT_GENERATE_MIPMAPS)
+
+// Milliseconds a changed file must be left alone before it's reloaded
+#define HOT_RELOAD_SETTLE_TIME 250
+
+/*___________________
+|
+| Type definitions
+|__________________*/
+
+typedef struct {
+  int         type;                     // ASSET_TYPE_... (0 = unused entry)
+  char        filename [_MAX_PATH];     // normalized
+  char        alpha_filename [_MAX_PATH];
+  unsigned    vertex_format;
+  unsigned    flags;
+  int         refs;
+  unsigned    resident_bytes;           // estimate
+  gx3dObject *object;
+  gx3dTexture texture;
+  gx3dParticleSystem psys;
+  void       *handles [MAX_HANDLES];    // where async loads stored the handle
+  int         num_handles;
+  bool        untracked;                // handle was also returned to a caller
+  bool        reloading;                // reload queued with the loader
+} Asset;
+
+// An object, texture or particle system waiting to be loaded by the loader
+typedef struct {
+  char        *filename;
+  char        *alpha_filename;
+  unsigned     vertex_format;
+  unsigned     flags;
+  gx3dObject **object;
+  gx3dTexture *texture;
+  gx3dParticleSystem *psys;
+} AssetRequest;
+
+/*___________________
+|
+| Function Prototypes
+|__________________*/
+
+static gx3dObject *Load_Object (char *filename, unsigned vertex_format, unsigned flags, gx3dObject **handle);
+static gx3dTexture Load_Texture (char *filename, char *alpha_filename, unsigned flags, gx3dTexture *handle);
+static void        Finalize_Object (void *data, LoaderFile *files, int num_files);
+static void        Finalize_Texture (void *data, LoaderFile *files, int num_files);
+static void        Finalize_Particle_System (void *data, LoaderFile *files, int num_files);
+static void        Finalize_Reload (void *data, LoaderFile *files, int num_files);
+static void        Add_Handle (Asset *asset, void *handle);
+static Asset      *Find_Asset (int type, char *filename, char *alpha_filename, unsigned vertex_format, unsigned flags);
+static Asset      *New_Asset (int type, char *filename, char *alpha_filename, unsigned vertex_format, unsigned flags);
+static void        Normalize_Filename (char *filename, char *normalized);
+static unsigned    Get_File_Size (char *filename);
+static unsigned    Get_Texture_Size (char *filename, unsigned flags);
+
+/*___________________
+|
+| Global variables
+|__________________*/
+
+static Asset        assets [MAX_ASSETS];
+static AssetRequest requests [MAX_ASSETS];
+static int          num_requests;
+static FileWatch   *watch;          // 0 unless hot reload is enabled
+
+/*____________________________________________________________________
+|
+| Function: Asset_Init
+|
+| Input: Called from Program_Run()
+| Output: Inits the asset manager.
+|___________________________________________________________________*/
+
+void Asset_Init ()
+{
+  memset (assets, 0, sizeof(assets));
+  num_requests = 0;
+  watch        = 0;
+}
+
+/*____________________________________________________________________
+|
+| Function: Asset_Free
+|
+| Input: Called from Program_Run()
+| Output: Frees all assets still loaded, regardless of reference count.
+|___________________________________________________________________*/
+
+void Asset_Free ()
+{
+  int i;
+
+  for (i=0; i<MAX_ASSETS; i++) {
+    if (assets[i].type == ASSET_TYPE_OBJECT)
+      gx3d_FreeObject (assets[i].object);
+    else if (assets[i].type == ASSET_TYPE_TEXTURE)
+      gx3d_FreeTexture (assets[i].texture);
+    else if (assets[i].type == ASSET_TYPE_PARTICLE_SYSTEM)
+      gx3d_FreeParticleSystem (assets[i].psys);
+  }
+  memset (assets, 0, sizeof(assets));
+
+  FileWatch_Free (watch);
+  watch = 0;
+}
+
+/*____________________________________________________________________
+|
+| Function: Asset_Load_Object
+|
+| Input: Called from Program_Run()
+| Output: Returns a shared handle to an object, loading it if needed.
+|   Returns 0 on any error.
+|___________________________________________________________________*/
+
+gx3dObject *Asset_Load_Object (char *filename, unsigned vertex_format, unsigned flags)
+{
+  return (Load_Object (filename, vertex_format, flags, 0));
+}
+
+/*____________________________________________________________________
+|
+| Function: Asset_Release_Object
+|
+| Input: Called from Program_Run()
+| Output: Releases a reference to an object, freeing the object if it
+|   was the last one.
+|___________________________________________________________________*/
+
+void Asset_Release_Object (gx3dObject *object)
+{
+  int i;
+
+  if (object) {
+    for (i=0; i<MAX_ASSETS; i++)
+      if ((assets[i].type == ASSET_TYPE_OBJECT) AND (assets[i].object == object))
+        break;
+    if (i < MAX_ASSETS) {
+      if (--assets[i].refs == 0) {
+        gx3d_FreeObject (object);
+        memset (&assets[i], 0, sizeof(Asset));
+      }
+    }
+    // Not managed (see Asset_Load_Object) so just free it
+    else
+      gx3d_FreeObject (object);
+  }
+}
+
+/*____________________________________________________________________
+|
+| Function: Asset_Load_Texture
+|
+| Input: Called from Program_Run()
+| Output: Returns a shared handle to a texture, loading it if needed.
+|___________________________________________________________________*/
+
+gx3dTexture Asset_Load_Texture (char *filename, char *alpha_filename, unsigned flags)
+{
+  return (Load_Texture (filename, alpha_filename, flags, 0));
+}
+
+/*____________________________________________________________________
+|
+| Function: Asset_Release_Texture
+|
+| Input: Called from Program_Run()
+| Output: Releases a reference to a texture, freeing the texture if it
+|   was the last one.
+|___________________________________________________________________*/
+
+void Asset_Release_Texture (gx3dTexture texture)
+{
+  int i;
+
+  if (texture) {
+    for (i=0; i<MAX_ASSETS; i++)
+      if ((assets[i].type == ASSET_TYPE_TEXTURE) AND (assets[i].texture == texture))
+        break;
+    if (i < MAX_ASSETS) {
+      if (--assets[i].refs == 0) {
+        gx3d_FreeTexture (texture);
+        memset (&assets[i], 0, sizeof(Asset));
+      }
+    }
+    else
+      gx3d_FreeTexture (texture);
+  }
+}
+
+/*____________________________________________________________________
+|
+| Function: Asset_Report
+|
+| Input: Called from Program_Run()
+| Output: Writes all loaded assets to the debug file.  Object sizes are
+|   the size of the source file, texture sizes are computed from the
+|   image dimensions at 32 bits per texel (plus mipmaps).
+|___________________________________________________________________*/
+
+void Asset_Report ()
+{
+  int i, num_objects, num_textures;
+  unsigned object_bytes, texture_bytes;
+  char str[_MAX_PATH * 2 + 64];
+
+  num_objects = num_textures = 0;
+  object_bytes = texture_bytes = 0;
+
+  debug_WriteFile ("_______________ Assets ___________________");
+  for (i=0; i<MAX_ASSETS; i++) {
+    if (assets[i].type == ASSET_TYPE_OBJECT) {
+      sprintf (str, "object  %8u bytes  refs %d  %s", assets[i].resident_bytes, assets[i].refs, assets[i].filename);
+      num_objects++;
+      object_bytes += assets[i].resident_bytes;
+    }
+    else if (assets[i].type == ASSET_TYPE_TEXTURE) {
+      sprintf (str, "texture %8u bytes  refs %d  %s %s", assets[i].resident_bytes, assets[i].refs, assets[i].filename, assets[i].alpha_filename);
+      num_textures++;
+      texture_bytes += assets[i].resident_bytes;
+    }
+    else if (assets[i].type == ASSET_TYPE_PARTICLE_SYSTEM)
+      sprintf (str, "particle system    refs %d  %s", assets[i].refs, assets[i].filename);
+    else
+      continue;
+    debug_WriteFile (str);
+  }
+  sprintf (str, "%d objects, %u bytes", num_objects, object_bytes);
+  debug_WriteFile (str);
+  sprintf (str, "%d textures, %u bytes", num_textures, texture_bytes);
+  debug_WriteFile (str);
+  debug_WriteFile ("__________________________________________");
+}
+
+/*____________________________________________________________________
+|
+| Function: Asset_Load_Object_Async
+|
+| Input: Called from Program_Run()
+| Output: Queues an object to be loaded by the loader.  *object is set
+|   when the job is finalized.  Returns the loader job id, or -1 if the
+|   object was loaded immediately because the request couldn't be
+|   queued.
+|___________________________________________________________________*/
+
+int Asset_Load_Object_Async (char *filename, unsigned vertex_format, unsigned flags, gx3dObject **object)
+{
+  AssetRequest *request;
+  int job = -1;
+
+  *object = 0;
+  if (num_requests < MAX_ASSETS) {
+    request = &requests[num_requests];
+    memset (request, 0, sizeof(AssetRequest));
+    request->filename      = filename;
+    request->vertex_format = vertex_format;
+    request->flags         = flags;
+    request->object        = object;
+    job = Loader_Add (Finalize_Object, (void *)request, filename, 0);
+    if (job != -1)
+      num_requests++;
+  }
+  if (job == -1)
+    *object = Asset_Load_Object (filename, vertex_format, flags);
+
+  return (job);
+}
+
+/*____________________________________________________________________
+|
+| Function: Asset_Load_Texture_Async
+|
+| Input: Called from Program_Run()
+| Output: Queues a texture to be loaded by the loader.  *texture is set
+|   when the job is finalized.  Returns the loader job id, or -1 if the
+|   texture was loaded immediately because the request couldn't be
+|   queued.
+|___________________________________________________________________*/
+
+int Asset_Load_Texture_Async (char *filename, char *alpha_filename, unsigned flags, gx3dTexture *texture)
+{
+  AssetRequest *request;
+  int job = -1;
+
+  *texture = 0;
+  if (num_requests < MAX_ASSETS) {
+    request = &requests[num_requests];
+    memset (request, 0, sizeof(AssetRequest));
+    request->filename       = filename;
+    request->alpha_filename = alpha_filename;
+    request->flags          = flags;
+    request->texture        = texture;
+    job = Loader_Add (Finalize_Texture, (void *)request, filename, alpha_filename);
+    if (job != -1)
+      num_requests++;
+  }
+  if (job == -1)
+    *texture = Asset_Load_Texture (filename, alpha_filename, flags);
+
+  return (job);
+}
+
+/*____________________________________________________________________
+|
+| Function: Asset_Load_Particle_System_Async
+|
+| Input: Called from Program_Run()
+| Output: Queues a particle system script to be loaded by the loader.
+|   *psys is set when the job is finalized.  Returns the loader job id,
+|   or -1 if the particle system was created immediately because the
+|   request couldn't be queued.
+|___________________________________________________________________*/
+
+int Asset_Load_Particle_System_Async (char *filename, gx3dParticleSystem *psys)
+{
+  AssetRequest *request;
+  int job = -1;
+
+  *psys = 0;
+  if (num_requests < MAX_ASSETS) {
+    request = &requests[num_requests];
+    memset (request, 0, sizeof(AssetRequest));
+    request->filename = filename;
+    request->psys     = psys;
+    job = Loader_Add (Finalize_Particle_System, (void *)request, filename, 0);
+    if (job != -1)
+      num_requests++;
+  }
+  if (job == -1)
+    *psys = Script_ParticleSystem_Create (filename);
+
+  return (job);
+}
+
+/*____________________________________________________________________
+|
+| Function: Asset_Release_Particle_System
+|
+| Input: Called from Program_Run()
+| Output: Frees a particle system.
+|___________________________________________________________________*/
+
+void Asset_Release_Particle_System (gx3dParticleSystem psys)
+{
+  int i;
+
+  if (psys) {
+    for (i=0; i<MAX_ASSETS; i++)
+      if ((assets[i].type == ASSET_TYPE_PARTICLE_SYSTEM) AND (assets[i].psys == psys)) {
+        memset (&assets[i], 0, sizeof(Asset));
+        break;
+      }
+    gx3d_FreeParticleSystem (psys);
+  }
+}
+
+/*____________________________________________________________________
+|
+| Function: Asset_Enable_Hot_Reload
+|
+| Input: Called from Program_Run()
+| Output: Starts watching the files of all assets, and of any loaded
+|   later.
+|___________________________________________________________________*/
+
+void Asset_Enable_Hot_Reload ()
+{
+  int i;
+
+  if (watch == 0) {
+    watch = FileWatch_Create (HOT_RELOAD_SETTLE_TIME);
+    for (i=0; i<MAX_ASSETS; i++)
+      if (assets[i].type) {
+        FileWatch_Add (watch, assets[i].filename);
+        if (assets[i].alpha_filename[0])
+          FileWatch_Add (watch, assets[i].alpha_filename);
+      }
+  }
+}
+
+/*____________________________________________________________________
+|
+| Function: Asset_Update
+|
+| Input: Called from Program_Run()
+| Output: Queues a reload with the loader for each asset whose files
+|   changed.  Reloads are done by Loader_Update().
+|___________________________________________________________________*/
+
+void Asset_Update (unsigned time)
+{
+  int i;
+  const char *filename;
+  char str[_MAX_PATH + 64];
+
+  if (watch == 0)
+    return;
+
+  while ((filename = FileWatch_Next_Change (watch, time)) != 0) {
+    // Watched names are already normalized
+    for (i=0; i<MAX_ASSETS; i++) {
+      if ((assets[i].type == 0) OR assets[i].reloading OR
+          ((strcmp (assets[i].filename, filename) != 0) AND (strcmp (assets[i].alpha_filename, filename) != 0)))
+        continue;
+      if (assets[i].untracked OR (assets[i].num_handles == 0) OR
+          ((assets[i].type == ASSET_TYPE_OBJECT) AND (assets[i].vertex_format & gx3d_VERTEXFORMAT_WEIGHTS))) {
+        sprintf (str, "Asset_Update(): %s changed but can't be reloaded", assets[i].filename);
+        debug_WriteFile (str);
+      }
+      else if (Loader_Add (Finalize_Reload, (void *)&assets[i], assets[i].filename, assets[i].alpha_filename[0] ? assets[i].alpha_filename : 0) != -1)
+        assets[i].reloading = true;
+    }
+  }
+}
+
+/*____________________________________________________________________
+|
+| Function: Load_Object
+|
+| Input: Called from Asset_Load_Object(), Finalize_Object()
+| Output: Returns a shared handle to an object, loading it if needed.
+|   handle is where the caller stores it (so it can be updated on
+|   reload), or 0 if unknown.  Returns 0 on any error.
+|___________________________________________________________________*/
+
+static gx3dObject *Load_Object (char *filename, unsigned vertex_format, unsigned flags, gx3dObject **handle)
+{
+  Asset *asset;
+  gx3dObject *object = 0;
+  int event;
+
+  // Drop flags that have no effect on this load
+  if (flags & gx3d_DONT_LOAD_TEXTURES)
+    flags &= ~OBJECT_TEXTURE_FLAGS;
+
+  asset = Find_Asset (ASSET_TYPE_OBJECT, filename, 0, vertex_format, flags);
+  if (asset) {
+    asset->refs++;
+    object = asset->object;
+  }
+  else {
+    // Decoding and creating the vertex buffers happen in one toolkit call, so are timed together
+    event = Trace_Begin ("load", filename);
+    gx3d_ReadLWO2File (filename, &object, vertex_format, flags);
+    if (object) {
+      asset = New_Asset (ASSET_TYPE_OBJECT, filename, 0, vertex_format, flags);
+      if (asset) {
+        asset->object         = object;
+        asset->resident_bytes = Get_File_Size (filename);
+      }
+      else
+        DEBUG_WRITE ("Asset_Load_Object(): too many assets, object won't be shared")
+    }
+    Trace_End_Bytes (event, asset ? asset->resident_bytes : 0);
+  }
+  if (asset)
+    Add_Handle (asset, (void *)handle);
+
+  return (object);
+}
+
+/*____________________________________________________________________
+|
+| Function: Load_Texture
+|
+| Input: Called from Asset_Load_Texture(), Finalize_Texture()
+| Output: Returns a shared handle to a texture, loading it if needed.
+|   handle is where the caller stores it, or 0 if unknown.
+|___________________________________________________________________*/
+
+static gx3dTexture Load_Texture (char *filename, char *alpha_filename, unsigned flags, gx3dTexture *handle)
+{
+  Asset *asset;
+  gx3dTexture texture = 0;
+  int event;
+
+  asset = Find_Asset (ASSET_TYPE_TEXTURE, filename, alpha_filename, 0, flags);
+  if (asset) {
+    asset->refs++;
+    texture = asset->texture;
+  }
+  else {
+    // Likewise decoding and uploading the image
+    event = Trace_Begin ("load", filename);
+    texture = gx3d_InitTexture_File (filename, alpha_filename, flags);
+    if (texture) {
+      asset = New_Asset (ASSET_TYPE_TEXTURE, filename, alpha_filename, 0, flags);
+      if (asset) {
+        asset->texture        = texture;
+        asset->resident_bytes = Get_Texture_Size (filename, flags);
+      }
+      else
+        DEBUG_WRITE ("Asset_Load_Texture(): too many assets, texture won't be shared")
+    }
+    Trace_End_Bytes (event, asset ? asset->resident_bytes : 0);
+  }
+  if (asset)
+    Add_Handle (asset, (void *)handle);
+
+  return (texture);
+}
+
+/*____________________________________________________________________
+|
+| Function: Finalize_Object, Finalize_Texture
+|
+| Input: Called from Loader_Update()
+| Output: Loads a queued object or texture.  The loader thread has
+|   already read the files, so the toolkit reads them from the cache.
+|___________________________________________________________________*/
+
+static void Finalize_Object (void *data, LoaderFile *files, int num_files)
+{
+  AssetRequest *request = (AssetRequest *)data;
+
+  *(request->object) = Load_Object (request->filename, request->vertex_format, request->flags, request->object);
+}
+
+static void Finalize_Texture (void *data, LoaderFile *files, int num_files)
+{
+  AssetRequest *request = (AssetRequest *)data;
+
+  *(request->texture) = Load_Texture (request->filename, request->alpha_filename, request->flags, request->texture);
+}
+
+/*____________________________________________________________________
+|
+| Function: Finalize_Particle_System
+|
+| Input: Called from Loader_Update()
+| Output: Creates a queued particle system.
+|___________________________________________________________________*/
+
+static void Finalize_Particle_System (void *data, LoaderFile *files, int num_files)
+{
+  AssetRequest *request = (AssetRequest *)data;
+  Asset *asset;
+
+  *(request->psys) = Script_ParticleSystem_Create (request->filename);
+  if (*(request->psys)) {
+    asset = New_Asset (ASSET_TYPE_PARTICLE_SYSTEM, request->filename, 0, 0, 0);
+    if (asset) {
+      asset->psys = *(request->psys);
+      Add_Handle (asset, (void *)request->psys);
+    }
+  }
+}
+
+/*____________________________________________________________________
+|
+| Function: Finalize_Reload
+|
+| Input: Called from Loader_Update()
+| Output: Reloads an asset whose files changed.  If it loads, frees the
+|   old one and updates every stored handle, else keeps the old one (the
+|   file may be only partly written).
+|___________________________________________________________________*/
+
+static void Finalize_Reload (void *data, LoaderFile *files, int num_files)
+{
+  int i;
+  Asset *asset = (Asset *)data;
+  gx3dObject *object = 0;
+  gx3dTexture texture = 0;
+  gx3dParticleSystem psys = 0;
+  char str[_MAX_PATH + 64];
+
+  // Released while the files were read?
+  if (NOT asset->reloading)
+    return;
+  asset->reloading = false;
+
+  if (asset->type == ASSET_TYPE_OBJECT) {
+    gx3d_ReadLWO2File (asset->filename, &object, asset->vertex_format, asset->flags);
+    if (object) {
+      gx3d_FreeObject (asset->object);
+      asset->object         = object;
+      asset->resident_bytes = Get_File_Size (asset->filename);
+      for (i=0; i<asset->num_handles; i++)
+        *((gx3dObject **)asset->handles[i]) = object;
+    }
+  }
+  else if (asset->type == ASSET_TYPE_TEXTURE) {
+    texture = gx3d_InitTexture_File (asset->filename, asset->alpha_filename[0] ? asset->alpha_filename : 0, asset->flags);
+    if (texture) {
+      gx3d_FreeTexture (asset->texture);
+      asset->texture        = texture;
+      asset->resident_bytes = Get_Texture_Size (asset->filename, asset->flags);
+      for (i=0; i<asset->num_handles; i++)
+        *((gx3dTexture *)asset->handles[i]) = texture;
+    }
+  }
+  else if (asset->type == ASSET_TYPE_PARTICLE_SYSTEM) {
+    psys = Script_ParticleSystem_Create (asset->filename);
+    if (psys) {
+      gx3d_FreeParticleSystem (asset->psys);
+      asset->psys = psys;
+      for (i=0; i<asset->num_handles; i++)
+        *((gx3dParticleSystem *)asset->handles[i]) = psys;
+    }
+  }
+
+  if (object OR texture OR psys)
+    sprintf (str, "Reloaded %s", asset->filename);
+  else
+    sprintf (str, "Can't reload %s, keeping the old one", asset->filename);
+  debug_WriteFile (str);
+}
+
+/*____________________________________________________________________
+|
+| Function: Add_Handle
+|
+| Input: Called from Load_Object(), Load_Texture(),
+|   Finalize_Particle_System()
+| Output: Records where a handle to an asset is stored, so it can be
+|   updated on reload.  A 0 handle means the caller has a copy that
+|   can't be updated.
+|___________________________________________________________________*/
+
+static void Add_Handle (Asset *asset, void *handle)
+{
+  if ((handle == 0) OR (asset->num_handles == MAX_HANDLES))
+    asset->untracked = true;
+  else
+    asset->handles[asset->num_handles++] = handle;
+}
+
+/*____________________________________________________________________
+|
+| Function: Find_Asset
+|
+| Input: Called from Load_Object(), Load_Texture()
+| Output: Returns the asset matching the key or 0 if not loaded.
+|___________________________________________________________________*/
+
+static Asset *Find_Asset (int type, char *filename, char *alpha_filename, unsigned vertex_format, unsigned flags)
+{
+  int i;
+  char name [_MAX_PATH], alpha_name [_MAX_PATH];
+
+  Normalize_Filename (filename, name);
+  Normalize_Filename (alpha_filename, alpha_name);
+
+  for (i=0; i<MAX_ASSETS; i++)
+    if ((assets[i].type == type) AND
+        (assets[i].vertex_format == vertex_format) AND
+        (assets[i].flags == flags) AND
+        (strcmp (assets[i].filename, name) == 0) AND
+        (strcmp (assets[i].alpha_filename, alpha_name) == 0))
+      return (&assets[i]);
+
+  return (0);
+}
+
+/*____________________________________________________________________
+|
+| Function: New_Asset
+|
+| Input: Called from Load_Object(), Load_Texture(),
+|   Finalize_Particle_System()
+| Output: Returns a new asset entry with a reference count of 1, or 0
+|   if the table is full.
+|___________________________________________________________________*/
+
+static Asset *New_Asset (int type, char *filename, char *alpha_filename, unsigned vertex_format, unsigned flags)
+{
+  int i;
+  Asset *asset = 0;
+
+  for (i=0; i<MAX_ASSETS; i++)
+    if (assets[i].type == 0) {
+      asset = &assets[i];
+      asset->type          = type;
+      asset->vertex_format = vertex_format;
+      asset->flags         = flags;
+      asset->refs          = 1;
+      Normalize_Filename (filename, asset->filename);
+      Normalize_Filename (alpha_filename, asset->alpha_filename);
+      if (watch) {
+        FileWatch_Add (watch, asset->filename);
+        if (asset->alpha_filename[0])
+          FileWatch_Add (watch, asset->alpha_filename);
+      }
+      break;
+    }
+
+  return (asset);
+}
+
+/*____________________________________________________________________
+|
+| Function: Normalize_Filename
+|
+| Input: Called from Find_Asset(), New_Asset()
+| Output: Copies filename in lower case with backslash separators.  A 0
+|   filename returns an empty string.
+|___________________________________________________________________*/
+
+static void Normalize_Filename (char *filename, char *normalized)
+{
+  int i;
+
+  if (filename == 0)
+    filename = "";
+
+  for (i=0; filename[i] AND (i < _MAX_PATH-1); i++) {
+    if (filename[i] == '/')
+      normalized[i] = '\\';
+    else
+      normalized[i] = (char) tolower (filename[i]);
+  }
+  normalized[i] = 0;
+}
+
+/*____________________________________________________________________
+|
+| Function: Get_File_Size
+|
+| Input: Called from Load_Object(), Finalize_Reload()
+| Output: Returns size of a file in bytes, or 0 on any error.
+|___________________________________________________________________*/
+
+static unsigned Get_File_Size (char *filename)
+{
+  FILE *fp;
+  unsigned size = 0;
+
+  fp = fopen (filename, "rb");
+  if (fp) {
+    if (fseek (fp, 0, SEEK_END) == 0)
+      size = (unsigned) ftell (fp);
+    fclose (fp);
+  }
+
+  return (size);
+}
+
+/*____________________________________________________________________
+|
+| Function: Get_Texture_Size
+|
+| Input: Called from Load_Texture(), Finalize_Reload()
+| Output: Returns an estimate of the memory used by a texture made from
+|   a BMP file, or 0 on any error.
+|___________________________________________________________________*/
+
+static unsigned Get_Texture_Size (char *filename, unsigned flags)
+{
+  FILE *fp;
+  BITMAPFILEHEADER file_header;
+  BITMAPINFOHEADER info_header;
+  unsigned size = 0;
+
+  fp = fopen (filename, "rb");
+  if (fp) {
+    if ((fread (&file_header, sizeof(file_header), 1, fp) == 1) AND
+        (fread (&info_header, sizeof(info_header), 1, fp) == 1) AND
+        (file_header.bfType == 0x4D42)) {  // 'BM'
+      size = abs (info_header.biWidth) * abs (info_header.biHeight) * 4;
+      // Add a full mipmap chain
+      if (NOT (flags & gx3d_DONT_GENERATE_MIPMAPS))
+        size += size / 3;
+    }
+    fclose (fp);
+  }
+
+  return (size);
+}
@@ -0,0 +1,62 @@
+/*____________________________________________________________________
+|
+| File: assets.h
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+// Init the asset manager
+void Asset_Init ();
+
+// Frees any assets still loaded
+void Asset_Free ();
+
+// Loads an object or returns a shared handle to an already loaded one
+gx3dObject *Asset_Load_Object (
+  char    *filename,        // LWO2 file
+  unsigned vertex_format,   // gx3d_VERTEXFORMAT_...
+  unsigned flags );         // same flags as gx3d_ReadLWO2File()
+
+// Releases a handle returned by Asset_Load_Object()
+void Asset_Release_Object (gx3dObject *object);
+
+// Loads a texture or returns a shared handle to an already loaded one
+gx3dTexture Asset_Load_Texture (
+  char    *filename,
+  char    *alpha_filename,  // can be 0
+  unsigned flags );
+
+// Releases a handle returned by Asset_Load_Texture()
+void Asset_Release_Texture (gx3dTexture texture);
+
+// Queues an object to be loaded by the loader, *object is set when it's loaded
+int Asset_Load_Object_Async (
+  char        *filename,
+  unsigned     vertex_format,
+  unsigned     flags,
+  gx3dObject **object );
+
+// Queues a texture to be loaded by the loader, *texture is set when it's loaded
+int Asset_Load_Texture_Async (
+  char        *filename,
+  char        *alpha_filename,
+  unsigned     flags,
+  gx3dTexture *texture );
+
+// Writes reference counts and resident memory of all assets to the debug file
+void Asset_Report ();
+
+// Queues a particle system script to be loaded by the loader, *psys is set when it's loaded
+int Asset_Load_Particle_System_Async (
+  char               *filename,
+  gx3dParticleSystem *psys );
+
+// Frees a particle system loaded by Asset_Load_Particle_System_Async()
+void Asset_Release_Particle_System (gx3dParticleSystem psys);
+
+// Watches the files of loaded assets so changed ones are reloaded
+void Asset_Enable_Hot_Reload ();
+
+// Queues reloads of assets whose files changed (call once per frame, the loader does the reloads)
+void Asset_Update (unsigned time);
@@ -0,0 +1,301 @@
+/*____________________________________________________________________
+|
+| File: benchmark.cpp
+|
+| Description: Frame statistics for the benchmark mode (see main.cpp).
+|   Each frame's time is measured from Benchmark_Begin_Frame() to
+|   Benchmark_End_Frame(), along with counts of draw calls and render
+|   state changes made during it (see benchmark_count.h).  The report
+|   gives frame time percentiles rather than just an average, since
+|   hitches show up in the 95th and 99th percentiles long before they
+|   move the mean.  Percentiles are nearest rank.  Frames are timed
+|   with the performance counter, since Visual Studio 2013's
+|   steady_clock is the system clock, which ticks every 1 to 15.6 ms.
+|
+|   The report is a small JSON object, so runs of different builds can
+|   be compared by a script.
+|
+| Functions: Benchmark_Init
+|            Benchmark_Free
+|            Benchmark_Running
+|            Benchmark_Begin_Frame
+|            Benchmark_End_Frame
+|            Benchmark_Count
+|            Benchmark_Write_Report
+|             Write_Stats
+|             Percentile
+|             Compare_Floats
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+/*___________________
+|
+| Include Files
+|__________________*/
+
+#include <windows.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "benchmark.h"
+
+/*___________________
+|
+| Function Prototypes
+|__________________*/
+
+static void  Write_Stats (FILE *fp, const char *name, float *values, int n, bool percentiles, bool last);
+static float Percentile (const float *sorted, int n, float percent);
+static int   Compare_Floats (const void *a, const void *b);
+
+/*___________________
+|
+| Global variables
+|__________________*/
+
+static float   *frame_ms;                                 // frame times
+static float   *counts [BENCHMARK_NUM_COUNTERS];          // counters of each frame
+static unsigned counters [BENCHMARK_NUM_COUNTERS];        // of the current frame
+static int      num_frames, max_frames;
+static bool     running;
+static LONGLONG frame_start;                              // performance counter ticks
+static double   ticks_per_ms;
+
+static const char *Counter_Names [BENCHMARK_NUM_COUNTERS] = { "draw_calls", "state_changes" };
+
+/*____________________________________________________________________
+|
+| Function: Benchmark_Init
+|
+| Input: Called from Program_Run()
+| Output: Allocates room for the frames.  Returns false if out of
+|   memory.
+|___________________________________________________________________*/
+
+bool Benchmark_Init (int frames)
+{
+  int i;
+  bool ok;
+  LARGE_INTEGER frequency;
+
+  Benchmark_Free ();
+  if (frames < 1)
+    return (false);
+
+  frame_ms = (float *) malloc (frames * sizeof(float));
+  ok = (frame_ms != 0);
+  for (i=0; i<BENCHMARK_NUM_COUNTERS; i++) {
+    counts[i] = (float *) malloc (frames * sizeof(float));
+    ok = ok && (counts[i] != 0);
+  }
+  if (! ok) {
+    Benchmark_Free ();
+    return (false);
+  }
+
+  QueryPerformanceFrequency (&frequency);
+  ticks_per_ms = frequency.QuadPart / 1000.0;
+  max_frames   = frames;
+  num_frames   = 0;
+  running      = true;
+
+  return (true);
+}
+
+/*____________________________________________________________________
+|
+| Function: Benchmark_Free
+|
+| Input: Called from Program_Run(), Benchmark_Init()
+| Output: Frees the recorded frames.
+|___________________________________________________________________*/
+
+void Benchmark_Free ()
+{
+  int i;
+
+  free (frame_ms);
+  frame_ms = 0;
+  for (i=0; i<BENCHMARK_NUM_COUNTERS; i++) {
+    free (counts[i]);
+    counts[i] = 0;
+  }
+  num_frames = max_frames = 0;
+  running = false;
+}
+
+/*____________________________________________________________________
+|
+| Function: Benchmark_Running
+|
+| Input: Called from ____
+| Output: Returns true if frames are being recorded.
+|___________________________________________________________________*/
+
+bool Benchmark_Running ()
+{
+  return (running);
+}
+
+/*____________________________________________________________________
+|
+| Function: Benchmark_Begin_Frame
+|
+| Input: Called from Program_Run()
+| Output: Starts timing a frame.
+|___________________________________________________________________*/
+
+void Benchmark_Begin_Frame ()
+{
+  LARGE_INTEGER now;
+
+  memset (counters, 0, sizeof(counters));
+  QueryPerformanceCounter (&now);
+  frame_start = now.QuadPart;
+}
+
+/*____________________________________________________________________
+|
+| Function: Benchmark_End_Frame
+|
+| Input: Called from Program_Run()
+| Output: Records the frame.  Returns true if all frames are recorded.
+|___________________________________________________________________*/
+
+bool Benchmark_End_Frame ()
+{
+  int i;
+  LARGE_INTEGER now;
+
+  if (num_frames < max_frames) {
+    QueryPerformanceCounter (&now);
+    frame_ms[num_frames] = (float)((now.QuadPart - frame_start) / ticks_per_ms);
+    for (i=0; i<BENCHMARK_NUM_COUNTERS; i++)
+      counts[i][num_frames] = (float) counters[i];
+    num_frames++;
+  }
+
+  return (num_frames == max_frames);
+}
+
+/*____________________________________________________________________
+|
+| Function: Benchmark_Count
+|
+| Input: Called from the wrappers in benchmark_count.h
+| Output: Adds 1 to a counter.
+|___________________________________________________________________*/
+
+void Benchmark_Count (int counter)
+{
+  counters[counter]++;
+}
+
+/*____________________________________________________________________
+|
+| Function: Benchmark_Write_Report
+|
+| Input: Called from Program_Run()
+| Output: Writes the report.  Returns true on success.
+|___________________________________________________________________*/
+
+bool Benchmark_Write_Report (const char *filename, const char *path_filename, int screen_width, int screen_height)
+{
+  int i;
+  bool ok;
+  FILE *fp;
+
+  if (num_frames == 0)
+    return (false);
+  fp = fopen (filename, "w");
+  if (fp == 0)
+    return (false);
+
+  fprintf (fp, "{\n");
+  fprintf (fp, "  \"path\": \"");
+  // Escape the backslashes of a Windows path
+  for (i=0; path_filename[i]; i++) {
+    if ((path_filename[i] == '\\') || (path_filename[i] == '"'))
+      fputc ('\\', fp);
+    fputc (path_filename[i], fp);
+  }
+  fprintf (fp, "\",\n");
+  fprintf (fp, "  \"screen\": [%d, %d],\n", screen_width, screen_height);
+#ifdef _DEBUG
+  fprintf (fp, "  \"build\": \"debug %s %s\",\n", __DATE__, __TIME__);
+#else
+  fprintf (fp, "  \"build\": \"release %s %s\",\n", __DATE__, __TIME__);
+#endif
+  fprintf (fp, "  \"frames\": %d,\n", num_frames);
+  Write_Stats (fp, "frame_ms", frame_ms, num_frames, true, false);
+  for (i=0; i<BENCHMARK_NUM_COUNTERS; i++)
+    Write_Stats (fp, Counter_Names[i], counts[i], num_frames, false, i == BENCHMARK_NUM_COUNTERS-1);
+  fprintf (fp, "}\n");
+
+  ok = (ferror (fp) == 0);
+  if (fclose (fp) != 0)
+    ok = false;
+
+  return (ok);
+}
+
+/*____________________________________________________________________
+|
+| Function: Write_Stats
+|
+| Input: Called from Benchmark_Write_Report()
+| Output: Writes the statistics of one value per frame (sorting the
+|   values).
+|___________________________________________________________________*/
+
+static void Write_Stats (FILE *fp, const char *name, float *values, int n, bool percentiles, bool last)
+{
+  int i;
+  double sum = 0;
+
+  for (i=0; i<n; i++)
+    sum += values[i];
+  qsort (values, n, sizeof(float), Compare_Floats);
+
+  fprintf (fp, "  \"%s\": { \"mean\": %.3f, \"min\": %.3f, ", name, sum / n, values[0]);
+  if (percentiles)
+    fprintf (fp, "\"p50\": %.3f, \"p95\": %.3f, \"p99\": %.3f, ",
+             Percentile (values, n, 50), Percentile (values, n, 95), Percentile (values, n, 99));
+  fprintf (fp, "\"max\": %.3f }%s\n", values[n-1], last ? "" : ",");
+}
+
+/*____________________________________________________________________
+|
+| Function: Percentile
+|
+| Input: Called from Write_Stats()
+| Output: Returns the nearest rank percentile of sorted values.
+|___________________________________________________________________*/
+
+static float Percentile (const float *sorted, int n, float percent)
+{
+  int rank = (int) ceil (percent / 100 * n);
+
+  if (rank < 1)
+    rank = 1;
+  return (sorted[rank-1]);
+}
+
+/*____________________________________________________________________
+|
+| Function: Compare_Floats
+|
+| Input: Called from qsort()
+| Output: Orders floats from lowest to highest.
+|___________________________________________________________________*/
+
+static int Compare_Floats (const void *a, const void *b)
+{
+  float fa = *(const float *)a, fb = *(const float *)b;
+
+  return ((fa > fb) - (fa < fb));
+}
@@ -0,0 +1,53 @@
+/*____________________________________________________________________
+|
+| File: benchmark.h
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+#ifndef _BENCHMARK_H_
+#define _BENCHMARK_H_
+
+/*___________________
+|
+| Constants
+|__________________*/
+
+// Counters (see benchmark_count.h)
+#define BENCHMARK_DRAW_CALLS     0
+#define BENCHMARK_STATE_CHANGES  1
+#define BENCHMARK_NUM_COUNTERS   2
+
+/*___________________
+|
+| Functions
+|__________________*/
+
+// Starts recording a number of frames, returns false if out of memory
+bool Benchmark_Init (int num_frames);
+
+// Frees any resources
+void Benchmark_Free ();
+
+// Returns true between Benchmark_Init() and Benchmark_Free()
+bool Benchmark_Running ();
+
+// Starts timing a frame and zeros the counters
+void Benchmark_Begin_Frame ();
+
+// Ends a frame, returns true once all frames are recorded
+bool Benchmark_End_Frame ();
+
+// Adds 1 to a counter for the current frame
+void Benchmark_Count (int counter);
+
+// Writes frame time percentiles and counter statistics of the recorded frames as
+//   JSON, returns true on success
+bool Benchmark_Write_Report (
+  const char *filename,
+  const char *path_filename,      // camera path played back
+  int         screen_width,
+  int         screen_height );
+
+#endif
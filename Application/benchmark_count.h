@@ -0,0 +1,38 @@
+/*____________________________________________________________________
+|
+| File: benchmark_count.h
+|
+| Description: Counts draw calls and render state changes for the
+|   benchmark report by wrapping the GX calls that make them.  Include
+|   this after all other headers in each module that draws.  A macro
+|   isn't expanded again inside its own expansion, so each wrapper
+|   calls the real function.
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+#include "benchmark.h"
+
+// Draw calls
+#define gx3d_DrawObject(...)            (Benchmark_Count (BENCHMARK_DRAW_CALLS), gx3d_DrawObject (__VA_ARGS__))
+#define gx3d_DrawObjectLayer(...)       (Benchmark_Count (BENCHMARK_DRAW_CALLS), gx3d_DrawObjectLayer (__VA_ARGS__))
+#define gx3d_DrawParticleSystem(...)    (Benchmark_Count (BENCHMARK_DRAW_CALLS), gx3d_DrawParticleSystem (__VA_ARGS__))
+
+// Render state changes
+#define gx3d_SetTexture(...)            (Benchmark_Count (BENCHMARK_STATE_CHANGES), gx3d_SetTexture (__VA_ARGS__))
+#define gx3d_SetMaterial(...)           (Benchmark_Count (BENCHMARK_STATE_CHANGES), gx3d_SetMaterial (__VA_ARGS__))
+#define gx3d_SetAmbientLight(...)       (Benchmark_Count (BENCHMARK_STATE_CHANGES), gx3d_SetAmbientLight (__VA_ARGS__))
+#define gx3d_EnableLight(...)           (Benchmark_Count (BENCHMARK_STATE_CHANGES), gx3d_EnableLight (__VA_ARGS__))
+#define gx3d_DisableLight(...)          (Benchmark_Count (BENCHMARK_STATE_CHANGES), gx3d_DisableLight (__VA_ARGS__))
+#define gx3d_EnableAlphaBlending(...)   (Benchmark_Count (BENCHMARK_STATE_CHANGES), gx3d_EnableAlphaBlending (__VA_ARGS__))
+#define gx3d_DisableAlphaBlending(...)  (Benchmark_Count (BENCHMARK_STATE_CHANGES), gx3d_DisableAlphaBlending (__VA_ARGS__))
+#define gx3d_EnableAlphaTesting(...)    (Benchmark_Count (BENCHMARK_STATE_CHANGES), gx3d_EnableAlphaTesting (__VA_ARGS__))
+#define gx3d_DisableAlphaTesting(...)   (Benchmark_Count (BENCHMARK_STATE_CHANGES), gx3d_DisableAlphaTesting (__VA_ARGS__))
+#define gx3d_EnableZBuffer(...)         (Benchmark_Count (BENCHMARK_STATE_CHANGES), gx3d_EnableZBuffer (__VA_ARGS__))
+#define gx3d_DisableZBuffer(...)        (Benchmark_Count (BENCHMARK_STATE_CHANGES), gx3d_DisableZBuffer (__VA_ARGS__))
+#define gx3d_EnableTextureMatrix(...)   (Benchmark_Count (BENCHMARK_STATE_CHANGES), gx3d_EnableTextureMatrix (__VA_ARGS__))
+#define gx3d_DisableTextureMatrix(...)  (Benchmark_Count (BENCHMARK_STATE_CHANGES), gx3d_DisableTextureMatrix (__VA_ARGS__))
+#define gx3d_SetViewport(...)           (Benchmark_Count (BENCHMARK_STATE_CHANGES), gx3d_SetViewport (__VA_ARGS__))
+#define gx3d_SetViewMatrix(...)         (Benchmark_Count (BENCHMARK_STATE_CHANGES), gx3d_SetViewMatrix (__VA_ARGS__))
+#define gx3d_SetProjectionMatrix(...)   (Benchmark_Count (BENCHMARK_STATE_CHANGES), gx3d_SetProjectionMatrix (__VA_ARGS__))
@@ -0,0 +1,594 @@
+/*____________________________________________________________________
+|
+| File: blend_graph.cpp
+|
+| Description: Blends up to BLEND_MAX_TRACKS motions (for example idle,
+|   step and run, crossfaded by movement speed) into one local pose per
+|   skeleton.  Evaluation is split into a job per track that samples its
+|   motion and a merge job that waits for them, so with the job pool the
+|   tracks of a character (and the tracks of every character queued for
+|   the same Job_Run()) are sampled in parallel.
+|
+|   Poses are kept one stream per component, so the merge does 4 bones
+|   at a time with SSE: positions and scales are weighted sums, and
+|   rotations are a normalized weighted sum with each quaternion flipped
+|   to the same hemisphere as the first track's.  Without SSE the same
+|   operations are done one bone at a time, in the same order, so the
+|   results are the same.
+|
+|   Blend_Pose_Lerp() blends two poses the same way, for animation LOD
+|   (see anim_lod.cpp) to draw between two poses sampled frames apart.
+|
+| Functions: Blend_Graph_Create
+|            Blend_Graph_Free
+|            Blend_Graph_Set_Track
+|            Blend_Graph_Queue
+|            Blend_Graph_Evaluate
+|            Blend_Graph_Get_Pose
+|            Blend_Pose_Create
+|            Blend_Pose_Free
+|            Blend_Pose_Copy
+|            Blend_Pose_Lerp
+|            Blend_Locomotion_Weights
+|             Sample_Track
+|             Merge_Pose
+|             Set_Pose_Streams
+|             Set_Pose_Identity
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+/*___________________
+|
+| Include Files
+|__________________*/
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define BLEND_SSE
+#include <emmintrin.h>
+#endif
+
+#include "job_pool.h"
+#include "blend_graph.h"
+
+/*___________________
+|
+| Constants
+|__________________*/
+
+#define POSE_STREAMS 10
+#define POSE_ALIGN   16
+
+/*___________________
+|
+| Type definitions
+|__________________*/
+
+typedef struct {
+  BlendGraph       *graph;
+  const MotionFile *motion;
+  float             frame;
+  float             weight;
+  BlendPose         pose;
+} BlendTrack;
+
+struct BlendGraph {
+  int        num_bones;
+  int        num_padded;            // num_bones rounded up to 4
+  BlendTrack tracks [BLEND_MAX_TRACKS];
+  BlendPose  pose;
+  void      *memory;
+};
+
+/*___________________
+|
+| Function Prototypes
+|__________________*/
+
+static void Sample_Track (void *data);
+static void Merge_Pose (void *data);
+static void Set_Pose_Streams (BlendPose *pose, float *streams, int num_padded);
+static void Set_Pose_Identity (BlendPose *pose, int num_padded);
+
+/*____________________________________________________________________
+|
+| Function: Blend_Graph_Create
+|
+| Input: Called from ____
+| Output: Returns a new blend graph with no tracks set, or 0 on any
+|   error.  The pose starts as identity transforms.
+|___________________________________________________________________*/
+
+BlendGraph *Blend_Graph_Create (int num_bones)
+{
+  int i;
+  size_t size;
+  float *streams;
+  BlendGraph *graph;
+
+  if (num_bones <= 0)
+    return (0);
+
+  graph = (BlendGraph *) calloc (1, sizeof(BlendGraph));
+  if (graph == 0)
+    return (0);
+  graph->num_bones  = num_bones;
+  graph->num_padded = (num_bones + 3) & ~3;
+
+  size = (size_t) graph->num_padded * POSE_STREAMS * (BLEND_MAX_TRACKS + 1) * sizeof(float);
+  graph->memory = malloc (size + POSE_ALIGN - 1);
+  if (graph->memory == 0) {
+    free (graph);
+    return (0);
+  }
+  streams = (float *)(((size_t) graph->memory + POSE_ALIGN - 1) & ~(size_t)(POSE_ALIGN - 1));
+  memset (streams, 0, size);
+
+  for (i=0; i<BLEND_MAX_TRACKS; i++) {
+    graph->tracks[i].graph = graph;
+    Set_Pose_Streams (&graph->tracks[i].pose, streams + i * POSE_STREAMS * graph->num_padded, graph->num_padded);
+  }
+  Set_Pose_Streams (&graph->pose, streams + BLEND_MAX_TRACKS * POSE_STREAMS * graph->num_padded, graph->num_padded);
+  Set_Pose_Identity (&graph->pose, graph->num_padded);
+
+  return (graph);
+}
+
+/*____________________________________________________________________
+|
+| Function: Blend_Graph_Free
+|
+| Input: Called from ____
+| Output: Frees a blend graph.
+|___________________________________________________________________*/
+
+void Blend_Graph_Free (BlendGraph *graph)
+{
+  if (graph) {
+    free (graph->memory);
+    free (graph);
+  }
+}
+
+/*____________________________________________________________________
+|
+| Function: Blend_Graph_Set_Track
+|
+| Input: Called from ____
+| Output: Sets the motion, frame and weight of a track.  Returns false
+|   if the track number is bad or the motion is for another skeleton.
+|___________________________________________________________________*/
+
+bool Blend_Graph_Set_Track (BlendGraph *graph, int track, const MotionFile *motion, float frame, float weight)
+{
+  if ((track < 0) || (track >= BLEND_MAX_TRACKS))
+    return (false);
+  if (motion && ((int) motion->header->num_bones != graph->num_bones))
+    return (false);
+
+  graph->tracks[track].motion = motion;
+  graph->tracks[track].frame  = frame;
+  graph->tracks[track].weight = weight;
+
+  return (true);
+}
+
+/*____________________________________________________________________
+|
+| Function: Blend_Graph_Queue
+|
+| Input: Called from ____
+| Output: Adds a job for each track in use and a merge job that waits
+|   for them.  Anything that can't be queued is done now.
+|___________________________________________________________________*/
+
+void Blend_Graph_Queue (BlendGraph *graph)
+{
+  int i, job, merge;
+  BlendTrack *track;
+
+  merge = Job_Add (Merge_Pose, (void *)graph);
+  if (merge == -1) {
+    Blend_Graph_Evaluate (graph);
+    return;
+  }
+  for (i=0; i<BLEND_MAX_TRACKS; i++) {
+    track = &graph->tracks[i];
+    if ((track->motion == 0) || (track->weight <= 0))
+      continue;
+    job = Job_Add (Sample_Track, (void *)track);
+    if ((job == -1) || (! Job_Add_Depend (merge, job)))
+      Sample_Track ((void *)track);
+  }
+}
+
+/*____________________________________________________________________
+|
+| Function: Blend_Graph_Evaluate
+|
+| Input: Called from Blend_Graph_Queue(), ____
+| Output: Samples each track in use and merges them.
+|___________________________________________________________________*/
+
+void Blend_Graph_Evaluate (BlendGraph *graph)
+{
+  int i;
+
+  for (i=0; i<BLEND_MAX_TRACKS; i++)
+    if (graph->tracks[i].motion && (graph->tracks[i].weight > 0))
+      Sample_Track ((void *)&graph->tracks[i]);
+  Merge_Pose ((void *)graph);
+}
+
+/*____________________________________________________________________
+|
+| Function: Blend_Graph_Get_Pose
+|
+| Input: Called from ____
+| Output: Returns the merged pose.
+|___________________________________________________________________*/
+
+const BlendPose *Blend_Graph_Get_Pose (const BlendGraph *graph)
+{
+  return (&graph->pose);
+}
+
+/*____________________________________________________________________
+|
+| Function: Blend_Pose_Create
+|
+| Input: Called from ____
+| Output: Allocates a pose set to identity transforms.  Returns true on
+|   success.
+|___________________________________________________________________*/
+
+bool Blend_Pose_Create (BlendPose *pose, int num_bones)
+{
+  int num_padded;
+  size_t size;
+  float *streams;
+
+  if (num_bones <= 0)
+    return (false);
+
+  num_padded = (num_bones + 3) & ~3;
+  size = (size_t) num_padded * POSE_STREAMS * sizeof(float);
+  pose->memory = malloc (size + POSE_ALIGN - 1);
+  if (pose->memory == 0)
+    return (false);
+  streams = (float *)(((size_t) pose->memory + POSE_ALIGN - 1) & ~(size_t)(POSE_ALIGN - 1));
+  memset (streams, 0, size);
+  Set_Pose_Streams (pose, streams, num_padded);
+  Set_Pose_Identity (pose, num_padded);
+
+  return (true);
+}
+
+/*____________________________________________________________________
+|
+| Function: Blend_Pose_Free
+|
+| Input: Called from ____
+| Output: Frees a pose.
+|___________________________________________________________________*/
+
+void Blend_Pose_Free (BlendPose *pose)
+{
+  free (pose->memory);
+  pose->memory = 0;
+}
+
+/*____________________________________________________________________
+|
+| Function: Blend_Pose_Copy
+|
+| Input: Called from ____
+| Output: Copies a pose, including the padding.
+|___________________________________________________________________*/
+
+void Blend_Pose_Copy (BlendPose *out, const BlendPose *in, int num_bones)
+{
+  // Poses are always one block of streams
+  memcpy (out->px, in->px, (size_t)((num_bones + 3) & ~3) * POSE_STREAMS * sizeof(float));
+}
+
+/*____________________________________________________________________
+|
+| Function: Blend_Pose_Lerp
+|
+| Input: Called from ____
+| Output: Blends two poses: positions and scales linearly, rotations by
+|   normalized lerp the short way around.  out may be a or b.
+|___________________________________________________________________*/
+
+void Blend_Pose_Lerp (BlendPose *out, const BlendPose *a, const BlendPose *b, float t, int num_bones)
+{
+  int i, num_padded = (num_bones + 3) & ~3;
+
+#ifdef BLEND_SSE
+  __m128 qx, qy, qz, qw, wa, wb, ws, dot, len, zero, one, sign, valid;
+
+  zero = _mm_setzero_ps ();
+  one  = _mm_set1_ps (1.0f);
+  sign = _mm_set1_ps (-0.0f);
+  wa   = _mm_set1_ps (1 - t);
+  wb   = _mm_set1_ps (t);
+  for (i=0; i<num_padded; i+=4) {
+    dot = _mm_add_ps (_mm_add_ps (_mm_add_ps (_mm_mul_ps (_mm_load_ps (&a->qx[i]), _mm_load_ps (&b->qx[i])),
+                                              _mm_mul_ps (_mm_load_ps (&a->qy[i]), _mm_load_ps (&b->qy[i]))),
+                                  _mm_mul_ps (_mm_load_ps (&a->qz[i]), _mm_load_ps (&b->qz[i]))),
+                      _mm_mul_ps (_mm_load_ps (&a->qw[i]), _mm_load_ps (&b->qw[i])));
+    ws = _mm_xor_ps (wb, _mm_and_ps (_mm_cmplt_ps (dot, zero), sign));
+    qx = _mm_add_ps (_mm_mul_ps (wa, _mm_load_ps (&a->qx[i])), _mm_mul_ps (ws, _mm_load_ps (&b->qx[i])));
+    qy = _mm_add_ps (_mm_mul_ps (wa, _mm_load_ps (&a->qy[i])), _mm_mul_ps (ws, _mm_load_ps (&b->qy[i])));
+    qz = _mm_add_ps (_mm_mul_ps (wa, _mm_load_ps (&a->qz[i])), _mm_mul_ps (ws, _mm_load_ps (&b->qz[i])));
+    qw = _mm_add_ps (_mm_mul_ps (wa, _mm_load_ps (&a->qw[i])), _mm_mul_ps (ws, _mm_load_ps (&b->qw[i])));
+    len = _mm_sqrt_ps (_mm_add_ps (_mm_add_ps (_mm_add_ps (_mm_mul_ps (qx, qx), _mm_mul_ps (qy, qy)), _mm_mul_ps (qz, qz)), _mm_mul_ps (qw, qw)));
+    valid = _mm_cmpgt_ps (len, zero);
+    len = _mm_or_ps (_mm_and_ps (valid, len), _mm_andnot_ps (valid, one));
+    _mm_store_ps (&out->px[i], _mm_add_ps (_mm_mul_ps (wa, _mm_load_ps (&a->px[i])), _mm_mul_ps (wb, _mm_load_ps (&b->px[i]))));
+    _mm_store_ps (&out->py[i], _mm_add_ps (_mm_mul_ps (wa, _mm_load_ps (&a->py[i])), _mm_mul_ps (wb, _mm_load_ps (&b->py[i]))));
+    _mm_store_ps (&out->pz[i], _mm_add_ps (_mm_mul_ps (wa, _mm_load_ps (&a->pz[i])), _mm_mul_ps (wb, _mm_load_ps (&b->pz[i]))));
+    _mm_store_ps (&out->sx[i], _mm_add_ps (_mm_mul_ps (wa, _mm_load_ps (&a->sx[i])), _mm_mul_ps (wb, _mm_load_ps (&b->sx[i]))));
+    _mm_store_ps (&out->sy[i], _mm_add_ps (_mm_mul_ps (wa, _mm_load_ps (&a->sy[i])), _mm_mul_ps (wb, _mm_load_ps (&b->sy[i]))));
+    _mm_store_ps (&out->sz[i], _mm_add_ps (_mm_mul_ps (wa, _mm_load_ps (&a->sz[i])), _mm_mul_ps (wb, _mm_load_ps (&b->sz[i]))));
+    _mm_store_ps (&out->qx[i], _mm_div_ps (qx, len));
+    _mm_store_ps (&out->qy[i], _mm_div_ps (qy, len));
+    _mm_store_ps (&out->qz[i], _mm_div_ps (qz, len));
+    _mm_store_ps (&out->qw[i], _mm_or_ps (_mm_and_ps (valid, _mm_div_ps (qw, len)), _mm_andnot_ps (valid, one)));
+  }
+#else
+  float qx, qy, qz, qw, wa, wb, ws, dot, len;
+
+  wa = 1 - t;
+  wb = t;
+  for (i=0; i<num_padded; i++) {
+    dot = a->qx[i] * b->qx[i] + a->qy[i] * b->qy[i] + a->qz[i] * b->qz[i] + a->qw[i] * b->qw[i];
+    ws  = (dot < 0) ? -wb : wb;
+    qx  = wa * a->qx[i] + ws * b->qx[i];
+    qy  = wa * a->qy[i] + ws * b->qy[i];
+    qz  = wa * a->qz[i] + ws * b->qz[i];
+    qw  = wa * a->qw[i] + ws * b->qw[i];
+    len = sqrtf (qx*qx + qy*qy + qz*qz + qw*qw);
+    out->px[i] = wa * a->px[i] + wb * b->px[i];
+    out->py[i] = wa * a->py[i] + wb * b->py[i];
+    out->pz[i] = wa * a->pz[i] + wb * b->pz[i];
+    out->sx[i] = wa * a->sx[i] + wb * b->sx[i];
+    out->sy[i] = wa * a->sy[i] + wb * b->sy[i];
+    out->sz[i] = wa * a->sz[i] + wb * b->sz[i];
+    if (len > 0) {
+      out->qx[i] = qx / len;
+      out->qy[i] = qy / len;
+      out->qz[i] = qz / len;
+      out->qw[i] = qw / len;
+    }
+    else {
+      out->qx[i] = out->qy[i] = out->qz[i] = 0;
+      out->qw[i] = 1;
+    }
+  }
+#endif
+}
+
+/*____________________________________________________________________
+|
+| Function: Blend_Locomotion_Weights
+|
+| Input: Called from ____
+| Output: Gets idle, step and run weights for a speed: idle fades into
+|   step from 0 to step_speed, step into run from step_speed to
+|   run_speed.
+|___________________________________________________________________*/
+
+void Blend_Locomotion_Weights (float speed, float step_speed, float run_speed, float weights[3])
+{
+  float t;
+
+  weights[BLEND_TRACK_IDLE] = weights[BLEND_TRACK_STEP] = weights[BLEND_TRACK_RUN] = 0;
+  if (speed <= 0)
+    weights[BLEND_TRACK_IDLE] = 1;
+  else if (speed < step_speed) {
+    t = speed / step_speed;
+    weights[BLEND_TRACK_IDLE] = 1 - t;
+    weights[BLEND_TRACK_STEP] = t;
+  }
+  else if (speed < run_speed) {
+    t = (speed - step_speed) / (run_speed - step_speed);
+    weights[BLEND_TRACK_STEP] = 1 - t;
+    weights[BLEND_TRACK_RUN]  = t;
+  }
+  else
+    weights[BLEND_TRACK_RUN] = 1;
+}
+
+/*____________________________________________________________________
+|
+| Function: Sample_Track
+|
+| Input: Called from a job pool thread, Blend_Graph_Queue(),
+|   Blend_Graph_Evaluate()
+| Output: Samples every bone of a track's motion into its pose.
+|___________________________________________________________________*/
+
+static void Sample_Track (void *data)
+{
+  int i;
+  float p[3], q[4], s[3];
+  BlendTrack *track = (BlendTrack *)data;
+  BlendPose *pose = &track->pose;
+
+  for (i=0; i<track->graph->num_bones; i++) {
+    MotionFile_Sample (track->motion, i, track->frame, p, q, s);
+    pose->px[i] = p[0];
+    pose->py[i] = p[1];
+    pose->pz[i] = p[2];
+    pose->qx[i] = q[0];
+    pose->qy[i] = q[1];
+    pose->qz[i] = q[2];
+    pose->qw[i] = q[3];
+    pose->sx[i] = s[0];
+    pose->sy[i] = s[1];
+    pose->sz[i] = s[2];
+  }
+}
+
+/*____________________________________________________________________
+|
+| Function: Merge_Pose
+|
+| Input: Called from a job pool thread after the track jobs,
+|   Blend_Graph_Evaluate()
+| Output: Merges the sampled tracks into the graph's pose.  Leaves the
+|   pose alone if no track is in use.
+|___________________________________________________________________*/
+
+static void Merge_Pose (void *data)
+{
+  int i, t, n;
+  float total, w[BLEND_MAX_TRACKS];
+  const BlendPose *in[BLEND_MAX_TRACKS], *ref;
+  BlendGraph *graph = (BlendGraph *)data;
+  BlendPose *out = &graph->pose;
+
+  // Tracks in use, with weights that sum to 1
+  for (t=n=0, total=0; t<BLEND_MAX_TRACKS; t++)
+    if (graph->tracks[t].motion && (graph->tracks[t].weight > 0)) {
+      in[n] = &graph->tracks[t].pose;
+      w[n]  = graph->tracks[t].weight;
+      total += w[n++];
+    }
+  if (n == 0)
+    return;
+  for (t=0; t<n; t++)
+    w[t] /= total;
+  ref = in[0];
+
+#ifdef BLEND_SSE
+  __m128 px, py, pz, qx, qy, qz, qw, sx, sy, sz, wt, ws, dot, len, zero, one, sign, valid;
+  const BlendPose *p;
+
+  zero = _mm_setzero_ps ();
+  one  = _mm_set1_ps (1.0f);
+  sign = _mm_set1_ps (-0.0f);
+  for (i=0; i<graph->num_padded; i+=4) {
+    px = py = pz = qx = qy = qz = qw = sx = sy = sz = zero;
+    for (t=0; t<n; t++) {
+      p  = in[t];
+      wt = _mm_set1_ps (w[t]);
+      px = _mm_add_ps (px, _mm_mul_ps (wt, _mm_load_ps (&p->px[i])));
+      py = _mm_add_ps (py, _mm_mul_ps (wt, _mm_load_ps (&p->py[i])));
+      pz = _mm_add_ps (pz, _mm_mul_ps (wt, _mm_load_ps (&p->pz[i])));
+      sx = _mm_add_ps (sx, _mm_mul_ps (wt, _mm_load_ps (&p->sx[i])));
+      sy = _mm_add_ps (sy, _mm_mul_ps (wt, _mm_load_ps (&p->sy[i])));
+      sz = _mm_add_ps (sz, _mm_mul_ps (wt, _mm_load_ps (&p->sz[i])));
+      // Negate the weight of bones whose rotation is in the other hemisphere from the first track's
+      dot = _mm_add_ps (_mm_add_ps (_mm_add_ps (_mm_mul_ps (_mm_load_ps (&p->qx[i]), _mm_load_ps (&ref->qx[i])),
+                                                _mm_mul_ps (_mm_load_ps (&p->qy[i]), _mm_load_ps (&ref->qy[i]))),
+                                    _mm_mul_ps (_mm_load_ps (&p->qz[i]), _mm_load_ps (&ref->qz[i]))),
+                        _mm_mul_ps (_mm_load_ps (&p->qw[i]), _mm_load_ps (&ref->qw[i])));
+      ws = _mm_xor_ps (wt, _mm_and_ps (_mm_cmplt_ps (dot, zero), sign));
+      qx = _mm_add_ps (qx, _mm_mul_ps (ws, _mm_load_ps (&p->qx[i])));
+      qy = _mm_add_ps (qy, _mm_mul_ps (ws, _mm_load_ps (&p->qy[i])));
+      qz = _mm_add_ps (qz, _mm_mul_ps (ws, _mm_load_ps (&p->qz[i])));
+      qw = _mm_add_ps (qw, _mm_mul_ps (ws, _mm_load_ps (&p->qw[i])));
+    }
+    len = _mm_sqrt_ps (_mm_add_ps (_mm_add_ps (_mm_add_ps (_mm_mul_ps (qx, qx), _mm_mul_ps (qy, qy)), _mm_mul_ps (qz, qz)), _mm_mul_ps (qw, qw)));
+    // A 0 length (only in padding) gives the identity rotation
+    valid = _mm_cmpgt_ps (len, zero);
+    len = _mm_or_ps (_mm_and_ps (valid, len), _mm_andnot_ps (valid, one));
+    _mm_store_ps (&out->px[i], px);
+    _mm_store_ps (&out->py[i], py);
+    _mm_store_ps (&out->pz[i], pz);
+    _mm_store_ps (&out->qx[i], _mm_div_ps (qx, len));
+    _mm_store_ps (&out->qy[i], _mm_div_ps (qy, len));
+    _mm_store_ps (&out->qz[i], _mm_div_ps (qz, len));
+    _mm_store_ps (&out->qw[i], _mm_or_ps (_mm_and_ps (valid, _mm_div_ps (qw, len)), _mm_andnot_ps (valid, one)));
+    _mm_store_ps (&out->sx[i], sx);
+    _mm_store_ps (&out->sy[i], sy);
+    _mm_store_ps (&out->sz[i], sz);
+  }
+#else
+  float px, py, pz, qx, qy, qz, qw, sx, sy, sz, ws, dot, len;
+  const BlendPose *p;
+
+  for (i=0; i<graph->num_padded; i++) {
+    px = py = pz = qx = qy = qz = qw = sx = sy = sz = 0;
+    for (t=0; t<n; t++) {
+      p   = in[t];
+      px += w[t] * p->px[i];
+      py += w[t] * p->py[i];
+      pz += w[t] * p->pz[i];
+      sx += w[t] * p->sx[i];
+      sy += w[t] * p->sy[i];
+      sz += w[t] * p->sz[i];
+      dot = p->qx[i] * ref->qx[i] + p->qy[i] * ref->qy[i] + p->qz[i] * ref->qz[i] + p->qw[i] * ref->qw[i];
+      ws  = (dot < 0) ? -w[t] : w[t];
+      qx += ws * p->qx[i];
+      qy += ws * p->qy[i];
+      qz += ws * p->qz[i];
+      qw += ws * p->qw[i];
+    }
+    len = sqrtf (qx*qx + qy*qy + qz*qz + qw*qw);
+    out->px[i] = px;
+    out->py[i] = py;
+    out->pz[i] = pz;
+    if (len > 0) {
+      out->qx[i] = qx / len;
+      out->qy[i] = qy / len;
+      out->qz[i] = qz / len;
+      out->qw[i] = qw / len;
+    }
+    else {
+      out->qx[i] = out->qy[i] = out->qz[i] = 0;
+      out->qw[i] = 1;
+    }
+    out->sx[i] = sx;
+    out->sy[i] = sy;
+    out->sz[i] = sz;
+  }
+#endif
+}
+
+/*____________________________________________________________________
+|
+| Function: Set_Pose_Streams
+|
+| Input: Called from Blend_Graph_Create(), Blend_Pose_Create()
+| Output: Points a pose's streams into a block of POSE_STREAMS streams.
+|___________________________________________________________________*/
+
+static void Set_Pose_Streams (BlendPose *pose, float *streams, int num_padded)
+{
+  pose->px = streams;
+  pose->py = pose->px + num_padded;
+  pose->pz = pose->py + num_padded;
+  pose->qx = pose->pz + num_padded;
+  pose->qy = pose->qx + num_padded;
+  pose->qz = pose->qy + num_padded;
+  pose->qw = pose->qz + num_padded;
+  pose->sx = pose->qw + num_padded;
+  pose->sy = pose->sx + num_padded;
+  pose->sz = pose->sy + num_padded;
+}
+
+/*____________________________________________________________________
+|
+| Function: Set_Pose_Identity
+|
+| Input: Called from Blend_Graph_Create(), Blend_Pose_Create()
+| Output: Sets every rotation and scale (positions are already 0) to
+|   identity.
+|___________________________________________________________________*/
+
+static void Set_Pose_Identity (BlendPose *pose, int num_padded)
+{
+  int i;
+
+  for (i=0; i<num_padded; i++)
+    pose->qw[i] = pose->sx[i] = pose->sy[i] = pose->sz[i] = 1;
+}
@@ -0,0 +1,88 @@
+/*____________________________________________________________________
+|
+| File: blend_graph.h
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+#ifndef _BLEND_GRAPH_H_
+#define _BLEND_GRAPH_H_
+
+#include "motion_file.h"
+
+/*___________________
+|
+| Constants
+|__________________*/
+
+#define BLEND_MAX_TRACKS 4
+
+// Tracks set up by Blend_Locomotion_Weights()
+#define BLEND_TRACK_IDLE 0
+#define BLEND_TRACK_STEP 1
+#define BLEND_TRACK_RUN  2
+
+/*___________________
+|
+| Type definitions
+|__________________*/
+
+// Local transform of each bone, one stream per component (padded to a multiple of 4 bones)
+typedef struct {
+  float *px, *py, *pz;
+  float *qx, *qy, *qz, *qw;       // quaternion
+  float *sx, *sy, *sz;
+  void  *memory;                  // set by Blend_Pose_Create()
+} BlendPose;
+
+typedef struct BlendGraph BlendGraph;
+
+/*___________________
+|
+| Functions
+|__________________*/
+
+// Creates a blend graph for a skeleton, returns 0 on any error
+BlendGraph *Blend_Graph_Create (int num_bones);
+
+// Frees a blend graph
+void Blend_Graph_Free (BlendGraph *graph);
+
+// Sets a track, returns false if the motion has a different number of bones
+bool Blend_Graph_Set_Track (
+  BlendGraph       *graph,
+  int               track,        // 0 to BLEND_MAX_TRACKS-1
+  const MotionFile *motion,       // 0 = track not used
+  float             frame,
+  float             weight );     // tracks with 0 weight aren't sampled
+
+// Adds jobs that sample each track and then merge them to the job pool's next Job_Run()
+void Blend_Graph_Queue (BlendGraph *graph);
+
+// Samples and merges the tracks on this thread
+void Blend_Graph_Evaluate (BlendGraph *graph);
+
+// Returns the pose from the last evaluation
+const BlendPose *Blend_Graph_Get_Pose (const BlendGraph *graph);
+
+// Allocates a pose of identity transforms, returns false on any error
+bool Blend_Pose_Create (BlendPose *pose, int num_bones);
+
+// Frees a pose from Blend_Pose_Create()
+void Blend_Pose_Free (BlendPose *pose);
+
+// Copies a pose
+void Blend_Pose_Copy (BlendPose *out, const BlendPose *in, int num_bones);
+
+// Blends from pose a (t = 0) to pose b (t = 1)
+void Blend_Pose_Lerp (BlendPose *out, const BlendPose *a, const BlendPose *b, float t, int num_bones);
+
+// Gets idle/step/run weights that crossfade with movement speed
+void Blend_Locomotion_Weights (
+  float speed,
+  float step_speed,               // speed at which the step motion has all the weight
+  float run_speed,                // speed at which the run motion has all the weight
+  float weights [3] );            // BLEND_TRACK_IDLE, _STEP, _RUN
+
+#endif
@@ -0,0 +1,378 @@
+/*____________________________________________________________________
+|
+| File: camera.cpp
+|
+| Description: First person camera core.  The heading is kept as a
+|   pitch and a yaw, so a turn only takes a sin and cos of each: the
+|   heading, right and up vectors come straight from them, already unit
+|   length and at right angles (the right vector has no y, so it needs
+|   no cross product or normalize).  The view matrix is written from
+|   the basis and position in one routine, and only the part that
+|   changed is recomputed: moving without turning redoes only the
+|   translation row, and a camera turned and moved in one frame has its
+|   basis computed once.
+|
+|   Each camera also keeps its projection and, when asked, the frustum
+|   planes of the two together, for culling.  Cameras only compute matrices, so
+|   any number can be used (one per viewport, see viewport.cpp).
+|
+|   Mouse movements are smoothed by the square root of their size, read
+|   from a table for the small movements a frame normally has.
+|
+| Functions: Camera_Init
+|            Camera_Set_Projection
+|            Camera_Rotate
+|            Camera_Move
+|            Camera_Update
+|            Camera_Update_Frustum
+|            Camera_Sphere_Visible
+|            Camera_Smooth_Delta
+|             Compute_Basis
+|             Compute_Translation
+|             Compute_Planes
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+/*___________________
+|
+| Include Files
+|__________________*/
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "camera.h"
+
+/*___________________
+|
+| Constants
+|__________________*/
+
+#define DEGREES_TO_RADIANS  (3.14159265f / 180)
+#define SQRT_TABLE_SIZE     256   // mouse movements smaller than this are looked up
+
+/*___________________
+|
+| Function Prototypes
+|__________________*/
+
+static void Compute_Basis (Camera *camera);
+static void Compute_Translation (Camera *camera);
+static void Compute_Planes (Camera *camera);
+
+/*___________________
+|
+| Global variables
+|__________________*/
+
+static unsigned char sqrt_table [SQRT_TABLE_SIZE];
+static bool          sqrt_table_built = false;
+
+/*____________________________________________________________________
+|
+| Function: Camera_Init
+|
+| Input: Called from ____
+| Output: Sets up a camera with no rotation from its start heading,
+|   with the basis and view matrix computed.
+|___________________________________________________________________*/
+
+void Camera_Init (Camera *camera, const float position[3], const float heading[3])
+{
+  int i;
+  float len;
+
+  if (! sqrt_table_built) {
+    for (i=0; i<SQRT_TABLE_SIZE; i++)
+      sqrt_table[i] = (unsigned char) sqrt ((double) i);
+    sqrt_table_built = true;
+  }
+
+  camera->position[0] = position[0];
+  camera->position[1] = position[1];
+  camera->position[2] = position[2];
+  len = sqrtf (heading[0]*heading[0] + heading[1]*heading[1] + heading[2]*heading[2]);
+  if (len > 0) {
+    camera->start_pitch = -asinf (heading[1] / len) / DEGREES_TO_RADIANS;
+    camera->start_yaw   = atan2f (heading[0], heading[2]) / DEGREES_TO_RADIANS;
+  }
+  else
+    camera->start_pitch = camera->start_yaw = 0;
+  camera->pitch   = 0;
+  camera->yaw     = 0;
+  camera->rotated = true;
+  camera->moved   = true;
+  camera->fov     = 0;
+
+  Camera_Set_Projection (camera, 60, 1, 0.1f, 1000);
+  Camera_Update (camera);
+}
+
+/*____________________________________________________________________
+|
+| Function: Camera_Set_Projection
+|
+| Input: Called from Camera_Init(), Viewport_Layout()
+| Output: Computes the projection matrix, the same as
+|   D3DXMatrixPerspectiveFovLH().
+|___________________________________________________________________*/
+
+void Camera_Set_Projection (Camera *camera, float fov, float aspect, float near_plane, float far_plane)
+{
+  float xscale, yscale, q;
+
+  // Called every frame by viewport layouts, so only a change is recomputed
+  if ((camera->fov == fov) && (camera->aspect == aspect) && (camera->near_plane == near_plane) && (camera->far_plane == far_plane))
+    return;
+
+  camera->fov        = fov;
+  camera->aspect     = aspect;
+  camera->near_plane = near_plane;
+  camera->far_plane  = far_plane;
+
+  yscale = 1 / tanf (fov * 0.5f * DEGREES_TO_RADIANS);
+  xscale = yscale / aspect;
+  q = far_plane / (far_plane - near_plane);
+  camera->projection[0][0] = xscale;  camera->projection[0][1] = 0;       camera->projection[0][2] = 0;               camera->projection[0][3] = 0;
+  camera->projection[1][0] = 0;       camera->projection[1][1] = yscale;  camera->projection[1][2] = 0;               camera->projection[1][3] = 0;
+  camera->projection[2][0] = 0;       camera->projection[2][1] = 0;       camera->projection[2][2] = q;               camera->projection[2][3] = 1;
+  camera->projection[3][0] = 0;       camera->projection[3][1] = 0;       camera->projection[3][2] = -q * near_plane; camera->projection[3][3] = 0;
+
+  camera->projected = true;
+}
+
+/*____________________________________________________________________
+|
+| Function: Camera_Rotate
+|
+| Input: Called from ____
+| Output: Adds to the pitch (down is positive) and yaw (right is
+|   positive).
+|___________________________________________________________________*/
+
+void Camera_Rotate (Camera *camera, float pitch, float yaw)
+{
+  if ((pitch == 0) && (yaw == 0))
+    return;
+
+  camera->pitch += pitch;
+  if (camera->pitch < -CAMERA_PITCH_MAX)
+    camera->pitch = -CAMERA_PITCH_MAX;
+  else if (camera->pitch > CAMERA_PITCH_MAX)
+    camera->pitch = CAMERA_PITCH_MAX;
+
+  camera->yaw += yaw;
+  while (camera->yaw < -360)
+    camera->yaw += 360;
+  while (camera->yaw > 360)
+    camera->yaw -= 360;
+
+  camera->rotated = true;
+}
+
+/*____________________________________________________________________
+|
+| Function: Camera_Move
+|
+| Input: Called from ____
+| Output: Moves the camera, along the new heading if it was rotated.
+|___________________________________________________________________*/
+
+void Camera_Move (Camera *camera, float forward, float right)
+{
+  if ((forward == 0) && (right == 0))
+    return;
+
+  if (camera->rotated)
+    Compute_Basis (camera);
+
+  camera->position[0] += forward * camera->heading[0] + right * camera->right[0];
+  camera->position[1] += forward * camera->heading[1] + right * camera->right[1];
+  camera->position[2] += forward * camera->heading[2] + right * camera->right[2];
+
+  camera->moved = true;
+}
+
+/*____________________________________________________________________
+|
+| Function: Camera_Update
+|
+| Input: Called from Camera_Init(), ____
+| Output: Recomputes the basis if rotated, then the translation if
+|   rotated or moved.  Returns true if the view matrix changed.
+|___________________________________________________________________*/
+
+bool Camera_Update (Camera *camera)
+{
+  bool changed = false;
+
+  if (camera->rotated)
+    Compute_Basis (camera);
+  if (camera->moved) {
+    Compute_Translation (camera);
+    camera->moved     = false;
+    camera->projected = true;
+    changed = true;
+  }
+
+  return (changed);
+}
+
+/*____________________________________________________________________
+|
+| Function: Camera_Update_Frustum
+|
+| Input: Called from ____
+| Output: Updates the camera, then the frustum planes if the view or
+|   projection changed.
+|___________________________________________________________________*/
+
+void Camera_Update_Frustum (Camera *camera)
+{
+  Camera_Update (camera);
+  if (camera->projected) {
+    Compute_Planes (camera);
+    camera->projected = false;
+  }
+}
+
+/*____________________________________________________________________
+|
+| Function: Camera_Sphere_Visible
+|
+| Input: Called from ____
+| Output: Returns false if the sphere is wholly outside any frustum
+|   plane.  Spheres just outside a frustum corner may pass.
+|___________________________________________________________________*/
+
+bool Camera_Sphere_Visible (const Camera *camera, const float center[3], float radius)
+{
+  int i;
+  const float *p;
+
+  for (i=0; i<6; i++) {
+    p = camera->planes[i];
+    if (p[0] * center[0] + p[1] * center[1] + p[2] * center[2] + p[3] < -radius)
+      return (false);
+  }
+
+  return (true);
+}
+
+/*____________________________________________________________________
+|
+| Function: Camera_Smooth_Delta
+|
+| Input: Called from ____
+| Output: Returns the signed integer square root of a mouse movement.
+|___________________________________________________________________*/
+
+int Camera_Smooth_Delta (int delta)
+{
+  int n = abs (delta);
+
+  n = (n < SQRT_TABLE_SIZE) ? sqrt_table[n] : (int) sqrt ((double) n);
+
+  return ((delta < 0) ? -n : n);
+}
+
+/*____________________________________________________________________
+|
+| Function: Compute_Basis
+|
+| Input: Called from Camera_Move(), Camera_Update()
+| Output: Computes the heading, right and up vectors and the rotation
+|   part of the view matrix, leaving the translation to be redone.
+|   The heading is 0,0,1 turned about x by the pitch and then about y
+|   by the yaw, like turning it by gx3d_GetRotateXMatrix() times
+|   gx3d_GetRotateYMatrix().
+|___________________________________________________________________*/
+
+static void Compute_Basis (Camera *camera)
+{
+  float sp, cp, sy, cy, a;
+  float *h = camera->heading, *r = camera->right, *u = camera->up;
+
+  a  = (camera->start_pitch + camera->pitch) * DEGREES_TO_RADIANS;
+  sp = sinf (a);
+  cp = cosf (a);
+  a  = (camera->start_yaw + camera->yaw) * DEGREES_TO_RADIANS;
+  sy = sinf (a);
+  cy = cosf (a);
+
+  h[0] = cp * sy;
+  h[1] = -sp;
+  h[2] = cp * cy;
+  // World up cross heading, divided by cp
+  r[0] = cy;
+  r[1] = 0;
+  r[2] = -sy;
+  // Heading cross right
+  u[0] = sp * sy;
+  u[1] = cp;
+  u[2] = sp * cy;
+
+  camera->view[0][0] = r[0];  camera->view[0][1] = u[0];  camera->view[0][2] = h[0];  camera->view[0][3] = 0;
+  camera->view[1][0] = r[1];  camera->view[1][1] = u[1];  camera->view[1][2] = h[1];  camera->view[1][3] = 0;
+  camera->view[2][0] = r[2];  camera->view[2][1] = u[2];  camera->view[2][2] = h[2];  camera->view[2][3] = 0;
+
+  camera->rotated = false;
+  camera->moved   = true;
+}
+
+/*____________________________________________________________________
+|
+| Function: Compute_Translation
+|
+| Input: Called from Camera_Update()
+| Output: Computes the translation row of the view matrix.
+|___________________________________________________________________*/
+
+static void Compute_Translation (Camera *camera)
+{
+  const float *p = camera->position;
+
+  camera->view[3][0] = -(camera->right[0]   * p[0] + camera->right[1]   * p[1] + camera->right[2]   * p[2]);
+  camera->view[3][1] = -(camera->up[0]      * p[0] + camera->up[1]      * p[1] + camera->up[2]      * p[2]);
+  camera->view[3][2] = -(camera->heading[0] * p[0] + camera->heading[1] * p[1] + camera->heading[2] * p[2]);
+  camera->view[3][3] = 1;
+}
+
+/*____________________________________________________________________
+|
+| Function: Compute_Planes
+|
+| Input: Called from Camera_Update_Frustum()
+| Output: Computes the world space frustum planes from the view times
+|   the projection matrix.  A point is inside a plane when
+|   a*x + b*y + c*z + d >= 0.
+|___________________________________________________________________*/
+
+static void Compute_Planes (Camera *camera)
+{
+  int i, j;
+  float m[4][4], len;
+  float (*p)[4] = camera->planes;
+
+  for (i=0; i<4; i++)
+    for (j=0; j<4; j++)
+      m[i][j] = camera->view[i][0] * camera->projection[0][j] + camera->view[i][1] * camera->projection[1][j] +
+                camera->view[i][2] * camera->projection[2][j] + camera->view[i][3] * camera->projection[3][j];
+
+  // Clip space -w <= x <= w, -w <= y <= w, 0 <= z <= w
+  for (i=0; i<4; i++) {
+    p[0][i] = m[i][3] + m[i][0];    // left
+    p[1][i] = m[i][3] - m[i][0];    // right
+    p[2][i] = m[i][3] + m[i][1];    // bottom
+    p[3][i] = m[i][3] - m[i][1];    // top
+    p[4][i] = m[i][2];              // near
+    p[5][i] = m[i][3] - m[i][2];    // far
+  }
+  for (i=0; i<6; i++) {
+    len = sqrtf (p[i][0]*p[i][0] + p[i][1]*p[i][1] + p[i][2]*p[i][2]);
+    for (j=0; j<4; j++)
+      p[i][j] /= len;
+  }
+}
@@ -0,0 +1,74 @@
+/*____________________________________________________________________
+|
+| File: camera.h
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+#ifndef _CAMERA_H_
+#define _CAMERA_H_
+
+/*___________________
+|
+| Constants
+|__________________*/
+
+#define CAMERA_PITCH_MAX 89.0f    // degrees up or down
+
+/*___________________
+|
+| Type definitions
+|__________________*/
+
+// A first person camera, turned by pitch then yaw from its start heading.  Cameras only
+//   compute matrices, nothing is set in the graphics state.
+typedef struct {
+  float position [3];
+  float pitch, yaw;               // degrees
+  float start_pitch, start_yaw;   // of the start heading
+  float heading [3];              // unit vectors
+  float right [3];
+  float up [3];
+  float view [4][4];              // row vector convention (like gx3dMatrix)
+  float fov;                      // vertical field of view in degrees
+  float aspect;                   // width / height
+  float near_plane, far_plane;
+  float projection [4][4];        // left handed, depth 0 to 1
+  float planes [6][4];            // frustum planes a,b,c,d with a,b,c pointing in (unit length)
+  bool  rotated;                  // basis must be recomputed
+  bool  moved;                    // view translation must be recomputed (after a move or turn)
+  bool  projected;                // frustum planes must be recomputed (after any change)
+} Camera;
+
+/*___________________
+|
+| Functions
+|__________________*/
+
+// Sets up a camera at a position, looking along a heading (need not be normalized), with
+//   a 60 degree square projection until Camera_Set_Projection() is called
+void Camera_Init (Camera *camera, const float position[3], const float heading[3]);
+
+// Sets a camera's projection
+void Camera_Set_Projection (Camera *camera, float fov, float aspect, float near_plane, float far_plane);
+
+// Turns a camera, pitch is clamped to +-CAMERA_PITCH_MAX and yaw wraps
+void Camera_Rotate (Camera *camera, float pitch, float yaw);
+
+// Moves a camera along its heading and right vectors
+void Camera_Move (Camera *camera, float forward, float right);
+
+// Recomputes what changed since the last update, returns true if the view matrix changed
+bool Camera_Update (Camera *camera);
+
+// Updates a camera and its frustum planes
+void Camera_Update_Frustum (Camera *camera);
+
+// Returns true if any part of a sphere may be in the camera's view (after Camera_Update_Frustum())
+bool Camera_Sphere_Visible (const Camera *camera, const float center[3], float radius);
+
+// Returns the integer square root of a mouse movement's size, with its sign
+int Camera_Smooth_Delta (int delta);
+
+#endif
@@ -0,0 +1,297 @@
+/*____________________________________________________________________
+|
+| File: camera_path.cpp
+|
+| Description: Camera paths, for flying the camera the same way every
+|   run (see the benchmark mode in main.cpp).  A path is a list of timed
+|   keys, either written by hand as a few control points or recorded
+|   from the live camera every frame.  Between keys the position and
+|   heading follow a Catmull-Rom spline, which passes through every key
+|   and needs no tangents in the file, so a hand written path is smooth
+|   and a recorded one plays back as it was flown.
+|
+| Functions: Camera_Path_Create
+|            Camera_Path_Free
+|            Camera_Path_Add
+|            Camera_Path_Read
+|            Camera_Path_Write
+|            Camera_Path_Duration
+|            Camera_Path_Sample
+|             Catmull_Rom
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+/*___________________
+|
+| Include Files
+|__________________*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "camera_path.h"
+
+/*___________________
+|
+| Constants
+|__________________*/
+
+#define INITIAL_KEYS   64
+#define MAX_LINE_SIZE  256
+
+/*___________________
+|
+| Function Prototypes
+|__________________*/
+
+static float Catmull_Rom (float p0, float p1, float p2, float p3, float t);
+
+/*____________________________________________________________________
+|
+| Function: Camera_Path_Create
+|
+| Input: Called from ____, Camera_Path_Read()
+| Output: Returns a path with no keys, or 0 if out of memory.
+|___________________________________________________________________*/
+
+CameraPath *Camera_Path_Create ()
+{
+  CameraPath *path;
+
+  path = (CameraPath *) calloc (1, sizeof(CameraPath));
+  if (path) {
+    path->keys = (CameraPathKey *) malloc (INITIAL_KEYS * sizeof(CameraPathKey));
+    if (path->keys == 0) {
+      free (path);
+      return (0);
+    }
+    path->max_keys = INITIAL_KEYS;
+  }
+
+  return (path);
+}
+
+/*____________________________________________________________________
+|
+| Function: Camera_Path_Free
+|
+| Input: Called from ____
+| Output: Frees a path.
+|___________________________________________________________________*/
+
+void Camera_Path_Free (CameraPath *path)
+{
+  if (path) {
+    free (path->keys);
+    free (path);
+  }
+}
+
+/*____________________________________________________________________
+|
+| Function: Camera_Path_Add
+|
+| Input: Called from ____, Camera_Path_Read()
+| Output: Adds a key at the end of the path, growing it as needed.
+|   Returns false if out of memory.
+|___________________________________________________________________*/
+
+bool Camera_Path_Add (CameraPath *path, float time, const float position[3], const float heading[3])
+{
+  CameraPathKey *keys, *key;
+
+  if ((path->num_keys > 0) && (time <= path->keys[path->num_keys-1].time))
+    return (true);
+
+  if (path->num_keys == path->max_keys) {
+    keys = (CameraPathKey *) realloc (path->keys, 2 * path->max_keys * sizeof(CameraPathKey));
+    if (keys == 0)
+      return (false);
+    path->keys      = keys;
+    path->max_keys *= 2;
+  }
+
+  key = &path->keys[path->num_keys++];
+  key->time = time;
+  memcpy (key->position, position, sizeof(key->position));
+  memcpy (key->heading, heading, sizeof(key->heading));
+
+  return (true);
+}
+
+/*____________________________________________________________________
+|
+| Function: Camera_Path_Read
+|
+| Input: Called from Program_Run()
+| Output: Reads a path file.  Returns the path, or 0 if the file can't
+|   be read, has a bad line or has fewer than 2 keys.
+|___________________________________________________________________*/
+
+CameraPath *Camera_Path_Read (const char *filename)
+{
+  int n;
+  char line [MAX_LINE_SIZE], *comment;
+  float time, position[3], heading[3];
+  bool ok = true;
+  FILE *fp;
+  CameraPath *path;
+
+  fp = fopen (filename, "r");
+  if (fp == 0)
+    return (0);
+  path = Camera_Path_Create ();
+
+  while (path && ok && fgets (line, MAX_LINE_SIZE, fp)) {
+    comment = strchr (line, '#');
+    if (comment)
+      *comment = 0;
+    n = sscanf (line, "%f %f %f %f %f %f %f", &time, &position[0], &position[1], &position[2], &heading[0], &heading[1], &heading[2]);
+    if (n == 7)
+      ok = Camera_Path_Add (path, time, position, heading);
+    // Anything but a blank line is an error
+    else if (n != EOF)
+      ok = false;
+  }
+  fclose (fp);
+
+  if (path && ((! ok) || (path->num_keys < 2))) {
+    Camera_Path_Free (path);
+    path = 0;
+  }
+
+  return (path);
+}
+
+/*____________________________________________________________________
+|
+| Function: Camera_Path_Write
+|
+| Input: Called from Program_Run()
+| Output: Writes a path file.  Returns true on success.
+|___________________________________________________________________*/
+
+bool Camera_Path_Write (CameraPath *path, const char *filename)
+{
+  int i;
+  bool ok;
+  FILE *fp;
+  CameraPathKey *key;
+
+  fp = fopen (filename, "w");
+  if (fp == 0)
+    return (false);
+
+  fprintf (fp, "# time x y z hx hy hz\n");
+  for (i=0; i<path->num_keys; i++) {
+    key = &path->keys[i];
+    fprintf (fp, "%.4f %.4f %.4f %.4f %.5f %.5f %.5f\n", key->time,
+             key->position[0], key->position[1], key->position[2],
+             key->heading[0], key->heading[1], key->heading[2]);
+  }
+  ok = (ferror (fp) == 0);
+  if (fclose (fp) != 0)
+    ok = false;
+
+  return (ok);
+}
+
+/*____________________________________________________________________
+|
+| Function: Camera_Path_Duration
+|
+| Input: Called from ____
+| Output: Returns the time of the last key (0 if none).
+|___________________________________________________________________*/
+
+float Camera_Path_Duration (CameraPath *path)
+{
+  if (path->num_keys == 0)
+    return (0);
+  return (path->keys[path->num_keys-1].time);
+}
+
+/*____________________________________________________________________
+|
+| Function: Camera_Path_Sample
+|
+| Input: Called from ____
+| Output: Gets the position and heading at a time.  The keys at each
+|   end are repeated as the outer control points of the first and last
+|   segments.
+|___________________________________________________________________*/
+
+void Camera_Path_Sample (CameraPath *path, float time, float position[3], float heading[3])
+{
+  int i, lo, hi, mid, i0, i2, i3;
+  float t, len;
+  CameraPathKey *keys = path->keys;
+
+  if (path->num_keys == 0) {
+    position[0] = position[1] = position[2] = 0;
+    heading[0] = heading[1] = 0;
+    heading[2] = 1;
+    return;
+  }
+
+  // Find the segment from key lo to key lo+1 holding the time
+  lo = 0;
+  hi = path->num_keys - 1;
+  if (time <= keys[0].time)
+    hi = 0;
+  else if (time >= keys[hi].time)
+    lo = hi;
+  else
+    while (hi - lo > 1) {
+      mid = (lo + hi) / 2;
+      if (keys[mid].time <= time)
+        lo = mid;
+      else
+        hi = mid;
+    }
+  if (lo == hi) {
+    memcpy (position, keys[lo].position, 3 * sizeof(float));
+    memcpy (heading, keys[lo].heading, 3 * sizeof(float));
+  }
+  else {
+    t  = (time - keys[lo].time) / (keys[hi].time - keys[lo].time);
+    i0 = (lo > 0) ? lo - 1 : lo;
+    i2 = hi;
+    i3 = (hi < path->num_keys - 1) ? hi + 1 : hi;
+    for (i=0; i<3; i++) {
+      position[i] = Catmull_Rom (keys[i0].position[i], keys[lo].position[i], keys[i2].position[i], keys[i3].position[i], t);
+      heading[i]  = Catmull_Rom (keys[i0].heading[i], keys[lo].heading[i], keys[i2].heading[i], keys[i3].heading[i], t);
+    }
+  }
+
+  len = sqrtf (heading[0]*heading[0] + heading[1]*heading[1] + heading[2]*heading[2]);
+  if (len > 0) {
+    heading[0] /= len;
+    heading[1] /= len;
+    heading[2] /= len;
+  }
+  else {
+    heading[0] = heading[1] = 0;
+    heading[2] = 1;
+  }
+}
+
+/*____________________________________________________________________
+|
+| Function: Catmull_Rom
+|
+| Input: Called from Camera_Path_Sample()
+| Output: Returns the point t (0-1) of the way from p1 to p2 on a
+|   uniform Catmull-Rom spline.
+|___________________________________________________________________*/
+
+static float Catmull_Rom (float p0, float p1, float p2, float p3, float t)
+{
+  float t2 = t * t, t3 = t2 * t;
+
+  return (0.5f * ((2 * p1) + (p2 - p0) * t + (2*p0 - 5*p1 + 4*p2 - p3) * t2 + (3*p1 - p0 - 3*p2 + p3) * t3));
+}
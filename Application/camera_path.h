@@ -0,0 +1,59 @@
+/*____________________________________________________________________
+|
+| File: camera_path.h
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+#ifndef _CAMERA_PATH_H_
+#define _CAMERA_PATH_H_
+
+/*___________________
+|
+| Type definitions
+|__________________*/
+
+// A camera position and heading at a time
+typedef struct {
+  float time;                     // seconds from the start of the path
+  float position [3];
+  float heading [3];              // need not be normalized
+} CameraPathKey;
+
+typedef struct {
+  CameraPathKey *keys;            // in increasing time
+  int            num_keys;
+  int            max_keys;
+} CameraPath;
+
+/*___________________
+|
+| Functions
+|__________________*/
+
+// Creates an empty path (for recording), returns 0 on any error
+CameraPath *Camera_Path_Create ();
+
+// Frees a path
+void Camera_Path_Free (CameraPath *path);
+
+// Adds a key at the end of a path, keys not later than the last one are ignored,
+//   returns false if out of memory
+bool Camera_Path_Add (CameraPath *path, float time, const float position[3], const float heading[3]);
+
+// Reads a path from a text file of keys, one per line: time x y z hx hy hz ('#' starts a
+//   comment), returns 0 on any error
+CameraPath *Camera_Path_Read (const char *filename);
+
+// Writes a path in the format read by Camera_Path_Read(), returns true on success
+bool Camera_Path_Write (CameraPath *path, const char *filename);
+
+// Returns the time of the last key
+float Camera_Path_Duration (CameraPath *path);
+
+// Gets the position and unit heading at a time (clamped to the path) on a spline
+//   through the keys
+void Camera_Path_Sample (CameraPath *path, float time, float position[3], float heading[3]);
+
+#endif
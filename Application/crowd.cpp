@@ -0,0 +1,485 @@
+/*____________________________________________________________________
+|
+| File: crowd.cpp
+|
+| Description: Crowds of animated characters sharing one skeleton and
+|   one motion.  The motion cycle (the motion's length, known once
+|   it's loaded) is split into buckets, each with its own copy of the
+|   character object and blend tree, and each character in the crowd
+|   is drawn with the bucket nearest its phase in the cycle.  Each
+|   frame the motion is sampled and skinned once per bucket (not per
+|   character), so the animation cost depends on the number of buckets,
+|   not the size of the crowd.
+|
+|   Bucket sample times are also rounded down to CROWD_SAMPLE_RATE, so
+|   a bucket whose pose hasn't moved to the next sample since the last
+|   frame is skipped (see pose_cache.cpp).
+|
+|   The one motion is played into each bucket's blend node in turn by
+|   pointing its output there before updating it.
+|
+|   Buckets also have animation LOD (see anim_lod.cpp): a bucket whose
+|   nearest character is far from the camera is updated every 2nd or
+|   4th frame, staggered with the other buckets, and a bucket with no
+|   character in view of any camera isn't updated at all.  Characters
+|   are culled against each camera's frustum once per frame, and the
+|   same result is used for the LOD and for drawing in each viewport.
+|   GX blend trees can't blend two sampled poses, so between updates a
+|   bucket holds its last pose.
+|
+|   Culling is split into chunks of characters run as jobs on the job
+|   pool (see job_pool.cpp), each finding the nearest character in view
+|   of each bucket for its own chunk.  Sampling and skinning call GX, so
+|   they stay on the calling thread.
+|
+| Functions: Crowd_Create
+|            Crowd_Free
+|            Crowd_Load_Async
+|            Crowd_Add
+|            Crowd_Update
+|            Crowd_Draw
+|             Cull_Chunk
+|             Finalize_Motion
+|             Finalize_Bucket
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+/*___________________
+|
+| Include Files
+|__________________*/
+
+#include <first_header.h>
+#include <math.h>
+
+#include "dp.h"
+
+#include "loader.h"
+#include "job_pool.h"
+#include "pose_cache.h"
+#include "anim_lod.h"
+#include "camera.h"
+#include "crowd.h"
+#include "benchmark_count.h"
+
+/*___________________
+|
+| Constants
+|__________________*/
+
+#define MAX_BUCKETS        16
+#define CROWD_SAMPLE_RATE  30     // bucket poses per second
+#define CROWD_MOTION_FPS   30
+
+#define LOD_FULL_DISTANCE  30     // buckets with a character nearer than this are updated every frame
+#define LOD_HALF_DISTANCE  80     // every 2nd frame, else every 4th
+
+#define MAX_CULL_CHUNKS    8      // culling jobs per update
+#define MIN_CULL_CHUNK     32     // fewest characters worth a job
+
+/*___________________
+|
+| Type definitions
+|__________________*/
+
+typedef struct {
+  Crowd         *crowd;
+  gx3dObject    *object;          // 0 until loaded
+  gx3dBlendNode *bnode;
+  gx3dBlendTree *btree;
+  PoseCache      pose;
+  AnimLod        lod;
+  int            num_instances;
+} CrowdBucket;
+
+typedef struct {
+  gx3dMatrix     m;               // characters don't move, so this is computed once
+  float          x, z, scale;
+  int            bucket;
+  unsigned       views;           // bit n set if in view of camera n at the last update
+} CrowdInstance;
+
+// Characters culled by one job, with the nearest in view of each bucket
+typedef struct {
+  Crowd   *crowd;
+  Camera **cameras;
+  int      num_cameras;
+  int      first, num;
+  float    distance [MAX_BUCKETS];
+  bool     visible [MAX_BUCKETS];
+} CullChunk;
+
+struct Crowd {
+  gx3dMotionSkeleton **skeleton;
+  gx3dMotion    *motion;          // 0 until loaded
+  float          cycle;           // seconds, the motion's length
+  unsigned       vertex_format;
+  unsigned       flags;
+  CrowdBucket    buckets [MAX_BUCKETS];
+  int            num_buckets;
+  AnimLodScheduler lod;
+  CrowdInstance *instances;
+  int            num_instances;
+  int            max_instances;
+};
+
+/*___________________
+|
+| Function Prototypes
+|__________________*/
+
+static void Cull_Chunk (void *data);
+static void Finalize_Motion (void *data, LoaderFile *files, int num_files);
+static void Finalize_Bucket (void *data, LoaderFile *files, int num_files);
+
+/*____________________________________________________________________
+|
+| Function: Crowd_Create
+|
+| Input: Called from Program_Run()
+| Output: Returns a new empty crowd or 0 on any error.
+|___________________________________________________________________*/
+
+Crowd *Crowd_Create (gx3dMotionSkeleton **skeleton, int num_buckets, int max_instances)
+{
+  int i;
+  Crowd *crowd;
+
+  if ((num_buckets < 1) OR (num_buckets > MAX_BUCKETS) OR (max_instances < 1))
+    return (0);
+
+  crowd = (Crowd *) calloc (1, sizeof(Crowd));
+  if (crowd) {
+    crowd->instances = (CrowdInstance *) calloc (max_instances, sizeof(CrowdInstance));
+    if (crowd->instances == 0) {
+      free (crowd);
+      return (0);
+    }
+    crowd->skeleton      = skeleton;
+    crowd->num_buckets   = num_buckets;
+    crowd->max_instances = max_instances;
+    Anim_Lod_Init (&crowd->lod, LOD_FULL_DISTANCE, LOD_HALF_DISTANCE);
+    for (i=0; i<num_buckets; i++) {
+      crowd->buckets[i].crowd = crowd;
+      Pose_Cache_Invalidate (&crowd->buckets[i].pose);
+      Anim_Lod_Add (&crowd->lod, &crowd->buckets[i].lod);
+    }
+  }
+
+  return (crowd);
+}
+
+/*____________________________________________________________________
+|
+| Function: Crowd_Free
+|
+| Input: Called from Program_Run()
+| Output: Frees a crowd.  Any loads queued for it must be finalized
+|   first.
+|___________________________________________________________________*/
+
+void Crowd_Free (Crowd *crowd)
+{
+  int i;
+  CrowdBucket *bucket;
+
+  if (crowd == 0)
+    return;
+
+  for (i=0; i<crowd->num_buckets; i++) {
+    bucket = &crowd->buckets[i];
+    if (bucket->btree)
+      gx3d_BlendTree_Free (bucket->btree);
+    if (bucket->bnode)
+      gx3d_BlendNode_Free (bucket->bnode);
+    if (bucket->object)
+      gx3d_FreeObject (bucket->object);
+  }
+  if (crowd->motion)
+    gx3d_Motion_Free (crowd->motion);
+  free (crowd->instances);
+  free (crowd);
+}
+
+/*____________________________________________________________________
+|
+| Function: Crowd_Load_Async
+|
+| Input: Called from Program_Run()
+| Output: Queues the motion (after depend_job) and then each bucket's
+|   object.  Returns the last job id or -1 on any error.
+|___________________________________________________________________*/
+
+int Crowd_Load_Async (Crowd *crowd, char *object_filename, char *motion_filename, unsigned vertex_format, unsigned flags, int depend_job)
+{
+  int i, job_motion, job = -1;
+
+  if (crowd == 0)
+    return (-1);
+
+  crowd->vertex_format = vertex_format;
+  crowd->flags         = flags;
+
+  job_motion = Loader_Add (Finalize_Motion, (void *)crowd, motion_filename, 0);
+  if (job_motion == -1)
+    return (-1);
+  Loader_Add_Depend (job_motion, depend_job);
+  // A job per bucket so loading the copies is spread over frames
+  for (i=0; i<crowd->num_buckets; i++) {
+    job = Loader_Add (Finalize_Bucket, (void *)&crowd->buckets[i], object_filename, 0);
+    if (job == -1)
+      break;
+    Loader_Add_Depend (job, job_motion);
+  }
+
+  return (job);
+}
+
+/*____________________________________________________________________
+|
+| Function: Crowd_Add
+|
+| Input: Called from Program_Run()
+| Output: Adds a character.  Returns its index or -1 if the crowd is
+|   full.
+|___________________________________________________________________*/
+
+int Crowd_Add (Crowd *crowd, float x, float z, float facing, float scale, float phase)
+{
+  int b;
+  gx3dMatrix m1, m2, m3, m;
+  CrowdInstance *instance;
+
+  if ((crowd == 0) OR (crowd->num_instances == crowd->max_instances))
+    return (-1);
+
+  b = (int)(phase * crowd->num_buckets);
+  if ((b < 0) OR (b >= crowd->num_buckets))
+    b = 0;
+
+  gx3d_GetScaleMatrix (&m1, scale, scale, scale);
+  gx3d_GetRotateYMatrix (&m2, facing);
+  gx3d_GetTranslateMatrix (&m3, x, 0, z);
+  gx3d_MultiplyMatrix (&m1, &m2, &m);
+  instance = &crowd->instances[crowd->num_instances];
+  gx3d_MultiplyMatrix (&m, &m3, &instance->m);
+  instance->x      = x;
+  instance->z      = z;
+  instance->scale  = scale;
+  instance->bucket = b;
+  instance->views  = 0;
+  crowd->buckets[b].num_instances++;
+
+  return (crowd->num_instances++);
+}
+
+/*____________________________________________________________________
+|
+| Function: Crowd_Update
+|
+| Input: Called from Program_Run(), after the cameras' frustums are
+|   updated (see Viewport_Layout())
+| Output: Finds the characters in view of each camera, then samples
+|   the motion into each loaded bucket in use that is due for an
+|   update, bucket b being b/num_buckets of the cycle ahead of bucket 0.
+|___________________________________________________________________*/
+
+void Crowd_Update (Crowd *crowd, unsigned time, Camera **cameras, int num_cameras)
+{
+  int i, b, num_chunks, chunk_size;
+  float t;
+  float distance [MAX_BUCKETS];
+  bool visible [MAX_BUCKETS];
+  PoseTrack track;
+  CrowdBucket *bucket;
+  CullChunk chunks [MAX_CULL_CHUNKS], *chunk;
+  JobCounter culled = {};
+
+  if (crowd == 0)
+    return;
+
+  // Cull each character once per camera in parallel, kept for Crowd_Draw() and used for
+  //   the nearest character in any view of each bucket
+  num_chunks = (crowd->num_instances + MIN_CULL_CHUNK - 1) / MIN_CULL_CHUNK;
+  if (num_chunks > MAX_CULL_CHUNKS)
+    num_chunks = MAX_CULL_CHUNKS;
+  chunk_size = num_chunks ? (crowd->num_instances + num_chunks - 1) / num_chunks : 0;
+  for (i=0; i<num_chunks; i++) {
+    chunk = &chunks[i];
+    chunk->crowd       = crowd;
+    chunk->cameras     = cameras;
+    chunk->num_cameras = num_cameras;
+    chunk->first       = i * chunk_size;
+    chunk->num         = crowd->num_instances - chunk->first;
+    if (chunk->num > chunk_size)
+      chunk->num = chunk_size;
+    Job_Spawn (Cull_Chunk, chunk, &culled);
+  }
+  Job_Wait (&culled);
+
+  for (b=0; b<crowd->num_buckets; b++) {
+    distance[b] = 0;
+    visible[b]  = false;
+    for (i=0; i<num_chunks; i++)
+      if (chunks[i].visible[b] AND ((NOT visible[b]) OR (chunks[i].distance[b] < distance[b]))) {
+        distance[b] = chunks[i].distance[b];
+        visible[b]  = true;
+      }
+  }
+
+  if (crowd->motion == 0)
+    return;
+
+  track.motion = crowd->motion;
+  track.weight = 1;
+  Anim_Lod_Begin_Frame (&crowd->lod);
+  for (i=0; i<crowd->num_buckets; i++) {
+    bucket = &crowd->buckets[i];
+    if ((bucket->btree == 0) OR (bucket->num_instances == 0))
+      continue;
+    Anim_Lod_Set_View (&crowd->lod, &bucket->lod, distance[i], visible[i]);
+    // The bucket holds its pose, so the predicted time of the next pose isn't used
+    if (Anim_Lod_Update (&crowd->lod, &bucket->lod, time / 1000.0f, 0) == ANIM_LOD_HOLD)
+      continue;
+    t = 0;
+    if (crowd->cycle > 0)
+      t = (float) fmod (time / 1000.0 + (double) crowd->cycle * i / crowd->num_buckets, (double) crowd->cycle);
+    t = floorf (t * CROWD_SAMPLE_RATE) / CROWD_SAMPLE_RATE;
+    track.time = t;
+    if (Pose_Cache_Changed (&bucket->pose, &track, 1)) {
+      gx3d_Motion_Set_Output (crowd->motion, bucket->bnode, gx3d_BLENDNODE_TRACK_0);
+      gx3d_Motion_Update (crowd->motion, t, false);
+      gx3d_BlendTree_Update (bucket->btree);
+    }
+  }
+}
+
+/*____________________________________________________________________
+|
+| Function: Crowd_Draw
+|
+| Input: Called from Program_Run()
+| Output: Draws each character whose bucket is loaded and that was in
+|   view of this camera at the last Crowd_Update().
+|___________________________________________________________________*/
+
+void Crowd_Draw (Crowd *crowd, int view)
+{
+  int i;
+  CrowdInstance *instance;
+  gx3dObject *object;
+
+  if (crowd == 0)
+    return;
+
+  for (i=0; i<crowd->num_instances; i++) {
+    instance = &crowd->instances[i];
+    if ((instance->views & (1u << view)) == 0)
+      continue;
+    object = crowd->buckets[instance->bucket].object;
+    if (object AND crowd->buckets[instance->bucket].btree) {
+      gx3d_SetObjectMatrix (object, &instance->m);
+      gx3d_DrawObject (object, 0);
+    }
+  }
+}
+
+/*____________________________________________________________________
+|
+| Function: Cull_Chunk
+|
+| Input: Called from Crowd_Update() (through the job pool)
+| Output: Finds the cameras each character of the chunk is in view of,
+|   and the nearest character in view of each bucket.
+|___________________________________________________________________*/
+
+static void Cull_Chunk (void *data)
+{
+  int i, j;
+  float dx, dz, dist, radius, center[3];
+  CullChunk *chunk = (CullChunk *) data;
+  Crowd *crowd = chunk->crowd;
+  Camera *camera;
+  CrowdBucket *bucket;
+  CrowdInstance *instance;
+  gx3dSphere *sphere;
+
+  for (i=0; i<crowd->num_buckets; i++) {
+    chunk->distance[i] = 0;
+    chunk->visible[i]  = false;
+  }
+  for (i=chunk->first; i<chunk->first+chunk->num; i++) {
+    instance = &crowd->instances[i];
+    instance->views = 0;
+    bucket = &crowd->buckets[instance->bucket];
+    if (bucket->object == 0)
+      continue;
+    // The sphere is grown to cover the character at any facing
+    sphere = &bucket->object->bound_sphere;
+    center[0] = instance->x;
+    center[1] = sphere->center.y * instance->scale;
+    center[2] = instance->z;
+    radius = (sphere->radius + sqrtf (sphere->center.x * sphere->center.x + sphere->center.z * sphere->center.z)) * instance->scale;
+    for (j=0; (j<chunk->num_cameras) AND (j<CROWD_MAX_VIEWS); j++) {
+      camera = chunk->cameras[j];
+      if (NOT Camera_Sphere_Visible (camera, center, radius))
+        continue;
+      instance->views |= 1u << j;
+      dx = instance->x - camera->position[0];
+      dz = instance->z - camera->position[2];
+      dist = sqrtf (dx*dx + dz*dz);
+      if ((NOT chunk->visible[instance->bucket]) OR (dist < chunk->distance[instance->bucket]))
+        chunk->distance[instance->bucket] = dist;
+      chunk->visible[instance->bucket] = true;
+    }
+  }
+}
+
+/*____________________________________________________________________
+|
+| Function: Finalize_Motion
+|
+| Input: Called from Loader_Update(), after the skeleton is loaded
+| Output: Loads the crowd's motion and takes the cycle from its
+|   length.
+|___________________________________________________________________*/
+
+static void Finalize_Motion (void *data, LoaderFile *files, int num_files)
+{
+  Crowd *crowd = (Crowd *)data;
+
+  if (*(crowd->skeleton))
+    crowd->motion = gx3d_Motion_Read_LWS_File (*(crowd->skeleton), files[0].filename, CROWD_MOTION_FPS, 0, 0, false);
+  if (crowd->motion == 0)
+    DEBUG_WRITE ("Crowd_Load_Async(): can't load motion, the crowd won't be drawn")
+  else
+    crowd->cycle = crowd->motion->duration / 1000.0f;   // to its last key, not the end of the scene
+}
+
+/*____________________________________________________________________
+|
+| Function: Finalize_Bucket
+|
+| Input: Called from Loader_Update(), after Finalize_Motion()
+| Output: Loads a bucket's copy of the object (not through the asset
+|   manager, which would share one copy) and creates its blend tree.
+|___________________________________________________________________*/
+
+static void Finalize_Bucket (void *data, LoaderFile *files, int num_files)
+{
+  CrowdBucket *bucket = (CrowdBucket *)data;
+  Crowd *crowd = bucket->crowd;
+
+  if (crowd->motion == 0)
+    return;
+
+  gx3d_ReadLWO2File (files[0].filename, &bucket->object, crowd->vertex_format, crowd->flags);
+  if (bucket->object) {
+    bucket->bnode = gx3d_BlendNode_Init (*(crowd->skeleton), gx3d_BLENDNODE_TYPE_SINGLE);
+    bucket->btree = gx3d_BlendTree_Init (*(crowd->skeleton));
+    gx3d_BlendTree_Add_Node (bucket->btree, bucket->bnode);
+    gx3d_BlendTree_Set_Output (bucket->btree, bucket->object->layer);
+  }
+}
@@ -0,0 +1,50 @@
+/*____________________________________________________________________
+|
+| File: crowd.h
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+#define CROWD_MAX_VIEWS 32       // cameras a crowd can be culled against
+
+typedef struct Crowd Crowd;
+
+// Creates a crowd, returns 0 on any error
+Crowd *Crowd_Create (
+  gx3dMotionSkeleton **skeleton,    // where the loader stores the shared skeleton
+  int                  num_buckets, // number of poses shared by the crowd (at most 16)
+  int                  max_instances );
+
+// Frees a crowd and everything it loaded
+void Crowd_Free (Crowd *crowd);
+
+// Queues the motion and one copy of the object per bucket to be loaded by the loader,
+//   after depend_job (the skeleton), returns the last job id or -1 on any error
+int Crowd_Load_Async (
+  Crowd   *crowd,
+  char    *object_filename,         // LWO2 file
+  char    *motion_filename,         // LWS file
+  unsigned vertex_format,           // gx3d_VERTEXFORMAT_... (must include gx3d_VERTEXFORMAT_WEIGHTS)
+  unsigned flags,                   // same flags as gx3d_ReadLWO2File()
+  int      depend_job );
+
+// Adds a character standing on the ground, returns its index or -1 if the crowd is full
+int Crowd_Add (
+  Crowd *crowd,
+  float  x,
+  float  z,
+  float  facing,                    // rotation about y in degrees
+  float  scale,
+  float  phase );                   // 0-1, where in the motion cycle the character is
+
+// Updates the pose of each bucket for the current time (milliseconds), less often
+//   for buckets far from the cameras and not at all for buckets out of view of all of them
+void Crowd_Update (
+  Crowd    *crowd,
+  unsigned  time,
+  Camera  **cameras,                // with frustums updated (see Camera_Update_Frustum())
+  int       num_cameras );          // at most CROWD_MAX_VIEWS
+
+// Draws every character in view of cameras[view] at the last update (with the current texture)
+void Crowd_Draw (Crowd *crowd, int view);
@@ -0,0 +1,117 @@
+/*____________________________________________________________________
+|
+| File: file_map.cpp
+|
+| Description: Maps files read-only into memory.  Uses file mapping
+|   objects on Windows and mmap() elsewhere, so the tools that build
+|   packs and meshes from it run on Linux too.
+|
+| Functions: FileMap_Open
+|            FileMap_Close
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+/*___________________
+|
+| Include Files
+|__________________*/
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include <string.h>
+
+#include "file_map.h"
+
+/*____________________________________________________________________
+|
+| Function: FileMap_Open
+|
+| Input: Called from ____
+| Output: Maps a file into memory.  Returns true on success, else false.
+|   An empty file can't be mapped and returns false.
+|___________________________________________________________________*/
+
+bool FileMap_Open (const char *filename, FileMap *map)
+{
+  memset (map, 0, sizeof(FileMap));
+
+#ifdef _WIN32
+  HANDLE file, mapping;
+  LARGE_INTEGER size;
+  void *data;
+
+  file = CreateFileA (filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+  if (file == INVALID_HANDLE_VALUE)
+    return (false);
+  if ((!GetFileSizeEx (file, &size)) || (size.QuadPart == 0) || (size.HighPart != 0)) {
+    CloseHandle (file);
+    return (false);
+  }
+  mapping = CreateFileMappingA (file, NULL, PAGE_READONLY, 0, 0, NULL);
+  if (mapping == NULL) {
+    CloseHandle (file);
+    return (false);
+  }
+  data = MapViewOfFile (mapping, FILE_MAP_READ, 0, 0, 0);
+  if (data == NULL) {
+    CloseHandle (mapping);
+    CloseHandle (file);
+    return (false);
+  }
+  map->data        = data;
+  map->size        = (size_t) size.QuadPart;
+  map->file_handle = (void *) file;
+  map->map_handle  = (void *) mapping;
+#else
+  int fd;
+  struct stat st;
+  void *data;
+
+  fd = open (filename, O_RDONLY);
+  if (fd < 0)
+    return (false);
+  if ((fstat (fd, &st) != 0) || (st.st_size == 0)) {
+    close (fd);
+    return (false);
+  }
+  data = mmap (NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping stays valid after the file is closed
+  close (fd);
+  if (data == MAP_FAILED)
+    return (false);
+  map->data = data;
+  map->size = (size_t) st.st_size;
+#endif
+
+  return (true);
+}
+
+/*____________________________________________________________________
+|
+| Function: FileMap_Close
+|
+| Input: Called from ____
+| Output: Unmaps a file mapped with FileMap_Open().
+|___________________________________________________________________*/
+
+void FileMap_Close (FileMap *map)
+{
+  if (map->data) {
+#ifdef _WIN32
+    UnmapViewOfFile (map->data);
+    CloseHandle ((HANDLE) map->map_handle);
+    CloseHandle ((HANDLE) map->file_handle);
+#else
+    munmap ((void *) map->data, map->size);
+#endif
+  }
+  memset (map, 0, sizeof(FileMap));
+}
@@ -0,0 +1,37 @@
+/*____________________________________________________________________
+|
+| File: file_map.h
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+#ifndef _FILE_MAP_H_
+#define _FILE_MAP_H_
+
+#include <stddef.h>
+
+/*___________________
+|
+| Type definitions
+|__________________*/
+
+typedef struct {
+  const void *data;         // start of mapped file (read-only)
+  size_t      size;         // size of file in bytes
+  void       *file_handle;
+  void       *map_handle;
+} FileMap;
+
+/*___________________
+|
+| Functions
+|__________________*/
+
+// Maps an entire file read-only into memory, returns true on success
+bool FileMap_Open (const char *filename, FileMap *map);
+
+// Unmaps a file
+void FileMap_Close (FileMap *map);
+
+#endif
@@ -0,0 +1,344 @@
+/*____________________________________________________________________
+|
+| File: file_watch.cpp
+|
+| Description: Reports files that changed on disk.  On Linux the
+|   directories holding the files are watched with inotify, so a change
+|   costs nothing until it happens.  Elsewhere, or if a directory can't
+|   be watched, files are polled: each call checks the size and modify
+|   time of a few files, so the cost per call stays small however many
+|   files are watched.
+|
+|   A file is reported once it has stopped changing for the settle
+|   time, so an editor writing a file in several steps (or writing a
+|   temporary file and renaming it) causes one report, after the write
+|   is complete.
+|
+| Functions: FileWatch_Create
+|            FileWatch_Free
+|            FileWatch_Add
+|            FileWatch_Next_Change
+|             Read_Events
+|             Poll_Files
+|             Get_File_Info
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+/*___________________
+|
+| Include Files
+|__________________*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <strings.h>
+#include <unistd.h>
+#endif
+
+#include "file_watch.h"
+
+/*___________________
+|
+| Constants
+|__________________*/
+
+#define MAX_FILES      128
+#define MAX_PATH_SIZE  260
+#define FILES_PER_POLL 8      // files checked per call when polling
+
+#ifdef _WIN32
+#define SEPARATOR '\\'
+#else
+#define SEPARATOR '/'
+#endif
+
+/*___________________
+|
+| Type definitions
+|__________________*/
+
+typedef struct {
+  char     name [MAX_PATH_SIZE];    // as passed to FileWatch_Add()
+  char     path [MAX_PATH_SIZE];    // with native separators
+  int      dir;                     // index of watched directory, or -1 if polled
+  unsigned size, time;              // last seen
+  bool     changed;
+  unsigned change_time;             // time of the last change seen
+} WatchFile;
+
+typedef struct {
+  int  wd;                          // inotify watch descriptor
+  char path [MAX_PATH_SIZE];
+} WatchDir;
+
+struct FileWatch {
+  WatchFile files [MAX_FILES];
+  int       num_files;
+  int       next_poll;              // next file to check when polling
+  unsigned  settle_time;
+  int       fd;                     // inotify instance, or -1
+  WatchDir  dirs [MAX_FILES];
+  int       num_dirs;
+};
+
+/*___________________
+|
+| Function Prototypes
+|__________________*/
+
+static void Read_Events (FileWatch *watch, unsigned time);
+static void Poll_Files (FileWatch *watch, unsigned time);
+static bool Get_File_Info (const char *path, unsigned *size, unsigned *time);
+
+/*____________________________________________________________________
+|
+| Function: FileWatch_Create
+|
+| Input: Called from ____
+| Output: Returns a new file watcher or 0 on any error.
+|___________________________________________________________________*/
+
+FileWatch *FileWatch_Create (unsigned settle_time)
+{
+  FileWatch *watch;
+
+  watch = (FileWatch *) calloc (1, sizeof(FileWatch));
+  if (watch) {
+    watch->settle_time = settle_time;
+#ifdef __linux__
+    watch->fd = inotify_init1 (IN_NONBLOCK | IN_CLOEXEC);
+#else
+    watch->fd = -1;
+#endif
+  }
+
+  return (watch);
+}
+
+/*____________________________________________________________________
+|
+| Function: FileWatch_Free
+|
+| Input: Called from ____
+| Output: Frees a file watcher.
+|___________________________________________________________________*/
+
+void FileWatch_Free (FileWatch *watch)
+{
+  if (watch) {
+#ifdef __linux__
+    if (watch->fd != -1)
+      close (watch->fd);
+#endif
+    free (watch);
+  }
+}
+
+/*____________________________________________________________________
+|
+| Function: FileWatch_Add
+|
+| Input: Called from ____
+| Output: Starts watching a file.  The file doesn't have to exist yet.
+|   Returns true on success or if the file is already watched, false if
+|   too many files are watched or the name is too long.
+|___________________________________________________________________*/
+
+bool FileWatch_Add (FileWatch *watch, const char *filename)
+{
+  int i;
+  char *s;
+  WatchFile *file;
+
+  if ((watch == 0) || (strlen (filename) >= MAX_PATH_SIZE))
+    return (false);
+  for (i=0; i<watch->num_files; i++)
+    if (strcmp (watch->files[i].name, filename) == 0)
+      return (true);
+  if (watch->num_files == MAX_FILES)
+    return (false);
+
+  file = &watch->files[watch->num_files++];
+  memset (file, 0, sizeof(WatchFile));
+  strcpy (file->name, filename);
+  strcpy (file->path, filename);
+  for (s=file->path; *s; s++)
+    if ((*s == '/') || (*s == '\\'))
+      *s = SEPARATOR;
+  Get_File_Info (file->path, &file->size, &file->time);
+  file->dir = -1;
+
+#ifdef __linux__
+  char dir [MAX_PATH_SIZE];
+  int wd;
+
+  if (watch->fd != -1) {
+    strcpy (dir, file->path);
+    s = strrchr (dir, '/');
+    if (s)
+      *s = 0;
+    else
+      strcpy (dir, ".");
+    for (i=0; (i<watch->num_dirs) && (strcmp (watch->dirs[i].path, dir) != 0); i++)
+      ;
+    if (i < watch->num_dirs)
+      file->dir = i;
+    else {
+      wd = inotify_add_watch (watch->fd, dir, IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+      if (wd != -1) {
+        watch->dirs[i].wd = wd;
+        strcpy (watch->dirs[i].path, dir);
+        watch->num_dirs++;
+        file->dir = i;
+      }
+    }
+  }
+#endif
+
+  return (true);
+}
+
+/*____________________________________________________________________
+|
+| Function: FileWatch_Next_Change
+|
+| Input: Called from ____
+| Output: Returns the name of a file that changed and has since been
+|   unchanged for the settle time, or 0 if there is none.  Each file is
+|   returned once per change.
+|___________________________________________________________________*/
+
+const char *FileWatch_Next_Change (FileWatch *watch, unsigned time)
+{
+  int i, pass;
+  WatchFile *file;
+
+  if (watch == 0)
+    return (0);
+
+  // Look for a settled change, checking for new changes only if there is none
+  for (pass=0; pass<2; pass++) {
+    for (i=0; i<watch->num_files; i++) {
+      file = &watch->files[i];
+      if (file->changed && (time - file->change_time >= watch->settle_time)) {
+        file->changed = false;
+        Get_File_Info (file->path, &file->size, &file->time);
+        return (file->name);
+      }
+    }
+    if (pass == 0) {
+      Read_Events (watch, time);
+      Poll_Files (watch, time);
+    }
+  }
+
+  return (0);
+}
+
+/*____________________________________________________________________
+|
+| Function: Read_Events
+|
+| Input: Called from FileWatch_Next_Change()
+| Output: Marks files changed for all pending inotify events.
+|___________________________________________________________________*/
+
+static void Read_Events (FileWatch *watch, unsigned time)
+{
+#ifdef __linux__
+  char buffer [4096] __attribute__ ((aligned (__alignof__ (struct inotify_event))));
+  const struct inotify_event *event;
+  const char *base;
+  ssize_t n;
+  int i, offset;
+  WatchFile *file;
+
+  if (watch->fd == -1)
+    return;
+
+  while ((n = read (watch->fd, buffer, sizeof(buffer))) > 0) {
+    for (offset=0; offset<n; offset+=sizeof(struct inotify_event)+event->len) {
+      event = (const struct inotify_event *) &buffer[offset];
+      if (event->len == 0)
+        continue;
+      for (i=0; i<watch->num_files; i++) {
+        file = &watch->files[i];
+        if ((file->dir == -1) || (watch->dirs[file->dir].wd != event->wd))
+          continue;
+        base = strrchr (file->path, '/');
+        base = base ? base + 1 : file->path;
+        // Asset names are written for Windows, so don't depend on case
+        if (strcasecmp (base, event->name) == 0) {
+          file->changed     = true;
+          file->change_time = time;
+        }
+      }
+    }
+  }
+#endif
+}
+
+/*____________________________________________________________________
+|
+| Function: Poll_Files
+|
+| Input: Called from FileWatch_Next_Change()
+| Output: Checks the next few polled files for a change in size or
+|   modify time.
+|___________________________________________________________________*/
+
+static void Poll_Files (FileWatch *watch, unsigned time)
+{
+  int i, n;
+  unsigned size, file_time;
+  WatchFile *file;
+
+  n = 0;
+  for (i=0; (i<watch->num_files) && (n<FILES_PER_POLL); i++) {
+    if (watch->next_poll >= watch->num_files)
+      watch->next_poll = 0;
+    file = &watch->files[watch->next_poll++];
+    if (file->dir != -1)
+      continue;
+    n++;
+    if (Get_File_Info (file->path, &size, &file_time) &&
+        ((size != file->size) || (file_time != file->time))) {
+      file->size        = size;
+      file->time        = file_time;
+      file->changed     = true;
+      file->change_time = time;
+    }
+  }
+}
+
+/*____________________________________________________________________
+|
+| Function: Get_File_Info
+|
+| Input: Called from FileWatch_Add(), FileWatch_Next_Change(),
+|   Poll_Files()
+| Output: Gets size and modify time of a file.  Returns true on success.
+|___________________________________________________________________*/
+
+static bool Get_File_Info (const char *path, unsigned *size, unsigned *time)
+{
+#ifdef _WIN32
+  struct _stat st;
+  if (_stat (path, &st) != 0)
+    return (false);
+#else
+  struct stat st;
+  if (stat (path, &st) != 0)
+    return (false);
+#endif
+  *size = (unsigned) st.st_size;
+  *time = (unsigned) st.st_mtime;
+
+  return (true);
+}
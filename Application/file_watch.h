@@ -0,0 +1,38 @@
+/*____________________________________________________________________
+|
+| File: file_watch.h
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+#ifndef _FILE_WATCH_H_
+#define _FILE_WATCH_H_
+
+/*___________________
+|
+| Type definitions
+|__________________*/
+
+typedef struct FileWatch FileWatch;
+
+/*___________________
+|
+| Functions
+|__________________*/
+
+// Creates a file watcher, returns 0 on any error
+FileWatch *FileWatch_Create (
+  unsigned settle_time );     // milliseconds a file must stop changing before it's reported
+
+// Stops watching and frees the watcher
+void FileWatch_Free (FileWatch *watch);
+
+// Watches a file (either separator), returns true on success or if already watched
+bool FileWatch_Add (FileWatch *watch, const char *filename);
+
+// Returns the name of a changed file (as passed to FileWatch_Add) or 0 if none,
+//   call with the current time in milliseconds until it returns 0
+const char *FileWatch_Next_Change (FileWatch *watch, unsigned time);
+
+#endif
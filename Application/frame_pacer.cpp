@@ -0,0 +1,352 @@
+/*____________________________________________________________________
+|
+| File: frame_pacer.cpp
+|
+| Description: Limits the frame rate by waiting at the top of each
+|   frame until it's due, before input is read, so the input a frame
+|   handles is as new as it can be when the frame is shown.  Deadlines
+|   are a fixed period apart, so a frame that starts late doesn't push
+|   back the ones after it.  A frame more than a period late starts a
+|   new schedule instead of the next frames rushing to catch up.
+|
+|   Waits sleep until shortly before the deadline, then spin for the
+|   rest.  How long before is learned from how late sleeps wake up: it
+|   grows quickly when a sleep wakes too late and shrinks slowly, so an
+|   occasional late wake up doesn't keep the thread spinning for long.
+|
+|   When page flips wait for the display (vsync), the frame rate is
+|   rounded to a whole number of refreshes and frames wait only until
+|   the refresh before the one they're to be shown at, letting the flip
+|   wait the rest.  Waiting on a schedule of its own would drift against
+|   the display's and now and then miss a refresh.
+|
+|   The time between page flips is kept for the latest frames, to
+|   report how evenly frames are shown.
+|
+| Functions: Frame_Pacer_Init
+|            Frame_Pacer_Set_Rate
+|            Frame_Pacer_Wait
+|            Frame_Pacer_Flip_Begin
+|            Frame_Pacer_Flip_End
+|            Frame_Pacer_Get_Stats
+|             Wait_Until
+|             Vsync
+|             Now_Us
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+/*___________________
+|
+| Include Files
+|__________________*/
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <chrono>
+#endif
+#include <math.h>
+#include <thread>
+
+#include "frame_pacer.h"
+
+/*___________________
+|
+| Constants
+|__________________*/
+
+#define SPIN_MIN_US     200     // always spin at least this long before a deadline
+#define SPIN_MAX_US     4000
+#define SPIN_START_US   1000    // how late sleeps wake up, until it's measured
+#define VSYNC_BLOCK_US  1000    // page flips taking longer than this on average are waiting for the display
+
+/*___________________
+|
+| Type definitions
+|__________________*/
+
+typedef struct {
+  unsigned interval;                // microseconds since the last page flip
+  unsigned target;                  // 0 if not limited
+  unsigned wait, spin;
+} Sample;
+
+/*___________________
+|
+| Function Prototypes
+|__________________*/
+
+static void      Wait_Until (long long deadline, long long now);
+static bool      Vsync ();
+static long long Now_Us ();
+
+/*___________________
+|
+| Global variables
+|__________________*/
+
+static long long period_us;         // 0 if not limited
+static long long refresh_us;        // 0 if unknown
+static long long next_deadline;     // 0 to start a new schedule
+static long long oversleep_us;      // how late sleeps wake up
+static long long flip_begin, last_flip_end;
+static long long flip_block_us;     // average time in a page flip
+static long long frame_target, frame_wait, frame_spin;
+
+static Sample    window [FRAME_PACER_WINDOW];
+static int       num_samples, next_sample;
+
+/*____________________________________________________________________
+|
+| Function: Frame_Pacer_Init
+|
+| Input: Called from Program_Run()
+| Output: Starts pacing frames, not limited until Frame_Pacer_Set_Rate()
+|   is called.
+|___________________________________________________________________*/
+
+void Frame_Pacer_Init (int refresh_rate)
+{
+  refresh_us    = (refresh_rate > 0) ? 1000000 / refresh_rate : 0;
+  period_us     = 0;
+  next_deadline = 0;
+  oversleep_us  = SPIN_START_US;
+  flip_begin    = 0;
+  last_flip_end = 0;
+  flip_block_us = 0;
+  frame_target  = 0;
+  frame_wait    = 0;
+  frame_spin    = 0;
+  num_samples   = 0;
+  next_sample   = 0;
+}
+
+/*____________________________________________________________________
+|
+| Function: Frame_Pacer_Set_Rate
+|
+| Input: Called from Program_Run()
+| Output: Sets the frames per second to limit to, 0 for no limit.  If
+|   it changes, starts a new schedule and empties the statistics.
+|___________________________________________________________________*/
+
+void Frame_Pacer_Set_Rate (int rate)
+{
+  long long period = (rate > 0) ? 1000000 / rate : 0;
+
+  if (period != period_us) {
+    period_us     = period;
+    next_deadline = 0;
+    num_samples   = 0;
+    next_sample   = 0;
+  }
+}
+
+/*____________________________________________________________________
+|
+| Function: Frame_Pacer_Wait
+|
+| Input: Called from Program_Run()
+| Output: Waits until the frame is due.
+|___________________________________________________________________*/
+
+void Frame_Pacer_Wait ()
+{
+  int refreshes;
+  long long now, deadline;
+
+  frame_target = period_us;
+  frame_wait   = 0;
+  frame_spin   = 0;
+  if (period_us == 0)
+    return;
+
+  now = Now_Us ();
+  if (Vsync () && last_flip_end) {
+    refreshes = (int)((period_us + refresh_us / 2) / refresh_us);
+    if (refreshes < 1)
+      refreshes = 1;
+    frame_target  = refreshes * refresh_us;
+    deadline      = last_flip_end + (refreshes - 1) * refresh_us;
+    next_deadline = 0;
+  }
+  else {
+    if ((next_deadline == 0) || (now - next_deadline > period_us))
+      next_deadline = now;
+    deadline = next_deadline;
+    next_deadline += period_us;
+  }
+
+  if (deadline > now)
+    Wait_Until (deadline, now);
+}
+
+/*____________________________________________________________________
+|
+| Function: Frame_Pacer_Flip_Begin
+|
+| Input: Called from Program_Run()
+| Output: Notes when the page flip started.
+|___________________________________________________________________*/
+
+void Frame_Pacer_Flip_Begin ()
+{
+  flip_begin = Now_Us ();
+}
+
+/*____________________________________________________________________
+|
+| Function: Frame_Pacer_Flip_End
+|
+| Input: Called from Program_Run()
+| Output: Averages how long page flips take and adds the time since
+|   the last flip to the window, dropping the oldest if it's full.
+|___________________________________________________________________*/
+
+void Frame_Pacer_Flip_End ()
+{
+  long long now = Now_Us ();
+  Sample *sample;
+
+  flip_block_us += ((now - flip_begin) - flip_block_us) / 8;
+
+  if (last_flip_end) {
+    sample = &window[next_sample];
+    sample->interval = (unsigned)(now - last_flip_end);
+    sample->target   = (unsigned) frame_target;
+    sample->wait     = (unsigned) frame_wait;
+    sample->spin     = (unsigned) frame_spin;
+    next_sample = (next_sample + 1) % FRAME_PACER_WINDOW;
+    if (num_samples < FRAME_PACER_WINDOW)
+      num_samples++;
+  }
+  last_flip_end = now;
+}
+
+/*____________________________________________________________________
+|
+| Function: Frame_Pacer_Get_Stats
+|
+| Input: Called from Program_Run()
+| Output: Fills in the statistics.  Returns false if there are no
+|   frames in the window.
+|___________________________________________________________________*/
+
+bool Frame_Pacer_Get_Stats (FramePacerStats *stats)
+{
+  int i;
+  double mean, error, sum = 0, sum_squares = 0, max_error = 0, wait = 0, spin = 0;
+
+  if (num_samples == 0)
+    return (false);
+
+  for (i=0; i<num_samples; i++) {
+    sum  += window[i].interval;
+    wait += window[i].wait;
+    spin += window[i].spin;
+  }
+  mean = sum / num_samples;
+  for (i=0; i<num_samples; i++) {
+    sum_squares += (window[i].interval - mean) * (window[i].interval - mean);
+    error = fabs (window[i].interval - (window[i].target ? (double) window[i].target : mean));
+    if (error > max_error)
+      max_error = error;
+  }
+
+  stats->frames       = num_samples;
+  stats->target_ms    = frame_target / 1000.0f;
+  stats->mean_ms      = (float)(mean / 1000);
+  stats->jitter_ms    = (float)(sqrt (sum_squares / num_samples) / 1000);
+  stats->max_error_ms = (float)(max_error / 1000);
+  stats->wait_ms      = (float)(wait / num_samples / 1000);
+  stats->spin_ms      = (float)(spin / num_samples / 1000);
+  stats->vsync        = Vsync ();
+
+  return (true);
+}
+
+/*____________________________________________________________________
+|
+| Function: Wait_Until
+|
+| Input: Called from Frame_Pacer_Wait()
+| Output: Sleeps until shortly before the deadline, then spins until
+|   it.  Learns how late sleeps wake up from this one.
+|___________________________________________________________________*/
+
+static void Wait_Until (long long deadline, long long now)
+{
+  long long start, spin_start, spin_us, sleep_us, late;
+
+  start   = now;
+  spin_us = oversleep_us + SPIN_MIN_US;
+  if (spin_us > SPIN_MAX_US)
+    spin_us = SPIN_MAX_US;
+
+  if (deadline - now > spin_us) {
+    sleep_us = deadline - now - spin_us;
+#ifdef _WIN32
+    // Whole milliseconds (see timeBeginPeriod()), the spin covers the rest
+    Sleep ((DWORD)(sleep_us / 1000));
+#else
+    std::this_thread::sleep_for (std::chrono::microseconds (sleep_us));
+#endif
+    now = Now_Us ();
+    late = (now - start) - sleep_us;
+    if (late < 0)
+      late = 0;
+    if (late > oversleep_us)
+      oversleep_us += (late - oversleep_us) / 4;
+    else
+      oversleep_us -= (oversleep_us - late) / 64;
+  }
+
+  spin_start = now;
+  while (now < deadline) {
+    std::this_thread::yield ();
+    now = Now_Us ();
+  }
+
+  frame_wait = now - start;
+  frame_spin = now - spin_start;
+}
+
+/*____________________________________________________________________
+|
+| Function: Vsync
+|
+| Input: Called from Frame_Pacer_Wait(), Frame_Pacer_Get_Stats()
+| Output: Returns true if page flips are waiting for the display.
+|___________________________________________________________________*/
+
+static bool Vsync ()
+{
+  return (refresh_us && (flip_block_us > VSYNC_BLOCK_US));
+}
+
+/*____________________________________________________________________
+|
+| Function: Now_Us
+|
+| Input: Called from Frame_Pacer_Wait(), Frame_Pacer_Flip_Begin(),
+|   Frame_Pacer_Flip_End(), Wait_Until()
+| Output: Returns microseconds on a monotonic high resolution clock,
+|   the performance counter on Windows (Visual Studio 2013's
+|   steady_clock is the system clock, too coarse to spin on).
+|___________________________________________________________________*/
+
+static long long Now_Us ()
+{
+#ifdef _WIN32
+  LARGE_INTEGER frequency, now;
+
+  QueryPerformanceFrequency (&frequency);
+  QueryPerformanceCounter (&now);
+  // Seconds and the rest apart, so ticks * 1000000 doesn't overflow after days of uptime
+  return (now.QuadPart / frequency.QuadPart * 1000000 + now.QuadPart % frequency.QuadPart * 1000000 / frequency.QuadPart);
+#else
+  return (std::chrono::duration_cast<std::chrono::microseconds> (std::chrono::steady_clock::now ().time_since_epoch ()).count ());
+#endif
+}
@@ -0,0 +1,57 @@
+/*____________________________________________________________________
+|
+| File: frame_pacer.h
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+#ifndef _FRAME_PACER_H_
+#define _FRAME_PACER_H_
+
+/*___________________
+|
+| Constants
+|__________________*/
+
+#define FRAME_PACER_WINDOW  256     // latest frames kept for the statistics
+
+/*___________________
+|
+| Type definitions
+|__________________*/
+
+typedef struct {
+  int   frames;                     // in the window
+  float target_ms;                  // frame time aimed for, 0 if not limited
+  float mean_ms;                    // between page flips
+  float jitter_ms;                  // standard deviation of the time between page flips
+  float max_error_ms;               // furthest from the target (or the mean if not limited)
+  float wait_ms;                    // mean wait per frame
+  float spin_ms;                    // part of the wait spent spinning instead of sleeping
+  bool  vsync;                      // page flips are waiting for the display
+} FramePacerStats;
+
+/*___________________
+|
+| Functions
+|__________________*/
+
+// Starts pacing frames, not limited until a rate is set
+void Frame_Pacer_Init (
+  int refresh_rate );               // of the display in Hz, 0 if unknown
+
+// Sets the frames per second to limit to (0 for no limit), emptying the statistics if it changes
+void Frame_Pacer_Set_Rate (int rate);
+
+// Waits for the next frame to start, call at the top of the frame before reading input
+void Frame_Pacer_Wait ();
+
+// Call just before and after the page flip
+void Frame_Pacer_Flip_Begin ();
+void Frame_Pacer_Flip_End ();
+
+// Gets statistics of the frames in the window, returns false if there are none
+bool Frame_Pacer_Get_Stats (FramePacerStats *stats);
+
+#endif
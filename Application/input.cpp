@@ -0,0 +1,71 @@
+/*____________________________________________________________________
+|
+| File: input.cpp
+|
+| Description: Reads all the user's input for a frame in one call.
+|   Every event queued since the last frame is copied into a frame
+|   local array, so a burst of key presses and releases is handled in
+|   the frame it arrives in instead of one event per frame.  Mouse
+|   motion isn't queued as events: the movement counters are read once
+|   per frame, coalescing however many moves the mouse made into one.
+|
+|   Each event is kept with the time the window captured it, for
+|   measuring the latency from input to the screen (see latency.cpp).
+|
+| Functions: Input_Begin
+|            Input_Drain
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+/*___________________
+|
+| Include Files
+|__________________*/
+
+#include <first_header.h>
+
+#include "dp.h"
+#include "..\Framework\win_support.h"
+
+#include "input.h"
+
+/*____________________________________________________________________
+|
+| Function: Input_Begin
+|
+| Input: Called from Program_Run()
+| Output: Empties the event queue and zeroes the mouse movement
+|   counters.
+|___________________________________________________________________*/
+
+void Input_Begin ()
+{
+  int move_x, move_y;
+
+  evFlushEvents ();
+  // Read the counters so the next read gets only movement from now on
+  msGetMouseMovement (&move_x, &move_y);
+}
+
+/*____________________________________________________________________
+|
+| Function: Input_Drain
+|
+| Input: Called from Program_Run()
+| Output: Fills in the input with every pending event and its capture
+|   time, up to INPUT_MAX_EVENTS (the rest stay queued for the next
+|   frame), and the mouse movement since the last call.
+|___________________________________________________________________*/
+
+void Input_Drain (InputFrame *input)
+{
+  input->num_events = 0;
+  while ((input->num_events < INPUT_MAX_EVENTS) AND evGetEvent (&input->events[input->num_events])) {
+    input->capture_times[input->num_events] = win_EventQueue_Capture_Time ();
+    input->num_events++;
+  }
+
+  msGetMouseMovement (&input->move_x, &input->move_y);
+}
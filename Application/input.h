@@ -0,0 +1,24 @@
+/*____________________________________________________________________
+|
+| File: input.h
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+#define INPUT_MAX_EVENTS  64    // events taken per frame, any more wait for the next frame
+
+// Everything the user did since the last frame
+typedef struct {
+  evEvent   events [INPUT_MAX_EVENTS];          // in the order they happened
+  long long capture_times [INPUT_MAX_EVENTS];   // when the window got each event (see Latency_Now())
+  int       num_events;
+  int       move_x, move_y;                     // mouse movement, all of it coalesced into one move
+} InputFrame;
+
+// Empties the event queue and zeroes the mouse movement, so the first frame only sees
+//   input from then on
+void Input_Begin ();
+
+// Takes every pending event and the mouse movement since the last call
+void Input_Drain (InputFrame *input);
@@ -0,0 +1,463 @@
+/*____________________________________________________________________
+|
+| File: job_pool.cpp
+|
+| Description: Work stealing pool of worker threads that runs short
+|   jobs.  Each thread has its own deque of queued jobs: it pushes the
+|   jobs it spawns onto the bottom and takes its next job from the
+|   bottom too, so it works on what it just split off while that data
+|   is still in its cache.  A thread with nothing left steals the oldest
+|   job from the top of another thread's deque, which is usually the
+|   biggest piece of work left there.  Each deque has its own lock, held
+|   only to push or take one job, so threads rarely wait on each other.
+|
+|   A parent job counts the children it spawns in a JobCounter and
+|   Job_Wait() returns once they're all done.  The waiting thread runs
+|   queued jobs (its own first) in the meantime instead of blocking, so
+|   the thread calling Job_Wait() or Job_Run() helps finish the work.
+|   Workers with nothing to steal sleep until a job is queued.
+|
+|   Graphs of jobs are built on top of this: jobs are added with the
+|   jobs they depend on (like the loader's jobs), then Job_Run() spawns
+|   every job with nothing to wait for.  As each job finishes, the jobs
+|   waiting only for it are spawned.  Job_Run() returns once the whole
+|   graph is done, and the next graph starts empty.
+|
+|   With no worker threads (one processor), the thread waiting runs
+|   every job itself.
+|
+| Functions: Job_Pool_Init
+|            Job_Pool_Free
+|            Job_Pool_Num_Threads
+|            Job_Spawn
+|            Job_Wait
+|            Job_Add
+|            Job_Add_Depend
+|            Job_Run
+|             Worker_Thread
+|             Take_Task
+|             Run_Task
+|             Run_Graph_Job
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+/*___________________
+|
+| Include Files
+|__________________*/
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "job_pool.h"
+
+/*___________________
+|
+| Constants
+|__________________*/
+
+#define MAX_JOBS         1024   // in a graph
+#define MAX_THREADS      8
+#define DEQUE_SIZE       1024   // queued jobs per thread, a job spawned onto a full deque runs at once
+#define CACHE_LINE_SIZE  64
+#define IDLE_SPINS       64     // tries to find a job before a worker sleeps
+
+// Visual Studio 2013 has no thread_local
+#ifdef _MSC_VER
+#define THREAD_LOCAL  __declspec(thread)
+#else
+#define THREAD_LOCAL  thread_local
+#endif
+
+/*___________________
+|
+| Type definitions
+|__________________*/
+
+typedef struct {
+  JobFunc     func;
+  void       *data;
+  JobCounter *counter;
+} Task;
+
+// Thread 0's deque is for any thread that isn't a worker (the program thread)
+typedef struct {
+  std::mutex lock;
+  Task       tasks [DEQUE_SIZE];
+  unsigned   top, bottom;                   // steal from the top, push and pop at the bottom
+  char       pad [CACHE_LINE_SIZE];
+} Deque;
+
+typedef struct {
+  JobFunc          func;
+  void            *data;
+  std::atomic<int> waiting;                 // jobs not yet done that this one depends on
+  int              dependents [JOB_MAX_DEPENDENTS];
+  int              num_dependents;
+} Job;
+
+/*___________________
+|
+| Function Prototypes
+|__________________*/
+
+static void Worker_Thread (int index);
+static bool Take_Task (int self, Task *task);
+static void Run_Task (Task *task);
+static void Run_Graph_Job (void *data);
+
+/*___________________
+|
+| Global variables
+|__________________*/
+
+static Deque                   deques [MAX_THREADS + 1];
+static int                     num_deques = 1;
+static THREAD_LOCAL int        this_deque;          // 0 unless a worker
+static std::atomic<int>        num_queued;          // in all deques
+static std::atomic<int>        num_sleeping;
+static std::mutex              sleep_lock;
+static std::condition_variable wake;
+static std::thread             threads [MAX_THREADS];
+static int                     num_threads;
+static bool                    quit;
+
+static Job                     jobs [MAX_JOBS];
+static int                     num_jobs;
+static int                     ready [MAX_JOBS];
+static JobCounter              graph_counter;
+
+/*____________________________________________________________________
+|
+| Function: Job_Pool_Init
+|
+| Input: Called from Program_Init()
+| Output: Starts the worker threads.  Returns true on success.  On
+|   failure jobs still run, on the thread waiting for them.
+|___________________________________________________________________*/
+
+bool Job_Pool_Init (int nthreads)
+{
+  int i;
+
+  if (nthreads == 0)
+    nthreads = (int) std::thread::hardware_concurrency () - 1;
+  if (nthreads < 0)
+    nthreads = 0;
+  if (nthreads > MAX_THREADS)
+    nthreads = MAX_THREADS;
+
+  for (i=0; i<=nthreads; i++)
+    deques[i].top = deques[i].bottom = 0;
+  num_deques  = nthreads + 1;
+  num_queued  = 0;
+  num_jobs    = 0;
+  num_threads = 0;
+  quit        = false;
+
+  try {
+    for (num_threads=0; num_threads<nthreads; num_threads++)
+      threads[num_threads] = std::thread (Worker_Thread, num_threads + 1);
+  }
+  catch (...) {
+    return (false);
+  }
+
+  return (true);
+}
+
+/*____________________________________________________________________
+|
+| Function: Job_Pool_Free
+|
+| Input: Called from Program_Free()
+| Output: Stops the worker threads.
+|___________________________________________________________________*/
+
+void Job_Pool_Free ()
+{
+  int i;
+
+  {
+    std::lock_guard<std::mutex> guard (sleep_lock);
+    quit = true;
+  }
+  wake.notify_all ();
+  for (i=0; i<num_threads; i++)
+    threads[i].join ();
+  num_threads = 0;
+  num_deques  = 1;
+}
+
+/*____________________________________________________________________
+|
+| Function: Job_Pool_Num_Threads
+|
+| Input: Called from ____
+| Output: Returns the number of worker threads.
+|___________________________________________________________________*/
+
+int Job_Pool_Num_Threads ()
+{
+  return (num_threads);
+}
+
+/*____________________________________________________________________
+|
+| Function: Job_Spawn
+|
+| Input: Called from ____ (any thread, including from inside a job)
+| Output: Pushes a job onto the calling thread's deque, waking a
+|   sleeping worker to take it.
+|___________________________________________________________________*/
+
+void Job_Spawn (JobFunc func, void *data, JobCounter *counter)
+{
+  bool pushed = false;
+  Task task;
+  Deque *deque = &deques[this_deque];
+
+  task.func    = func;
+  task.data    = data;
+  task.counter = counter;
+  if (counter)
+    counter->pending.fetch_add (1, std::memory_order_relaxed);
+
+  // Counted before it can be taken, so the count is never less than the jobs queued
+  num_queued.fetch_add (1);
+  {
+    std::lock_guard<std::mutex> guard (deque->lock);
+    if (deque->bottom - deque->top < DEQUE_SIZE) {
+      deque->tasks[deque->bottom % DEQUE_SIZE] = task;
+      deque->bottom++;
+      pushed = true;
+    }
+  }
+  if (! pushed) {
+    num_queued.fetch_sub (1);
+    Run_Task (&task);
+    return;
+  }
+
+  // A worker going to sleep counts itself before checking for jobs, so it sees this job or is woken
+  if (num_sleeping.load () > 0) {
+    { std::lock_guard<std::mutex> guard (sleep_lock); }
+    wake.notify_one ();
+  }
+}
+
+/*____________________________________________________________________
+|
+| Function: Job_Wait
+|
+| Input: Called from ____
+| Output: Runs queued jobs until the counter reaches zero.
+|___________________________________________________________________*/
+
+void Job_Wait (JobCounter *counter)
+{
+  Task task;
+
+  while (counter->pending.load (std::memory_order_acquire) > 0) {
+    if (Take_Task (this_deque, &task))
+      Run_Task (&task);
+    else
+      // What's left is running on other threads
+      std::this_thread::yield ();
+  }
+}
+
+/*____________________________________________________________________
+|
+| Function: Job_Add
+|
+| Input: Called from ____
+| Output: Adds a job to the next graph.  Returns the job id or -1 if
+|   too many jobs were added.
+|___________________________________________________________________*/
+
+int Job_Add (JobFunc func, void *data)
+{
+  Job *job;
+
+  if (num_jobs == MAX_JOBS)
+    return (-1);
+
+  job = &jobs[num_jobs];
+  job->func           = func;
+  job->data           = data;
+  job->waiting        = 0;
+  job->num_dependents = 0;
+
+  return (num_jobs++);
+}
+
+/*____________________________________________________________________
+|
+| Function: Job_Add_Depend
+|
+| Input: Called from ____
+| Output: Makes job wait for depend_job.  Returns false if either id
+|   is bad or depend_job already has too many dependents.
+|___________________________________________________________________*/
+
+bool Job_Add_Depend (int job, int depend_job)
+{
+  Job *depend;
+
+  if ((job < 0) || (job >= num_jobs) || (depend_job < 0) || (depend_job >= num_jobs) || (job == depend_job))
+    return (false);
+  depend = &jobs[depend_job];
+  if (depend->num_dependents == JOB_MAX_DEPENDENTS)
+    return (false);
+
+  depend->dependents[depend->num_dependents++] = job;
+  jobs[job].waiting++;
+
+  return (true);
+}
+
+/*____________________________________________________________________
+|
+| Function: Job_Run
+|
+| Input: Called from ____
+| Output: Runs the graph, helping on this thread, and empties it.
+|___________________________________________________________________*/
+
+void Job_Run ()
+{
+  int i, num_ready = 0;
+
+  // Find every job with nothing to wait for before spawning any, since a finished job
+  //   spawns the jobs it was the last wait of
+  for (i=0; i<num_jobs; i++)
+    if (jobs[i].waiting == 0)
+      ready[num_ready++] = i;
+  for (i=0; i<num_ready; i++)
+    Job_Spawn (Run_Graph_Job, &jobs[ready[i]], &graph_counter);
+  Job_Wait (&graph_counter);
+
+  num_jobs = 0;
+}
+
+/*____________________________________________________________________
+|
+| Function: Worker_Thread
+|
+| Input: Called from Job_Pool_Init()
+| Output: Worker thread.  Runs jobs until told to quit, sleeping when
+|   there are none.
+|___________________________________________________________________*/
+
+static void Worker_Thread (int index)
+{
+  int spins = 0;
+  Task task;
+
+  this_deque = index;
+  for (;;) {
+    if (Take_Task (index, &task)) {
+      Run_Task (&task);
+      spins = 0;
+    }
+    else if (++spins < IDLE_SPINS)
+      std::this_thread::yield ();
+    else {
+      std::unique_lock<std::mutex> guard (sleep_lock);
+      num_sleeping.fetch_add (1);
+      while ((! quit) && (num_queued.load () == 0))
+        wake.wait (guard);
+      num_sleeping.fetch_sub (1);
+      if (quit)
+        break;
+      spins = 0;
+    }
+  }
+}
+
+/*____________________________________________________________________
+|
+| Function: Take_Task
+|
+| Input: Called from Job_Wait(), Worker_Thread()
+| Output: Takes the newest job from this thread's deque, or failing
+|   that steals the oldest from another's.  Returns false if every
+|   deque is empty.
+|___________________________________________________________________*/
+
+static bool Take_Task (int self, Task *task)
+{
+  int i;
+  bool taken = false;
+  Deque *deque;
+
+  if (num_queued.load (std::memory_order_relaxed) == 0)
+    return (false);
+
+  deque = &deques[self];
+  {
+    std::lock_guard<std::mutex> guard (deque->lock);
+    if (deque->bottom != deque->top) {
+      deque->bottom--;
+      *task = deque->tasks[deque->bottom % DEQUE_SIZE];
+      taken = true;
+    }
+  }
+  // Start with the next thread's deque, so thieves spread out
+  for (i=1; (! taken) && (i<num_deques); i++) {
+    deque = &deques[(self + i) % num_deques];
+    std::lock_guard<std::mutex> guard (deque->lock);
+    if (deque->bottom != deque->top) {
+      *task = deque->tasks[deque->top % DEQUE_SIZE];
+      deque->top++;
+      taken = true;
+    }
+  }
+  if (taken)
+    num_queued.fetch_sub (1);
+
+  return (taken);
+}
+
+/*____________________________________________________________________
+|
+| Function: Run_Task
+|
+| Input: Called from Job_Spawn(), Job_Wait(), Worker_Thread()
+| Output: Runs a job, then counts it done.
+|___________________________________________________________________*/
+
+static void Run_Task (Task *task)
+{
+  (*task->func) (task->data);
+  if (task->counter)
+    task->counter->pending.fetch_sub (1, std::memory_order_release);
+}
+
+/*____________________________________________________________________
+|
+| Function: Run_Graph_Job
+|
+| Input: Called from Run_Task()
+| Output: Runs a job of the graph, then spawns the jobs that were
+|   waiting only for it.  They're spawned before this job is counted
+|   done, so the graph's counter can't reach zero early.
+|___________________________________________________________________*/
+
+static void Run_Graph_Job (void *data)
+{
+  int i, d;
+  Job *job = (Job *) data;
+
+  (*job->func) (job->data);
+
+  for (i=0; i<job->num_dependents; i++) {
+    d = job->dependents[i];
+    if (jobs[d].waiting.fetch_sub (1) == 1)
+      Job_Spawn (Run_Graph_Job, &jobs[d], &graph_counter);
+  }
+}
@@ -0,0 +1,65 @@
+/*____________________________________________________________________
+|
+| File: job_pool.h
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+#ifndef _JOB_POOL_H_
+#define _JOB_POOL_H_
+
+#include <atomic>
+
+/*___________________
+|
+| Constants
+|__________________*/
+
+#define JOB_MAX_DEPENDENTS 8    // max jobs that can wait for one job
+
+/*___________________
+|
+| Type definitions
+|__________________*/
+
+// Called on a worker thread or a thread waiting in Job_Run() or Job_Wait()
+typedef void (*JobFunc) (void *data);
+
+// Counts the unfinished jobs spawned by a parent (start it at zero: JobCounter counter = {};)
+typedef struct {
+  std::atomic<int> pending;
+} JobCounter;
+
+/*___________________
+|
+| Functions
+|__________________*/
+
+// Starts the worker threads, returns true on success
+bool Job_Pool_Init (
+  int num_threads );          // 0 = one less than the number of processors, -1 = none
+
+// Stops the worker threads
+void Job_Pool_Free ();
+
+// Returns the number of worker threads
+int Job_Pool_Num_Threads ();
+
+// Queues a job to run as soon as a thread is free, counted in counter until it's done
+//   (counter may be 0).  Jobs can spawn more jobs, on the same counter or their own.
+void Job_Spawn (JobFunc func, void *data, JobCounter *counter);
+
+// Runs queued jobs on this thread until every job counted in counter is done
+void Job_Wait (JobCounter *counter);
+
+// Adds a job to the graph run by the next Job_Run(), returns a job id or -1 if too many jobs
+int Job_Add (JobFunc func, void *data);
+
+// Makes a job wait for another job to finish, returns false if depend_job has too many dependents
+bool Job_Add_Depend (int job, int depend_job);
+
+// Runs every job added, each after the jobs it depends on, and returns when all are done
+void Job_Run ();
+
+#endif
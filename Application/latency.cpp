@@ -0,0 +1,228 @@
+/*____________________________________________________________________
+|
+| File: latency.cpp
+|
+| Description: Rolling histogram of input latency, from when an event
+|   is captured by the window to when the frame that handled it is
+|   flipped to the screen.  Events are stamped with Latency_Now() as
+|   they're captured, and each frame adds the latency of the events it
+|   handled once its page flip returns.
+|
+|   Only the latest LATENCY_WINDOW samples are kept, so the statistics
+|   follow what the game is doing now.  The histogram's buckets are
+|   updated as samples enter and leave the window, so adding a sample
+|   costs the same however many are kept.
+|
+| Functions: Latency_Now
+|            Latency_Reset
+|            Latency_Add
+|            Latency_Get_Stats
+|            Latency_Write
+|             Percentile
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+/*___________________
+|
+| Include Files
+|__________________*/
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <chrono>
+#endif
+#include <stdio.h>
+#include <string.h>
+
+#include "latency.h"
+
+/*___________________
+|
+| Function Prototypes
+|__________________*/
+
+static float Percentile (float percent);
+
+/*___________________
+|
+| Global variables
+|__________________*/
+
+static unsigned  window [LATENCY_WINDOW];           // microseconds, oldest at next_sample once full
+static int       num_samples, next_sample;
+static int       buckets [LATENCY_NUM_BUCKETS];
+static long long sum_us;
+
+/*____________________________________________________________________
+|
+| Function: Latency_Now
+|
+| Input: Called from CMainFrame::EventQueue_Add(), Latency_Add()
+| Output: Returns microseconds on a monotonic high resolution clock.
+|   On Windows that's the performance counter: Visual Studio 2013's
+|   steady_clock is the system clock, which ticks every 1 to 15.6 ms
+|   and can be set back.
+|___________________________________________________________________*/
+
+long long Latency_Now ()
+{
+#ifdef _WIN32
+  LARGE_INTEGER frequency, now;
+
+  QueryPerformanceFrequency (&frequency);
+  QueryPerformanceCounter (&now);
+  // Seconds and the rest apart, so ticks * 1000000 doesn't overflow after days of uptime
+  return (now.QuadPart / frequency.QuadPart * 1000000 + now.QuadPart % frequency.QuadPart * 1000000 / frequency.QuadPart);
+#else
+  return (std::chrono::duration_cast<std::chrono::microseconds> (std::chrono::steady_clock::now ().time_since_epoch ()).count ());
+#endif
+}
+
+/*____________________________________________________________________
+|
+| Function: Latency_Reset
+|
+| Input: Called from Program_Run()
+| Output: Empties the histogram.
+|___________________________________________________________________*/
+
+void Latency_Reset ()
+{
+  num_samples = 0;
+  next_sample = 0;
+  sum_us      = 0;
+  memset (buckets, 0, sizeof(buckets));
+}
+
+/*____________________________________________________________________
+|
+| Function: Latency_Add
+|
+| Input: Called from Program_Run()
+| Output: Adds a sample, dropping the oldest one if the window is full.
+|___________________________________________________________________*/
+
+void Latency_Add (long long capture_time)
+{
+  long long us;
+  int bucket;
+
+  us = Latency_Now () - capture_time;
+  if (us < 0)
+    us = 0;
+  else if (us > 0xFFFFFFFF)
+    us = 0xFFFFFFFF;
+
+  if (num_samples == LATENCY_WINDOW) {
+    bucket = window[next_sample] / LATENCY_BUCKET_US;
+    buckets[bucket < LATENCY_NUM_BUCKETS ? bucket : LATENCY_NUM_BUCKETS-1]--;
+    sum_us -= window[next_sample];
+  }
+  else
+    num_samples++;
+
+  window[next_sample] = (unsigned) us;
+  next_sample = (next_sample + 1) % LATENCY_WINDOW;
+  bucket = (int)(us / LATENCY_BUCKET_US);
+  buckets[bucket < LATENCY_NUM_BUCKETS ? bucket : LATENCY_NUM_BUCKETS-1]++;
+  sum_us += us;
+}
+
+/*____________________________________________________________________
+|
+| Function: Latency_Get_Stats
+|
+| Input: Called from Program_Run(), Latency_Write()
+| Output: Fills in the statistics.  Returns false if there are no
+|   samples.
+|___________________________________________________________________*/
+
+bool Latency_Get_Stats (LatencyStats *stats)
+{
+  int i;
+  unsigned max_us = 0;
+
+  if (num_samples == 0)
+    return (false);
+
+  for (i=0; i<num_samples; i++)
+    if (window[i] > max_us)
+      max_us = window[i];
+
+  stats->samples = num_samples;
+  stats->mean_ms = (float)(sum_us / 1000.0 / num_samples);
+  stats->p50_ms  = Percentile (50);
+  stats->p95_ms  = Percentile (95);
+  stats->p99_ms  = Percentile (99);
+  stats->max_ms  = max_us / 1000.0f;
+
+  return (true);
+}
+
+/*____________________________________________________________________
+|
+| Function: Latency_Write
+|
+| Input: Called from Program_Run()
+| Output: Writes the statistics and the histogram (one count per
+|   bucket, for graphing).  Returns true on success.
+|___________________________________________________________________*/
+
+bool Latency_Write (const char *filename)
+{
+  int i;
+  bool ok;
+  LatencyStats stats;
+  FILE *fp;
+
+  if (! Latency_Get_Stats (&stats))
+    return (false);
+  fp = fopen (filename, "w");
+  if (fp == 0)
+    return (false);
+
+  fprintf (fp, "{\n");
+  fprintf (fp, "  \"samples\": %d,\n", stats.samples);
+  fprintf (fp, "  \"latency_ms\": { \"mean\": %.3f, \"p50\": %.3f, \"p95\": %.3f, \"p99\": %.3f, \"max\": %.3f },\n",
+           stats.mean_ms, stats.p50_ms, stats.p95_ms, stats.p99_ms, stats.max_ms);
+  fprintf (fp, "  \"bucket_ms\": %.3f,\n", LATENCY_BUCKET_US / 1000.0f);
+  fprintf (fp, "  \"buckets\": [");
+  for (i=0; i<LATENCY_NUM_BUCKETS; i++)
+    fprintf (fp, "%s%d", i ? ", " : "", buckets[i]);
+  fprintf (fp, "]\n");
+  fprintf (fp, "}\n");
+
+  ok = (ferror (fp) == 0);
+  if (fclose (fp) != 0)
+    ok = false;
+
+  return (ok);
+}
+
+/*____________________________________________________________________
+|
+| Function: Percentile
+|
+| Input: Called from Latency_Get_Stats()
+| Output: Returns the upper edge in milliseconds of the bucket holding
+|   the nearest rank percentile.
+|___________________________________________________________________*/
+
+static float Percentile (float percent)
+{
+  int i, rank, count;
+
+  rank = (int)(percent / 100 * num_samples + 0.999f);
+  if (rank < 1)
+    rank = 1;
+  for (i=0, count=0; i<LATENCY_NUM_BUCKETS-1; i++) {
+    count += buckets[i];
+    if (count >= rank)
+      break;
+  }
+
+  return ((i + 1) * LATENCY_BUCKET_US / 1000.0f);
+}
@@ -0,0 +1,54 @@
+/*____________________________________________________________________
+|
+| File: latency.h
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+#ifndef _LATENCY_H_
+#define _LATENCY_H_
+
+/*___________________
+|
+| Constants
+|__________________*/
+
+#define LATENCY_WINDOW       1024   // latest samples kept in the histogram
+#define LATENCY_BUCKET_US    250    // width of a histogram bucket
+#define LATENCY_NUM_BUCKETS  201    // 0-50 ms, the last bucket holds anything longer
+
+/*___________________
+|
+| Type definitions
+|__________________*/
+
+typedef struct {
+  int   samples;                    // in the window
+  float mean_ms;
+  float p50_ms, p95_ms, p99_ms;     // upper edge of the bucket holding the percentile
+  float max_ms;
+} LatencyStats;
+
+/*___________________
+|
+| Functions
+|__________________*/
+
+// Returns a monotonic high resolution time in microseconds, for stamping input (any thread)
+long long Latency_Now ();
+
+// Empties the histogram
+void Latency_Reset ();
+
+// Adds the latency from a capture time (from Latency_Now()) to now
+void Latency_Add (long long capture_time);
+
+// Gets statistics of the samples in the window, returns false if there are none
+bool Latency_Get_Stats (LatencyStats *stats);
+
+// Writes the statistics and histogram buckets of the samples in the window as JSON,
+//   returns true on success
+bool Latency_Write (const char *filename);
+
+#endif
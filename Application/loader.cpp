@@ -0,0 +1,438 @@
+/*____________________________________________________________________
+|
+| File: loader.cpp
+|
+| Description: Background loader.  Loading is split in two stages: a
+|   pool of threads reads each job's files into memory in parallel, and
+|   the main thread finalizes jobs as soon as they're read and the jobs
+|   they depend on are finalized (calls into the GX toolkit, which isn't
+|   thread safe, happen here).  Jobs can finish out of the order they
+|   were queued in, so only dependencies order them: for example a
+|   motion depends on its skeleton to wait for it.  Finalizing is spread
+|   over frames by a per-call time budget so a screen can be drawn while
+|   loading.
+|
+|   Reading the files on the loader threads also leaves them in the file
+|   cache, so finalize functions that can only load by filename still
+|   read from memory.
+|
+|   Once every queued job is finalized the job table is reused, so jobs
+|   can keep being queued after loading (for example to reload assets).
+|
+|   Each file read and each finalize is traced, named by the job's first
+|   file, so the startup trace shows reads overlapping finalizes.
+|
+| Functions: Loader_Init
+|            Loader_Free
+|            Loader_Add
+|            Loader_Add_Depend
+|            Loader_Update
+|            Loader_Finish
+|            Loader_Done
+|            Loader_Get_Progress
+|             Loader_Thread
+|             Read_File
+|             Free_Job
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+/*___________________
+|
+| Include Files
+|__________________*/
+
+#include <windows.h>
+#include <mmsystem.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "trace.h"
+#include "loader.h"
+
+/*___________________
+|
+| Type definitions
+|__________________*/
+
+typedef struct {
+  volatile int state;           // JOB_STATE_...
+  LoaderFunc   finalize;
+  void        *data;
+  LoaderFile   files [LOADER_MAX_FILES];
+  int          num_files;
+  int          depends [LOADER_MAX_DEPENDS];
+  int          num_depends;
+} Job;
+
+/*___________________
+|
+| Function Prototypes
+|__________________*/
+
+static DWORD WINAPI Loader_Thread (LPVOID param);
+static void Read_File (LoaderFile *file);
+static void Free_Job (Job *job);
+
+/*___________________
+|
+| Constants
+|__________________*/
+
+#define MAX_JOBS    128
+#define MAX_THREADS 4
+
+#define JOB_STATE_QUEUED    0
+#define JOB_STATE_READ      1   // files read, waiting to be finalized
+#define JOB_STATE_FINALIZED 2
+
+/*___________________
+|
+| Global variables
+|__________________*/
+
+static Job              jobs [MAX_JOBS];
+static int              num_jobs;
+static int              next_read;      // next job for a loader thread to read
+static int              next_finalize;  // first job not yet finalized
+static int              num_finalized;
+static CRITICAL_SECTION lock;
+static HANDLE           work_ready;     // semaphore, one count per queued job
+static HANDLE           job_read;       // set each time a job is read
+static HANDLE           threads [MAX_THREADS];
+static int              num_threads;
+static volatile bool    quit;
+
+/*____________________________________________________________________
+|
+| Function: Loader_Init
+|
+| Input: Called from Program_Run()
+| Output: Starts the loader threads.  Returns true on success.  On
+|   failure the loader still works, but reads files on the main thread.
+|___________________________________________________________________*/
+
+bool Loader_Init (int nthreads)
+{
+  SYSTEM_INFO info;
+
+  if (nthreads <= 0) {
+    GetSystemInfo (&info);
+    nthreads = (int) info.dwNumberOfProcessors - 1;
+  }
+  if (nthreads < 1)
+    nthreads = 1;
+  if (nthreads > MAX_THREADS)
+    nthreads = MAX_THREADS;
+
+  memset (jobs, 0, sizeof(jobs));
+  num_jobs      = 0;
+  next_read     = 0;
+  next_finalize = 0;
+  num_finalized = 0;
+  num_threads   = 0;
+  quit          = false;
+
+  // Without loader threads, files are read on the main thread when finalizing
+  InitializeCriticalSection (&lock);
+  work_ready = CreateSemaphore (NULL, 0, MAX_JOBS + MAX_THREADS, NULL);
+  job_read   = CreateEvent (NULL, FALSE, FALSE, NULL);
+  if ((work_ready == NULL) || (job_read == NULL))
+    return (false);
+
+  for (num_threads=0; num_threads<nthreads; num_threads++) {
+    threads[num_threads] = CreateThread (NULL, 0, Loader_Thread, NULL, 0, NULL);
+    if (threads[num_threads] == NULL)
+      break;
+    // Keep the main thread responsive while files are read
+    SetThreadPriority (threads[num_threads], THREAD_PRIORITY_BELOW_NORMAL);
+  }
+
+  return (num_threads > 0);
+}
+
+/*____________________________________________________________________
+|
+| Function: Loader_Free
+|
+| Input: Called from Program_Run()
+| Output: Stops the loader threads and frees any files read for jobs
+|   that weren't finalized.
+|___________________________________________________________________*/
+
+void Loader_Free ()
+{
+  int i;
+
+  quit = true;
+  if (num_threads) {
+    ReleaseSemaphore (work_ready, num_threads, NULL);
+    WaitForMultipleObjects (num_threads, threads, TRUE, INFINITE);
+    for (i=0; i<num_threads; i++)
+      CloseHandle (threads[i]);
+    num_threads = 0;
+  }
+  if (work_ready)
+    CloseHandle (work_ready);
+  if (job_read)
+    CloseHandle (job_read);
+  work_ready = NULL;
+  job_read   = NULL;
+  DeleteCriticalSection (&lock);
+
+  for (i=0; i<num_jobs; i++)
+    Free_Job (&jobs[i]);
+  num_jobs = 0;
+}
+
+/*____________________________________________________________________
+|
+| Function: Loader_Add
+|
+| Input: Called from Program_Run()
+| Output: Queues a job.  Returns the job id or -1 if too many jobs are
+|   queued.  Job ids are only valid until all queued jobs are finalized.
+|___________________________________________________________________*/
+
+int Loader_Add (LoaderFunc finalize, void *data, char *filename, char *filename2)
+{
+  Job *job;
+  int id = -1;
+
+  EnterCriticalSection (&lock);
+  // Every job was read (so the loader threads are idle) and finalized, start over
+  if (num_finalized == num_jobs) {
+    num_jobs      = 0;
+    next_read     = 0;
+    next_finalize = 0;
+    num_finalized = 0;
+  }
+  if (num_jobs < MAX_JOBS) {
+    id  = num_jobs;
+    job = &jobs[id];
+    memset (job, 0, sizeof(Job));
+    job->state    = JOB_STATE_QUEUED;
+    job->finalize = finalize;
+    job->data     = data;
+    if (filename)
+      job->files[job->num_files++].filename = filename;
+    if (filename2)
+      job->files[job->num_files++].filename = filename2;
+    num_jobs++;
+  }
+  LeaveCriticalSection (&lock);
+
+  if ((id != -1) && work_ready)
+    ReleaseSemaphore (work_ready, 1, NULL);
+
+  return (id);
+}
+
+/*____________________________________________________________________
+|
+| Function: Loader_Add_Depend
+|
+| Input: Called from Program_Run()
+| Output: Makes job wait for depend_job to be finalized.  depend_job
+|   must have been queued before job.
+|___________________________________________________________________*/
+
+void Loader_Add_Depend (int job, int depend_job)
+{
+  if ((job >= 0) && (job < num_jobs) && (depend_job >= 0) && (depend_job < job) &&
+      (jobs[job].num_depends < LOADER_MAX_DEPENDS))
+    jobs[job].depends[jobs[job].num_depends++] = depend_job;
+}
+
+/*____________________________________________________________________
+|
+| Function: Loader_Update
+|
+| Input: Called from Program_Run()
+| Output: Finalizes jobs whose files are read and whose dependencies
+|   are finalized, checking them in the order queued but skipping any
+|   that aren't ready yet.  Always finalizes at least one ready job,
+|   then stops when budget milliseconds have passed.
+|___________________________________________________________________*/
+
+void Loader_Update (unsigned budget)
+{
+  int i, j, event;
+  unsigned start_time;
+  Job *job;
+  bool ready;
+
+  start_time = timeGetTime ();
+
+  for (i=next_finalize; i<num_jobs; i++) {
+    job = &jobs[i];
+    if ((job->state == JOB_STATE_QUEUED) && (num_threads == 0)) {
+      for (j=0; j<job->num_files; j++)
+        Read_File (&job->files[j]);
+      job->state = JOB_STATE_READ;
+    }
+    if (job->state != JOB_STATE_READ)
+      continue;
+    for (j=0, ready=true; (j<job->num_depends) && ready; j++)
+      ready = (jobs[job->depends[j]].state == JOB_STATE_FINALIZED);
+    if (! ready)
+      continue;
+
+    if (job->finalize) {
+      event = Trace_Begin ("finalize", job->num_files ? job->files[0].filename : "job");
+      (*job->finalize) (job->data, job->files, job->num_files);
+      Trace_End (event);
+    }
+    Free_Job (job);
+    job->state = JOB_STATE_FINALIZED;
+    num_finalized++;
+
+    if (timeGetTime () - start_time >= budget)
+      break;
+  }
+
+  while ((next_finalize < num_jobs) && (jobs[next_finalize].state == JOB_STATE_FINALIZED))
+    next_finalize++;
+}
+
+/*____________________________________________________________________
+|
+| Function: Loader_Finish
+|
+| Input: Called from Program_Run()
+| Output: Finalizes all queued jobs.
+|___________________________________________________________________*/
+
+void Loader_Finish ()
+{
+  while (! Loader_Done ()) {
+    Loader_Update (INFINITE);
+    if ((! Loader_Done ()) && job_read)
+      WaitForSingleObject (job_read, 10);
+  }
+}
+
+/*____________________________________________________________________
+|
+| Function: Loader_Done
+|
+| Input: Called from Program_Run()
+| Output: Returns true if all queued jobs have been finalized.
+|___________________________________________________________________*/
+
+bool Loader_Done ()
+{
+  return (num_finalized == num_jobs);
+}
+
+/*____________________________________________________________________
+|
+| Function: Loader_Get_Progress
+|
+| Input: Called from Program_Run()
+| Output: Gets the number of jobs finalized and the number queued.
+|___________________________________________________________________*/
+
+void Loader_Get_Progress (int *done, int *total)
+{
+  *done  = num_finalized;
+  *total = num_jobs;
+}
+
+/*____________________________________________________________________
+|
+| Function: Loader_Thread
+|
+| Input: Called from Loader_Init()
+| Output: Loader thread.  Reads the files for each queued job.
+|___________________________________________________________________*/
+
+static DWORD WINAPI Loader_Thread (LPVOID param)
+{
+  int i;
+  Job *job;
+
+  Trace_Name_Thread ("loader");
+
+  for (;;) {
+    WaitForSingleObject (work_ready, INFINITE);
+    if (quit)
+      break;
+
+    EnterCriticalSection (&lock);
+    job = (next_read < num_jobs) ? &jobs[next_read++] : 0;
+    LeaveCriticalSection (&lock);
+
+    if (job) {
+      for (i=0; (i<job->num_files) && (! quit); i++)
+        Read_File (&job->files[i]);
+      // Make sure file contents are visible to the main thread before the state change
+      MemoryBarrier ();
+      job->state = JOB_STATE_READ;
+      SetEvent (job_read);
+    }
+  }
+
+  return (0);
+}
+
+/*____________________________________________________________________
+|
+| Function: Read_File
+|
+| Input: Called from Loader_Thread()
+| Output: Reads an entire file into memory.  On error file->bytes is 0.
+|___________________________________________________________________*/
+
+static void Read_File (LoaderFile *file)
+{
+  FILE *fp;
+  long size;
+  int event;
+
+  event = Trace_Begin ("read", file->filename);
+  file->bytes = 0;
+  file->size  = 0;
+
+  fp = fopen (file->filename, "rb");
+  if (fp) {
+    fseek (fp, 0, SEEK_END);
+    size = ftell (fp);
+    fseek (fp, 0, SEEK_SET);
+    if (size > 0) {
+      file->bytes = malloc (size);
+      if (file->bytes) {
+        if (fread (file->bytes, size, 1, fp) == 1)
+          file->size = (unsigned) size;
+        else {
+          free (file->bytes);
+          file->bytes = 0;
+        }
+      }
+    }
+    fclose (fp);
+  }
+  Trace_End_Bytes (event, file->size);
+}
+
+/*____________________________________________________________________
+|
+| Function: Free_Job
+|
+| Input: Called from Loader_Update(), Loader_Free()
+| Output: Frees file contents read for a job.
+|___________________________________________________________________*/
+
+static void Free_Job (Job *job)
+{
+  int i;
+
+  for (i=0; i<job->num_files; i++) {
+    if (job->files[i].bytes)
+      free (job->files[i].bytes);
+    job->files[i].bytes = 0;
+    job->files[i].size  = 0;
+  }
+}
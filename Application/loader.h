@@ -0,0 +1,69 @@
+/*____________________________________________________________________
+|
+| File: loader.h
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+#ifndef _LOADER_H_
+#define _LOADER_H_
+
+/*___________________
+|
+| Constants
+|__________________*/
+
+#define LOADER_MAX_FILES   2    // max files read for one job
+#define LOADER_MAX_DEPENDS 4    // max jobs one job can depend on
+
+/*___________________
+|
+| Type definitions
+|__________________*/
+
+typedef struct {
+  char     *filename;
+  void     *bytes;              // contents of file, or 0 if it couldn't be read
+  unsigned  size;
+} LoaderFile;
+
+// Called on the main thread once a job's files are read and the jobs it
+//   depends on are finalized.  File contents are freed on return.
+typedef void (*LoaderFunc) (void *data, LoaderFile *files, int num_files);
+
+/*___________________
+|
+| Functions
+|__________________*/
+
+// Starts the loader threads, returns true on success
+bool Loader_Init (
+  int num_threads );          // 0 = one less than the number of processors
+
+// Stops the loader threads and drops any jobs not yet finalized
+void Loader_Free ();
+
+// Queues a job, returns a job id or -1 if too many jobs are queued
+int Loader_Add (
+  LoaderFunc finalize,
+  void      *data,
+  char      *filename,        // can be 0 for a job that reads no files
+  char      *filename2 );     // can be 0
+
+// Makes a job wait for another job to be finalized before it is finalized
+void Loader_Add_Depend (int job, int depend_job);
+
+// Finalizes ready jobs, stopping once budget milliseconds have been used
+void Loader_Update (unsigned budget);
+
+// Finalizes all jobs, waiting for them to be read as needed
+void Loader_Finish ();
+
+// Returns true if all queued jobs have been finalized
+bool Loader_Done ();
+
+// Gets the number of jobs finalized and the number queued
+void Loader_Get_Progress (int *done, int *total);
+
+#endif
@@ -10,6 +10,12 @@
 |								Set_Mouse_Cursor
 |             Program_Run
 |							 Init_Render_State
+|							 Load_Motion
+|							 Finalize_Sound
+|							 Finalize_Skeleton
+|							 Finalize_Motion
+|							 Finalize_Blend_Tree
+|							 Get_Benchmark_Options
 |             Program_Free
 |             Program_Immediate_Key_Handler
 |
@@ -30,7 +36,23 @@
 #include <rom8x8.h>
 
 #include "main.h"
+#include "camera.h"
 #include "position.h"
+#include "viewport.h"
+#include "input.h"
+#include "latency.h"
+#include "frame_pacer.h"
+#include "particle_queue.h"
+#include "assets.h"
+#include "loader.h"
+#include "music_stream.h"
+#include "trace.h"
+#include "pose_cache.h"
+#include "crowd.h"
+#include "job_pool.h"
+#include "camera_path.h"
+#include "benchmark.h"
+#include "benchmark_count.h"
 
 /*___________________
 |
@@ -42,6 +64,15 @@ typedef struct {
 	unsigned bitdepth;
 } UserPreferences;
 
+// Character animation data, set up by loader jobs
+typedef struct {
+	gx3dObject         **object;
+	gx3dMotionSkeleton **mskeleton;
+	gx3dMotion         **motion;
+	gx3dBlendNode      **bnode;
+	gx3dBlendTree      **btree;
+} CharacterLoad;
+
 /*___________________
 |
 | Function Prototypes
@@ -51,6 +82,11 @@ static int Init_Graphics(unsigned resolution, unsigned bitdepth, unsigned stenci
 static void Set_Mouse_Cursor();
 static void Init_Render_State();
 static gx3dMotion *Load_Motion(gx3dMotionSkeleton *mskeleton, char *filename, int fps, gx3dMotionMetadataRequest *metadata_requested, int num_metadata_requested, bool load_all_metadata);
+static void Finalize_Sound(void *data, LoaderFile *files, int num_files);
+static void Finalize_Skeleton(void *data, LoaderFile *files, int num_files);
+static void Finalize_Motion(void *data, LoaderFile *files, int num_files);
+static void Finalize_Blend_Tree(void *data, LoaderFile *files, int num_files);
+static bool Get_Benchmark_Options(char *path_filename, int *num_frames);
 
 /*___________________
 |
@@ -85,6 +121,36 @@ static gx3dMotion *Load_Motion(gx3dMotionSkeleton *mskeleton, char *filename, in
 #define NO_AUTO_TRACKING 0
 #define SCREENSHOT_FILENAME "screenshots\\screen"
 
+#define START_SCREEN_TIME 5000  // min milliseconds to show start screen
+#define LOADER_BUDGET     8     // milliseconds per frame spent finalizing loaded assets
+#define HOT_RELOAD        1     // reload assets when their files change
+#define TRACE_FILENAME    "startup_trace.json"  // startup timings, written once everything is loaded
+
+// Latency from input to the screen and frame pacing, logged every LATENCY_LOG_TIME with the latency
+//   histogram rewritten for graphing
+#define LATENCY_FILENAME  "input_latency.json"
+#define LATENCY_LOG_TIME  10000  // milliseconds
+#define LATENCY_EVENTS    (evTYPE_RAW_KEY_PRESS | evTYPE_RAW_KEY_RELEASE | evTYPE_MOUSE_LEFT_PRESS | evTYPE_MOUSE_RIGHT_PRESS)
+
+// Frames per second limits (0 for no limit), the benchmark isn't limited
+#define FRAME_RATE         120   // playing
+#define STATIC_FRAME_RATE  30    // start screen (once loaded) and game over screen, which don't change
+
+#define NUM_CROWD         200   // characters in the crowd (F5 shows it), sharing the character's skeleton
+#define CROWD_BUCKETS     8     // poses shared by the crowd
+
+#define CHASE_DISTANCE    25    // feet behind the character of the second camera (F3 shows it)
+#define CHASE_HEIGHT      15    // feet above the character
+
+// Benchmark mode (command line: -benchmark [path file] [-frames n]) flies the camera along a path
+//   over the scene with a fixed time step, then writes a report of the frame times and quits
+#define BENCHMARK_PATH_FILENAME   "benchmark.path"
+#define BENCHMARK_REPORT_FILENAME "benchmark.json"
+#define BENCHMARK_FRAMES          1800  // frames recorded
+#define BENCHMARK_FRAME_TIME      16    // simulated milliseconds per frame
+#define BENCHMARK_SEED            1     // for the scene's random placement
+#define RECORD_PATH_FILENAME      "recorded.path"  // F4 starts and stops recording the camera to this file
+
 /*____________________________________________________________________
 |
 | Function: Program_Get_User_Preferences
@@ -112,8 +178,8 @@ int Program_Get_User_Preferences(void **preferences)
 | Function: Program_Init
 |
 | Input: Called from CMainFrame::Start_Program_Thread()
-| Output: Starts graphics mode.  Returns # of user pages available if
-|       successful, else 0.
+| Output: Starts graphics mode and the job pool's worker threads.
+|       Returns # of user pages available if successful, else 0.
 |___________________________________________________________________*/
 
 int Program_Init(void *preferences, int *generate_keypress_events)
@@ -123,6 +189,9 @@ int Program_Init(void *preferences, int *generate_keypress_events)
 
 	if (user_preferences)
 		initialized = Init_Graphics(user_preferences->resolution, user_preferences->bitdepth, GRAPHICS_STENCILDEPTH, generate_keypress_events);
+	// Without worker threads, jobs run on the program thread when it waits for them
+	if (initialized AND (NOT Job_Pool_Init(0)))
+		debug_WriteFile("Program_Init(): can't start the job pool's worker threads");
 
 	return (initialized);
 }
@@ -138,7 +207,7 @@ int Program_Init(void *preferences, int *generate_keypress_events)
 
 static int Init_Graphics(unsigned resolution, unsigned bitdepth, unsigned stencildepth, int *generate_keypress_events)
 {
-	int num_pages;
+	int num_pages, trace_event;
 	byte *font_data;
 	unsigned font_size;
 
@@ -159,7 +228,9 @@ static int Init_Graphics(unsigned resolution, unsigned bitdepth, unsigned stenci
 	font_size = sizeof(font_data_rom8x8);
 
 	// Start graphics mode                                      
+	trace_event = Trace_Begin("startup", "gxStartGraphics");
 	num_pages = gxStartGraphics(resolution, bitdepth, stencildepth, MAX_VRAM_PAGES, GRAPHICS_DRIVER);
+	Trace_End(trace_event);
 	if (num_pages == MAX_VRAM_PAGES) {
 		// Init system, drawing fonts 
 		Pgm_system_font = gxLoadFontData(gxFONT_TYPE_GX, font_data, font_size);
@@ -167,12 +238,14 @@ static int Init_Graphics(unsigned resolution, unsigned bitdepth, unsigned stenci
 		gxSetFont(Pgm_system_font);
 
 		// Start event processing
+		trace_event = Trace_Begin("startup", "evStartEvents");
 		evStartEvents(evTYPE_MOUSE_LEFT_PRESS | evTYPE_MOUSE_RIGHT_PRESS |
 			evTYPE_MOUSE_LEFT_RELEASE | evTYPE_MOUSE_RIGHT_RELEASE |
 			evTYPE_MOUSE_WHEEL_BACKWARD | evTYPE_MOUSE_WHEEL_FORWARD |
 			//                   evTYPE_KEY_PRESS | 
 			evTYPE_RAW_KEY_PRESS | evTYPE_RAW_KEY_RELEASE,
 			AUTO_TRACKING, EVENT_DRIVER);
+		Trace_End(trace_event);
 		*generate_keypress_events = FALSE;  // true if using evTYPE_KEY_PRESS in the above mask
 
 		// Set a custom mouse cursor
@@ -221,7 +294,7 @@ static void Set_Mouse_Cursor()
 void Program_Run()
 {
 	int quit;
-	evEvent event;
+	evEvent *event;
 	gx3dDriverInfo dinfo;
 	gxColor color;
 	char str[256];
@@ -275,6 +348,27 @@ void Program_Run()
 	debug_WriteFile(str);
 	debug_WriteFile("__________________________________________");
 
+	/*____________________________________________________________________
+	|
+	| Benchmark mode
+	|___________________________________________________________________*/
+
+	char benchmark_path[MAX_PATH];
+	int benchmark_frames;
+	unsigned benchmark_time = 0;
+	CameraPath *camera_path = 0;
+	bool benchmark = Get_Benchmark_Options(benchmark_path, &benchmark_frames);
+	if (benchmark) {
+		camera_path = Camera_Path_Read(benchmark_path);
+		if (camera_path == 0) {
+			debug_WriteFile("Program_Run(): can't read the benchmark camera path, running normally");
+			benchmark = false;
+		}
+		// The same scene every run
+		else
+			srand(BENCHMARK_SEED);
+	}
+
 	/*____________________________________________________________________
 	|
 	| Initialize the sound library
@@ -283,15 +377,14 @@ void Program_Run()
 	snd_Init(22, 16, 2, 1, 1);
 	snd_SetListenerDistanceFactorToFeet(snd_3D_APPLY_NOW);
 
-	Sound  s_song, s_footstep, s_die, s_yeah, s_boom, s_over;
+	// Music is streamed from disk, starting now so it plays over the start screen
+	MusicStream *music = Music_Stream_Open("wav\\background.wav", true);
+	Music_Stream_Set_Volume(music, 90);
+	Music_Stream_Play(music);
 
-	s_song = snd_LoadSound("wav\\background.wav", snd_CONTROL_VOLUME, 0);
+	// Sounds are loaded by the loader
+	Sound  s_footstep = 0, s_die = 0, s_yeah = 0, s_boom = 0, s_over = 0;
 
-	s_footstep = snd_LoadSound("wav\\footstep.wav", snd_CONTROL_VOLUME, 0);
-	s_die = snd_LoadSound("wav\\die.wav", snd_CONTROL_VOLUME, 0);
-	s_yeah = snd_LoadSound("wav\\ping.wav", snd_CONTROL_VOLUME, 0);
-	s_boom = snd_LoadSound("wav\\boom.wav", snd_CONTROL_VOLUME, 0);
-	s_over = snd_LoadSound("wav\\gameover.wav", snd_CONTROL_VOLUME, 0);
 	/*____________________________________________________________________
 	|
 	| Initialize the graphics state
@@ -349,102 +442,134 @@ void Program_Run()
 
 	/*____________________________________________________________________
 	|
-	| Load 3D models
+	| Load the start screen, queue everything else
 	|___________________________________________________________________*/
 
-	gx3dParticleSystem psys_fire = Script_ParticleSystem_Create("fire.gxps");
-	gx3dParticleSystem psys_power = Script_ParticleSystem_Create("power.gxps");
+	Asset_Init();
+
+	// The start screen is loaded now so it can be drawn while the rest loads
+	int trace_event = Trace_Begin("startup", "Load start screen");
+	gx3dObject *obj_start;
+	obj_start = Asset_Load_Object("Objects\\game.lwo", gx3d_VERTEXFORMAT_DEFAULT, gx3d_DONT_LOAD_TEXTURES);
+	gx3dTexture tex_start = Asset_Load_Texture("Objects\\startscreen.bmp", 0, 0);
+	Trace_End(trace_event);
+
+	// Everything else is read by the loader threads and finalized on this thread between frames
+	int trace_loading = Trace_Begin("startup", "Load assets");
+	Loader_Init(0);
+
+	Loader_Add(Finalize_Sound, (void *)&s_footstep, "wav\\footstep.wav", 0);
+	Loader_Add(Finalize_Sound, (void *)&s_die, "wav\\die.wav", 0);
+	Loader_Add(Finalize_Sound, (void *)&s_yeah, "wav\\ping.wav", 0);
+	Loader_Add(Finalize_Sound, (void *)&s_boom, "wav\\boom.wav", 0);
+	Loader_Add(Finalize_Sound, (void *)&s_over, "wav\\gameover.wav", 0);
+
+	gx3dParticleSystem psys_fire = 0, psys_power = 0;
+	Asset_Load_Particle_System_Async("fire.gxps", &psys_fire);
+	Asset_Load_Particle_System_Async("power.gxps", &psys_power);
 
 	//Load character model
 	gx3dObject *obj_character;
-	gx3d_ReadLWO2File("Objects\\tifa.lwo", &obj_character, gx3d_VERTEXFORMAT_TEXCOORDS | gx3d_VERTEXFORMAT_WEIGHTS, gx3d_MERGE_DUPLICATE_VERTICES | gx3d_SMOOTH_DISCONTINUOUS_VERTICES | gx3d_DONT_LOAD_TEXTURES);
-	gx3dTexture tex_character = gx3d_InitTexture_File("Objects\\tifa_tex_d512.bmp", "Objects\\tifa_tex_d512_fa.bmp", 0);
-	mskeleton = gx3d_MotionSkeleton_Read_LWS_File("Objects\\tifa movement.lws");
-	// Load a motion
+	gx3dTexture tex_character;
 	gx3dMotion *motion1 = 0;
-	motion1 = Load_Motion(mskeleton, "Objects\\tifa_step.lws", 30, 0, 0, false);
-
-	// Create a blend tree                                                
-	gx3dBlendNode *bnode1;
-	gx3dBlendTree *btree1;
-	bnode1 = gx3d_BlendNode_Init(mskeleton, gx3d_BLENDNODE_TYPE_SINGLE); // create single input blending node (doesn't blend, just reads in)
-	gx3d_Motion_Set_Output(motion1, bnode1, gx3d_BLENDNODE_TRACK_0);  // set output of animation to blending node (track 0)
-
-	btree1 = gx3d_BlendTree_Init(mskeleton);            // create blendtree
-	gx3d_BlendTree_Add_Node(btree1, bnode1);             // add blending node to the tree
-	gx3d_BlendTree_Set_Output(btree1, obj_character->layer);  // set output of tree to a model object layer (containing vertices to be animated)
+	gx3dBlendNode *bnode1 = 0;
+	gx3dBlendTree *btree1 = 0;
+	CharacterLoad character_load = { &obj_character, &mskeleton, &motion1, &bnode1, &btree1 };
+	int job_character, job_skeleton, job_motion, job_blend_tree;
+	job_character = Asset_Load_Object_Async("Objects\\tifa.lwo", gx3d_VERTEXFORMAT_TEXCOORDS | gx3d_VERTEXFORMAT_WEIGHTS, gx3d_MERGE_DUPLICATE_VERTICES | gx3d_SMOOTH_DISCONTINUOUS_VERTICES | gx3d_DONT_LOAD_TEXTURES, &obj_character);
+	Asset_Load_Texture_Async("Objects\\tifa_tex_d512.bmp", "Objects\\tifa_tex_d512_fa.bmp", 0, &tex_character);
+	job_skeleton = Loader_Add(Finalize_Skeleton, (void *)&character_load, "Objects\\tifa movement.lws", 0);
+	// Load a motion (after the skeleton)
+	job_motion = Loader_Add(Finalize_Motion, (void *)&character_load, "Objects\\tifa_step.lws", 0);
+	Loader_Add_Depend(job_motion, job_skeleton);
+	// Create a blend tree (after the motion and the model it animates)
+	job_blend_tree = Loader_Add(Finalize_Blend_Tree, (void *)&character_load, 0, 0);
+	Loader_Add_Depend(job_blend_tree, job_motion);
+	Loader_Add_Depend(job_blend_tree, job_character);
 
 	// Load a 3D model																								
-	gx3d_ReadLWO2File("Objects\\tree2.lwo", &obj_tree, gx3d_VERTEXFORMAT_DEFAULT, gx3d_DONT_LOAD_TEXTURES);
+	Asset_Load_Object_Async("Objects\\tree2.lwo", gx3d_VERTEXFORMAT_DEFAULT, gx3d_DONT_LOAD_TEXTURES, &obj_tree);
 	// Load the same model but make sure mipmapping of the texture is turned off
-	gx3d_ReadLWO2File("Objects\\tree2.lwo", &obj_tree2, gx3d_VERTEXFORMAT_DEFAULT, gx3d_DONT_LOAD_TEXTURES | gx3d_DONT_GENERATE_MIPMAPS);
-	gx3dTexture tex_tree = gx3d_InitTexture_File("Objects\\Images\\leaves.bmp", 0, 0);
-	gx3dTexture tex_bark = gx3d_InitTexture_File("Objects\\Images\\bark_texture.bmp", 0, 0);
+	// (textures aren't loaded with the object so this shares obj_tree's geometry)
+	Asset_Load_Object_Async("Objects\\tree2.lwo", gx3d_VERTEXFORMAT_DEFAULT, gx3d_DONT_LOAD_TEXTURES | gx3d_DONT_GENERATE_MIPMAPS, &obj_tree2);
+	gx3dTexture tex_tree, tex_bark;
+	Asset_Load_Texture_Async("Objects\\Images\\leaves.bmp", 0, 0, &tex_tree);
+	Asset_Load_Texture_Async("Objects\\Images\\bark_texture.bmp", 0, 0, &tex_bark);
 
 	//Sky dome
-	gx3d_ReadLWO2File("Objects\\skydome.lwo", &obj_skydome, gx3d_VERTEXFORMAT_DEFAULT, gx3d_DONT_LOAD_TEXTURES);
-	gx3dTexture tex_skydome = gx3d_InitTexture_File("Objects\\Images\\bright_sky_d128.bmp", 0, 0);
+	Asset_Load_Object_Async("Objects\\skydome.lwo", gx3d_VERTEXFORMAT_DEFAULT, gx3d_DONT_LOAD_TEXTURES, &obj_skydome);
+	gx3dTexture tex_skydome;
+	Asset_Load_Texture_Async("Objects\\Images\\bright_sky_d128.bmp", 0, 0, &tex_skydome);
 
 	//Cloud dome
-	gx3d_ReadLWO2File("Objects\\clouddome.lwo", &obj_clouddome, gx3d_VERTEXFORMAT_DEFAULT, gx3d_DONT_LOAD_TEXTURES);
-	gx3dTexture tex_clouddome = gx3d_InitTexture_File("Objects\\purple_cloud.bmp", 0, 0);
+	Asset_Load_Object_Async("Objects\\clouddome.lwo", gx3d_VERTEXFORMAT_DEFAULT, gx3d_DONT_LOAD_TEXTURES, &obj_clouddome);
+	gx3dTexture tex_clouddome;
+	Asset_Load_Texture_Async("Objects\\purple_cloud.bmp", 0, 0, &tex_clouddome);
 
 	//Ghost
-	gx3d_ReadLWO2File("Objects\\billboard_ghost.lwo", &obj_ghost, gx3d_VERTEXFORMAT_DEFAULT, gx3d_DONT_LOAD_TEXTURES);
-	gx3dTexture tex_red_ghost = gx3d_InitTexture_File("Objects\\Images\\ghost_die.bmp", "Objects\\Images\\ghost_fa.bmp", 0);
+	Asset_Load_Object_Async("Objects\\billboard_ghost.lwo", gx3d_VERTEXFORMAT_DEFAULT, gx3d_DONT_LOAD_TEXTURES, &obj_ghost);
+	gx3dTexture tex_red_ghost;
+	Asset_Load_Texture_Async("Objects\\Images\\ghost_die.bmp", "Objects\\Images\\ghost_fa.bmp", 0, &tex_red_ghost);
 
 	//Hit
 	gx3dObject *obj_hit;
-	gx3d_ReadLWO2File("Objects\\hit.lwo", &obj_hit, gx3d_VERTEXFORMAT_DEFAULT, gx3d_DONT_LOAD_TEXTURES);
-	gx3dTexture tex_hit = gx3d_InitTexture_File("Objects\\yeah.bmp", "Objects\\yeah_fa.bmp", 0);
-	gx3dTexture tex_boom = gx3d_InitTexture_File("Objects\\boom.bmp", "Objects\\boom_fa.bmp", 0);
+	Asset_Load_Object_Async("Objects\\hit.lwo", gx3d_VERTEXFORMAT_DEFAULT, gx3d_DONT_LOAD_TEXTURES, &obj_hit);
+	gx3dTexture tex_hit, tex_boom;
+	Asset_Load_Texture_Async("Objects\\yeah.bmp", "Objects\\yeah_fa.bmp", 0, &tex_hit);
+	Asset_Load_Texture_Async("Objects\\boom.bmp", "Objects\\boom_fa.bmp", 0, &tex_boom);
 
 	//Ground
 	gx3dObject *obj_ground;
-	gx3d_ReadLWO2File("Objects\\ground.lwo", &obj_ground, gx3d_VERTEXFORMAT_DEFAULT, gx3d_DONT_LOAD_TEXTURES);
-	gx3dTexture tex_ground = gx3d_InitTexture_File("Objects\\sand.bmp", 0, 0);
+	Asset_Load_Object_Async("Objects\\ground.lwo", gx3d_VERTEXFORMAT_DEFAULT, gx3d_DONT_LOAD_TEXTURES, &obj_ground);
+	gx3dTexture tex_ground;
+	Asset_Load_Texture_Async("Objects\\sand.bmp", 0, 0, &tex_ground);
 
-	//Start screen
-	gx3dObject *obj_start;
-	gx3d_ReadLWO2File("Objects\\game.lwo", &obj_start, gx3d_VERTEXFORMAT_DEFAULT, gx3d_DONT_LOAD_TEXTURES);
-	gx3dTexture tex_start = gx3d_InitTexture_File("Objects\\startscreen.bmp", 0, 0);
-	gx3dTexture tex_over = gx3d_InitTexture_File("Objects\\gameover.bmp", 0, 0);
+	//Game over screen
+	gx3dTexture tex_over;
+	Asset_Load_Texture_Async("Objects\\gameover.bmp", 0, 0, &tex_over);
 
 	//flower
 	gx3dObject *obj_flower;
-	gx3d_ReadLWO2File("Objects\\flower.lwo", &obj_flower, gx3d_VERTEXFORMAT_DEFAULT, gx3d_DONT_LOAD_TEXTURES);
-	gx3dTexture tex_flower = gx3d_InitTexture_File("Objects\\flower.bmp", "Objects\\flower_fa.bmp", 0);
+	Asset_Load_Object_Async("Objects\\flower.lwo", gx3d_VERTEXFORMAT_DEFAULT, gx3d_DONT_LOAD_TEXTURES, &obj_flower);
+	gx3dTexture tex_flower;
+	Asset_Load_Texture_Async("Objects\\flower.bmp", "Objects\\flower_fa.bmp", 0, &tex_flower);
 
 	//grass
 	gx3dObject *obj_grass;
-	gx3d_ReadLWO2File("Objects\\grass.lwo", &obj_grass, gx3d_VERTEXFORMAT_DEFAULT, gx3d_DONT_LOAD_TEXTURES);
-	gx3dTexture tex_grass = gx3d_InitTexture_File("Objects\\grass.bmp", "Objects\\grass_fa.bmp", 0);
+	Asset_Load_Object_Async("Objects\\grass.lwo", gx3d_VERTEXFORMAT_DEFAULT, gx3d_DONT_LOAD_TEXTURES, &obj_grass);
+	gx3dTexture tex_grass;
+	Asset_Load_Texture_Async("Objects\\grass.bmp", "Objects\\grass_fa.bmp", 0, &tex_grass);
 
 	//power
 	gx3dObject *obj_power;
-	gx3d_ReadLWO2File("Objects\\power.lwo", &obj_power, gx3d_VERTEXFORMAT_DEFAULT, gx3d_DONT_LOAD_TEXTURES);
-	gx3dTexture tex_purple = gx3d_InitTexture_File("Objects\\tex_purple.bmp", 0, 0);
+	Asset_Load_Object_Async("Objects\\power.lwo", gx3d_VERTEXFORMAT_DEFAULT, gx3d_DONT_LOAD_TEXTURES, &obj_power);
+	gx3dTexture tex_purple;
+	Asset_Load_Texture_Async("Objects\\tex_purple.bmp", 0, 0, &tex_purple);
 
 	//explosion
 	gx3dObject *obj_explosion;
-	gx3d_ReadLWO2File("Objects\\explosion.lwo", &obj_explosion, gx3d_VERTEXFORMAT_DEFAULT, gx3d_DONT_LOAD_TEXTURES);
-	gx3dTexture tex_explosion = gx3d_InitTexture_File("Objects\\tex_fire.bmp", 0, 0);
+	Asset_Load_Object_Async("Objects\\explosion.lwo", gx3d_VERTEXFORMAT_DEFAULT, gx3d_DONT_LOAD_TEXTURES, &obj_explosion);
+	gx3dTexture tex_explosion;
+	Asset_Load_Texture_Async("Objects\\tex_fire.bmp", 0, 0, &tex_explosion);
 
 	//skull
 	gx3dObject *obj_die;
-	gx3d_ReadLWO2File("Objects\\die.lwo", &obj_die, gx3d_VERTEXFORMAT_DEFAULT, gx3d_DONT_LOAD_TEXTURES);
-	gx3dTexture tex_die = gx3d_InitTexture_File("Objects\\tex_die.bmp", "Objects\\die_fa.bmp", 0);
+	Asset_Load_Object_Async("Objects\\die.lwo", gx3d_VERTEXFORMAT_DEFAULT, gx3d_DONT_LOAD_TEXTURES, &obj_die);
+	gx3dTexture tex_die;
+	Asset_Load_Texture_Async("Objects\\tex_die.bmp", "Objects\\die_fa.bmp", 0, &tex_die);
 
 	//mountain
 	gx3dObject *obj_mountain;
-	gx3d_ReadLWO2File("Objects\\mountain.lwo", &obj_mountain, gx3d_VERTEXFORMAT_DEFAULT, gx3d_DONT_LOAD_TEXTURES);
-	gx3dTexture tex_mountain = gx3d_InitTexture_File("Objects\\tex_mountain.bmp", 0, 0);
+	Asset_Load_Object_Async("Objects\\mountain.lwo", gx3d_VERTEXFORMAT_DEFAULT, gx3d_DONT_LOAD_TEXTURES, &obj_mountain);
+	gx3dTexture tex_mountain;
+	Asset_Load_Texture_Async("Objects\\tex_mountain.bmp", 0, 0, &tex_mountain);
 
 	//tall tree
 	gx3dObject *obj_talltree;
-	gx3d_ReadLWO2File("Objects\\ptree6.lwo", &obj_talltree, gx3d_VERTEXFORMAT_DEFAULT, gx3d_DONT_LOAD_TEXTURES);
+	Asset_Load_Object_Async("Objects\\ptree6.lwo", gx3d_VERTEXFORMAT_DEFAULT, gx3d_DONT_LOAD_TEXTURES, &obj_talltree);
 	// Load the texture (with mipmaps)
-	gx3dTexture tex_talltree = gx3d_InitTexture_File("Objects\\Images\\ptree_d512.bmp", "Objects\\Images\\ptree_d512_fa.bmp", 0);
+	gx3dTexture tex_talltree;
+	Asset_Load_Texture_Async("Objects\\Images\\ptree_d512.bmp", "Objects\\Images\\ptree_d512_fa.bmp", 0, &tex_talltree);
 
 	//Power	
 #define NUM_POWER 15
@@ -502,6 +627,9 @@ void Program_Run()
 	}
 
 
+	// Particle systems are drawn after the opaque geometry, depth sorted
+	Particle_Queue_Init(NUM_POWER + NUM_EXPLOSION);
+
 	bool game_over = false;
 	int xmove = 0;
 	int ymove = 0;
@@ -566,12 +694,10 @@ void Program_Run()
 	| Flush input queue
 	|___________________________________________________________________*/
 
-	int move_x, move_y;	// mouse movement counters
+	InputFrame input;
 
-	// Flush input queue
-	evFlushEvents();
-	// Zero mouse movement counters
-	msGetMouseMovement(&move_x, &move_y);  // call this here so the next call will get movement that has occurred since it was called here                                    
+	// Flush input queue and zero mouse movement counters
+	Input_Begin();
 	// Hide mouse cursor
 	msHideMouse();
 
@@ -582,26 +708,47 @@ void Program_Run()
 
 	
 
-	
-	snd_PlaySound(s_song, 1);
-	snd_SetSoundVolume(s_song, 90);
-
-	
-
 	// Variables
 	unsigned elapsed_time, last_time, new_time;
 	unsigned start_time = timeGetTime();
 	bool force_update;
+	bool loaded;
+	PoseCache character_pose;
+	PoseTrack character_track = { 0, 0, 1 };
 	unsigned cmd_move;
 	float scale;
+	Camera chase_camera;
+	Viewport screen_view, viewports[VIEWPORT_MAX];
+	Camera *view_cameras[VIEWPORT_MAX];
+	int view_mode, num_views;
+	gx3dVector view_position, view_heading;
+	unsigned view_elapsed;
+	CameraPath *record_path = 0;
+	unsigned record_start = 0;
+	Crowd *crowd = 0;
+	bool show_crowd = false;
+	unsigned latency_log_time;
+	LatencyStats latency;
+	FramePacerStats pacing;
 
 
 	// Init loop variables
 	cmd_move = 0;
 	last_time = 0;
 	force_update = false;
+	loaded = false;
+	Pose_Cache_Invalidate(&character_pose);
+	Latency_Reset();
+	latency_log_time = start_time;
+	Frame_Pacer_Init(win_Get_Refresh_Rate());
+	// Sleeps wake up within about a millisecond instead of a timer tick (about 16 ms)
+	timeBeginPeriod(1);
 	play_animation = false;
 	take_screenshot = false;
+	view_mode = VIEWPORT_MODE_SINGLE;
+	// The start screen, HUD and game over screen are drawn full screen from the main camera
+	screen_view.rect = Pgm_screen;
+	screen_view.camera = Position_Get_Camera();
 
 	scale = ((float)rand()) / ((float)RAND_MAX)*2.0f + 1.0f;
 
@@ -618,6 +765,20 @@ void Program_Run()
 	// Game loop
 	for (quit = FALSE; NOT quit;) {
 
+		/*____________________________________________________________________
+		|
+		| Wait for the frame to be due
+		|___________________________________________________________________*/
+
+		// Waits before input is read, so the input handled is as new as it can be when the frame is shown
+		if (benchmark)
+			Frame_Pacer_Set_Rate(0);
+		else if (game_over OR (loaded AND (timeGetTime() - start_time < START_SCREEN_TIME)))
+			Frame_Pacer_Set_Rate(STATIC_FRAME_RATE);
+		else
+			Frame_Pacer_Set_Rate(FRAME_RATE);
+		Frame_Pacer_Wait();
+
 		angle += 0.5;
 		if (angle >= 360)
 			angle = 0;
@@ -648,83 +809,144 @@ void Program_Run()
 			elapsed_time = new_time - last_time;
 		last_time = new_time;
 
+		// A benchmark frame moves everything by the same time step, however long the last frame took
+		if (Benchmark_Running()) {
+			Benchmark_Begin_Frame();
+			benchmark_time += BENCHMARK_FRAME_TIME;
+			new_time = benchmark_time;
+			elapsed_time = BENCHMARK_FRAME_TIME;
+		}
+
+		/*____________________________________________________________________
+		|
+		| Finalize assets read by the loader
+		|___________________________________________________________________*/
+
+		// Once loaded, this finalizes assets reloaded because their files changed
+		Loader_Update(LOADER_BUDGET);
+		if (NOT loaded) {
+			if (Loader_Done()) {
+				loaded = true;
+				Trace_End(trace_loading);
+				Trace_Write(TRACE_FILENAME);
+				Asset_Report();
+				if (HOT_RELOAD AND (NOT benchmark))
+					Asset_Enable_Hot_Reload();
+			}
+		}
+		else
+			Asset_Update(new_time);
+
 		/*____________________________________________________________________
 		|
 		| Process user input
 		|___________________________________________________________________*/
 
-		// Any event ready?
-		if (evGetEvent(&event)) {
+		// Take every event since the last frame, so a burst of input is all handled now
+		Input_Drain(&input);
+		for (int e = 0; e < input.num_events; e++) {
+			event = &input.events[e];
+			// Until everything is loaded (or in benchmark mode) only ESC is handled
+			if ((NOT loaded) OR benchmark) {
+				if ((event->type == evTYPE_RAW_KEY_PRESS) AND (event->keycode == evKY_ESC))
+					quit = TRUE;
+			}
 			// key press?
-			if (event.type == evTYPE_RAW_KEY_PRESS)	{
+			else if (event->type == evTYPE_RAW_KEY_PRESS)	{
 				// If ESC pressed, exit the program
-				if (event.keycode == evKY_ESC)
+				if (event->keycode == evKY_ESC)
 					quit = TRUE;
-				else if (event.keycode == 'w') 
+				else if (event->keycode == 'w') 
 					cmd_move |= POSITION_MOVE_FORWARD;				
-				else if (event.keycode == 's') 
+				else if (event->keycode == 's') 
 					cmd_move |= POSITION_MOVE_BACK;
-				else if (event.keycode == 'a') 
+				else if (event->keycode == 'a') 
 					cmd_move |= POSITION_MOVE_LEFT;
-				else if (event.keycode == 'd') 
+				else if (event->keycode == 'd') 
 					cmd_move |= POSITION_MOVE_RIGHT;
 
-				else if (event.keycode == evKY_UP_ARROW) {
+				else if (event->keycode == evKY_UP_ARROW) {
 					facing = 180;
 					zmove -= 2;	
 					play_animation = true;
 					ani_time = -1;
 					snd_PlaySound(s_footstep, 0);
 				}
-				else if (event.keycode == evKY_DOWN_ARROW) {
+				else if (event->keycode == evKY_DOWN_ARROW) {
 					facing = 0;
 					zmove += 2;	
 					play_animation = true;
 					ani_time = -1;
 					snd_PlaySound(s_footstep, 0);
 				}
-				else if (event.keycode == evKY_LEFT_ARROW) {
+				else if (event->keycode == evKY_LEFT_ARROW) {
 					facing = 270;					
 					xmove -= 2;	
 					play_animation = true;
 					ani_time = -1;
 					snd_PlaySound(s_footstep, 0);
 				}
-				else if (event.keycode == evKY_RIGHT_ARROW) {
+				else if (event->keycode == evKY_RIGHT_ARROW) {
 					facing = 90;
 					xmove += 2;	
 					play_animation = true;
 					ani_time = -1;
 					snd_PlaySound(s_footstep, 0);
 				}
-				else if (event.keycode == evKY_F1)
+				else if (event->keycode == evKY_F1)
 					take_screenshot = true;
+				else if (event->keycode == evKY_F2)
+					Particle_Queue_Set_Sorting(NOT Particle_Queue_Get_Sorting());
+				else if (event->keycode == evKY_F3)
+					view_mode = (view_mode + 1) % VIEWPORT_NUM_MODES;
+				else if (event->keycode == evKY_F4) {
+					// Start recording the camera, or stop and write the recording
+					if (record_path == 0) {
+						record_path = Camera_Path_Create();
+						record_start = new_time;
+					}
+					else {
+						if (NOT Camera_Path_Write(record_path, RECORD_PATH_FILENAME))
+							debug_WriteFile("Program_Run(): can't write the recorded camera path");
+						Camera_Path_Free(record_path);
+						record_path = 0;
+					}
+				}
+				else if (event->keycode == evKY_F5) {
+					// A crowd playing the character's motion, loaded and placed the first time it's shown
+					if (crowd == 0) {
+						crowd = Crowd_Create(&mskeleton, CROWD_BUCKETS, NUM_CROWD);
+						Crowd_Load_Async(crowd, "Objects\\tifa.lwo", "Objects\\tifa_step.lws", gx3d_VERTEXFORMAT_TEXCOORDS | gx3d_VERTEXFORMAT_WEIGHTS, gx3d_MERGE_DUPLICATE_VERTICES | gx3d_SMOOTH_DISCONTINUOUS_VERTICES | gx3d_DONT_LOAD_TEXTURES, -1);
+						for (int i = 0; i < NUM_CROWD; i++)
+							Crowd_Add(crowd, (float)((rand() % 200) - 100), (float)((rand() % 200) - 100), (float)(rand() % 360), 2.5f, ((float)rand()) / ((float)RAND_MAX + 1));
+					}
+					show_crowd = NOT show_crowd;
+				}
 					
 			}
 			// key release?
-			else if (event.type == evTYPE_RAW_KEY_RELEASE) {
-				if (event.keycode == 'w')
+			else if (event->type == evTYPE_RAW_KEY_RELEASE) {
+				if (event->keycode == 'w')
 					cmd_move &= ~(POSITION_MOVE_FORWARD);
-				else if (event.keycode == 's')
+				else if (event->keycode == 's')
 					cmd_move &= ~(POSITION_MOVE_BACK);
-				else if (event.keycode == 'a')
+				else if (event->keycode == 'a')
 					cmd_move &= ~(POSITION_MOVE_LEFT);
-				else if (event.keycode == 'd')
+				else if (event->keycode == 'd')
 					cmd_move &= ~(POSITION_MOVE_RIGHT);
 			}
+		}
 
+		if (input.num_events > 0) {
 			//Footstep sound
 			if (cmd_move != 0) {
 			    if (! snd_IsPlaying(s_footstep))
 			        snd_PlaySound (s_footstep, 1);
 			}
-			else  {
+			else if (loaded) {
 			    snd_StopSound (s_footstep);			 
 			}
-
 		}
-		// Check for camera movement (via mouse)
-		msGetMouseMovement(&move_x, &move_y);
 
 		/*____________________________________________________________________
 		|
@@ -732,11 +954,41 @@ void Program_Run()
 		|___________________________________________________________________*/
 
 		bool position_changed, camera_changed;
-		Position_Update(elapsed_time, cmd_move, -move_y, move_x, force_update,
-			&position_changed, &camera_changed, &position, &heading);
+		if (benchmark AND loaded) {
+			// The camera flies along the path, looping
+			float path_position[3], path_heading[3];
+			Camera_Path_Sample(camera_path, fmodf(benchmark_time / 1000.0f, Camera_Path_Duration(camera_path)), path_position, path_heading);
+			Camera_Init(Position_Get_Camera(), path_position, path_heading);
+			position.x = path_position[0];
+			position.y = path_position[1];
+			position.z = path_position[2];
+			heading.x = path_heading[0];
+			heading.y = path_heading[1];
+			heading.z = path_heading[2];
+		}
+		else
+			Position_Update(elapsed_time, cmd_move, -input.move_y, input.move_x, force_update,
+				&position_changed, &camera_changed, &position, &heading);
+		if (record_path)
+			Camera_Path_Add(record_path, (new_time - record_start) / 1000.0f, Position_Get_Camera()->position, Position_Get_Camera()->heading);
 		snd_SetListenerPosition(position.x, position.y, position.z, snd_3D_APPLY_NOW);
 		snd_SetListenerOrientation(heading.x, heading.y, heading.z, 0, 1, 0, snd_3D_APPLY_NOW);
 
+		// The second camera follows behind the character
+		float chase_position[3], chase_heading[3];
+		chase_position[0] = xmove - sinf(facing * 3.14159265f / 180) * CHASE_DISTANCE;
+		chase_position[1] = ymove + CHASE_HEIGHT;
+		chase_position[2] = zmove - cosf(facing * 3.14159265f / 180) * CHASE_DISTANCE;
+		chase_heading[0] = xmove - chase_position[0];
+		chase_heading[1] = -CHASE_HEIGHT / 2.0f;
+		chase_heading[2] = zmove - chase_position[2];
+		Camera_Init(&chase_camera, chase_position, chase_heading);
+
+		// Lay out the viewports, updating each camera's frustum
+		num_views = Viewport_Layout(view_mode, &Pgm_screen, Position_Get_Camera(), &chase_camera, fov, near_plane, far_plane, viewports);
+		for (int i = 0; i < num_views; i++)
+			view_cameras[i] = viewports[i].camera;
+
 
 
 		/*____________________________________________________________________
@@ -748,13 +1000,14 @@ void Program_Run()
 		gx3d_ClearViewport(gx3d_CLEAR_SURFACE | gx3d_CLEAR_ZBUFFER, color, gx3d_MAX_ZBUFFER_VALUE, 0);
 		// Start rendering in 3D
 		if (gx3d_BeginRender()) {
+			Viewport_Begin(&screen_view);
 			// Set the default light
 			gx3d_SetAmbientLight(color3d_dim);
 			// Set the default material
 			gx3d_SetMaterial(&material_default);
 
-			//Draw start screen
-			if (timeGetTime() - start_time < 5000) { //10s
+			//Draw start screen (until everything is loaded)
+			if ((NOT loaded) OR ((NOT benchmark) AND (timeGetTime() - start_time < START_SCREEN_TIME))) {
 				gx3d_SetAmbientLight(color3d_white);
 				gx3d_DisableZBuffer();
 				gx3d_GetIdentityMatrix(&s);
@@ -766,31 +1019,21 @@ void Program_Run()
 			}
 			else {
 
-				//Draw ground
-				gx3d_SetAmbientLight(color3d_white);
-				gx3d_GetTranslateMatrix(&g, 0, 0, 0);
-				gx3d_SetObjectMatrix(obj_ground, &g);
-				gx3d_SetTexture(0, tex_ground);
-				gx3d_DrawObject(obj_ground, 0); 
-
-
-				// Enable alpha blending
-				gx3d_EnableAlphaBlending();
-				gx3d_EnableAlphaTesting(128);
+				// Animate the crowd, culled once against every view's camera
+				if (show_crowd)
+					Crowd_Update(crowd, new_time, view_cameras, num_views);
 
+				/*____________________________________________________________________
+				|
+				| Update the world (once per frame, however many views draw it)
+				|___________________________________________________________________*/
 
-				//Draw character
+				// Character bounding sphere, for catching falling items
 				characterSphere = obj_character->bound_sphere;
 				characterSphere.center.x = characterSphere.center.x*2.5 + xmove;
 				characterSphere.center.y = characterSphere.center.y*2.5 + ymove;
 				characterSphere.center.z = characterSphere.center.z*2.5 + zmove;
 				characterSphere.radius *= 2.5;
-				gx3d_GetScaleMatrix(&m1, 2.5, 2.5, 2.5);
-				gx3d_GetRotateYMatrix(&m2, facing);
-				gx3d_GetTranslateMatrix(&m3, xmove, ymove, zmove);				
-				gx3d_MultiplyMatrix(&m1, &m2, &m);
-				gx3d_MultiplyMatrix(&m, &m3, &m);
-				gx3d_SetObjectMatrix(obj_character, &m);
 
 				//Animation
 				// Play the animation, with looping
@@ -801,172 +1044,29 @@ void Program_Run()
 					// Add the elapsed frame time to the local timer for the animation
 					else
 						ani_time += elapsed_time;
-					// Update the animation based on the local timer          
-					gx3d_Motion_Update(motion1, ani_time / 1000.0f, false);
-					// Update the animation blend tree
-					gx3d_BlendTree_Update(btree1);
+					character_track.time = ani_time / 1000.0f;
 				}
 				// Just draw neutral pose (first keyframe in idle animation)
-				else {
-					gx3d_Motion_Update(motion1, 0, false); // keyframe 0 is a neutral pose
+				else
+					character_track.time = 0; // keyframe 0 is a neutral pose
+				// Update the animation and blend tree (which skins the character) only if the pose changed
+				character_track.motion = motion1;
+				if (Pose_Cache_Changed(&character_pose, &character_track, 1)) {
+					gx3d_Motion_Update(motion1, character_track.time, false);
 					gx3d_BlendTree_Update(btree1);
 				}
 
-				gx3d_SetTexture(0, tex_character);
-				gx3d_DrawObject(obj_character, 0);
-
-				gx3d_EnableLight(point_light1);
-
-				// Draw a tree
-				gx3d_GetScaleMatrix(&m1, 0.5, 0.5, 0.5);
-				gx3d_GetTranslateMatrix(&m2, -50, 0, 5);
-				gx3d_MultiplyMatrix(&m1, &m2, &m);
-				gx3d_SetObjectMatrix(obj_tree, &m);
-				gx3d_Object_UpdateTransforms(obj_tree);
-				// Draw 2 layer object, by layer
-				gx3dObjectLayer *layer;
-				layer = gx3d_GetObjectLayer(obj_tree, "trunk");
-				gx3d_SetTexture(0, tex_bark);
-				gx3d_DrawObjectLayer(layer, 0);
-				layer = gx3d_GetObjectLayer(obj_tree, "leaves");
-				gx3d_SetTexture(0, tex_tree);
-				gx3d_DrawObjectLayer(layer, 0);
-
-				// Draw a smaller tree
-				gx3d_GetScaleMatrix(&m1, 0.5, 0.35, 0.5);
-				gx3d_GetTranslateMatrix(&m2, 40, 0, -20);
-				gx3d_MultiplyMatrix(&m1, &m2, &m);
-				gx3d_SetObjectMatrix(obj_tree2, &m);
-				gx3d_Object_UpdateTransforms(obj_tree2);
-				// Draw 2 layer object, by layer
-				gx3dObjectLayer *layer1;
-				layer1 = gx3d_GetObjectLayer(obj_tree2, "trunk");
-				gx3d_SetTexture(0, tex_bark);
-				gx3d_DrawObjectLayer(layer1, 0);
-				layer1 = gx3d_GetObjectLayer(obj_tree2, "leaves");
-				gx3d_SetTexture(0, tex_tree);
-				gx3d_DrawObjectLayer(layer1, 0);
-
-				//Draw tall tree
-				gx3d_GetScaleMatrix(&m1, 1, 0.75, 1);
-				gx3d_GetTranslateMatrix(&m2, -60, 0, -5);
-				gx3d_MultiplyMatrix(&m1, &m2, &m);
-				gx3d_SetObjectMatrix(obj_talltree, &m);
-				gx3d_SetTexture(0, tex_talltree);
-				gx3d_DrawObject(obj_talltree, 0);
-
-				//Draw tall tree
-				gx3d_GetScaleMatrix(&m1, 1, 0.65, 1);
-				gx3d_GetTranslateMatrix(&m2, 60, 0, 0);
-				gx3d_MultiplyMatrix(&m1, &m2, &m);
-				gx3d_SetObjectMatrix(obj_talltree, &m);
-				gx3d_SetTexture(0, tex_talltree);
-				gx3d_DrawObject(obj_talltree, 0);
-				
-				gx3d_DisableLight(point_light1);
-
-				//Draw grass and flowers
-				for (int i = 0; i < 50; i++) {
-					gx3d_GetScaleMatrix(&m1, scale, scale, scale);
-					gx3d_GetTranslateMatrix(&m2, x_flower[i], 0, z_flower[i]);
-					gx3d_MultiplyMatrix(&m1, &m2, &m);
-					gx3d_SetObjectMatrix(obj_flower, &m);
-					gx3d_SetTexture(0, tex_flower);
-					gx3d_DrawObject(obj_flower, 0);
-				}
-
-				for (int j = 0; j < 50; j++) {
-					gx3d_GetTranslateMatrix(&m, x_grass[j], 0, z_grass[j]);
-					gx3d_SetObjectMatrix(obj_grass, &m);
-					gx3d_SetTexture(0, tex_grass);
-					gx3d_DrawObject(obj_grass, 0);
-				}
-
-				//Draw mountain
-				gx3d_GetScaleMatrix(&m1, 6, 6, 6);
-				gx3d_GetRotateYMatrix(&m2, 180);
-				gx3d_GetTranslateMatrix(&m3, 0, 0, 300);
-				gx3d_MultiplyMatrix(&m1, &m2, &mo);
-				gx3d_MultiplyMatrix(&mo, &m3, &mo);
-				gx3d_SetObjectMatrix(obj_mountain, &mo);
-				gx3d_SetTexture(0, tex_mountain);
-				gx3d_DrawObject(obj_mountain, 0);
-
-				gx3d_GetScaleMatrix(&m1, 6, 6, 6);
-				gx3d_GetRotateYMatrix(&m2, 180);
-				gx3d_GetTranslateMatrix(&m3, 120, 0, 300);
-				gx3d_MultiplyMatrix(&m1, &m2, &mo);
-				gx3d_MultiplyMatrix(&mo, &m3, &mo);
-				gx3d_SetObjectMatrix(obj_mountain, &mo);
-				gx3d_SetTexture(0, tex_mountain);
-				gx3d_DrawObject(obj_mountain, 0);
-
-				gx3d_GetScaleMatrix(&m1, 6, 6, 6);
-				gx3d_GetRotateYMatrix(&m2, 180);
-				gx3d_GetTranslateMatrix(&m3, -120, 0, 300);
-				gx3d_MultiplyMatrix(&m1, &m2, &mo);
-				gx3d_MultiplyMatrix(&mo, &m3, &mo);
-				gx3d_SetObjectMatrix(obj_mountain, &mo);
-				gx3d_SetTexture(0, tex_mountain);
-				gx3d_DrawObject(obj_mountain, 0);
-
-				gx3d_GetScaleMatrix(&m1, 6, 6, 6);
-				gx3d_GetRotateYMatrix(&m2, 180);
-				gx3d_GetTranslateMatrix(&m3, -240, 0, 300);
-				gx3d_MultiplyMatrix(&m1, &m2, &mo);
-				gx3d_MultiplyMatrix(&mo, &m3, &mo);
-				gx3d_SetObjectMatrix(obj_mountain, &mo);
-				gx3d_SetTexture(0, tex_mountain);
-				gx3d_DrawObject(obj_mountain, 0);
-
-				gx3d_DisableAlphaTesting();
-
-				// Draw skydome
-				gx3d_SetAmbientLight(color3d_white);
-				gx3d_DisableLight(dir_light);
-				gx3d_GetScaleMatrix(&m1, 500, 500, 500);
-				gx3d_SetTexture(0, tex_skydome);
-				gx3d_SetObjectMatrix(obj_skydome, &m1);
-				gx3d_DrawObject(obj_skydome, 0);
-
-				// Draw clouds
-				static float offset = 0;
-				offset += 0.001;
-				if (offset > 1.0)
-					offset = 0;
-
-				static float angle = 0;
-				angle += 1;
-				if (angle == 360)
-					angle = 0;
-
-				// Turn on fog
-				//gx3d_EnableFog();
-				//gx3d_SetFogColor(0, 0, 0);
-				//			gx3d_SetLinearPixelFog (450, 550);
-				//gx3d_SetExp2PixelFog(0.005);  // 0-1
-
-				gx3d_SetAmbientLight(color3d_white);
-				gx3d_EnableTextureMatrix(0);
-				gx3d_GetTranslateTextureMatrix(&m, -0.5, -0.5);
-				gx3d_GetRotateTextureMatrix(&m2, angle);
-				gx3d_GetTranslateTextureMatrix(&m3, 0.5, 0.5);
-				gx3d_MultiplyMatrix(&m, &m2, &m);
-				gx3d_MultiplyMatrix(&m, &m3, &m);
-				gx3d_SetTextureMatrix(0, &m);
-
-				gx3d_GetScaleMatrix(&m1, 500, 500, 500);
-				gx3d_SetObjectMatrix(obj_clouddome, &m1);
-				gx3d_SetTexture(0, tex_clouddome);
-				gx3d_DrawObject(obj_clouddome, 0);
-
-				gx3d_DisableTextureMatrix(0);				
-				gx3d_DisableLight(dir_light);
-
-				// Turn off fog
-				//gx3d_DisableFog();
-
-				//Draw power
+				// Turn the clouds
+				static float cloud_offset = 0;
+				static float cloud_angle = 0;
+				cloud_offset += 0.001;
+				if (cloud_offset > 1.0)
+					cloud_offset = 0;
+				cloud_angle += 1;
+				if (cloud_angle == 360)
+					cloud_angle = 0;
+
+				//Drop power, a power that reaches the ground costs a life
 				for (int i = 0; i < NUM_POWER; i++) {
 					powerPosition[i].y -= powerSpeed[i];
 					if (powerPosition[i].y <= 0) {
@@ -978,7 +1078,7 @@ void Program_Run()
 					}
 				}
 
-				static gx3dVector billboard_normal = { 0, 0, 1 };
+				//Catch power
 				gxRelation powerRelation;
 				for (int i = 0; i < NUM_POWER; i++) {
 					if (powerDraw[i]) {
@@ -996,25 +1096,10 @@ void Program_Run()
 							hitTimer[hitIndex] = 500;// +elapsed_time;
 							hitIndex = (hitIndex + 1) % MAX_HIT;	
 						}
-						if (powerDraw[i]) {
-							gx3d_GetScaleMatrix(&m1, 1.5, 1.5, 1.5);
-							gx3d_GetBillboardRotateYMatrix(&m2, &billboard_normal, &heading);
-							gx3d_GetTranslateMatrix(&m3, powerPosition[i].x, powerPosition[i].y, powerPosition[i].z);
-							gx3d_MultiplyMatrix(&m1, &m2, &m);
-							gx3d_MultiplyMatrix(&m, &m3, &m);
-							gx3d_SetObjectMatrix(obj_power, &m);
-							gx3d_SetTexture(0, tex_purple);
-							gx3d_DrawObject(obj_power, 0);
-
-							//Draw partical system
-							gx3d_SetParticleSystemMatrix(psys_power, &m);
-							gx3d_UpdateParticleSystem(psys_power, elapsed_time);
-							gx3d_DrawParticleSystem(psys_power, &heading, false);
-						}
 					}
 				}
 
-				//Draw explosion
+				//Drop explosion
 				for (int i = 0; i < NUM_EXPLOSION; i++) {
 					exPosition[i].y -= exSpeed[i];
 					if (exPosition[i].y <= 0) {
@@ -1022,6 +1107,7 @@ void Program_Run()
 					}
 				}
 
+				//Catch explosion, which costs a life
 				gxRelation exRelation;
 				for (int i = 0; i < NUM_EXPLOSION; i++) {
 					if (exDraw[i]) {
@@ -1044,9 +1130,226 @@ void Program_Run()
 								game_over = true;
 							}
 						}
+					}
+				}
+
+				//Update hit makers timers
+				for (int i = 0; i < MAX_HIT; i++) {
+					if (hitTimer[i] > 0)
+						hitTimer[i] -= elapsed_time;
+				}
+				for (int i = 0; i < exMAX_HIT; i++) {
+					if (exhitTimer[i] > 0)
+						exhitTimer[i] -= elapsed_time;
+				}
+
+				/*____________________________________________________________________
+				|
+				| Draw the world in each view
+				|___________________________________________________________________*/
+
+				for (int view = 0; view < num_views; view++) {
+					Viewport_Begin(&viewports[view]);
+					if (view > 0)
+						gx3d_ClearViewport(gx3d_CLEAR_SURFACE | gx3d_CLEAR_ZBUFFER, color, gx3d_MAX_ZBUFFER_VALUE, 0);
+					Viewport_Get_Camera(&viewports[view], &view_position, &view_heading);
+					// Particle systems are updated as they're drawn, so they move in the first view only
+					view_elapsed = (view == 0) ? elapsed_time : 0;
+
+					Particle_Queue_Begin(&view_position, &view_heading, near_plane, far_plane);
+
+					//Draw ground
+					gx3d_SetAmbientLight(color3d_white);
+					gx3d_GetTranslateMatrix(&g, 0, 0, 0);
+					gx3d_SetObjectMatrix(obj_ground, &g);
+					gx3d_SetTexture(0, tex_ground);
+					gx3d_DrawObject(obj_ground, 0); 
+
+
+					// Enable alpha blending
+					gx3d_EnableAlphaBlending();
+					gx3d_EnableAlphaTesting(128);
+
+
+					//Draw character
+					gx3d_GetScaleMatrix(&m1, 2.5, 2.5, 2.5);
+					gx3d_GetRotateYMatrix(&m2, facing);
+					gx3d_GetTranslateMatrix(&m3, xmove, ymove, zmove);				
+					gx3d_MultiplyMatrix(&m1, &m2, &m);
+					gx3d_MultiplyMatrix(&m, &m3, &m);
+					gx3d_SetObjectMatrix(obj_character, &m);
+
+					gx3d_SetTexture(0, tex_character);
+					gx3d_DrawObject(obj_character, 0);
+
+					// Draw the crowd (same texture)
+					if (show_crowd)
+						Crowd_Draw(crowd, view);
+
+					gx3d_EnableLight(point_light1);
+
+					// Draw a tree
+					gx3d_GetScaleMatrix(&m1, 0.5, 0.5, 0.5);
+					gx3d_GetTranslateMatrix(&m2, -50, 0, 5);
+					gx3d_MultiplyMatrix(&m1, &m2, &m);
+					gx3d_SetObjectMatrix(obj_tree, &m);
+					gx3d_Object_UpdateTransforms(obj_tree);
+					// Draw 2 layer object, by layer
+					gx3dObjectLayer *layer;
+					layer = gx3d_GetObjectLayer(obj_tree, "trunk");
+					gx3d_SetTexture(0, tex_bark);
+					gx3d_DrawObjectLayer(layer, 0);
+					layer = gx3d_GetObjectLayer(obj_tree, "leaves");
+					gx3d_SetTexture(0, tex_tree);
+					gx3d_DrawObjectLayer(layer, 0);
+
+					// Draw a smaller tree
+					gx3d_GetScaleMatrix(&m1, 0.5, 0.35, 0.5);
+					gx3d_GetTranslateMatrix(&m2, 40, 0, -20);
+					gx3d_MultiplyMatrix(&m1, &m2, &m);
+					gx3d_SetObjectMatrix(obj_tree2, &m);
+					gx3d_Object_UpdateTransforms(obj_tree2);
+					// Draw 2 layer object, by layer
+					gx3dObjectLayer *layer1;
+					layer1 = gx3d_GetObjectLayer(obj_tree2, "trunk");
+					gx3d_SetTexture(0, tex_bark);
+					gx3d_DrawObjectLayer(layer1, 0);
+					layer1 = gx3d_GetObjectLayer(obj_tree2, "leaves");
+					gx3d_SetTexture(0, tex_tree);
+					gx3d_DrawObjectLayer(layer1, 0);
+
+					//Draw tall tree
+					gx3d_GetScaleMatrix(&m1, 1, 0.75, 1);
+					gx3d_GetTranslateMatrix(&m2, -60, 0, -5);
+					gx3d_MultiplyMatrix(&m1, &m2, &m);
+					gx3d_SetObjectMatrix(obj_talltree, &m);
+					gx3d_SetTexture(0, tex_talltree);
+					gx3d_DrawObject(obj_talltree, 0);
+
+					//Draw tall tree
+					gx3d_GetScaleMatrix(&m1, 1, 0.65, 1);
+					gx3d_GetTranslateMatrix(&m2, 60, 0, 0);
+					gx3d_MultiplyMatrix(&m1, &m2, &m);
+					gx3d_SetObjectMatrix(obj_talltree, &m);
+					gx3d_SetTexture(0, tex_talltree);
+					gx3d_DrawObject(obj_talltree, 0);
+				
+					gx3d_DisableLight(point_light1);
+
+					//Draw grass and flowers
+					for (int i = 0; i < 50; i++) {
+						gx3d_GetScaleMatrix(&m1, scale, scale, scale);
+						gx3d_GetTranslateMatrix(&m2, x_flower[i], 0, z_flower[i]);
+						gx3d_MultiplyMatrix(&m1, &m2, &m);
+						gx3d_SetObjectMatrix(obj_flower, &m);
+						gx3d_SetTexture(0, tex_flower);
+						gx3d_DrawObject(obj_flower, 0);
+					}
+
+					for (int j = 0; j < 50; j++) {
+						gx3d_GetTranslateMatrix(&m, x_grass[j], 0, z_grass[j]);
+						gx3d_SetObjectMatrix(obj_grass, &m);
+						gx3d_SetTexture(0, tex_grass);
+						gx3d_DrawObject(obj_grass, 0);
+					}
+
+					//Draw mountain
+					gx3d_GetScaleMatrix(&m1, 6, 6, 6);
+					gx3d_GetRotateYMatrix(&m2, 180);
+					gx3d_GetTranslateMatrix(&m3, 0, 0, 300);
+					gx3d_MultiplyMatrix(&m1, &m2, &mo);
+					gx3d_MultiplyMatrix(&mo, &m3, &mo);
+					gx3d_SetObjectMatrix(obj_mountain, &mo);
+					gx3d_SetTexture(0, tex_mountain);
+					gx3d_DrawObject(obj_mountain, 0);
+
+					gx3d_GetScaleMatrix(&m1, 6, 6, 6);
+					gx3d_GetRotateYMatrix(&m2, 180);
+					gx3d_GetTranslateMatrix(&m3, 120, 0, 300);
+					gx3d_MultiplyMatrix(&m1, &m2, &mo);
+					gx3d_MultiplyMatrix(&mo, &m3, &mo);
+					gx3d_SetObjectMatrix(obj_mountain, &mo);
+					gx3d_SetTexture(0, tex_mountain);
+					gx3d_DrawObject(obj_mountain, 0);
+
+					gx3d_GetScaleMatrix(&m1, 6, 6, 6);
+					gx3d_GetRotateYMatrix(&m2, 180);
+					gx3d_GetTranslateMatrix(&m3, -120, 0, 300);
+					gx3d_MultiplyMatrix(&m1, &m2, &mo);
+					gx3d_MultiplyMatrix(&mo, &m3, &mo);
+					gx3d_SetObjectMatrix(obj_mountain, &mo);
+					gx3d_SetTexture(0, tex_mountain);
+					gx3d_DrawObject(obj_mountain, 0);
+
+					gx3d_GetScaleMatrix(&m1, 6, 6, 6);
+					gx3d_GetRotateYMatrix(&m2, 180);
+					gx3d_GetTranslateMatrix(&m3, -240, 0, 300);
+					gx3d_MultiplyMatrix(&m1, &m2, &mo);
+					gx3d_MultiplyMatrix(&mo, &m3, &mo);
+					gx3d_SetObjectMatrix(obj_mountain, &mo);
+					gx3d_SetTexture(0, tex_mountain);
+					gx3d_DrawObject(obj_mountain, 0);
+
+					gx3d_DisableAlphaTesting();
+
+					// Draw skydome
+					gx3d_SetAmbientLight(color3d_white);
+					gx3d_DisableLight(dir_light);
+					gx3d_GetScaleMatrix(&m1, 500, 500, 500);
+					gx3d_SetTexture(0, tex_skydome);
+					gx3d_SetObjectMatrix(obj_skydome, &m1);
+					gx3d_DrawObject(obj_skydome, 0);
+
+					// Draw clouds
+					// Turn on fog
+					//gx3d_EnableFog();
+					//gx3d_SetFogColor(0, 0, 0);
+					//			gx3d_SetLinearPixelFog (450, 550);
+					//gx3d_SetExp2PixelFog(0.005);  // 0-1
+
+					gx3d_SetAmbientLight(color3d_white);
+					gx3d_EnableTextureMatrix(0);
+					gx3d_GetTranslateTextureMatrix(&m, -0.5, -0.5);
+					gx3d_GetRotateTextureMatrix(&m2, cloud_angle);
+					gx3d_GetTranslateTextureMatrix(&m3, 0.5, 0.5);
+					gx3d_MultiplyMatrix(&m, &m2, &m);
+					gx3d_MultiplyMatrix(&m, &m3, &m);
+					gx3d_SetTextureMatrix(0, &m);
+
+					gx3d_GetScaleMatrix(&m1, 500, 500, 500);
+					gx3d_SetObjectMatrix(obj_clouddome, &m1);
+					gx3d_SetTexture(0, tex_clouddome);
+					gx3d_DrawObject(obj_clouddome, 0);
+
+					gx3d_DisableTextureMatrix(0);				
+					gx3d_DisableLight(dir_light);
+
+					// Turn off fog
+					//gx3d_DisableFog();
+
+					//Draw power
+					static gx3dVector billboard_normal = { 0, 0, 1 };
+					for (int i = 0; i < NUM_POWER; i++) {
+						if (powerDraw[i]) {
+							gx3d_GetScaleMatrix(&m1, 1.5, 1.5, 1.5);
+							gx3d_GetBillboardRotateYMatrix(&m2, &billboard_normal, &view_heading);
+							gx3d_GetTranslateMatrix(&m3, powerPosition[i].x, powerPosition[i].y, powerPosition[i].z);
+							gx3d_MultiplyMatrix(&m1, &m2, &m);
+							gx3d_MultiplyMatrix(&m, &m3, &m);
+							gx3d_SetObjectMatrix(obj_power, &m);
+							gx3d_SetTexture(0, tex_purple);
+							gx3d_DrawObject(obj_power, 0);
+
+							//Queue partical system
+							Particle_Queue_Add(psys_power, &m, view_elapsed);
+						}
+					}
+
+					//Draw explosion
+					for (int i = 0; i < NUM_EXPLOSION; i++) {
 						if (exDraw[i]) {
 							gx3d_GetScaleMatrix(&m1, 1.5, 1.5, 1.5);
-							gx3d_GetBillboardRotateYMatrix(&m2, &billboard_normal, &heading);
+							gx3d_GetBillboardRotateYMatrix(&m2, &billboard_normal, &view_heading);
 							gx3d_GetTranslateMatrix(&m3, exPosition[i].x, exPosition[i].y, exPosition[i].z);
 							gx3d_MultiplyMatrix(&m1, &m2, &m);
 							gx3d_MultiplyMatrix(&m, &m3, &m);
@@ -1054,70 +1357,60 @@ void Program_Run()
 							gx3d_SetTexture(0, tex_explosion);
 							gx3d_DrawObject(obj_explosion, 0);
 
-							//Draw partical system
-							gx3d_SetParticleSystemMatrix(psys_fire, &m);
-							gx3d_UpdateParticleSystem(psys_fire, elapsed_time);
-							gx3d_DrawParticleSystem(psys_fire, &heading, false);
+							//Queue partical system
+							Particle_Queue_Add(psys_fire, &m, view_elapsed);
 						}
 					}
-				}
-
-				
 
-				/*____________________________________________________________________
-				|
-				| Process hit makers
-				|___________________________________________________________________*/
+					//Draw all particle systems (back-to-front when sorting is on)
+					Particle_Queue_Draw(&view_heading);
 
-				const float HIT_SCALE = 3;
-				//Update hit makers timer
-				for (int i = 0; i < MAX_HIT; i++) {
-					if (hitTimer[i] > 0)
-						hitTimer[i] -= elapsed_time;
-				}
+					/*____________________________________________________________________
+					|
+					| Draw hit makers
+					|___________________________________________________________________*/
 
-				//Draw any hit makers
-				gx3d_EnableAlphaBlending();
-				gx3d_EnableAlphaTesting(128);
-				for (int i = 0; i < MAX_HIT; i++) {
-					if (hitTimer[i] > 0) {
-						gx3d_GetScaleMatrix(&m1, HIT_SCALE, HIT_SCALE, HIT_SCALE);
-						gx3d_GetBillboardRotateYMatrix(&m2, &billboard_normal, &heading);
-						float y = hitPosition[i].y + (1 - (hitTimer[i] / 1000.0f))*(2 * HIT_SCALE);
-						gx3d_GetTranslateMatrix(&m3, hitPosition[i].x, y + 12, hitPosition[i].z);
-						gx3d_MultiplyMatrix(&m1, &m2, &m);
-						gx3d_MultiplyMatrix(&m, &m3, &m);
-						gx3d_SetObjectMatrix(obj_hit, &m);
-						gx3d_SetTexture(0, tex_hit);
-						gx3d_DrawObject(obj_hit, 0);
+					const float HIT_SCALE = 3;
+					//Draw any hit makers
+					gx3d_EnableAlphaBlending();
+					gx3d_EnableAlphaTesting(128);
+					for (int i = 0; i < MAX_HIT; i++) {
+						if (hitTimer[i] > 0) {
+							gx3d_GetScaleMatrix(&m1, HIT_SCALE, HIT_SCALE, HIT_SCALE);
+							gx3d_GetBillboardRotateYMatrix(&m2, &billboard_normal, &view_heading);
+							float y = hitPosition[i].y + (1 - (hitTimer[i] / 1000.0f))*(2 * HIT_SCALE);
+							gx3d_GetTranslateMatrix(&m3, hitPosition[i].x, y + 12, hitPosition[i].z);
+							gx3d_MultiplyMatrix(&m1, &m2, &m);
+							gx3d_MultiplyMatrix(&m, &m3, &m);
+							gx3d_SetObjectMatrix(obj_hit, &m);
+							gx3d_SetTexture(0, tex_hit);
+							gx3d_DrawObject(obj_hit, 0);
+						}
 					}
-				}
 
-				//exploision
-				const float exHIT_SCALE = 3;
-				//Update hit makers timer
-				for (int i = 0; i < exMAX_HIT; i++) {
-					if (exhitTimer[i] > 0)
-						exhitTimer[i] -= elapsed_time;
-				}
-
-				//Draw any hit makers
-				for (int i = 0; i < exMAX_HIT; i++) {
-					if (exhitTimer[i] > 0) {
-						gx3d_GetScaleMatrix(&m1, exHIT_SCALE, exHIT_SCALE, exHIT_SCALE);
-						gx3d_GetBillboardRotateYMatrix(&m2, &billboard_normal, &heading);
-						float y = exhitPosition[i].y + (1 - (exhitTimer[i] / 1000.0f))*(2 * exHIT_SCALE);
-						gx3d_GetTranslateMatrix(&m3, exhitPosition[i].x, y + 12, exhitPosition[i].z);
-						gx3d_MultiplyMatrix(&m1, &m2, &m);
-						gx3d_MultiplyMatrix(&m, &m3, &m);
-						gx3d_SetObjectMatrix(obj_hit, &m);
-						gx3d_SetTexture(0, tex_boom);
-						gx3d_DrawObject(obj_hit, 0);
+					//exploision
+					const float exHIT_SCALE = 3;
+					//Draw any hit makers
+					for (int i = 0; i < exMAX_HIT; i++) {
+						if (exhitTimer[i] > 0) {
+							gx3d_GetScaleMatrix(&m1, exHIT_SCALE, exHIT_SCALE, exHIT_SCALE);
+							gx3d_GetBillboardRotateYMatrix(&m2, &billboard_normal, &view_heading);
+							float y = exhitPosition[i].y + (1 - (exhitTimer[i] / 1000.0f))*(2 * exHIT_SCALE);
+							gx3d_GetTranslateMatrix(&m3, exhitPosition[i].x, y + 12, exhitPosition[i].z);
+							gx3d_MultiplyMatrix(&m1, &m2, &m);
+							gx3d_MultiplyMatrix(&m, &m3, &m);
+							gx3d_SetObjectMatrix(obj_hit, &m);
+							gx3d_SetTexture(0, tex_boom);
+							gx3d_DrawObject(obj_hit, 0);
+						}
 					}
+
+					gx3d_DisableAlphaBlending();
+					gx3d_DisableAlphaTesting();
 				}
 
-				gx3d_DisableAlphaBlending();
-				gx3d_DisableAlphaTesting();
+				// Back to the full screen for the 2D graphics
+				Viewport_Begin(&screen_view);
 
 				/*____________________________________________________________________
 				|
@@ -1158,7 +1451,7 @@ void Program_Run()
 
 				//Game over
 				if (game_over) { 
-					snd_StopSound(s_song);
+					Music_Stream_Stop(music);
 					snd_StopSound(s_yeah);
 					snd_StopSound(s_boom);
 					snd_PlaySound(s_over, 0);										
@@ -1196,33 +1489,84 @@ void Program_Run()
 			}
 
 			// Page flip (so user can see it)
+			Frame_Pacer_Flip_Begin();
 			gxFlipVisualActivePages(FALSE);
+			Frame_Pacer_Flip_End();
+
+			// The input handled this frame is on the screen now
+			for (int e = 0; e < input.num_events; e++)
+				if (input.events[e].type & LATENCY_EVENTS)
+					Latency_Add(input.capture_times[e]);
+			if (timeGetTime() - latency_log_time >= LATENCY_LOG_TIME) {
+				if (Latency_Get_Stats(&latency)) {
+					sprintf(str, "input latency (last %d events): mean %.2f ms, p50 %.2f ms, p95 %.2f ms, p99 %.2f ms, max %.2f ms",
+						latency.samples, latency.mean_ms, latency.p50_ms, latency.p95_ms, latency.p99_ms, latency.max_ms);
+					debug_WriteFile(str);
+					Latency_Write(LATENCY_FILENAME);
+				}
+				if (Frame_Pacer_Get_Stats(&pacing)) {
+					sprintf(str, "frame pacing (last %d frames): target %.2f ms, mean %.2f ms, jitter %.2f ms, max error %.2f ms, wait %.2f ms (%.2f ms spinning)%s",
+						pacing.frames, pacing.target_ms, pacing.mean_ms, pacing.jitter_ms, pacing.max_error_ms, pacing.wait_ms, pacing.spin_ms, pacing.vsync ? ", vsync" : "");
+					debug_WriteFile(str);
+				}
+				latency_log_time = timeGetTime();
+			}
 
+			// Benchmark frames start once everything is loaded, the report is written after the last
+			if (benchmark AND loaded) {
+				if (NOT Benchmark_Running()) {
+					if (NOT Benchmark_Init(benchmark_frames)) {
+						debug_WriteFile("Program_Run(): can't start the benchmark");
+						quit = TRUE;
+					}
+				}
+				else if (Benchmark_End_Frame()) {
+					if (NOT Benchmark_Write_Report(BENCHMARK_REPORT_FILENAME, benchmark_path, Pgm_screen.xright + 1, Pgm_screen.ybottom + 1))
+						debug_WriteFile("Program_Run(): can't write the benchmark report");
+					Benchmark_Free();
+					quit = TRUE;
+				}
+			}
 		}
 	}
 
+	timeEndPeriod(1);
+
 	/*____________________________________________________________________
 	|
 	| Free stuff and exit
 	|___________________________________________________________________*/
 
-	gx3d_FreeObject(obj_tree);
-	gx3d_FreeObject(obj_tree2);
-	gx3d_FreeObject(obj_skydome);
-	gx3d_FreeObject(obj_ground);
-	gx3d_FreeObject(obj_power);
-	gx3d_FreeObject(obj_mountain);
-	gx3d_FreeObject(obj_talltree);
-	gx3d_FreeObject(obj_grass);
-	gx3d_FreeObject(obj_character);
-	gx3d_FreeObject(obj_flower);
-	gx3d_FreeParticleSystem(psys_fire);
-	gx3d_FreeParticleSystem(psys_power);
+	// Finish any loads still queued (if quit while loading) so everything below is valid
+	Loader_Finish();
+	Loader_Free();
+
+	Asset_Release_Object(obj_tree);
+	Asset_Release_Object(obj_tree2);
+	Asset_Release_Object(obj_skydome);
+	Asset_Release_Object(obj_ground);
+	Asset_Release_Object(obj_power);
+	Asset_Release_Object(obj_mountain);
+	Asset_Release_Object(obj_talltree);
+	Asset_Release_Object(obj_grass);
+	Asset_Release_Object(obj_character);
+	Asset_Release_Object(obj_flower);
+	Asset_Release_Particle_System(psys_fire);
+	Asset_Release_Particle_System(psys_power);
+	Particle_Queue_Free();
 	gx3d_Motion_Free(motion1);
 	gx3d_BlendNode_Free(bnode1);
 	gx3d_BlendTree_Free(btree1);
+	Crowd_Free(crowd);
+	Camera_Path_Free(camera_path);
+	if (record_path) {
+		Camera_Path_Write(record_path, RECORD_PATH_FILENAME);
+		Camera_Path_Free(record_path);
+	}
+	// Free any objects and textures still loaded
+	Asset_Free();
 
-	snd_StopSound(s_song);
+	Music_Stream_Close(music);
 	snd_Free();
 }
 
@@ -1300,6 +1644,110 @@ static gx3dMotion *Load_Motion(gx3dMotionSkeleton *mskeleton, char *filename, in
 }
 
 
+/*____________________________________________________________________
+|
+| Function: Finalize_Sound
+|
+| Input: Called from Loader_Update()
+| Output: Loads a sound.  data points to the Sound to set.
+|___________________________________________________________________*/
+
+static void Finalize_Sound(void *data, LoaderFile *files, int num_files)
+{
+	*((Sound *)data) = snd_LoadSound(files[0].filename, snd_CONTROL_VOLUME, 0);
+}
+
+/*____________________________________________________________________
+|
+| Function: Finalize_Skeleton
+|
+| Input: Called from Loader_Update()
+| Output: Loads the character's motion skeleton.
+|___________________________________________________________________*/
+
+static void Finalize_Skeleton(void *data, LoaderFile *files, int num_files)
+{
+	CharacterLoad *load = (CharacterLoad *)data;
+
+	*(load->mskeleton) = gx3d_MotionSkeleton_Read_LWS_File(files[0].filename);
+}
+
+/*____________________________________________________________________
+|
+| Function: Finalize_Motion
+|
+| Input: Called from Loader_Update(), after Finalize_Skeleton()
+| Output: Loads the character's motion.
+|___________________________________________________________________*/
+
+static void Finalize_Motion(void *data, LoaderFile *files, int num_files)
+{
+	CharacterLoad *load = (CharacterLoad *)data;
+
+	*(load->motion) = Load_Motion(*(load->mskeleton), files[0].filename, 30, 0, 0, false);
+}
+
+/*____________________________________________________________________
+|
+| Function: Finalize_Blend_Tree
+|
+| Input: Called from Loader_Update(), after Finalize_Motion() and the
+|   character object are loaded
+| Output: Creates a blend tree to play the motion on the character.
+|___________________________________________________________________*/
+
+static void Finalize_Blend_Tree(void *data, LoaderFile *files, int num_files)
+{
+	CharacterLoad *load = (CharacterLoad *)data;
+
+	*(load->bnode) = gx3d_BlendNode_Init(*(load->mskeleton), gx3d_BLENDNODE_TYPE_SINGLE); // create single input blending node (doesn't blend, just reads in)
+	gx3d_Motion_Set_Output(*(load->motion), *(load->bnode), gx3d_BLENDNODE_TRACK_0);  // set output of animation to blending node (track 0)
+
+	*(load->btree) = gx3d_BlendTree_Init(*(load->mskeleton));         // create blendtree
+	gx3d_BlendTree_Add_Node(*(load->btree), *(load->bnode));           // add blending node to the tree
+	gx3d_BlendTree_Set_Output(*(load->btree), (*(load->object))->layer);  // set output of tree to a model object layer (containing vertices to be animated)
+}
+
+/*____________________________________________________________________
+|
+| Function: Get_Benchmark_Options
+|
+| Input: Called from Program_Run()
+| Output: Returns true if benchmark mode was asked for on the command
+|   line (-benchmark), along with the camera path file (the argument
+|   after -benchmark, if any) and the number of frames to record
+|   (-frames n).
+|___________________________________________________________________*/
+
+static bool Get_Benchmark_Options(char *path_filename, int *num_frames)
+{
+	char cmd[1024], *arg;
+	bool benchmark = false;
+
+	strcpy(path_filename, BENCHMARK_PATH_FILENAME);
+	*num_frames = BENCHMARK_FRAMES;
+
+	strncpy(cmd, GetCommandLineA(), sizeof(cmd) - 1);
+	cmd[sizeof(cmd) - 1] = 0;
+	// Program names with spaces are split here, but come before any option
+	arg = strtok(cmd, " \t\"");
+	while ((arg = strtok(0, " \t\"")) != 0) {
+		if (strcmp(arg, "-benchmark") == 0)
+			benchmark = true;
+		else if ((strcmp(arg, "-frames") == 0) AND ((arg = strtok(0, " \t\"")) != 0))
+			*num_frames = atoi(arg);
+		// A file name after -benchmark
+		else if (benchmark AND (arg[0] != '-')) {
+			strncpy(path_filename, arg, MAX_PATH - 1);
+			path_filename[MAX_PATH - 1] = 0;
+		}
+	}
+	if (*num_frames < 1)
+		*num_frames = BENCHMARK_FRAMES;
+
+	return (benchmark);
+}
+
 /*____________________________________________________________________
 |
 | Function: Program_Free
@@ -1310,6 +1758,7 @@ static gx3dMotion *Load_Motion(gx3dMotionSkeleton *mskeleton, char *filename, in
 
 void Program_Free()
 {
+	Job_Pool_Free();
 	// Stop event processing 
 	evStopEvents();
 	// Return to text mode 
@@ -0,0 +1,342 @@
+/*____________________________________________________________________
+|
+| File: mesh_file.cpp
+|
+| Description: Preprocessed binary mesh files (.gxm).  A mesh file holds
+|   welded, smoothed, triangulated geometry ready to copy into vertex and
+|   index buffers, plus a layer table and bounding spheres.  Files are
+|   built offline from LWO2 objects (see Tools/mesh_convert.cpp) and
+|   mapped into memory at load time, so loading is a validation pass
+|   over the header and tables - no parsing and no copying.
+|
+|   mesh_convert builds this file too, so it makes no GX calls.
+|
+| Functions: MeshFile_Write
+|            MeshFile_Open
+|            MeshFile_Close
+|            MeshFile_Is_Current
+|            MeshFile_Get_Source_Info
+|             Align
+|             Range_Ok
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+/*___________________
+|
+| Include Files
+|__________________*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "mesh_file.h"
+
+/*___________________
+|
+| Function Prototypes
+|__________________*/
+
+static unsigned Align (unsigned offset);
+static bool     Range_Ok (const MeshFileHeader *header, unsigned offset, unsigned count, unsigned size);
+
+/*___________________
+|
+| Constants
+|__________________*/
+
+#define MESH_FILE_ALIGNMENT 16
+
+/*____________________________________________________________________
+|
+| Function: MeshFile_Write
+|
+| Input: Called from ____
+| Output: Writes a mesh file.  Indices are stored 16-bit if every layer
+|   has fewer than 64K vertices, else 32-bit.  Returns true on success.
+|___________________________________________________________________*/
+
+bool MeshFile_Write (const char *filename, MeshFileData *data)
+{
+  int i;
+  unsigned offset, index_size;
+  MeshFileHeader header;
+  unsigned char *buffer;
+  unsigned short *indices16;
+  FILE *fp;
+  bool ok = false;
+
+/*____________________________________________________________________
+|
+| Build the header
+|___________________________________________________________________*/
+
+  index_size = 2;
+  for (i=0; i<data->num_layers; i++)
+    if (data->layers[i].num_vertices > 0xFFFF)
+      index_size = 4;
+
+  memset (&header, 0, sizeof(header));
+  header.magic        = MESH_FILE_MAGIC;
+  header.version      = MESH_FILE_VERSION;
+  header.flags        = data->flags;
+  header.source_size  = data->source_size;
+  header.source_time  = data->source_time;
+  header.num_layers   = data->num_layers;
+  header.num_vertices = data->num_vertices;
+  header.num_indices  = data->num_indices;
+  header.index_size   = index_size;
+  header.num_bones    = data->num_bones;
+  if (data->skin)
+    header.flags |= MESH_FILE_FLAG_SKIN;
+  else
+    header.flags &= ~MESH_FILE_FLAG_SKIN;
+
+  offset = Align (sizeof(MeshFileHeader));
+  header.layer_offset  = offset;
+  offset = Align (offset + data->num_layers * sizeof(MeshFileLayer));
+  header.vertex_offset = offset;
+  offset = Align (offset + data->num_vertices * sizeof(MeshFileVertex));
+  if (data->skin) {
+    header.skin_offset = offset;
+    offset = Align (offset + data->num_vertices * sizeof(MeshFileSkin));
+  }
+  header.index_offset = offset;
+  offset = Align (offset + data->num_indices * index_size);
+  header.bone_offset = offset;
+  offset = Align (offset + data->num_bones * sizeof(MeshFileName));
+  header.file_size = offset;
+
+  // Bounding sphere of the whole mesh encloses all layer spheres
+  if (data->num_layers) {
+    float min[3], max[3], r, d, dx, dy, dz;
+    int j;
+    for (j=0; j<3; j++) {
+      min[j] = data->layers[0].bound_sphere[j] - data->layers[0].bound_sphere[3];
+      max[j] = data->layers[0].bound_sphere[j] + data->layers[0].bound_sphere[3];
+    }
+    for (i=1; i<data->num_layers; i++)
+      for (j=0; j<3; j++) {
+        if (data->layers[i].bound_sphere[j] - data->layers[i].bound_sphere[3] < min[j])
+          min[j] = data->layers[i].bound_sphere[j] - data->layers[i].bound_sphere[3];
+        if (data->layers[i].bound_sphere[j] + data->layers[i].bound_sphere[3] > max[j])
+          max[j] = data->layers[i].bound_sphere[j] + data->layers[i].bound_sphere[3];
+      }
+    for (j=0; j<3; j++)
+      header.bound_sphere[j] = (min[j] + max[j]) / 2;
+    for (i=0, r=0; i<data->num_layers; i++) {
+      dx = data->layers[i].bound_sphere[0] - header.bound_sphere[0];
+      dy = data->layers[i].bound_sphere[1] - header.bound_sphere[1];
+      dz = data->layers[i].bound_sphere[2] - header.bound_sphere[2];
+      d = (float) sqrt (dx*dx + dy*dy + dz*dz) + data->layers[i].bound_sphere[3];
+      if (d > r)
+        r = d;
+    }
+    header.bound_sphere[3] = r;
+  }
+
+/*____________________________________________________________________
+|
+| Build the file image and write it
+|___________________________________________________________________*/
+
+  buffer = (unsigned char *) calloc (header.file_size, 1);
+  if (buffer == 0)
+    return (false);
+
+  memcpy (buffer, &header, sizeof(header));
+  memcpy (buffer + header.layer_offset,  data->layers,   data->num_layers   * sizeof(MeshFileLayer));
+  memcpy (buffer + header.vertex_offset, data->vertices, data->num_vertices * sizeof(MeshFileVertex));
+  if (data->skin)
+    memcpy (buffer + header.skin_offset, data->skin, data->num_vertices * sizeof(MeshFileSkin));
+  if (index_size == 4)
+    memcpy (buffer + header.index_offset, data->indices, data->num_indices * sizeof(unsigned));
+  else {
+    indices16 = (unsigned short *) (buffer + header.index_offset);
+    for (i=0; i<data->num_indices; i++)
+      indices16[i] = (unsigned short) data->indices[i];
+  }
+  memcpy (buffer + header.bone_offset, data->bones, data->num_bones * sizeof(MeshFileName));
+
+  fp = fopen (filename, "wb");
+  if (fp) {
+    ok = (fwrite (buffer, header.file_size, 1, fp) == 1);
+    if (fclose (fp) != 0)
+      ok = false;
+  }
+  free (buffer);
+
+  return (ok);
+}
+
+/*____________________________________________________________________
+|
+| Function: MeshFile_Open
+|
+| Input: Called from ____
+| Output: Maps a mesh file and sets pointers to its sections.  Returns
+|   false if the file can't be mapped or fails validation.
+|___________________________________________________________________*/
+
+bool MeshFile_Open (const char *filename, MeshFile *mesh)
+{
+  unsigned i, vertex_end, index_end;
+  const unsigned char *base;
+  const MeshFileHeader *header;
+  const MeshFileLayer *layer;
+
+  memset (mesh, 0, sizeof(MeshFile));
+  if (!FileMap_Open (filename, &mesh->map))
+    return (false);
+
+  base   = (const unsigned char *) mesh->map.data;
+  header = (const MeshFileHeader *) base;
+
+/*____________________________________________________________________
+|
+| Validate header and section ranges
+|___________________________________________________________________*/
+
+  if ((mesh->map.size < sizeof(MeshFileHeader)) ||
+      (header->magic != MESH_FILE_MAGIC) ||
+      (header->version != MESH_FILE_VERSION) ||
+      (header->file_size != mesh->map.size) ||
+      ((header->index_size != 2) && (header->index_size != 4)) ||
+      (!Range_Ok (header, header->layer_offset,  header->num_layers,   sizeof(MeshFileLayer))) ||
+      (!Range_Ok (header, header->vertex_offset, header->num_vertices, sizeof(MeshFileVertex))) ||
+      (!Range_Ok (header, header->index_offset,  header->num_indices,  header->index_size)) ||
+      (!Range_Ok (header, header->bone_offset,   header->num_bones,    sizeof(MeshFileName))) ||
+      ((header->flags & MESH_FILE_FLAG_SKIN) && (!Range_Ok (header, header->skin_offset, header->num_vertices, sizeof(MeshFileSkin))))) {
+    MeshFile_Close (mesh);
+    return (false);
+  }
+
+  // Make sure every layer refers to vertices and indices inside the file
+  layer = (const MeshFileLayer *) (base + header->layer_offset);
+  for (i=0; i<header->num_layers; i++) {
+    vertex_end = layer[i].first_vertex + layer[i].num_vertices;
+    index_end  = layer[i].first_index + layer[i].num_indices;
+    if ((vertex_end < layer[i].first_vertex) || (vertex_end > header->num_vertices) ||
+        (index_end < layer[i].first_index) || (index_end > header->num_indices) ||
+        (layer[i].parent >= (int) header->num_layers)) {
+      MeshFile_Close (mesh);
+      return (false);
+    }
+  }
+
+  mesh->header   = header;
+  mesh->layers   = layer;
+  mesh->vertices = (const MeshFileVertex *) (base + header->vertex_offset);
+  mesh->indices  = (const void *) (base + header->index_offset);
+  mesh->bones    = (const MeshFileName *) (base + header->bone_offset);
+  if (header->flags & MESH_FILE_FLAG_SKIN)
+    mesh->skin = (const MeshFileSkin *) (base + header->skin_offset);
+
+  return (true);
+}
+
+/*____________________________________________________________________
+|
+| Function: MeshFile_Close
+|
+| Input: Called from ____
+| Output: Unmaps a mesh file.
+|___________________________________________________________________*/
+
+void MeshFile_Close (MeshFile *mesh)
+{
+  FileMap_Close (&mesh->map);
+  memset (mesh, 0, sizeof(MeshFile));
+}
+
+/*____________________________________________________________________
+|
+| Function: MeshFile_Is_Current
+|
+| Input: Called from ____
+| Output: Returns true if the mesh file exists, has the current version
+|   and was built from a source file with the same size and modify time.
+|___________________________________________________________________*/
+
+bool MeshFile_Is_Current (const char *filename, const char *source_filename)
+{
+  FILE *fp;
+  MeshFileHeader header;
+  unsigned size, time;
+  bool current = false;
+
+  if (MeshFile_Get_Source_Info (source_filename, &size, &time)) {
+    fp = fopen (filename, "rb");
+    if (fp) {
+      if (fread (&header, sizeof(header), 1, fp) == 1)
+        current = (header.magic == MESH_FILE_MAGIC) &&
+                  (header.version == MESH_FILE_VERSION) &&
+                  (header.source_size == size) &&
+                  (header.source_time == time);
+      fclose (fp);
+    }
+  }
+
+  return (current);
+}
+
+/*____________________________________________________________________
+|
+| Function: MeshFile_Get_Source_Info
+|
+| Input: Called from ____
+| Output: Gets size and modify time of a file.  Returns true on success.
+|___________________________________________________________________*/
+
+bool MeshFile_Get_Source_Info (const char *filename, unsigned *size, unsigned *time)
+{
+#ifdef _WIN32
+  struct _stat st;
+  if (_stat (filename, &st) != 0)
+    return (false);
+#else
+  struct stat st;
+  if (stat (filename, &st) != 0)
+    return (false);
+#endif
+  *size = (unsigned) st.st_size;
+  *time = (unsigned) st.st_mtime;
+
+  return (true);
+}
+
+/*____________________________________________________________________
+|
+| Function: Align
+|
+| Input: Called from MeshFile_Write()
+| Output: Returns offset rounded up to the section alignment.
+|___________________________________________________________________*/
+
+static unsigned Align (unsigned offset)
+{
+  return ((offset + MESH_FILE_ALIGNMENT - 1) & ~(MESH_FILE_ALIGNMENT - 1));
+}
+
+/*____________________________________________________________________
+|
+| Function: Range_Ok
+|
+| Input: Called from MeshFile_Open()
+| Output: Returns true if count elements of size bytes at offset are
+|   aligned and fit inside the file.
+|___________________________________________________________________*/
+
+static bool Range_Ok (const MeshFileHeader *header, unsigned offset, unsigned count, unsigned size)
+{
+  unsigned long long end;
+
+  end = (unsigned long long) offset + (unsigned long long) count * size;
+
+  return (((offset % MESH_FILE_ALIGNMENT) == 0) && (offset >= sizeof(MeshFileHeader)) && (end <= header->file_size));
+}
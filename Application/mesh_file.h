@@ -0,0 +1,127 @@
+/*____________________________________________________________________
+|
+| File: mesh_file.h
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+#ifndef _MESH_FILE_H_
+#define _MESH_FILE_H_
+
+#include "file_map.h"
+
+/*___________________
+|
+| Constants
+|__________________*/
+
+#define MESH_FILE_MAGIC     0x424D5847  // "GXMB"
+#define MESH_FILE_VERSION   1
+#define MESH_FILE_EXTENSION ".gxm"
+#define MESH_FILE_NAME_SIZE 32
+
+// Header flags
+#define MESH_FILE_FLAG_SKIN 0x1         // file has a skin stream (bone indices + weights)
+
+/*___________________
+|
+| Type definitions
+|__________________*/
+
+// All offsets are from the start of the file and 16-byte aligned
+typedef struct {
+  unsigned magic;
+  unsigned version;
+  unsigned flags;
+  unsigned file_size;
+  unsigned source_size;           // size of source file (to check if cache is current)
+  unsigned source_time;           // modify time of source file
+  unsigned num_layers;
+  unsigned layer_offset;
+  unsigned num_vertices;
+  unsigned vertex_offset;         // MeshFileVertex [num_vertices]
+  unsigned skin_offset;           // MeshFileSkin [num_vertices], if MESH_FILE_FLAG_SKIN
+  unsigned num_indices;
+  unsigned index_size;            // 2 or 4 bytes
+  unsigned index_offset;          // triangle list, indices are relative to the layer's first vertex
+  unsigned num_bones;
+  unsigned bone_offset;           // MeshFileName [num_bones], weight map name for each bone index
+  float    bound_sphere[4];       // center x,y,z, radius
+} MeshFileHeader;
+
+typedef struct {
+  char     name [MESH_FILE_NAME_SIZE];
+  int      parent;                // index of parent layer or -1
+  float    pivot[3];
+  float    bound_sphere[4];
+  unsigned first_vertex;
+  unsigned num_vertices;
+  unsigned first_index;
+  unsigned num_indices;
+} MeshFileLayer;
+
+// Vertex layout matches D3DFVF_XYZ | D3DFVF_NORMAL | D3DFVF_TEX1
+typedef struct {
+  float position[3];
+  float normal[3];
+  float uv[2];
+} MeshFileVertex;
+
+typedef struct {
+  unsigned char bone[4];          // index into bone name table
+  float         weight[4];        // sums to 1, unused slots are 0
+} MeshFileSkin;
+
+typedef struct {
+  char name [MESH_FILE_NAME_SIZE];
+} MeshFileName;
+
+// Data to write to a mesh file
+typedef struct {
+  unsigned        flags;
+  unsigned        source_size;
+  unsigned        source_time;
+  int             num_layers;
+  MeshFileLayer  *layers;
+  int             num_vertices;
+  MeshFileVertex *vertices;
+  MeshFileSkin   *skin;           // 0 if no skin stream
+  int             num_indices;
+  unsigned       *indices;        // relative to each layer's first vertex
+  int             num_bones;
+  MeshFileName   *bones;
+} MeshFileData;
+
+// A mapped mesh file - all pointers point into the mapped file
+typedef struct {
+  const MeshFileHeader *header;
+  const MeshFileLayer  *layers;
+  const MeshFileVertex *vertices;
+  const MeshFileSkin   *skin;     // 0 if none
+  const void           *indices;  // unsigned short or unsigned, see header->index_size
+  const MeshFileName   *bones;
+  FileMap               map;
+} MeshFile;
+
+/*___________________
+|
+| Functions
+|__________________*/
+
+// Writes a mesh file, returns true on success
+bool MeshFile_Write (const char *filename, MeshFileData *data);
+
+// Maps a mesh file into memory and validates it, returns true on success
+bool MeshFile_Open (const char *filename, MeshFile *mesh);
+
+// Unmaps a mesh file
+void MeshFile_Close (MeshFile *mesh);
+
+// Returns true if a mesh file exists and was built from the current version of source_filename
+bool MeshFile_Is_Current (const char *filename, const char *source_filename);
+
+// Gets size and modify time of a file, returns true on success
+bool MeshFile_Get_Source_Info (const char *filename, unsigned *size, unsigned *time);
+
+#endif
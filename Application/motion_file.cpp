@@ -0,0 +1,624 @@
+/*____________________________________________________________________
+|
+| File: motion_file.cpp
+|
+| Description: Preprocessed binary motion files (.gxa).  A motion file
+|   holds a skeleton (bone hierarchy and rest pose) and, for each bone,
+|   a position, rotation and scale track sampled at the scene frame rate.
+|   Files are built offline from LightWave scenes (see
+|   Tools/lws_convert.cpp) and mapped into memory at load time.
+|
+|   To keep files small, rotations are stored as 48-bit "smallest three"
+|   quaternions, positions and scales as 16 bits per component in the
+|   range of their track, and each track keeps only the keys needed to
+|   reproduce the source motion within a tolerance.  A seek index lets
+|   a sample at any frame find its keys without scanning the track.
+|
+| Functions: MotionFile_Write
+|            MotionFile_Open
+|            MotionFile_Close
+|            MotionFile_Is_Current
+|            MotionFile_Sample
+|             Build_Track
+|             Segment_Ok
+|             Key_Error
+|             Interpolate
+|             Quantize_Key
+|             Dequantize_Key
+|             Align
+|             Range_Ok
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+/*___________________
+|
+| Include Files
+|__________________*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mesh_file.h"
+#include "motion_file.h"
+
+/*___________________
+|
+| Function Prototypes
+|__________________*/
+
+static int      Build_Track (MotionFileData *data, int bone, int type, MotionFileTrack *track, unsigned short *times, MotionFileKey *keys, MotionFileKey *frame_keys, float *frame_values);
+static bool     Segment_Ok (MotionFileData *data, int bone, int type, const float *frame_values, int start, int end);
+static float    Key_Error (int type, const float *value, const float *source);
+static void     Interpolate (int type, const float *v0, const float *v1, float t, float *value);
+static void     Quantize_Key (int type, const MotionFileTrack *track, const float *value, MotionFileKey *key);
+static void     Dequantize_Key (int type, const MotionFileTrack *track, const MotionFileKey *key, float *value);
+static unsigned Align (unsigned offset);
+static bool     Range_Ok (const MotionFileHeader *header, unsigned offset, unsigned count, unsigned size);
+
+/*___________________
+|
+| Constants
+|__________________*/
+
+#define MOTION_FILE_ALIGNMENT 16
+#define SQRT2                 1.41421356f
+
+// Offset of each track in a sample
+static const int Sample_Offset [MOTION_TRACKS_PER_BONE] = { 0, 3, 7 };
+
+/*____________________________________________________________________
+|
+| Function: MotionFile_Write
+|
+| Input: Called from ____
+| Output: Quantizes and reduces the sampled tracks and writes a motion
+|   file.  Returns true on success.
+|___________________________________________________________________*/
+
+bool MotionFile_Write (const char *filename, MotionFileData *data)
+{
+  int i, s, t, frame;
+  unsigned num_tracks, num_keys, num_seeks, k, offset;
+  MotionFileHeader header;
+  MotionFileTrack *tracks;
+  unsigned short *times, *seeks;
+  MotionFileKey *keys, *frame_keys;
+  float *frame_values;
+  unsigned char *buffer;
+  FILE *fp;
+  bool ok = false;
+
+  if ((data->num_bones <= 0) || (data->num_frames <= 0) || (data->num_frames > MOTION_FILE_MAX_FRAMES))
+    return (false);
+
+  num_tracks   = data->num_bones * MOTION_TRACKS_PER_BONE;
+  num_seeks    = (data->num_frames - 1) / MOTION_FILE_SEEK_FRAMES + 1;
+  tracks       = (MotionFileTrack *) calloc (num_tracks, sizeof(MotionFileTrack));
+  times        = (unsigned short *) malloc (num_tracks * data->num_frames * sizeof(unsigned short));
+  keys         = (MotionFileKey *) malloc (num_tracks * data->num_frames * sizeof(MotionFileKey));
+  seeks        = (unsigned short *) malloc (num_seeks * num_tracks * sizeof(unsigned short));
+  frame_keys   = (MotionFileKey *) malloc (data->num_frames * sizeof(MotionFileKey));
+  frame_values = (float *) malloc (data->num_frames * 4 * sizeof(float));
+  buffer       = 0;
+
+  if (tracks && times && keys && seeks && frame_keys && frame_values) {
+
+/*____________________________________________________________________
+|
+| Build the tracks and the seek index
+|___________________________________________________________________*/
+
+    num_keys = 0;
+    for (i=0; i<data->num_bones; i++)
+      for (t=0; t<MOTION_TRACKS_PER_BONE; t++) {
+        MotionFileTrack *track = &tracks[i * MOTION_TRACKS_PER_BONE + t];
+        track->first_key = num_keys;
+        track->num_keys  = Build_Track (data, i, t, track, times + num_keys, keys + num_keys, frame_keys, frame_values);
+        num_keys += track->num_keys;
+      }
+
+    for (t=0; t<(int)num_tracks; t++)
+      for (s=0, k=0; s<(int)num_seeks; s++) {
+        frame = s * MOTION_FILE_SEEK_FRAMES;
+        while ((k+1 < tracks[t].num_keys) && (times[tracks[t].first_key + k + 1] <= frame))
+          k++;
+        seeks[s * num_tracks + t] = (unsigned short) k;
+      }
+
+/*____________________________________________________________________
+|
+| Build the header
+|___________________________________________________________________*/
+
+    memset (&header, 0, sizeof(header));
+    header.magic       = MOTION_FILE_MAGIC;
+    header.version     = MOTION_FILE_VERSION;
+    header.source_size = data->source_size;
+    header.source_time = data->source_time;
+    header.fps         = data->fps;
+    header.num_frames  = data->num_frames;
+    header.num_bones   = data->num_bones;
+    header.num_tracks  = num_tracks;
+    header.num_keys    = num_keys;
+    header.num_seeks   = num_seeks;
+
+    offset = Align (sizeof(MotionFileHeader));
+    header.bone_offset  = offset;
+    offset = Align (offset + data->num_bones * sizeof(MotionFileBone));
+    header.track_offset = offset;
+    offset = Align (offset + num_tracks * sizeof(MotionFileTrack));
+    header.time_offset  = offset;
+    offset = Align (offset + num_keys * sizeof(unsigned short));
+    header.key_offset   = offset;
+    offset = Align (offset + num_keys * sizeof(MotionFileKey));
+    header.seek_offset  = offset;
+    offset = Align (offset + num_seeks * num_tracks * sizeof(unsigned short));
+    header.file_size    = offset;
+
+/*____________________________________________________________________
+|
+| Build the file image and write it
+|___________________________________________________________________*/
+
+    buffer = (unsigned char *) calloc (header.file_size, 1);
+    if (buffer) {
+      memcpy (buffer, &header, sizeof(header));
+      memcpy (buffer + header.bone_offset,  data->bones, data->num_bones * sizeof(MotionFileBone));
+      memcpy (buffer + header.track_offset, tracks,      num_tracks * sizeof(MotionFileTrack));
+      memcpy (buffer + header.time_offset,  times,       num_keys * sizeof(unsigned short));
+      memcpy (buffer + header.key_offset,   keys,        num_keys * sizeof(MotionFileKey));
+      memcpy (buffer + header.seek_offset,  seeks,       num_seeks * num_tracks * sizeof(unsigned short));
+
+      fp = fopen (filename, "wb");
+      if (fp) {
+        ok = (fwrite (buffer, header.file_size, 1, fp) == 1);
+        if (fclose (fp) != 0)
+          ok = false;
+      }
+    }
+  }
+
+  free (buffer);
+  free (frame_values);
+  free (frame_keys);
+  free (seeks);
+  free (keys);
+  free (times);
+  free (tracks);
+
+  return (ok);
+}
+
+/*____________________________________________________________________
+|
+| Function: MotionFile_Open
+|
+| Input: Called from ____
+| Output: Maps a motion file and sets pointers to its sections.  Returns
+|   false if the file can't be mapped or fails validation.
+|___________________________________________________________________*/
+
+bool MotionFile_Open (const char *filename, MotionFile *motion)
+{
+  unsigned i, key_end;
+  const unsigned char *base;
+  const MotionFileHeader *header;
+  const MotionFileBone *bone = 0;
+  const MotionFileTrack *track = 0;
+  const unsigned short *seek = 0;
+  bool ok;
+
+  memset (motion, 0, sizeof(MotionFile));
+  if (!FileMap_Open (filename, &motion->map))
+    return (false);
+
+  base   = (const unsigned char *) motion->map.data;
+  header = (const MotionFileHeader *) base;
+
+/*____________________________________________________________________
+|
+| Validate header and section ranges
+|___________________________________________________________________*/
+
+  ok = (motion->map.size >= sizeof(MotionFileHeader)) &&
+       (header->magic == MOTION_FILE_MAGIC) &&
+       (header->version == MOTION_FILE_VERSION) &&
+       (header->file_size == motion->map.size) &&
+       (header->num_frames > 0) && (header->num_frames <= MOTION_FILE_MAX_FRAMES) &&
+       (header->num_tracks == header->num_bones * MOTION_TRACKS_PER_BONE) &&
+       (header->num_seeks == (header->num_frames - 1) / MOTION_FILE_SEEK_FRAMES + 1) &&
+       Range_Ok (header, header->bone_offset,  header->num_bones,  sizeof(MotionFileBone)) &&
+       Range_Ok (header, header->track_offset, header->num_tracks, sizeof(MotionFileTrack)) &&
+       Range_Ok (header, header->time_offset,  header->num_keys,   sizeof(unsigned short)) &&
+       Range_Ok (header, header->key_offset,   header->num_keys,   sizeof(MotionFileKey)) &&
+       Range_Ok (header, header->seek_offset,  header->num_seeks * header->num_tracks, sizeof(unsigned short));
+
+  // Make sure every bone, track and seek entry refers to something inside the file
+  if (ok) {
+    bone  = (const MotionFileBone *) (base + header->bone_offset);
+    track = (const MotionFileTrack *) (base + header->track_offset);
+    seek  = (const unsigned short *) (base + header->seek_offset);
+    for (i=0; ok && (i<header->num_bones); i++)
+      ok = (bone[i].parent < (int) i);
+    for (i=0; ok && (i<header->num_tracks); i++) {
+      key_end = track[i].first_key + track[i].num_keys;
+      ok = (track[i].num_keys > 0) && (key_end > track[i].first_key) && (key_end <= header->num_keys);
+    }
+    for (i=0; ok && (i<header->num_seeks*header->num_tracks); i++)
+      ok = (seek[i] < track[i % header->num_tracks].num_keys);
+  }
+  if (!ok) {
+    MotionFile_Close (motion);
+    return (false);
+  }
+
+  motion->header = header;
+  motion->bones  = bone;
+  motion->tracks = track;
+  motion->times  = (const unsigned short *) (base + header->time_offset);
+  motion->keys   = (const MotionFileKey *) (base + header->key_offset);
+  motion->seeks  = seek;
+
+  return (true);
+}
+
+/*____________________________________________________________________
+|
+| Function: MotionFile_Close
+|
+| Input: Called from ____
+| Output: Unmaps a motion file.
+|___________________________________________________________________*/
+
+void MotionFile_Close (MotionFile *motion)
+{
+  FileMap_Close (&motion->map);
+  memset (motion, 0, sizeof(MotionFile));
+}
+
+/*____________________________________________________________________
+|
+| Function: MotionFile_Is_Current
+|
+| Input: Called from ____
+| Output: Returns true if the motion file exists, has the current version
+|   and was built from a source file with the same size and modify time.
+|___________________________________________________________________*/
+
+bool MotionFile_Is_Current (const char *filename, const char *source_filename)
+{
+  FILE *fp;
+  MotionFileHeader header;
+  unsigned size, time;
+  bool current = false;
+
+  if (MeshFile_Get_Source_Info (source_filename, &size, &time)) {
+    fp = fopen (filename, "rb");
+    if (fp) {
+      if (fread (&header, sizeof(header), 1, fp) == 1)
+        current = (header.magic == MOTION_FILE_MAGIC) &&
+                  (header.version == MOTION_FILE_VERSION) &&
+                  (header.source_size == size) &&
+                  (header.source_time == time);
+      fclose (fp);
+    }
+  }
+
+  return (current);
+}
+
+/*____________________________________________________________________
+|
+| Function: MotionFile_Sample
+|
+| Input: Called from ____
+| Output: Gets the local position, rotation and scale of a bone at a
+|   frame.  Frames outside the motion are clamped to the first or last
+|   frame.
+|___________________________________________________________________*/
+
+void MotionFile_Sample (const MotionFile *motion, int bone, float frame, float position[3], float rotation[4], float scale[3])
+{
+  int t, n;
+  unsigned k, f, track_index;
+  const MotionFileTrack *track;
+  const unsigned short *times;
+  float *value, v0[4], v1[4];
+
+  if (frame < 0)
+    frame = 0;
+  if (frame > (float) (motion->header->num_frames - 1))
+    frame = (float) (motion->header->num_frames - 1);
+  f = (unsigned) frame;
+
+  for (t=0; t<MOTION_TRACKS_PER_BONE; t++) {
+    track_index = bone * MOTION_TRACKS_PER_BONE + t;
+    track = &motion->tracks[track_index];
+    times = motion->times + track->first_key;
+    n     = (t == MOTION_TRACK_ROTATION) ? 4 : 3;
+    value = (t == MOTION_TRACK_POSITION) ? position : ((t == MOTION_TRACK_ROTATION) ? rotation : scale);
+
+    // Start from the seek index, then step to the key in effect at this frame
+    k = motion->seeks[(f / MOTION_FILE_SEEK_FRAMES) * motion->header->num_tracks + track_index];
+    while ((k+1 < track->num_keys) && (times[k+1] <= f))
+      k++;
+
+    Dequantize_Key (t, track, &motion->keys[track->first_key + k], v0);
+    if (k+1 < track->num_keys) {
+      Dequantize_Key (t, track, &motion->keys[track->first_key + k + 1], v1);
+      Interpolate (t, v0, v1, (frame - times[k]) / (times[k+1] - times[k]), value);
+    }
+    else
+      memcpy (value, v0, n * sizeof(float));
+  }
+}
+
+/*____________________________________________________________________
+|
+| Function: Build_Track
+|
+| Input: Called from MotionFile_Write()
+| Output: Quantizes one track of a bone and keeps only the keys needed
+|   to stay within tolerance of the source samples.  Returns the number
+|   of keys.
+|___________________________________________________________________*/
+
+static int Build_Track (MotionFileData *data, int bone, int type, MotionFileTrack *track, unsigned short *times, MotionFileKey *keys, MotionFileKey *frame_keys, float *frame_values)
+{
+  int i, j, start, end, num_keys;
+  float max[3];
+  const float *sample;
+
+  // Position and scale are quantized in the range of the track
+  if (type != MOTION_TRACK_ROTATION) {
+    for (i=0; i<data->num_frames; i++) {
+      sample = data->samples + (bone * data->num_frames + i) * MOTION_FILE_SAMPLE_SIZE + Sample_Offset[type];
+      for (j=0; j<3; j++) {
+        if ((i == 0) || (sample[j] < track->min[j]))
+          track->min[j] = sample[j];
+        if ((i == 0) || (sample[j] > max[j]))
+          max[j] = sample[j];
+      }
+    }
+    for (j=0; j<3; j++)
+      track->extent[j] = max[j] - track->min[j];
+  }
+
+  // Quantize every frame, keep the values the runtime will see
+  for (i=0; i<data->num_frames; i++) {
+    sample = data->samples + (bone * data->num_frames + i) * MOTION_FILE_SAMPLE_SIZE + Sample_Offset[type];
+    Quantize_Key (type, track, sample, &frame_keys[i]);
+    Dequantize_Key (type, track, &frame_keys[i], &frame_values[i * 4]);
+  }
+
+  // Extend each segment as far as interpolation stays within tolerance
+  times[0] = 0;
+  keys[0]  = frame_keys[0];
+  num_keys = 1;
+  for (start=0; start<data->num_frames-1; start=end) {
+    end = start + 1;
+    while ((end+1 < data->num_frames) && Segment_Ok (data, bone, type, frame_values, start, end+1))
+      end++;
+    times[num_keys] = (unsigned short) end;
+    keys[num_keys]  = frame_keys[end];
+    num_keys++;
+  }
+
+  // A track that never changes needs only one key
+  if ((num_keys == 2) && (memcmp (&keys[0], &keys[1], sizeof(MotionFileKey)) == 0))
+    num_keys = 1;
+
+  return (num_keys);
+}
+
+/*____________________________________________________________________
+|
+| Function: Segment_Ok
+|
+| Input: Called from Build_Track()
+| Output: Returns true if interpolating between the keys at frames start
+|   and end reproduces every source sample in between within tolerance.
+|___________________________________________________________________*/
+
+static bool Segment_Ok (MotionFileData *data, int bone, int type, const float *frame_values, int start, int end)
+{
+  int i;
+  float value[4], tolerance;
+  const float *sample;
+
+  tolerance = (type == MOTION_TRACK_POSITION) ? data->position_tolerance :
+              ((type == MOTION_TRACK_ROTATION) ? data->rotation_tolerance : data->scale_tolerance);
+
+  for (i=start+1; i<end; i++) {
+    Interpolate (type, &frame_values[start * 4], &frame_values[end * 4], (float) (i - start) / (end - start), value);
+    sample = data->samples + (bone * data->num_frames + i) * MOTION_FILE_SAMPLE_SIZE + Sample_Offset[type];
+    if (Key_Error (type, value, sample) > tolerance)
+      return (false);
+  }
+
+  return (true);
+}
+
+/*____________________________________________________________________
+|
+| Function: Key_Error
+|
+| Input: Called from Segment_Ok()
+| Output: Returns the error of a value against a source sample - the
+|   distance for positions, the angle in radians for rotations and the
+|   largest component difference for scales.
+|___________________________________________________________________*/
+
+static float Key_Error (int type, const float *value, const float *source)
+{
+  int i;
+  float d, sign, chord, error;
+
+  if (type == MOTION_TRACK_POSITION)
+    error = (float) sqrt ((value[0] - source[0]) * (value[0] - source[0]) +
+                          (value[1] - source[1]) * (value[1] - source[1]) +
+                          (value[2] - source[2]) * (value[2] - source[2]));
+  else if (type == MOTION_TRACK_ROTATION) {
+    // From the chord between the quaternions, acos() of the dot product can't resolve small angles in float
+    sign = ((value[0] * source[0] + value[1] * source[1] + value[2] * source[2] + value[3] * source[3]) < 0) ? -1.0f : 1.0f;
+    for (i=0, chord=0; i<4; i++)
+      chord += (value[i] - sign * source[i]) * (value[i] - sign * source[i]);
+    chord = (float) sqrt (chord) / 2;
+    error = 4 * (float) asin ((chord < 1) ? chord : 1);
+  }
+  else {
+    error = (float) fabs (value[0] - source[0]);
+    d = (float) fabs (value[1] - source[1]);
+    if (d > error)
+      error = d;
+    d = (float) fabs (value[2] - source[2]);
+    if (d > error)
+      error = d;
+  }
+
+  return (error);
+}
+
+/*____________________________________________________________________
+|
+| Function: Interpolate
+|
+| Input: Called from MotionFile_Sample(), Segment_Ok()
+| Output: Interpolates between two values, 0 <= t <= 1.  Rotations are
+|   normalized lerped along the shortest arc.
+|___________________________________________________________________*/
+
+static void Interpolate (int type, const float *v0, const float *v1, float t, float *value)
+{
+  int i;
+  float sign, length;
+
+  if (type != MOTION_TRACK_ROTATION) {
+    for (i=0; i<3; i++)
+      value[i] = v0[i] + (v1[i] - v0[i]) * t;
+  }
+  else {
+    sign = ((v0[0] * v1[0] + v0[1] * v1[1] + v0[2] * v1[2] + v0[3] * v1[3]) < 0) ? -1.0f : 1.0f;
+    for (i=0; i<4; i++)
+      value[i] = v0[i] + (sign * v1[i] - v0[i]) * t;
+    length = (float) sqrt (value[0] * value[0] + value[1] * value[1] + value[2] * value[2] + value[3] * value[3]);
+    if (length > 0)
+      for (i=0; i<4; i++)
+        value[i] /= length;
+  }
+}
+
+/*____________________________________________________________________
+|
+| Function: Quantize_Key
+|
+| Input: Called from Build_Track()
+| Output: Quantizes a value.  A rotation is stored as the index of its
+|   largest component (made positive, so it can be rebuilt) and the other
+|   three, which must lie in +-1/sqrt(2), at 15 bits each.
+|___________________________________________________________________*/
+
+static void Quantize_Key (int type, const MotionFileTrack *track, const float *value, MotionFileKey *key)
+{
+  int i, largest, shift;
+  float q[4], length, u;
+  unsigned long long bits;
+
+  if (type != MOTION_TRACK_ROTATION) {
+    for (i=0; i<3; i++) {
+      u = (track->extent[i] > 0) ? (value[i] - track->min[i]) / track->extent[i] * 65535 + 0.5f : 0;
+      key->q[i] = (unsigned short) ((u < 0) ? 0 : ((u > 65535) ? 65535 : u));
+    }
+  }
+  else {
+    length = (float) sqrt (value[0] * value[0] + value[1] * value[1] + value[2] * value[2] + value[3] * value[3]);
+    largest = 0;
+    for (i=0; i<4; i++) {
+      q[i] = (length > 0) ? value[i] / length : ((i == 3) ? 1.0f : 0.0f);
+      if (fabs (q[i]) > fabs (q[largest]))
+        largest = i;
+    }
+    if (q[largest] < 0)
+      for (i=0; i<4; i++)
+        q[i] = -q[i];
+    bits  = (unsigned long long) largest << 45;
+    shift = 30;
+    for (i=0; i<4; i++)
+      if (i != largest) {
+        u = (q[i] * SQRT2 + 1) * 0.5f * 32767 + 0.5f;
+        bits |= (unsigned long long) ((u < 0) ? 0 : ((u > 32767) ? 32767 : (unsigned) u)) << shift;
+        shift -= 15;
+      }
+    key->q[0] = (unsigned short) bits;
+    key->q[1] = (unsigned short) (bits >> 16);
+    key->q[2] = (unsigned short) (bits >> 32);
+  }
+}
+
+/*____________________________________________________________________
+|
+| Function: Dequantize_Key
+|
+| Input: Called from MotionFile_Sample(), Build_Track()
+| Output: Rebuilds a value from a quantized key.
+|___________________________________________________________________*/
+
+static void Dequantize_Key (int type, const MotionFileTrack *track, const MotionFileKey *key, float *value)
+{
+  int i, largest, shift;
+  float sum;
+  unsigned long long bits;
+
+  if (type != MOTION_TRACK_ROTATION) {
+    for (i=0; i<3; i++)
+      value[i] = track->min[i] + key->q[i] * (1.0f / 65535) * track->extent[i];
+  }
+  else {
+    bits = (unsigned long long) key->q[0] | ((unsigned long long) key->q[1] << 16) | ((unsigned long long) key->q[2] << 32);
+    largest = (int) (bits >> 45) & 3;
+    shift = 30;
+    sum   = 0;
+    for (i=0; i<4; i++)
+      if (i != largest) {
+        value[i] = ((float) ((bits >> shift) & 0x7FFF) * (2.0f / 32767) - 1) * (1 / SQRT2);
+        sum += value[i] * value[i];
+        shift -= 15;
+      }
+    value[largest] = (sum < 1) ? (float) sqrt (1 - sum) : 0;
+  }
+}
+
+/*____________________________________________________________________
+|
+| Function: Align
+|
+| Input: Called from MotionFile_Write()
+| Output: Returns offset rounded up to the section alignment.
+|___________________________________________________________________*/
+
+static unsigned Align (unsigned offset)
+{
+  return ((offset + MOTION_FILE_ALIGNMENT - 1) & ~(MOTION_FILE_ALIGNMENT - 1));
+}
+
+/*____________________________________________________________________
+|
+| Function: Range_Ok
+|
+| Input: Called from MotionFile_Open()
+| Output: Returns true if count elements of size bytes at offset are
+|   aligned and fit inside the file.
+|___________________________________________________________________*/
+
+static bool Range_Ok (const MotionFileHeader *header, unsigned offset, unsigned count, unsigned size)
+{
+  unsigned long long end;
+
+  end = (unsigned long long) offset + (unsigned long long) count * size;
+
+  return (((offset % MOTION_FILE_ALIGNMENT) == 0) && (offset >= sizeof(MotionFileHeader)) && (end <= header->file_size));
+}
@@ -0,0 +1,139 @@
+/*____________________________________________________________________
+|
+| File: motion_file.h
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+#ifndef _MOTION_FILE_H_
+#define _MOTION_FILE_H_
+
+#include "file_map.h"
+
+/*___________________
+|
+| Constants
+|__________________*/
+
+#define MOTION_FILE_MAGIC       0x4E415847  // "GXAN"
+#define MOTION_FILE_VERSION     1
+#define MOTION_FILE_EXTENSION   ".gxa"
+#define MOTION_FILE_NAME_SIZE   32
+#define MOTION_FILE_SEEK_FRAMES 16          // frames between entries in the seek index
+#define MOTION_FILE_MAX_FRAMES  65536       // key times are 16-bit frame numbers
+
+// Each bone has 3 tracks, in this order
+#define MOTION_TRACK_POSITION  0
+#define MOTION_TRACK_ROTATION  1
+#define MOTION_TRACK_SCALE     2
+#define MOTION_TRACKS_PER_BONE 3
+
+// Floats per bone per frame in MotionFileData samples: position x,y,z, rotation x,y,z,w, scale x,y,z
+#define MOTION_FILE_SAMPLE_SIZE 10
+
+/*___________________
+|
+| Type definitions
+|__________________*/
+
+// All offsets are from the start of the file and 16-byte aligned
+typedef struct {
+  unsigned magic;
+  unsigned version;
+  unsigned file_size;
+  unsigned source_size;           // size of source file (to check if cache is current)
+  unsigned source_time;           // modify time of source file
+  float    fps;
+  unsigned num_frames;            // keys are at frames 0 to num_frames-1
+  unsigned num_bones;
+  unsigned bone_offset;           // MotionFileBone [num_bones]
+  unsigned num_tracks;            // num_bones * MOTION_TRACKS_PER_BONE
+  unsigned track_offset;          // MotionFileTrack [num_tracks]
+  unsigned num_keys;              // total over all tracks
+  unsigned time_offset;           // unsigned short [num_keys], frame of each key
+  unsigned key_offset;            // MotionFileKey [num_keys]
+  unsigned num_seeks;
+  unsigned seek_offset;           // unsigned short [num_seeks][num_tracks], see below
+} MotionFileHeader;
+
+typedef struct {
+  char  name [MOTION_FILE_NAME_SIZE];
+  int   parent;                   // index of parent bone or -1
+  float rest_position[3];         // relative to parent
+  float rest_rotation[4];         // quaternion x,y,z,w, relative to parent
+  float rest_length;
+} MotionFileBone;
+
+// Keys of a track are sorted by frame.  The first key is at frame 0, the
+// last at num_frames-1, values in between are interpolated.
+typedef struct {
+  unsigned first_key;
+  unsigned num_keys;
+  float    min[3];                // position and scale: value = min + q / 65535 * extent
+  float    extent[3];
+} MotionFileTrack;
+
+// A quantized key.  Position and scale are 16 bits per component in
+// the track's range.  Rotation is a unit quaternion stored as its three
+// smallest components (15 bits each) plus the index of the largest (2 bits).
+typedef struct {
+  unsigned short q[3];
+} MotionFileKey;
+
+// The seek index has an entry every MOTION_FILE_SEEK_FRAMES frames.  Entry
+// [s][t] is the key (relative to first_key of track t) in effect at frame
+// s * MOTION_FILE_SEEK_FRAMES, so sampling scans at most a few keys.
+
+// Data to write to a motion file
+typedef struct {
+  unsigned        source_size;
+  unsigned        source_time;
+  float           fps;
+  int             num_frames;
+  int             num_bones;
+  MotionFileBone *bones;
+  const float    *samples;        // [num_bones][num_frames][MOTION_FILE_SAMPLE_SIZE]
+  float           position_tolerance;   // max error allowed when removing keys, in units
+  float           rotation_tolerance;   // in radians
+  float           scale_tolerance;
+} MotionFileData;
+
+// A mapped motion file - all pointers point into the mapped file
+typedef struct {
+  const MotionFileHeader *header;
+  const MotionFileBone   *bones;
+  const MotionFileTrack  *tracks;
+  const unsigned short   *times;
+  const MotionFileKey    *keys;
+  const unsigned short   *seeks;
+  FileMap                 map;
+} MotionFile;
+
+/*___________________
+|
+| Functions
+|__________________*/
+
+// Quantizes and reduces keys and writes a motion file, returns true on success
+bool MotionFile_Write (const char *filename, MotionFileData *data);
+
+// Maps a motion file into memory and validates it, returns true on success
+bool MotionFile_Open (const char *filename, MotionFile *motion);
+
+// Unmaps a motion file
+void MotionFile_Close (MotionFile *motion);
+
+// Returns true if a motion file exists and was built from the current version of source_filename
+bool MotionFile_Is_Current (const char *filename, const char *source_filename);
+
+// Gets the local transform of a bone at any frame (fractional frames are interpolated)
+void MotionFile_Sample (
+  const MotionFile *motion,
+  int               bone,
+  float             frame,
+  float             position[3],
+  float             rotation[4],  // quaternion x,y,z,w
+  float             scale[3] );
+
+#endif
@@ -0,0 +1,395 @@
+/*____________________________________________________________________
+|
+| File: music_stream.cpp
+|
+| Description: Streaming music playback.  Instead of loading a whole
+|   wav file into a sound buffer, a stream keeps a small ring of
+|   waveOut buffers queued on the device.  A background thread refills
+|   each buffer from disk as soon as the device is done with it.  When
+|   looping, the end of the file is followed by the start of the file
+|   in the same buffer, so there is no gap at the loop point.
+|
+|   Only the ring is resident - NUM_BUFFERS x BUFFER_MS of audio.
+|
+| Functions: Music_Stream_Open
+|            Music_Stream_Play
+|            Music_Stream_Stop
+|            Music_Stream_Is_Playing
+|            Music_Stream_Set_Volume
+|            Music_Stream_Close
+|             Stream_Thread
+|             Fill_Buffer
+|             Read_Wav_Header
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+/*___________________
+|
+| Include Files
+|__________________*/
+
+#include <windows.h>
+#include <mmsystem.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "music_stream.h"
+
+/*___________________
+|
+| Constants
+|__________________*/
+
+#define NUM_BUFFERS 4
+#define BUFFER_MS   250   // milliseconds of audio per buffer
+
+/*___________________
+|
+| Type definitions
+|__________________*/
+
+struct MusicStream {
+  FILE            *fp;
+  WAVEFORMATEX     format;
+  unsigned         data_start;    // file offset of sample data
+  unsigned         data_size;
+  unsigned         data_pos;      // read position in sample data
+  bool             loop;
+  volatile bool    playing;
+  volatile bool    quit;
+  HWAVEOUT         device;
+  HANDLE           event;         // signaled by the device when a buffer is done
+  HANDLE           thread;
+  CRITICAL_SECTION lock;
+  WAVEHDR          headers [NUM_BUFFERS];
+  char            *buffers [NUM_BUFFERS];
+  unsigned         buffer_size;
+};
+
+/*___________________
+|
+| Function Prototypes
+|__________________*/
+
+static DWORD WINAPI Stream_Thread (LPVOID param);
+static bool Fill_Buffer (MusicStream *stream, WAVEHDR *header);
+static bool Read_Wav_Header (MusicStream *stream);
+
+/*____________________________________________________________________
+|
+| Function: Music_Stream_Open
+|
+| Input: Called from Program_Run()
+| Output: Opens a wav file and the wave out device.  Returns the stream
+|   or 0 on any error.
+|___________________________________________________________________*/
+
+MusicStream *Music_Stream_Open (char *filename, bool loop)
+{
+  int i;
+  MusicStream *stream;
+  bool ok;
+
+  stream = (MusicStream *) calloc (1, sizeof(MusicStream));
+  if (stream == 0)
+    return (0);
+  stream->loop = loop;
+  InitializeCriticalSection (&stream->lock);
+
+  stream->fp = fopen (filename, "rb");
+  ok = (stream->fp != 0) && Read_Wav_Header (stream);
+  if (ok) {
+    // Buffer size is a whole number of sample frames
+    stream->buffer_size = (stream->format.nAvgBytesPerSec * BUFFER_MS / 1000) / stream->format.nBlockAlign * stream->format.nBlockAlign;
+    stream->event = CreateEvent (NULL, FALSE, FALSE, NULL);
+    ok = (stream->event != NULL) &&
+         (waveOutOpen (&stream->device, WAVE_MAPPER, &stream->format, (DWORD_PTR) stream->event, 0, CALLBACK_EVENT) == MMSYSERR_NOERROR);
+  }
+  for (i=0; ok && (i<NUM_BUFFERS); i++) {
+    stream->buffers[i] = (char *) malloc (stream->buffer_size);
+    if (stream->buffers[i] == 0)
+      ok = false;
+    else {
+      stream->headers[i].lpData         = stream->buffers[i];
+      stream->headers[i].dwBufferLength = stream->buffer_size;
+      ok = (waveOutPrepareHeader (stream->device, &stream->headers[i], sizeof(WAVEHDR)) == MMSYSERR_NOERROR);
+      // Mark as done so the first Play() fills it
+      stream->headers[i].dwFlags |= WHDR_DONE;
+    }
+  }
+  if (ok) {
+    stream->thread = CreateThread (NULL, 0, Stream_Thread, (LPVOID) stream, 0, NULL);
+    ok = (stream->thread != NULL);
+    if (ok)
+      SetThreadPriority (stream->thread, THREAD_PRIORITY_ABOVE_NORMAL);
+  }
+  if (! ok) {
+    Music_Stream_Close (stream);
+    stream = 0;
+  }
+
+  return (stream);
+}
+
+/*____________________________________________________________________
+|
+| Function: Music_Stream_Play
+|
+| Input: Called from Program_Run()
+| Output: Starts playing from the beginning of the file.
+|___________________________________________________________________*/
+
+void Music_Stream_Play (MusicStream *stream)
+{
+  int i;
+
+  if (stream == 0)
+    return;
+
+  Music_Stream_Stop (stream);
+
+  EnterCriticalSection (&stream->lock);
+  stream->data_pos = 0;
+  fseek (stream->fp, stream->data_start, SEEK_SET);
+  stream->playing = true;
+  // Queue the whole ring, the thread keeps it full from here on
+  for (i=0; i<NUM_BUFFERS; i++)
+    if (Fill_Buffer (stream, &stream->headers[i]))
+      waveOutWrite (stream->device, &stream->headers[i], sizeof(WAVEHDR));
+  LeaveCriticalSection (&stream->lock);
+}
+
+/*____________________________________________________________________
+|
+| Function: Music_Stream_Stop
+|
+| Input: Called from Program_Run()
+| Output: Stops playing.  All buffers are returned by the device.
+|___________________________________________________________________*/
+
+void Music_Stream_Stop (MusicStream *stream)
+{
+  int i;
+
+  if (stream == 0)
+    return;
+
+  EnterCriticalSection (&stream->lock);
+  stream->playing = false;
+  waveOutReset (stream->device);
+  // Reset marks all queued buffers done, make sure of it for unqueued ones
+  for (i=0; i<NUM_BUFFERS; i++)
+    stream->headers[i].dwFlags |= WHDR_DONE;
+  LeaveCriticalSection (&stream->lock);
+}
+
+/*____________________________________________________________________
+|
+| Function: Music_Stream_Is_Playing
+|
+| Input: Called from Program_Run()
+| Output: Returns true if the stream is playing.
+|___________________________________________________________________*/
+
+bool Music_Stream_Is_Playing (MusicStream *stream)
+{
+  return (stream && stream->playing);
+}
+
+/*____________________________________________________________________
+|
+| Function: Music_Stream_Set_Volume
+|
+| Input: Called from Program_Run()
+| Output: Sets volume from 0 (silent) to 100 (full).
+|___________________________________________________________________*/
+
+void Music_Stream_Set_Volume (MusicStream *stream, int volume)
+{
+  DWORD level;
+
+  if (stream) {
+    if (volume < 0)
+      volume = 0;
+    if (volume > 100)
+      volume = 100;
+    // Low word is the left channel, high word the right
+    level = (DWORD) (volume * 0xFFFF / 100);
+    waveOutSetVolume (stream->device, (level << 16) | level);
+  }
+}
+
+/*____________________________________________________________________
+|
+| Function: Music_Stream_Close
+|
+| Input: Called from Program_Run()
+| Output: Stops the stream and frees all resources.
+|___________________________________________________________________*/
+
+void Music_Stream_Close (MusicStream *stream)
+{
+  int i;
+
+  if (stream == 0)
+    return;
+
+  if (stream->thread) {
+    stream->quit = true;
+    SetEvent (stream->event);
+    WaitForSingleObject (stream->thread, INFINITE);
+    CloseHandle (stream->thread);
+  }
+  if (stream->device) {
+    waveOutReset (stream->device);
+    for (i=0; i<NUM_BUFFERS; i++)
+      if (stream->headers[i].dwFlags & WHDR_PREPARED)
+        waveOutUnprepareHeader (stream->device, &stream->headers[i], sizeof(WAVEHDR));
+    waveOutClose (stream->device);
+  }
+  for (i=0; i<NUM_BUFFERS; i++)
+    if (stream->buffers[i])
+      free (stream->buffers[i]);
+  if (stream->event)
+    CloseHandle (stream->event);
+  if (stream->fp)
+    fclose (stream->fp);
+  DeleteCriticalSection (&stream->lock);
+  free (stream);
+}
+
+/*____________________________________________________________________
+|
+| Function: Stream_Thread
+|
+| Input: Called from Music_Stream_Open()
+| Output: Streaming thread.  Each time the device finishes a buffer,
+|   refills it from the file and queues it again.
+|___________________________________________________________________*/
+
+static DWORD WINAPI Stream_Thread (LPVOID param)
+{
+  int i, num_queued;
+  MusicStream *stream = (MusicStream *) param;
+
+  for (;;) {
+    WaitForSingleObject (stream->event, INFINITE);
+    if (stream->quit)
+      break;
+
+    EnterCriticalSection (&stream->lock);
+    if (stream->playing) {
+      num_queued = 0;
+      for (i=0; i<NUM_BUFFERS; i++) {
+        if (! (stream->headers[i].dwFlags & WHDR_DONE))
+          num_queued++;
+        else if (Fill_Buffer (stream, &stream->headers[i])) {
+          waveOutWrite (stream->device, &stream->headers[i], sizeof(WAVEHDR));
+          num_queued++;
+        }
+      }
+      // Not looping and the last buffer has played
+      if (num_queued == 0)
+        stream->playing = false;
+    }
+    LeaveCriticalSection (&stream->lock);
+  }
+
+  return (0);
+}
+
+/*____________________________________________________________________
+|
+| Function: Fill_Buffer
+|
+| Input: Called from Music_Stream_Play(), Stream_Thread()
+| Output: Reads the next block of samples into a buffer, wrapping to
+|   the start of the data if looping.  Returns false if there is
+|   nothing left to play.
+|___________________________________________________________________*/
+
+static bool Fill_Buffer (MusicStream *stream, WAVEHDR *header)
+{
+  unsigned n, filled, remaining;
+
+  filled = 0;
+  while (filled < stream->buffer_size) {
+    remaining = stream->data_size - stream->data_pos;
+    if (remaining == 0) {
+      if (! stream->loop)
+        break;
+      stream->data_pos = 0;
+      fseek (stream->fp, stream->data_start, SEEK_SET);
+      continue;
+    }
+    n = stream->buffer_size - filled;
+    if (n > remaining)
+      n = remaining;
+    n = (unsigned) fread (header->lpData + filled, 1, n, stream->fp);
+    if (n == 0)
+      break;
+    filled           += n;
+    stream->data_pos += n;
+  }
+
+  if (filled) {
+    header->dwBufferLength = filled;
+    header->dwFlags       &= ~WHDR_DONE;
+  }
+
+  return (filled > 0);
+}
+
+/*____________________________________________________________________
+|
+| Function: Read_Wav_Header
+|
+| Input: Called from Music_Stream_Open()
+| Output: Reads the format and finds the sample data of a RIFF wav
+|   file.  Only uncompressed PCM is supported.  Returns true on success.
+|___________________________________________________________________*/
+
+static bool Read_Wav_Header (MusicStream *stream)
+{
+  unsigned char riff[12], chunk[8], fmt[16];
+  unsigned size;
+  bool have_format = false;
+
+  if ((fread (riff, sizeof(riff), 1, stream->fp) != 1) ||
+      (memcmp (riff, "RIFF", 4) != 0) || (memcmp (riff + 8, "WAVE", 4) != 0))
+    return (false);
+
+  while (fread (chunk, sizeof(chunk), 1, stream->fp) == 1) {
+    size = chunk[4] | (chunk[5] << 8) | (chunk[6] << 16) | ((unsigned) chunk[7] << 24);
+    if (memcmp (chunk, "fmt ", 4) == 0) {
+      if ((size < sizeof(fmt)) || (fread (fmt, sizeof(fmt), 1, stream->fp) != 1))
+        return (false);
+      stream->format.wFormatTag      = (WORD) (fmt[0] | (fmt[1] << 8));
+      stream->format.nChannels       = (WORD) (fmt[2] | (fmt[3] << 8));
+      stream->format.nSamplesPerSec  = fmt[4] | (fmt[5] << 8) | (fmt[6] << 16) | ((unsigned) fmt[7] << 24);
+      stream->format.nAvgBytesPerSec = fmt[8] | (fmt[9] << 8) | (fmt[10] << 16) | ((unsigned) fmt[11] << 24);
+      stream->format.nBlockAlign     = (WORD) (fmt[12] | (fmt[13] << 8));
+      stream->format.wBitsPerSample  = (WORD) (fmt[14] | (fmt[15] << 8));
+      stream->format.cbSize          = 0;
+      if ((stream->format.wFormatTag != WAVE_FORMAT_PCM) || (stream->format.nBlockAlign == 0))
+        return (false);
+      have_format = true;
+      size -= sizeof(fmt);
+    }
+    else if (memcmp (chunk, "data", 4) == 0) {
+      if (! have_format)
+        return (false);
+      stream->data_start = (unsigned) ftell (stream->fp);
+      stream->data_size  = size / stream->format.nBlockAlign * stream->format.nBlockAlign;
+      return (stream->data_size > 0);
+    }
+    // Chunks are padded to an even length
+    if (fseek (stream->fp, size + (size & 1), SEEK_CUR) != 0)
+      return (false);
+  }
+
+  return (false);
+}
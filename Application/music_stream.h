@@ -0,0 +1,44 @@
+/*____________________________________________________________________
+|
+| File: music_stream.h
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+#ifndef _MUSIC_STREAM_H_
+#define _MUSIC_STREAM_H_
+
+/*___________________
+|
+| Type definitions
+|__________________*/
+
+typedef struct MusicStream MusicStream;
+
+/*___________________
+|
+| Functions
+|__________________*/
+
+// Opens a PCM wav file for streaming, returns 0 on any error
+MusicStream *Music_Stream_Open (
+  char *filename,
+  bool  loop );               // true = loop forever without a gap
+
+// Starts playing from the beginning
+void Music_Stream_Play (MusicStream *stream);
+
+// Stops playing
+void Music_Stream_Stop (MusicStream *stream);
+
+// Returns true if playing
+bool Music_Stream_Is_Playing (MusicStream *stream);
+
+// Sets volume, 0-100
+void Music_Stream_Set_Volume (MusicStream *stream, int volume);
+
+// Stops playing and closes the stream
+void Music_Stream_Close (MusicStream *stream);
+
+#endif
@@ -0,0 +1,568 @@
+/*____________________________________________________________________
+|
+| File: pack_file.cpp
+|
+| Description: Asset pack files (.pak).  A pack holds many files in one
+|   file that is mapped into memory, so finding a file is a hash probe
+|   and its data is a pointer into the mapping - no open or seek per
+|   file.  Paths are hashed with FNV-1a into an open addressed table.
+|   Entry data is 16-byte aligned and is optionally compressed with a
+|   small byte oriented LZ77 (literal runs plus 16-bit offset matches).
+|   Packs are built offline (see Tools/pack_build.cpp).
+|
+| Functions: PackFile_Write
+|            PackFile_Open
+|            PackFile_Close
+|            PackFile_Find
+|            PackFile_Data
+|            PackFile_Extract
+|            PackFile_Hash
+|             Normalize_Char
+|             Compress
+|             Decompress
+|             Put_Length
+|             Align
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+/*___________________
+|
+| Include Files
+|__________________*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pack_file.h"
+
+/*___________________
+|
+| Function Prototypes
+|__________________*/
+
+static char     Normalize_Char (char c);
+static unsigned Compress (const unsigned char *src, unsigned size, unsigned char *dst, unsigned capacity);
+static bool     Decompress (const unsigned char *src, unsigned stored_size, unsigned char *dst, unsigned size);
+static bool     Put_Length (unsigned char **p, const unsigned char *end, unsigned length);
+static unsigned Align (unsigned offset);
+
+/*___________________
+|
+| Constants
+|__________________*/
+
+#define PACK_FILE_ALIGNMENT 16
+
+#define FNV_OFFSET_BASIS 2166136261u
+#define FNV_PRIME        16777619u
+
+#define LZ_MIN_MATCH  4
+#define LZ_MAX_OFFSET 0xFFFF
+#define LZ_HASH_BITS  14
+
+/*____________________________________________________________________
+|
+| Function: PackFile_Write
+|
+| Input: Called from ____
+| Output: Writes a pack file.  An entry is kept compressed only if that
+|   saves at least 1/8 of its size.  Returns false on error or if two
+|   inputs have the same path.
+|___________________________________________________________________*/
+
+bool PackFile_Write (const char *filename, const PackFileInput *inputs, int num_inputs, bool compress)
+{
+  int i, j;
+  unsigned num_slots, slot, name_size, max_size, offset, stored_size;
+  PackFileHeader header;
+  PackFileEntry *slots, *entry;
+  unsigned *input_slot;
+  unsigned char *scratch, zero[PACK_FILE_ALIGNMENT];
+  const void *data;
+  char *names;
+  FILE *fp;
+  bool ok;
+
+  if (num_inputs < 0)
+    return (false);
+
+  // Table at most half full keeps probes short
+  for (num_slots=16; num_slots < (unsigned) num_inputs * 2; num_slots*=2)
+    ;
+  for (i=0, name_size=0, max_size=0; i<num_inputs; i++) {
+    name_size += (unsigned) strlen (inputs[i].path) + 1;
+    if (inputs[i].size > max_size)
+      max_size = inputs[i].size;
+  }
+  slots      = (PackFileEntry *) calloc (num_slots, sizeof(PackFileEntry));
+  input_slot = (unsigned *) malloc ((num_inputs ? num_inputs : 1) * sizeof(unsigned));
+  names      = (char *) malloc (name_size ? name_size : 1);
+  scratch    = compress ? (unsigned char *) malloc (max_size ? max_size : 1) : 0;
+  memset (zero, 0, sizeof(zero));
+  ok = (slots && input_slot && names && ((!compress) || scratch));
+
+/*____________________________________________________________________
+|
+| Build the hash table and the name table
+|___________________________________________________________________*/
+
+  name_size = 0;
+  for (i=0; ok && (i<num_inputs); i++) {
+    for (j=0; inputs[i].path[j]; j++)
+      names[name_size + j] = Normalize_Char (inputs[i].path[j]);
+    names[name_size + j] = 0;
+    for (slot = PackFile_Hash (names + name_size) & (num_slots - 1); slots[slot].flags & PACK_FILE_FLAG_USED; slot = (slot + 1) & (num_slots - 1))
+      if (strcmp (names + slots[slot].name, names + name_size) == 0)
+        ok = false;
+    input_slot[i] = slot;
+    entry = &slots[slot];
+    entry->hash  = PackFile_Hash (names + name_size);
+    entry->flags = PACK_FILE_FLAG_USED;
+    entry->name  = name_size;
+    entry->size  = inputs[i].size;
+    name_size += j + 1;
+  }
+
+/*____________________________________________________________________
+|
+| Write the entries in input order, then the header and tables
+|___________________________________________________________________*/
+
+  memset (&header, 0, sizeof(header));
+  header.magic       = PACK_FILE_MAGIC;
+  header.version     = PACK_FILE_VERSION;
+  header.num_entries = num_inputs;
+  header.num_slots   = num_slots;
+  header.slot_offset = Align (sizeof(PackFileHeader));
+  header.name_offset = Align (header.slot_offset + num_slots * sizeof(PackFileEntry));
+  header.name_size   = name_size;
+  offset = Align (header.name_offset + name_size);
+
+  fp = ok ? fopen (filename, "wb") : 0;
+  ok = (fp != 0) && (fseek (fp, offset, SEEK_SET) == 0);
+  for (i=0; ok && (i<num_inputs); i++) {
+    entry       = &slots[input_slot[i]];
+    data        = inputs[i].data;
+    stored_size = inputs[i].size;
+    if (compress && (inputs[i].size >= 64)) {
+      stored_size = Compress ((const unsigned char *) inputs[i].data, inputs[i].size, scratch, inputs[i].size - inputs[i].size / 8);
+      if (stored_size) {
+        data = scratch;
+        entry->flags |= PACK_FILE_FLAG_COMPRESSED;
+      }
+      else
+        stored_size = inputs[i].size;
+    }
+    entry->offset      = offset;
+    entry->stored_size = stored_size;
+    if (stored_size)
+      ok = (fwrite (data, stored_size, 1, fp) == 1);
+    offset += stored_size;
+    if (ok && (Align (offset) != offset)) {
+      ok = (fwrite (zero, Align (offset) - offset, 1, fp) == 1);
+      offset = Align (offset);
+    }
+  }
+  header.file_size = offset;
+
+  if (ok)
+    ok = (fseek (fp, 0, SEEK_SET) == 0) &&
+         (fwrite (&header, sizeof(header), 1, fp) == 1) &&
+         (fseek (fp, header.slot_offset, SEEK_SET) == 0) &&
+         (fwrite (slots, num_slots * sizeof(PackFileEntry), 1, fp) == 1) &&
+         (fseek (fp, header.name_offset, SEEK_SET) == 0) &&
+         ((name_size == 0) || (fwrite (names, name_size, 1, fp) == 1));
+  if (fp && (fclose (fp) != 0))
+    ok = false;
+
+  free (scratch);
+  free (names);
+  free (input_slot);
+  free (slots);
+
+  return (ok);
+}
+
+/*____________________________________________________________________
+|
+| Function: PackFile_Open
+|
+| Input: Called from ____
+| Output: Maps a pack file and sets pointers to its tables.  Returns
+|   false if the file can't be mapped or fails validation.
+|___________________________________________________________________*/
+
+bool PackFile_Open (const char *filename, PackFile *pack)
+{
+  unsigned i, n;
+  unsigned long long end;
+  const unsigned char *base;
+  const PackFileHeader *header;
+  const PackFileEntry *slots = 0;
+  const char *names = 0;
+  bool ok;
+
+  memset (pack, 0, sizeof(PackFile));
+  if (!FileMap_Open (filename, &pack->map))
+    return (false);
+
+  base   = (const unsigned char *) pack->map.data;
+  header = (const PackFileHeader *) base;
+
+/*____________________________________________________________________
+|
+| Validate header, tables and every entry
+|___________________________________________________________________*/
+
+  ok = (pack->map.size >= sizeof(PackFileHeader)) &&
+       (header->magic == PACK_FILE_MAGIC) &&
+       (header->version == PACK_FILE_VERSION) &&
+       (header->file_size == pack->map.size) &&
+       (header->num_slots > header->num_entries) &&
+       ((header->num_slots & (header->num_slots - 1)) == 0) &&
+       (header->slot_offset == Align (sizeof(PackFileHeader))) &&
+       (header->name_offset == Align (header->slot_offset + header->num_slots * sizeof(PackFileEntry))) &&
+       ((unsigned long long) header->name_offset + header->name_size <= header->file_size) &&
+       ((header->name_size == 0) || (base[header->name_offset + header->name_size - 1] == 0));
+
+  if (ok) {
+    slots = (const PackFileEntry *) (base + header->slot_offset);
+    names = (const char *) (base + header->name_offset);
+    for (i=0, n=0; ok && (i<header->num_slots); i++)
+      if (slots[i].flags & PACK_FILE_FLAG_USED) {
+        n++;
+        end = (unsigned long long) slots[i].offset + slots[i].stored_size;
+        ok = (slots[i].name < header->name_size) &&
+             ((slots[i].offset % PACK_FILE_ALIGNMENT) == 0) &&
+             (end <= header->file_size) &&
+             ((slots[i].flags & PACK_FILE_FLAG_COMPRESSED) || (slots[i].stored_size == slots[i].size));
+      }
+    ok = ok && (n == header->num_entries);
+  }
+  if (!ok) {
+    PackFile_Close (pack);
+    return (false);
+  }
+
+  pack->header = header;
+  pack->slots  = slots;
+  pack->names  = names;
+
+  return (true);
+}
+
+/*____________________________________________________________________
+|
+| Function: PackFile_Close
+|
+| Input: Called from ____
+| Output: Unmaps a pack file.
+|___________________________________________________________________*/
+
+void PackFile_Close (PackFile *pack)
+{
+  FileMap_Close (&pack->map);
+  memset (pack, 0, sizeof(PackFile));
+}
+
+/*____________________________________________________________________
+|
+| Function: PackFile_Find
+|
+| Input: Called from ____
+| Output: Returns the entry for a path, or 0 if it isn't in the pack.
+|   The path can use either separator and any case.
+|___________________________________________________________________*/
+
+const PackFileEntry *PackFile_Find (const PackFile *pack, const char *path)
+{
+  unsigned hash, mask, slot, i;
+  const PackFileEntry *entry;
+  const char *name;
+
+  if (pack->header == 0)
+    return (0);
+
+  hash = PackFile_Hash (path);
+  mask = pack->header->num_slots - 1;
+  for (slot=hash&mask; ; slot=(slot+1)&mask) {
+    entry = &pack->slots[slot];
+    // An empty slot ends the probe (the table always has one)
+    if (!(entry->flags & PACK_FILE_FLAG_USED))
+      return (0);
+    if (entry->hash == hash) {
+      name = pack->names + entry->name;
+      for (i=0; path[i] && (Normalize_Char (path[i]) == name[i]); i++)
+        ;
+      if ((path[i] == 0) && (name[i] == 0))
+        return (entry);
+    }
+  }
+}
+
+/*____________________________________________________________________
+|
+| Function: PackFile_Data
+|
+| Input: Called from ____
+| Output: Returns a pointer to the data of an entry as stored.  If the
+|   entry isn't compressed this is the file itself.
+|___________________________________________________________________*/
+
+const void *PackFile_Data (const PackFile *pack, const PackFileEntry *entry)
+{
+  return ((const unsigned char *) pack->map.data + entry->offset);
+}
+
+/*____________________________________________________________________
+|
+| Function: PackFile_Extract
+|
+| Input: Called from ____
+| Output: Copies an entry to buffer, decompressing it if needed.  Buffer
+|   must hold entry->size bytes.  Returns true on success.
+|___________________________________________________________________*/
+
+bool PackFile_Extract (const PackFile *pack, const PackFileEntry *entry, void *buffer)
+{
+  const unsigned char *data;
+
+  data = (const unsigned char *) PackFile_Data (pack, entry);
+  if (entry->flags & PACK_FILE_FLAG_COMPRESSED)
+    return (Decompress (data, entry->stored_size, (unsigned char *) buffer, entry->size));
+
+  memcpy (buffer, data, entry->size);
+
+  return (true);
+}
+
+/*____________________________________________________________________
+|
+| Function: PackFile_Hash
+|
+| Input: Called from PackFile_Write(), PackFile_Find()
+| Output: Returns the 32-bit FNV-1a hash of a path, lower case with /
+|   separators.
+|___________________________________________________________________*/
+
+unsigned PackFile_Hash (const char *path)
+{
+  unsigned hash = FNV_OFFSET_BASIS;
+
+  for (; *path; path++) {
+    hash ^= (unsigned char) Normalize_Char (*path);
+    hash *= FNV_PRIME;
+  }
+
+  return (hash);
+}
+
+/*____________________________________________________________________
+|
+| Function: Normalize_Char
+|
+| Input: Called from PackFile_Write(), PackFile_Find(), PackFile_Hash()
+| Output: Returns a path character lower case, with \ changed to /.
+|___________________________________________________________________*/
+
+static char Normalize_Char (char c)
+{
+  if (c == '\\')
+    return ('/');
+  if ((c >= 'A') && (c <= 'Z'))
+    return (c - 'A' + 'a');
+
+  return (c);
+}
+
+/*____________________________________________________________________
+|
+| Function: Compress
+|
+| Input: Called from PackFile_Write()
+| Output: Compresses src into dst.  Returns the compressed size, or 0 if
+|   it doesn't fit in capacity bytes.
+|
+|   The output is a list of sequences, each a token byte (high 4 bits
+|   literal count, low 4 bits match length - 4), more literal count bytes
+|   if it was 15, the literals, a 2 byte offset, then more match length
+|   bytes if it was 15.  Extra length bytes are added until one is less
+|   than 255.  The last sequence has literals only.
+|___________________________________________________________________*/
+
+static unsigned Compress (const unsigned char *src, unsigned size, unsigned char *dst, unsigned capacity)
+{
+  unsigned i, anchor, candidate, literals, length, h;
+  unsigned char *p, *token;
+  const unsigned char *end;
+  unsigned *table;
+
+  table = (unsigned *) malloc ((1 << LZ_HASH_BITS) * sizeof(unsigned));
+  if (table == 0)
+    return (0);
+  // Positions are stored plus 1, so 0 is an empty slot
+  memset (table, 0, (1 << LZ_HASH_BITS) * sizeof(unsigned));
+
+  p      = dst;
+  end    = dst + capacity;
+  anchor = 0;
+  i      = 0;
+  while (i + LZ_MIN_MATCH <= size) {
+    h = (((unsigned) src[i] | ((unsigned) src[i+1] << 8) | ((unsigned) src[i+2] << 16) | ((unsigned) src[i+3] << 24)) * 2654435761u) >> (32 - LZ_HASH_BITS);
+    candidate = table[h];
+    table[h]  = i + 1;
+    if ((candidate == 0) || (i - (candidate - 1) > LZ_MAX_OFFSET) || (memcmp (src + candidate - 1, src + i, LZ_MIN_MATCH) != 0)) {
+      i++;
+      continue;
+    }
+    candidate--;
+    for (length=LZ_MIN_MATCH; (i + length < size) && (src[candidate + length] == src[i + length]); length++)
+      ;
+
+    // Sequence: literals from anchor to i, then the match
+    literals = i - anchor;
+    if (p + 1 + literals + 2 > end) {
+      free (table);
+      return (0);
+    }
+    token  = p++;
+    *token = (unsigned char) (((literals < 15) ? literals : 15) << 4);
+    if ((literals >= 15) && (!Put_Length (&p, end, literals - 15))) {
+      free (table);
+      return (0);
+    }
+    if (p + literals + 2 > end) {
+      free (table);
+      return (0);
+    }
+    memcpy (p, src + anchor, literals);
+    p += literals;
+    *p++ = (unsigned char) (i - candidate);
+    *p++ = (unsigned char) ((i - candidate) >> 8);
+    *token |= (unsigned char) (((length - LZ_MIN_MATCH) < 15) ? (length - LZ_MIN_MATCH) : 15);
+    if ((length - LZ_MIN_MATCH >= 15) && (!Put_Length (&p, end, length - LZ_MIN_MATCH - 15))) {
+      free (table);
+      return (0);
+    }
+    i += length;
+    anchor = i;
+  }
+  free (table);
+
+  // Last sequence, literals only
+  literals = size - anchor;
+  if (p + 1 > end)
+    return (0);
+  token  = p++;
+  *token = (unsigned char) (((literals < 15) ? literals : 15) << 4);
+  if ((literals >= 15) && (!Put_Length (&p, end, literals - 15)))
+    return (0);
+  if (p + literals > end)
+    return (0);
+  memcpy (p, src + anchor, literals);
+  p += literals;
+
+  return ((unsigned) (p - dst));
+}
+
+/*____________________________________________________________________
+|
+| Function: Decompress
+|
+| Input: Called from PackFile_Extract()
+| Output: Decompresses data written by Compress().  Returns true if the
+|   data is valid and decompresses to exactly size bytes.
+|___________________________________________________________________*/
+
+static bool Decompress (const unsigned char *src, unsigned stored_size, unsigned char *dst, unsigned size)
+{
+  unsigned literals, length, offset, n;
+  const unsigned char *src_end;
+  unsigned char *p, *dst_end;
+
+  p       = dst;
+  dst_end = dst + size;
+  src_end = src + stored_size;
+  while (src < src_end) {
+    literals = *src >> 4;
+    length   = (*src & 15) + LZ_MIN_MATCH;
+    src++;
+    if (literals == 15)
+      do {
+        if (src >= src_end)
+          return (false);
+        n = *src++;
+        literals += n;
+      } while (n == 255);
+    if ((literals > (unsigned) (src_end - src)) || (literals > (unsigned) (dst_end - p)))
+      return (false);
+    memcpy (p, src, literals);
+    p   += literals;
+    src += literals;
+    if (src == src_end)
+      break;
+
+    if (src_end - src < 2)
+      return (false);
+    offset = src[0] | (src[1] << 8);
+    src += 2;
+    if (length == 15 + LZ_MIN_MATCH)
+      do {
+        if (src >= src_end)
+          return (false);
+        n = *src++;
+        length += n;
+      } while (n == 255);
+    if ((offset == 0) || (offset > (unsigned) (p - dst)) || (length > (unsigned) (dst_end - p)))
+      return (false);
+    // Byte by byte if the match overlaps its own output
+    if (offset >= length) {
+      memcpy (p, p - offset, length);
+      p += length;
+    }
+    else
+      for (; length; length--, p++)
+        *p = *(p - offset);
+  }
+
+  return (p == dst_end);
+}
+
+/*____________________________________________________________________
+|
+| Function: Put_Length
+|
+| Input: Called from Compress()
+| Output: Writes the extra bytes of a length of 15 or more.  Returns
+|   false if they don't fit.
+|___________________________________________________________________*/
+
+static bool Put_Length (unsigned char **p, const unsigned char *end, unsigned length)
+{
+  for (;;) {
+    if (*p >= end)
+      return (false);
+    if (length < 255) {
+      *(*p)++ = (unsigned char) length;
+      return (true);
+    }
+    *(*p)++ = 255;
+    length -= 255;
+  }
+}
+
+/*____________________________________________________________________
+|
+| Function: Align
+|
+| Input: Called from PackFile_Write(), PackFile_Open()
+| Output: Returns offset rounded up to the entry alignment.
+|___________________________________________________________________*/
+
+static unsigned Align (unsigned offset)
+{
+  return ((offset + PACK_FILE_ALIGNMENT - 1) & ~(PACK_FILE_ALIGNMENT - 1));
+}
@@ -0,0 +1,95 @@
+/*____________________________________________________________________
+|
+| File: pack_file.h
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+#ifndef _PACK_FILE_H_
+#define _PACK_FILE_H_
+
+#include "file_map.h"
+
+/*___________________
+|
+| Constants
+|__________________*/
+
+#define PACK_FILE_MAGIC     0x4B505847  // "GXPK"
+#define PACK_FILE_VERSION   1
+#define PACK_FILE_EXTENSION ".pak"
+
+// Entry flags
+#define PACK_FILE_FLAG_USED       0x1   // slot holds an entry
+#define PACK_FILE_FLAG_COMPRESSED 0x2   // entry is LZ compressed
+
+/*___________________
+|
+| Type definitions
+|__________________*/
+
+// All offsets are from the start of the file and 16-byte aligned
+typedef struct {
+  unsigned magic;
+  unsigned version;
+  unsigned file_size;
+  unsigned num_entries;
+  unsigned num_slots;             // power of 2, more than num_entries
+  unsigned slot_offset;           // PackFileEntry [num_slots], an open addressed hash table
+  unsigned name_offset;           // 0 terminated paths
+  unsigned name_size;
+} PackFileHeader;
+
+// Paths are stored lower case with / separators, the hash is FNV-1a of the stored path
+typedef struct {
+  unsigned hash;
+  unsigned flags;
+  unsigned name;                  // offset in name table
+  unsigned offset;                // start of entry data
+  unsigned stored_size;           // size in the pack
+  unsigned size;                  // size when extracted
+} PackFileEntry;
+
+// A file to write to a pack
+typedef struct {
+  const char *path;
+  const void *data;
+  unsigned    size;
+} PackFileInput;
+
+// A mapped pack file - all pointers point into the mapped file
+typedef struct {
+  const PackFileHeader *header;
+  const PackFileEntry  *slots;
+  const char           *names;
+  FileMap               map;
+} PackFile;
+
+/*___________________
+|
+| Functions
+|__________________*/
+
+// Writes a pack file, compressing entries where that saves space if compress is true, returns true on success
+bool PackFile_Write (const char *filename, const PackFileInput *inputs, int num_inputs, bool compress);
+
+// Maps a pack file into memory and validates it, returns true on success
+bool PackFile_Open (const char *filename, PackFile *pack);
+
+// Unmaps a pack file
+void PackFile_Close (PackFile *pack);
+
+// Returns the entry for a path (either separator, any case) or 0 if not in the pack
+const PackFileEntry *PackFile_Find (const PackFile *pack, const char *path);
+
+// Returns the data of an entry as stored in the pack
+const void *PackFile_Data (const PackFile *pack, const PackFileEntry *entry);
+
+// Copies or decompresses an entry into a buffer of entry->size bytes, returns true on success
+bool PackFile_Extract (const PackFile *pack, const PackFileEntry *entry, void *buffer);
+
+// Returns the hash of a path
+unsigned PackFile_Hash (const char *path);
+
+#endif
@@ -0,0 +1,207 @@
+/*____________________________________________________________________
+|
+| File: particle_queue.cpp
+|
+| Description: Queues particle system draws for a frame and draws them
+|   all at once after the opaque geometry.  When sorting is on, every
+|   draw from every emitter is put in back-to-front order with a radix
+|   sort on quantized view depth so blended sprites composite correctly.
+|
+| Functions: Particle_Queue_Init
+|            Particle_Queue_Free
+|            Particle_Queue_Set_Sorting
+|            Particle_Queue_Get_Sorting
+|            Particle_Queue_Begin
+|            Particle_Queue_Add
+|            Particle_Queue_Draw
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+/*___________________
+|
+| Include Files
+|__________________*/
+
+#include <first_header.h>
+
+#include "dp.h"
+
+#include "radix_sort.h"
+#include "particle_queue.h"
+#include "benchmark_count.h"
+
+/*___________________
+|
+| Type definitions
+|__________________*/
+
+typedef struct {
+  gx3dParticleSystem psys;
+  gx3dMatrix         m;
+  unsigned           elapsed_time;
+} ParticleDraw;
+
+/*___________________
+|
+| Global variables
+|__________________*/
+
+static ParticleDraw   *draws;        // draws queued this frame
+static RadixSortEntry *order;        // sort key + draw index, one per draw
+static RadixSortEntry *scratch;
+static int             max_draws;
+static int             num_draws;
+static bool            sorting = true;
+
+static gx3dVector      camera_position;
+static gx3dVector      camera_heading;
+static float           depth_near, depth_far;
+
+/*____________________________________________________________________
+|
+| Function: Particle_Queue_Init
+|
+| Input: Called from Program_Run()
+| Output: Allocates the queue.
+|___________________________________________________________________*/
+
+void Particle_Queue_Init (int max)
+{
+  draws   = (ParticleDraw *) malloc (max * sizeof(ParticleDraw));
+  order   = (RadixSortEntry *) malloc (max * sizeof(RadixSortEntry));
+  scratch = (RadixSortEntry *) malloc (max * sizeof(RadixSortEntry));
+  max_draws = max;
+  num_draws = 0;
+}
+
+/*____________________________________________________________________
+|
+| Function: Particle_Queue_Free
+|
+| Input: Called from Program_Run()
+| Output: Frees the queue.
+|___________________________________________________________________*/
+
+void Particle_Queue_Free ()
+{
+  free (draws);
+  free (order);
+  free (scratch);
+  draws   = 0;
+  order   = 0;
+  scratch = 0;
+  max_draws = 0;
+  num_draws = 0;
+}
+
+/*____________________________________________________________________
+|
+| Function: Particle_Queue_Set_Sorting
+|
+| Input: Called from Program_Run()
+| Output: Turns depth sorting on or off.  With sorting off, draws are
+|   made in the order they were added.
+|___________________________________________________________________*/
+
+void Particle_Queue_Set_Sorting (bool sort)
+{
+  sorting = sort;
+}
+
+/*____________________________________________________________________
+|
+| Function: Particle_Queue_Get_Sorting
+|
+| Input: Called from Program_Run()
+| Output: Returns true if depth sorting is on.
+|___________________________________________________________________*/
+
+bool Particle_Queue_Get_Sorting ()
+{
+  return (sorting);
+}
+
+/*____________________________________________________________________
+|
+| Function: Particle_Queue_Begin
+|
+| Input: Called from Program_Run()
+| Output: Empties the queue and saves the camera used to compute depths.
+|___________________________________________________________________*/
+
+void Particle_Queue_Begin (
+  gx3dVector *position,
+  gx3dVector *heading,
+  float       near_plane,
+  float       far_plane )
+{
+  camera_position = *position;
+  camera_heading  = *heading;
+  depth_near      = near_plane;
+  depth_far       = far_plane;
+  num_draws       = 0;
+}
+
+/*____________________________________________________________________
+|
+| Function: Particle_Queue_Add
+|
+| Input: Called from Program_Run()
+| Output: Adds a draw to the queue.  The sort key is the view depth of
+|   the emitter origin (translation part of the matrix).
+|___________________________________________________________________*/
+
+void Particle_Queue_Add (
+  gx3dParticleSystem psys,
+  gx3dMatrix        *m,
+  unsigned           elapsed_time )
+{
+  gx3dVector origin, v;
+  float depth;
+
+  if (num_draws < max_draws) {
+    draws[num_draws].psys         = psys;
+    draws[num_draws].m            = *m;
+    draws[num_draws].elapsed_time = elapsed_time;
+    // Get distance of emitter along the view direction
+    origin.x = 0;
+    origin.y = 0;
+    origin.z = 0;
+    gx3d_MultiplyVectorMatrix (&origin, m, &v);
+    depth = (v.x - camera_position.x) * camera_heading.x +
+            (v.y - camera_position.y) * camera_heading.y +
+            (v.z - camera_position.z) * camera_heading.z;
+    order[num_draws].key   = Radix_Sort_Depth_Key (depth, depth_near, depth_far);
+    order[num_draws].index = num_draws;
+    num_draws++;
+  }
+}
+
+/*____________________________________________________________________
+|
+| Function: Particle_Queue_Draw
+|
+| Input: Called from Program_Run()
+| Output: Updates and draws all particle systems in the queue.  Caller
+|   should have alpha blending set up.
+|___________________________________________________________________*/
+
+void Particle_Queue_Draw (gx3dVector *heading)
+{
+  int i;
+  ParticleDraw *draw;
+
+  if (sorting)
+    Radix_Sort (order, scratch, num_draws);
+
+  for (i=0; i<num_draws; i++) {
+    draw = &draws[order[i].index];
+    gx3d_SetParticleSystemMatrix (draw->psys, &draw->m);
+    gx3d_UpdateParticleSystem (draw->psys, draw->elapsed_time);
+    gx3d_DrawParticleSystem (draw->psys, heading, false);
+  }
+
+  num_draws = 0;
+}
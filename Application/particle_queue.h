@@ -0,0 +1,35 @@
+/*____________________________________________________________________
+|
+| File: particle_queue.h
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+// Allocates a queue able to hold this many particle system draws per frame
+void Particle_Queue_Init (int max_draws);
+
+// Free any resources
+void Particle_Queue_Free ();
+
+// Turns depth sorting on or off (on by default)
+void Particle_Queue_Set_Sorting (bool sort);
+
+// Returns true if depth sorting is on
+bool Particle_Queue_Get_Sorting ();
+
+// Starts a new frame, emptying the queue
+void Particle_Queue_Begin (
+  gx3dVector *camera_position,
+  gx3dVector *camera_heading,   // normalized
+  float       near_plane,
+  float       far_plane );
+
+// Adds a particle system draw to the queue (drawn later by Particle_Queue_Draw)
+void Particle_Queue_Add (
+  gx3dParticleSystem psys,
+  gx3dMatrix        *m,         // world transform for this draw
+  unsigned           elapsed_time );
+
+// Updates and draws all queued particle systems, back-to-front if sorting is on
+void Particle_Queue_Draw (gx3dVector *heading);
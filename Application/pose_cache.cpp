@@ -0,0 +1,77 @@
+/*____________________________________________________________________
+|
+| File: pose_cache.cpp
+|
+| Description: Remembers the inputs (motions, sample times and blend
+|   weights) of the pose last written to a blend tree's output, so a
+|   frame that would produce the same pose can skip sampling the
+|   motions and updating the tree.  Updating the tree skins the
+|   character's vertices, and the skinned vertices stay in the layer
+|   until the next update, so an idle character costs nothing.
+|
+|   Inputs are compared exactly: a pose is only reused when it would
+|   come out the same.
+|
+| Functions: Pose_Cache_Invalidate
+|            Pose_Cache_Changed
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+/*___________________
+|
+| Include Files
+|__________________*/
+
+#include "pose_cache.h"
+
+/*____________________________________________________________________
+|
+| Function: Pose_Cache_Invalidate
+|
+| Input: Called from ____
+| Output: Forgets the cached pose.
+|___________________________________________________________________*/
+
+void Pose_Cache_Invalidate (PoseCache *cache)
+{
+  cache->valid      = false;
+  cache->num_tracks = 0;
+}
+
+/*____________________________________________________________________
+|
+| Function: Pose_Cache_Changed
+|
+| Input: Called from ____
+| Output: Returns false if the tracks are the same as the cached ones,
+|   else caches them and returns true.  More than POSE_CACHE_MAX_TRACKS
+|   tracks are never cached (always returns true).
+|___________________________________________________________________*/
+
+bool Pose_Cache_Changed (PoseCache *cache, const PoseTrack *tracks, int num_tracks)
+{
+  int i;
+  bool same;
+
+  if (num_tracks > POSE_CACHE_MAX_TRACKS) {
+    Pose_Cache_Invalidate (cache);
+    return (true);
+  }
+
+  same = cache->valid && (cache->num_tracks == num_tracks);
+  for (i=0; (i<num_tracks) && same; i++)
+    same = (cache->tracks[i].motion == tracks[i].motion) &&
+           (cache->tracks[i].time   == tracks[i].time)   &&
+           (cache->tracks[i].weight == tracks[i].weight);
+  if (same)
+    return (false);
+
+  for (i=0; i<num_tracks; i++)
+    cache->tracks[i] = tracks[i];
+  cache->num_tracks = num_tracks;
+  cache->valid      = true;
+
+  return (true);
+}
@@ -0,0 +1,53 @@
+/*____________________________________________________________________
+|
+| File: pose_cache.h
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+#ifndef _POSE_CACHE_H_
+#define _POSE_CACHE_H_
+
+/*___________________
+|
+| Constants
+|__________________*/
+
+#define POSE_CACHE_MAX_TRACKS 4
+
+/*___________________
+|
+| Type definitions
+|__________________*/
+
+// One motion feeding a blend tree
+typedef struct {
+  const void *motion;         // gx3dMotion *
+  float       time;           // sample time in seconds
+  float       weight;         // blend weight (1 if the tree doesn't blend)
+} PoseTrack;
+
+// The inputs of the pose last written to a blend tree's output
+typedef struct {
+  bool      valid;
+  int       num_tracks;
+  PoseTrack tracks [POSE_CACHE_MAX_TRACKS];
+} PoseCache;
+
+/*___________________
+|
+| Functions
+|__________________*/
+
+// Forgets the cached pose, so the next call to Pose_Cache_Changed() returns true
+void Pose_Cache_Invalidate (PoseCache *cache);
+
+// Returns true (and remembers the tracks) if the pose they produce differs from the
+//   cached one, meaning the motions and blend tree must be updated
+bool Pose_Cache_Changed (
+  PoseCache       *cache,
+  const PoseTrack *tracks,
+  int              num_tracks );
+
+#endif
@@ -2,11 +2,15 @@
 |
 | File: position.cpp
 |
-| Description: Functions to create and manipulate a camera.
+| Description: Functions to create and manipulate a camera.  The
+|   camera's heading, basis and view matrix are kept by camera.cpp.
+|   Nothing is set in the graphics state: the caller sets the camera's
+|   view matrix in each viewport it is drawn in (see viewport.cpp).
 |
 | Functions: Position_Init
 |            Position_Free
 |            Position_Set_Speed
+|            Position_Get_Camera
 |            Position_Update
 |
 | (C) Copyright 2013 Abonvita Software LLC.
@@ -23,29 +27,16 @@
 
 #include "dp.h"
 
+#include "camera.h"
 #include "position.h"
 
-/*___________________
-|
-| Constants
-|__________________*/
-
-#define ROTATE_UP_MAX   ((float)-89)
-#define ROTATE_DOWN_MAX ((float)89)                   
-
-#define CAMERA_DISTANCE 10	// distance of 'to' point away from the camera position
-
 /*___________________
 |
 | Global variables
 |__________________*/
 
-static gx3dVector current_position;			// current position
-static gx3dVector start_heading;				// start heading (normalized)
-static gx3dVector current_heading;			// current heading (normalized)
-static float      current_speed;				// current move speed
-static float      current_xrotate;			// current rotation of camera	
-static float	    current_yrotate;
+static Camera current_camera;
+static float  current_speed;				// current move speed
 
 /*____________________________________________________________________
 |
@@ -62,15 +53,12 @@ void Position_Init (
 {
   bool b;
   gx3dVector v;
+  float p[3] = { position->x, position->y, position->z };
+  float h[3] = { heading->x, heading->y, heading->z };
 
   // Init global variables
-  current_position = *position;
-  current_heading  = *heading;
-  gx3d_NormalizeVector (&current_heading, &current_heading); // just in case its not already normalized
-  start_heading    = current_heading;
-  current_speed    = move_speed;
-  current_xrotate  = 0;
-  current_yrotate  = 0;
+  Camera_Init (&current_camera, p, h);
+  current_speed = move_speed;
 
   Position_Update (0, 0, 0, 0, true, &b, &b, &v, &v);	// force an update to start the camera off in the correct position
 }
@@ -101,6 +89,19 @@ void Position_Set_Speed (float move_speed)
   current_speed = move_speed;
 }
 
+/*____________________________________________________________________
+|
+| Function: Position_Get_Camera
+|
+| Input: Called from ____
+| Output: Returns the camera moved by Position_Update().
+|___________________________________________________________________*/
+
+Camera *Position_Get_Camera ()
+{
+  return (&current_camera);
+}
+
 /*____________________________________________________________________
 |
 | Function: Position_Update
@@ -120,11 +121,7 @@ void Position_Update (
   gx3dVector *new_position,
   gx3dVector *new_heading )
 {
-	int n;
-	float move_amount;
-  gx3dMatrix m, mx, my, mxy;
-  gx3dVector to, world_up = { 0, 1, 0 };
-	gx3dVector v1, v_right;
+	float move_amount, forward, right;
 
 /*____________________________________________________________________
 |
@@ -143,38 +140,11 @@ void Position_Update (
 |___________________________________________________________________*/
 
   // Smooth out the rotations
-	n = xrotate;
-	xrotate = (int) sqrt ((double)(abs(xrotate)));
-	if (n < 0)
-		xrotate = -xrotate;
-	n = yrotate;
-	yrotate = (int) sqrt ((double)(abs(yrotate)));
-	if (n < 0)
-		yrotate = -yrotate;
-
-	// Add to the current x axis rotation
-	current_xrotate += (float)xrotate * 0.5;	// scale by .5 so doesn't rotate so fast
-  if (current_xrotate < ROTATE_UP_MAX)
-    current_xrotate = ROTATE_UP_MAX;
-  else if (current_xrotate > ROTATE_DOWN_MAX)
-    current_xrotate = ROTATE_DOWN_MAX;
-
-	// Add to the current y axis rotation
-  current_yrotate += (float)yrotate * 0.5;	// scale by .5 so doesn't rotate so fast
-  while (current_yrotate < -360)
-    current_yrotate += 360;
-  while (current_yrotate > 360)
-    current_yrotate -= 360;
-
-  // Rotate heading
-  if ((xrotate != 0) OR (yrotate != 0)) {
-    gx3d_GetRotateXMatrix (&mx, current_xrotate);
-    gx3d_GetRotateYMatrix (&my, current_yrotate);
-    gx3d_MultiplyMatrix (&mx, &my, &mxy);
-    gx3d_MultiplyVectorMatrix (&start_heading, &mxy, &current_heading);  
-    // Make sure heading is normalized
-    gx3d_NormalizeVector (&current_heading, &current_heading);
-  }
+	xrotate = Camera_Smooth_Delta (xrotate);
+	yrotate = Camera_Smooth_Delta (yrotate);
+
+	// Add to the current rotation, scaled by .5 so doesn't rotate so fast
+	Camera_Rotate (&current_camera, (float)xrotate * 0.5f, (float)yrotate * 0.5f);
   
 /*____________________________________________________________________
 |
@@ -182,32 +152,18 @@ void Position_Update (
 |___________________________________________________________________*/
   
   if (move OR update_all) {
-		if (move & POSITION_MOVE_FORWARD) {
-			// Move 0.5 feet along the view vector
-			gx3d_MultiplyScalarVector (move_amount, &current_heading, &v1);
-		  gx3d_AddVector (&current_position, &v1, &current_position);
-		}
-		if (move & POSITION_MOVE_BACK) {
-			// Move -0.5 feet along the view vector
-			gx3d_MultiplyScalarVector (-move_amount, &current_heading, &v1);
-		  gx3d_AddVector (&current_position, &v1, &current_position);
-		}
-		if (move & POSITION_MOVE_RIGHT) {
-			// Compute the normalized right vector
-			gx3d_VectorCrossProduct (&world_up, &current_heading, &v_right);
-			gx3d_NormalizeVector (&v_right, &v_right);
-			// Move 0.5 feet along the right vector
-			gx3d_MultiplyScalarVector (move_amount, &v_right, &v1);
-		  gx3d_AddVector (&current_position, &v1, &current_position);
-		}
-		if (move & POSITION_MOVE_LEFT) {
-			// Compute the normalized right vector
-			gx3d_VectorCrossProduct (&world_up, &current_heading, &v_right);
-			gx3d_NormalizeVector (&v_right, &v_right);
-			// Move -0.5 feet along the right vector
-			gx3d_MultiplyScalarVector (-move_amount, &v_right, &v1);
-		  gx3d_AddVector (&current_position, &v1, &current_position);
-		}
+		forward = 0;
+		right   = 0;
+		if (move & POSITION_MOVE_FORWARD)
+			forward += move_amount;
+		if (move & POSITION_MOVE_BACK)
+			forward -= move_amount;
+		if (move & POSITION_MOVE_RIGHT)
+			right += move_amount;
+		if (move & POSITION_MOVE_LEFT)
+			right -= move_amount;
+		// Move along the (new) view and right vectors
+		Camera_Move (&current_camera, forward, right);
 		*position_changed = true;
 	}
 
@@ -216,24 +172,18 @@ void Position_Update (
 | Update camera
 |___________________________________________________________________*/
   
-  if ((xrotate != 0) OR (yrotate != 0) OR *position_changed) {
-    // Compute a point the camera is looking at
-		gx3d_MultiplyScalarVector (CAMERA_DISTANCE, &current_heading, &v1);
-	  gx3d_AddVector (&current_position, &v1, &to);
-//		to.x = current_position.x + (current_heading.x * CAMERA_DISTANCE);
-//    to.y = current_position.y + (current_heading.y * CAMERA_DISTANCE);
-//    to.z = current_position.z + (current_heading.z * CAMERA_DISTANCE);
-    // Set new camera	position
-	  gx3d_ComputeViewMatrix (&m, &current_position, &to, &world_up);
-  	gx3d_SetViewMatrix (&m);
+  if (Camera_Update (&current_camera) OR *position_changed)
     *camera_changed = true;
-  }
   
 /*____________________________________________________________________
 |
 | Return new position and heading
 |___________________________________________________________________*/
 
-  *new_position = current_position;
-  *new_heading  = current_heading;
+  new_position->x = current_camera.position[0];
+  new_position->y = current_camera.position[1];
+  new_position->z = current_camera.position[2];
+  new_heading->x  = current_camera.heading[0];
+  new_heading->y  = current_camera.heading[1];
+  new_heading->z  = current_camera.heading[2];
 }
@@ -31,7 +31,10 @@ void Position_Free ();
 // Sets new move speed (in fps)
 void Position_Set_Speed (float move_speed);
 
-// Update position
+// Returns the camera moved by Position_Update()
+Camera *Position_Get_Camera ();
+
+// Update position (the view matrix is not set, see Position_Get_Camera())
 void Position_Update (
   unsigned    elapsed_time,
   unsigned    move,
@@ -39,6 +42,6 @@ void Position_Update (
   int         yrotate,
   bool        update_all,       // boolean           
   bool       *position_changed, // returns true if position has changed, else false
-  bool       *camera_changed,   // return true if heading has changed
+  bool       *camera_changed,   // return true if the camera's view matrix has changed
   gx3dVector *new_position,
   gx3dVector *new_heading );
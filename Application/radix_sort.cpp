@@ -0,0 +1,153 @@
+/*____________________________________________________________________
+|
+| File: radix_sort.cpp
+|
+| Description: LSD radix sort of 32-bit keys with an index payload.
+|   Key and index are kept together in one 8-byte entry so each pass
+|   scatters a single stream.
+|   Used to depth sort blended draws (particle systems) each frame.
+|   Keys are sorted 8 bits at a time.  A first pass finds which bits
+|   differ between keys, and digits that are the same in every key are
+|   neither counted nor sorted, so quantized depth keys (16 bits) take
+|   2 passes.  Counting a digit that never changes would bump the same
+|   counter for every key, each increment waiting on the last.  The
+|   histograms of the digits that do change are built in one pass.
+|
+| Functions: Radix_Sort
+|            Radix_Sort_Depth_Key
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+/*___________________
+|
+| Include Files
+|__________________*/
+
+#include <string.h>
+
+#include "radix_sort.h"
+
+/*___________________
+|
+| Constants
+|__________________*/
+
+#define RADIX_BITS    8
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+#define RADIX_MASK    (RADIX_BUCKETS - 1)
+#define RADIX_PASSES  (32 / RADIX_BITS)
+
+#define DEPTH_KEY_BITS 16   // 0.015 foot steps over a 1000 foot depth range
+#define DEPTH_KEY_MAX  ((1 << DEPTH_KEY_BITS) - 1)
+
+/*____________________________________________________________________
+|
+| Function: Radix_Sort
+|
+| Input: Called from Particle_Queue_Draw()
+| Output: Sorts keys in ascending order.  The sort is stable so entries
+|   with the same key stay in the order they were added.
+|___________________________________________________________________*/
+
+void Radix_Sort (
+  RadixSortEntry *entries,
+  RadixSortEntry *scratch,
+  int             num )
+{
+  int i, pass, shift;
+  unsigned key, first, differ, sum, count;
+  unsigned histogram [RADIX_PASSES][RADIX_BUCKETS];
+  unsigned *h;
+  unsigned next [RADIX_BUCKETS];
+  RadixSortEntry entry, *src, *dst, *tmp;
+
+  if (num < 2)
+    return;
+
+/*____________________________________________________________________
+|
+| Find the bits that differ, then build histograms for their digits
+|___________________________________________________________________*/
+
+  first  = entries[0].key;
+  differ = 0;
+  for (i=1; i<num; i++)
+    differ |= entries[i].key ^ first;
+  if (differ == 0)
+    return;
+
+  memset (histogram, 0, sizeof(histogram));
+  if (differ >> 16)
+    for (i=0; i<num; i++) {
+      key = entries[i].key;
+      histogram[0][key         & RADIX_MASK]++;
+      histogram[1][(key >> 8)  & RADIX_MASK]++;
+      histogram[2][(key >> 16) & RADIX_MASK]++;
+      histogram[3][key >> 24]++;
+    }
+  // Keys that differ only in the low 16 bits, like depth keys
+  else
+    for (i=0; i<num; i++) {
+      key = entries[i].key;
+      histogram[0][key         & RADIX_MASK]++;
+      histogram[1][(key >> 8)  & RADIX_MASK]++;
+    }
+
+/*____________________________________________________________________
+|
+| Scatter, one digit per pass
+|___________________________________________________________________*/
+
+  src = entries;
+  dst = scratch;
+
+  for (pass=0, shift=0; pass<RADIX_PASSES; pass++, shift+=RADIX_BITS) {
+    // Skip this pass if every key has the same digit
+    if (((differ >> shift) & RADIX_MASK) == 0)
+      continue;
+    h = histogram[pass];
+    // Convert counts to starting offsets, in a local array so stores to dst can't alias them
+    for (i=0, sum=0; i<RADIX_BUCKETS; i++) {
+      count   = h[i];
+      next[i] = sum;
+      sum    += count;
+    }
+    for (i=0; i<num; i++) {
+      entry = src[i];
+      dst[next[(entry.key >> shift) & RADIX_MASK]++] = entry;
+    }
+    // Swap source and destination
+    tmp = src;
+    src = dst;
+    dst = tmp;
+  }
+
+  // Make sure the result ends up in the caller's array
+  if (src != entries)
+    memcpy (entries, src, num * sizeof(RadixSortEntry));
+}
+
+/*____________________________________________________________________
+|
+| Function: Radix_Sort_Depth_Key
+|
+| Input: Called from ____
+| Output: Returns a 16-bit key for a view depth.  Farther depths get
+|   smaller keys so an ascending sort gives back-to-front order.  Depths
+|   outside the range are clamped.
+|___________________________________________________________________*/
+
+unsigned Radix_Sort_Depth_Key (float depth, float near_depth, float far_depth)
+{
+  float t;
+
+  t = (depth - near_depth) / (far_depth - near_depth);
+  if (t < 0)
+    t = 0;
+  else if (t > 1)
+    t = 1;
+
+  return (DEPTH_KEY_MAX - (unsigned)(t * (float)DEPTH_KEY_MAX));
+}
@@ -0,0 +1,36 @@
+/*____________________________________________________________________
+|
+| File: radix_sort.h
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+#ifndef _RADIX_SORT_H_
+#define _RADIX_SORT_H_
+
+/*___________________
+|
+| Type definitions
+|__________________*/
+
+typedef struct {
+  unsigned key;
+  unsigned index;   // caller data that moves with the key
+} RadixSortEntry;
+
+/*___________________
+|
+| Functions
+|__________________*/
+
+// Sorts entries by key in ascending order
+void Radix_Sort (
+  RadixSortEntry *entries,  // array of entries (sorted in place)
+  RadixSortEntry *scratch,  // scratch array, same size as entries
+  int             num );    // # of entries in arrays
+
+// Quantizes a depth in [near_depth, far_depth] to a key that sorts far-to-near
+unsigned Radix_Sort_Depth_Key (float depth, float near_depth, float far_depth);
+
+#endif
@@ -0,0 +1,563 @@
+/*____________________________________________________________________
+|
+| File: skin.cpp
+|
+| Description: CPU skinning.  Each vertex is transformed by up to 4
+|   bone matrices and the results blended by the vertex's weights.
+|   Positions, normals, bone indices and weights are each kept in a
+|   separate stream (structure of arrays), so a SIMD kernel handles
+|   several vertices at once with one vertex per lane and no shuffling
+|   of vertex data: the SSE kernel does 4 vertices at a time and the
+|   AVX2 kernel 8, loading each vertex's bone and transposing so each
+|   register holds one bone matrix element for every vertex.  The
+|   kernel is picked at run time from what the CPU supports.
+|
+|   All kernels do the same operations in the same order (no fused
+|   multiply-add), so they give the same results.  An influence is
+|   skipped for a block of vertices if all their weights for it are 0,
+|   which is common since most vertices have only 1 or 2 bones.
+|
+|   Normals are transformed by the rotation part of each bone and not
+|   renormalized.
+|
+|   Streams are padded to a multiple of SKIN_BLOCK vertices (padding has
+|   0 weights) and aligned, so the kernels never handle a partial block.
+|   Large meshes can be split across threads by blocks.
+|
+|   Tools/skin_bench.cpp builds this file without the rest of the game
+|   to check the kernels against each other, so it makes no GX calls.
+|
+| Functions: Skin_Init_Mesh
+|            Skin_Free_Mesh
+|            Skin_Init_Output
+|            Skin_Free_Output
+|            Skin_Get_Kernel
+|            Skin_Set_Kernel
+|            Skin_Vertices
+|            Skin_Mesh
+|             Skin_Scalar
+|             Skin_SSE
+|             Skin_AVX2
+|             Get_Best_Kernel
+|             Alloc_Aligned
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+/*___________________
+|
+| Include Files
+|__________________*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define SKIN_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#include "skin.h"
+
+/*___________________
+|
+| Constants
+|__________________*/
+
+#define SKIN_ALIGN             32     // bytes, for AVX loads
+#define SKIN_MAX_THREADS       8
+#define SKIN_THREAD_MIN_BLOCKS 1024   // don't start a thread for fewer vertex blocks than this
+
+#define NUM_MESH_STREAMS   (6 + 2 * SKIN_MAX_INFLUENCES)
+#define NUM_OUTPUT_STREAMS 6
+
+// gcc needs each function using instructions beyond the build's target marked
+#if defined(SKIN_X86) && defined(__GNUC__)
+#define TARGET_SSE  __attribute__ ((target ("sse2")))
+#define TARGET_AVX2 __attribute__ ((target ("avx2")))
+#else
+#define TARGET_SSE
+#define TARGET_AVX2
+#endif
+
+/*___________________
+|
+| Type definitions
+|__________________*/
+
+typedef void (*SkinFunc) (const SkinMesh *mesh, const float *bones, SkinStreams *out, int first, int last);
+
+/*___________________
+|
+| Function Prototypes
+|__________________*/
+
+static void  Skin_Scalar (const SkinMesh *mesh, const float *bones, SkinStreams *out, int first, int last);
+#ifdef SKIN_X86
+static void  Skin_SSE (const SkinMesh *mesh, const float *bones, SkinStreams *out, int first, int last);
+static void  Skin_AVX2 (const SkinMesh *mesh, const float *bones, SkinStreams *out, int first, int last);
+#endif
+static int   Get_Best_Kernel ();
+static void *Alloc_Aligned (size_t size, void **memory);
+
+/*___________________
+|
+| Global variables
+|__________________*/
+
+static int      kernel = -1;        // -1 until first used
+static int      best_kernel;
+static SkinFunc skin_func;
+
+/*____________________________________________________________________
+|
+| Function: Skin_Init_Mesh
+|
+| Input: Called from ____
+| Output: Splits mesh file vertices and skin into streams.  Returns
+|   true on success.
+|___________________________________________________________________*/
+
+bool Skin_Init_Mesh (SkinMesh *mesh, const MeshFileVertex *vertices, const MeshFileSkin *skin, int num_vertices, int num_bones)
+{
+  int i, k, bone;
+  float *streams;
+
+  memset (mesh, 0, sizeof(SkinMesh));
+  if ((vertices == 0) || (skin == 0) || (num_vertices <= 0) || (num_bones <= 0))
+    return (false);
+
+  mesh->num_vertices = num_vertices;
+  mesh->num_padded   = (num_vertices + SKIN_BLOCK - 1) / SKIN_BLOCK * SKIN_BLOCK;
+  mesh->num_bones    = num_bones;
+  streams = (float *) Alloc_Aligned ((size_t) mesh->num_padded * NUM_MESH_STREAMS * sizeof(float), &mesh->memory);
+  if (streams == 0)
+    return (false);
+  // Padding is all zeros: bone 0 with no weight
+  memset (streams, 0, (size_t) mesh->num_padded * NUM_MESH_STREAMS * sizeof(float));
+
+  mesh->bind.x  = streams;
+  mesh->bind.y  = mesh->bind.x  + mesh->num_padded;
+  mesh->bind.z  = mesh->bind.y  + mesh->num_padded;
+  mesh->bind.nx = mesh->bind.z  + mesh->num_padded;
+  mesh->bind.ny = mesh->bind.nx + mesh->num_padded;
+  mesh->bind.nz = mesh->bind.ny + mesh->num_padded;
+  for (k=0; k<SKIN_MAX_INFLUENCES; k++) {
+    mesh->bone[k]   = (int *)(mesh->bind.nz + (1 + 2*k) * mesh->num_padded);
+    mesh->weight[k] = mesh->bind.nz + (2 + 2*k) * mesh->num_padded;
+  }
+
+  for (i=0; i<num_vertices; i++) {
+    mesh->bind.x[i]  = vertices[i].position[0];
+    mesh->bind.y[i]  = vertices[i].position[1];
+    mesh->bind.z[i]  = vertices[i].position[2];
+    mesh->bind.nx[i] = vertices[i].normal[0];
+    mesh->bind.ny[i] = vertices[i].normal[1];
+    mesh->bind.nz[i] = vertices[i].normal[2];
+    for (k=0; k<SKIN_MAX_INFLUENCES; k++) {
+      bone = skin[i].bone[k];
+      mesh->bone[k][i]   = (bone < num_bones) ? bone : 0;
+      mesh->weight[k][i] = skin[i].weight[k];
+    }
+  }
+
+  return (true);
+}
+
+/*____________________________________________________________________
+|
+| Function: Skin_Free_Mesh
+|
+| Input: Called from ____
+| Output: Frees a mesh.
+|___________________________________________________________________*/
+
+void Skin_Free_Mesh (SkinMesh *mesh)
+{
+  if (mesh->memory)
+    free (mesh->memory);
+  memset (mesh, 0, sizeof(SkinMesh));
+}
+
+/*____________________________________________________________________
+|
+| Function: Skin_Init_Output
+|
+| Input: Called from ____
+| Output: Allocates output streams for a mesh.  Returns true on
+|   success.
+|___________________________________________________________________*/
+
+bool Skin_Init_Output (SkinStreams *out, const SkinMesh *mesh)
+{
+  float *streams;
+
+  memset (out, 0, sizeof(SkinStreams));
+  streams = (float *) Alloc_Aligned ((size_t) mesh->num_padded * NUM_OUTPUT_STREAMS * sizeof(float), &out->memory);
+  if (streams == 0)
+    return (false);
+
+  out->x  = streams;
+  out->y  = out->x  + mesh->num_padded;
+  out->z  = out->y  + mesh->num_padded;
+  out->nx = out->z  + mesh->num_padded;
+  out->ny = out->nx + mesh->num_padded;
+  out->nz = out->ny + mesh->num_padded;
+
+  return (true);
+}
+
+/*____________________________________________________________________
+|
+| Function: Skin_Free_Output
+|
+| Input: Called from ____
+| Output: Frees output streams.
+|___________________________________________________________________*/
+
+void Skin_Free_Output (SkinStreams *out)
+{
+  if (out->memory)
+    free (out->memory);
+  memset (out, 0, sizeof(SkinStreams));
+}
+
+/*____________________________________________________________________
+|
+| Function: Skin_Get_Kernel
+|
+| Input: Called from ____
+| Output: Returns the kernel in use.
+|___________________________________________________________________*/
+
+int Skin_Get_Kernel ()
+{
+  if (kernel == -1) {
+    best_kernel = Get_Best_Kernel ();
+    Skin_Set_Kernel (best_kernel);
+  }
+
+  return (kernel);
+}
+
+/*____________________________________________________________________
+|
+| Function: Skin_Set_Kernel
+|
+| Input: Called from ____
+| Output: Selects a kernel, or the best supported one if the CPU
+|   doesn't support it.  Returns the kernel selected.
+|___________________________________________________________________*/
+
+int Skin_Set_Kernel (int new_kernel)
+{
+  if (kernel == -1)
+    best_kernel = Get_Best_Kernel ();
+  if ((new_kernel < SKIN_KERNEL_SCALAR) || (new_kernel > best_kernel))
+    new_kernel = best_kernel;
+
+  kernel = new_kernel;
+  switch (kernel) {
+#ifdef SKIN_X86
+    case SKIN_KERNEL_AVX2: skin_func = Skin_AVX2;
+                           break;
+    case SKIN_KERNEL_SSE:  skin_func = Skin_SSE;
+                           break;
+#endif
+    default:               skin_func = Skin_Scalar;
+                           break;
+  }
+
+  return (kernel);
+}
+
+/*____________________________________________________________________
+|
+| Function: Skin_Vertices
+|
+| Input: Called from Skin_Mesh(), ____
+| Output: Skins count vertices starting at first.  The range is
+|   extended to the end of its last block.
+|___________________________________________________________________*/
+
+void Skin_Vertices (const SkinMesh *mesh, const SkinMatrix *bones, SkinStreams *out, int first, int count)
+{
+  int last;
+
+  if (kernel == -1)
+    Skin_Get_Kernel ();
+
+  last = first + count;
+  last = (last + SKIN_BLOCK - 1) / SKIN_BLOCK * SKIN_BLOCK;
+  if (last > mesh->num_padded)
+    last = mesh->num_padded;
+  if ((first >= 0) && (first < last) && (first % SKIN_BLOCK == 0))
+    (*skin_func) (mesh, &bones[0].m[0][0], out, first, last);
+}
+
+/*____________________________________________________________________
+|
+| Function: Skin_Mesh
+|
+| Input: Called from ____
+| Output: Skins every vertex of a mesh.  Large meshes are split into
+|   one range per thread, the calling thread doing the first.
+|___________________________________________________________________*/
+
+void Skin_Mesh (const SkinMesh *mesh, const SkinMatrix *bones, SkinStreams *out, int num_threads)
+{
+  int i, n, num_blocks, blocks_per_thread;
+  std::thread threads [SKIN_MAX_THREADS];
+
+  num_blocks = mesh->num_padded / SKIN_BLOCK;
+  n = num_blocks / SKIN_THREAD_MIN_BLOCKS;
+  if (n > num_threads)
+    n = num_threads;
+  if (n > SKIN_MAX_THREADS)
+    n = SKIN_MAX_THREADS;
+
+  if (n <= 1)
+    Skin_Vertices (mesh, bones, out, 0, mesh->num_padded);
+  else {
+    if (kernel == -1)
+      Skin_Get_Kernel ();
+    blocks_per_thread = (num_blocks + n - 1) / n;
+    for (i=1; i<n; i++)
+      threads[i] = std::thread (Skin_Vertices, mesh, bones, out, i * blocks_per_thread * SKIN_BLOCK, blocks_per_thread * SKIN_BLOCK);
+    Skin_Vertices (mesh, bones, out, 0, blocks_per_thread * SKIN_BLOCK);
+    for (i=1; i<n; i++)
+      threads[i].join ();
+  }
+}
+
+/*____________________________________________________________________
+|
+| Function: Skin_Scalar
+|
+| Input: Called from Skin_Vertices()
+| Output: Skins vertices first to last-1, one at a time.  bones is 12
+|   floats per bone.
+|___________________________________________________________________*/
+
+static void Skin_Scalar (const SkinMesh *mesh, const float *bones, SkinStreams *out, int first, int last)
+{
+  int i, k;
+  float x, y, z, nx, ny, nz, px, py, pz, qx, qy, qz, w;
+  const float *m;
+
+  for (i=first; i<last; i++) {
+    x  = mesh->bind.x[i];
+    y  = mesh->bind.y[i];
+    z  = mesh->bind.z[i];
+    nx = mesh->bind.nx[i];
+    ny = mesh->bind.ny[i];
+    nz = mesh->bind.nz[i];
+    px = py = pz = qx = qy = qz = 0;
+    for (k=0; k<SKIN_MAX_INFLUENCES; k++) {
+      w = mesh->weight[k][i];
+      if (w == 0)
+        continue;
+      m = bones + mesh->bone[k][i] * 12;
+      px += w * (x*m[0] + y*m[3] + z*m[6] + m[9]);
+      py += w * (x*m[1] + y*m[4] + z*m[7] + m[10]);
+      pz += w * (x*m[2] + y*m[5] + z*m[8] + m[11]);
+      qx += w * (nx*m[0] + ny*m[3] + nz*m[6]);
+      qy += w * (nx*m[1] + ny*m[4] + nz*m[7]);
+      qz += w * (nx*m[2] + ny*m[5] + nz*m[8]);
+    }
+    out->x[i]  = px;
+    out->y[i]  = py;
+    out->z[i]  = pz;
+    out->nx[i] = qx;
+    out->ny[i] = qy;
+    out->nz[i] = qz;
+  }
+}
+
+#ifdef SKIN_X86
+
+/*____________________________________________________________________
+|
+| Function: Skin_SSE
+|
+| Input: Called from Skin_Vertices()
+| Output: Skins vertices first to last-1, 4 at a time.  For each
+|   influence, the 4 vertices' bones are loaded as rows and transposed
+|   so each register holds one matrix element for all 4 vertices.
+|___________________________________________________________________*/
+
+TARGET_SSE static void Skin_SSE (const SkinMesh *mesh, const float *bones, SkinStreams *out, int first, int last)
+{
+  int i, k;
+  const int *bone;
+  const float *m0, *m1, *m2, *m3;
+  __m128 x, y, z, nx, ny, nz, px, py, pz, qx, qy, qz, w, zero;
+  __m128 a0, a1, a2, a3, b0, b1, b2, b3, c0, c1, c2, c3;
+
+  zero = _mm_setzero_ps ();
+  for (i=first; i<last; i+=4) {
+    x  = _mm_load_ps (&mesh->bind.x[i]);
+    y  = _mm_load_ps (&mesh->bind.y[i]);
+    z  = _mm_load_ps (&mesh->bind.z[i]);
+    nx = _mm_load_ps (&mesh->bind.nx[i]);
+    ny = _mm_load_ps (&mesh->bind.ny[i]);
+    nz = _mm_load_ps (&mesh->bind.nz[i]);
+    px = py = pz = qx = qy = qz = zero;
+    for (k=0; k<SKIN_MAX_INFLUENCES; k++) {
+      w = _mm_load_ps (&mesh->weight[k][i]);
+      if (_mm_movemask_ps (_mm_cmpneq_ps (w, zero)) == 0)
+        continue;
+      bone = &mesh->bone[k][i];
+      m0 = bones + bone[0] * 12;
+      m1 = bones + bone[1] * 12;
+      m2 = bones + bone[2] * 12;
+      m3 = bones + bone[3] * 12;
+      // a = elements 0-3, b = 4-7, c = 8-11, one register per element after transposing
+      a0 = _mm_loadu_ps (m0);     a1 = _mm_loadu_ps (m1);     a2 = _mm_loadu_ps (m2);     a3 = _mm_loadu_ps (m3);
+      b0 = _mm_loadu_ps (m0 + 4); b1 = _mm_loadu_ps (m1 + 4); b2 = _mm_loadu_ps (m2 + 4); b3 = _mm_loadu_ps (m3 + 4);
+      c0 = _mm_loadu_ps (m0 + 8); c1 = _mm_loadu_ps (m1 + 8); c2 = _mm_loadu_ps (m2 + 8); c3 = _mm_loadu_ps (m3 + 8);
+      _MM_TRANSPOSE4_PS (a0, a1, a2, a3);
+      _MM_TRANSPOSE4_PS (b0, b1, b2, b3);
+      _MM_TRANSPOSE4_PS (c0, c1, c2, c3);
+      // m[0..11] = a0 a1 a2 a3 b0 b1 b2 b3 c0 c1 c2 c3
+      px = _mm_add_ps (px, _mm_mul_ps (w, _mm_add_ps (_mm_add_ps (_mm_add_ps (_mm_mul_ps (x, a0), _mm_mul_ps (y, a3)), _mm_mul_ps (z, b2)), c1)));
+      py = _mm_add_ps (py, _mm_mul_ps (w, _mm_add_ps (_mm_add_ps (_mm_add_ps (_mm_mul_ps (x, a1), _mm_mul_ps (y, b0)), _mm_mul_ps (z, b3)), c2)));
+      pz = _mm_add_ps (pz, _mm_mul_ps (w, _mm_add_ps (_mm_add_ps (_mm_add_ps (_mm_mul_ps (x, a2), _mm_mul_ps (y, b1)), _mm_mul_ps (z, c0)), c3)));
+      qx = _mm_add_ps (qx, _mm_mul_ps (w, _mm_add_ps (_mm_add_ps (_mm_mul_ps (nx, a0), _mm_mul_ps (ny, a3)), _mm_mul_ps (nz, b2))));
+      qy = _mm_add_ps (qy, _mm_mul_ps (w, _mm_add_ps (_mm_add_ps (_mm_mul_ps (nx, a1), _mm_mul_ps (ny, b0)), _mm_mul_ps (nz, b3))));
+      qz = _mm_add_ps (qz, _mm_mul_ps (w, _mm_add_ps (_mm_add_ps (_mm_mul_ps (nx, a2), _mm_mul_ps (ny, b1)), _mm_mul_ps (nz, c0))));
+    }
+    _mm_store_ps (&out->x[i],  px);
+    _mm_store_ps (&out->y[i],  py);
+    _mm_store_ps (&out->z[i],  pz);
+    _mm_store_ps (&out->nx[i], qx);
+    _mm_store_ps (&out->ny[i], qy);
+    _mm_store_ps (&out->nz[i], qz);
+  }
+}
+
+/*____________________________________________________________________
+|
+| Function: Skin_AVX2
+|
+| Input: Called from Skin_Vertices()
+| Output: Skins vertices first to last-1, 8 at a time.  For each
+|   influence, the 8 vertices' bones are loaded and transposed as in
+|   Skin_SSE(), 4 to each half of the registers.  This is faster than
+|   gathering each element (12 gathers).
+|___________________________________________________________________*/
+
+TARGET_AVX2 static void Skin_AVX2 (const SkinMesh *mesh, const float *bones, SkinStreams *out, int first, int last)
+{
+  int i, j, k, e;
+  const int *bone;
+  const float *b;
+  __m256 x, y, z, nx, ny, nz, px, py, pz, qx, qy, qz, w, zero, m[12], t0, t1, t2, t3;
+
+  zero = _mm256_setzero_ps ();
+  for (i=first; i<last; i+=8) {
+    x  = _mm256_load_ps (&mesh->bind.x[i]);
+    y  = _mm256_load_ps (&mesh->bind.y[i]);
+    z  = _mm256_load_ps (&mesh->bind.z[i]);
+    nx = _mm256_load_ps (&mesh->bind.nx[i]);
+    ny = _mm256_load_ps (&mesh->bind.ny[i]);
+    nz = _mm256_load_ps (&mesh->bind.nz[i]);
+    px = py = pz = qx = qy = qz = zero;
+    for (k=0; k<SKIN_MAX_INFLUENCES; k++) {
+      w = _mm256_load_ps (&mesh->weight[k][i]);
+      if (_mm256_movemask_ps (_mm256_cmp_ps (w, zero, _CMP_NEQ_UQ)) == 0)
+        continue;
+      // Load elements e to e+3 of vertex j's bone in the low half of m[e+j] and of vertex
+      //   j+4's in the high half, then transpose each half so m[e] is element e for all 8
+      bone = &mesh->bone[k][i];
+      for (e=0; e<12; e+=4) {
+        for (j=0; j<4; j++) {
+          b = bones + e;
+          m[e+j] = _mm256_insertf128_ps (_mm256_castps128_ps256 (_mm_loadu_ps (b + bone[j] * 12)), _mm_loadu_ps (b + bone[j+4] * 12), 1);
+        }
+        t0 = _mm256_unpacklo_ps (m[e],   m[e+1]);
+        t1 = _mm256_unpacklo_ps (m[e+2], m[e+3]);
+        t2 = _mm256_unpackhi_ps (m[e],   m[e+1]);
+        t3 = _mm256_unpackhi_ps (m[e+2], m[e+3]);
+        m[e]   = _mm256_shuffle_ps (t0, t1, _MM_SHUFFLE (1, 0, 1, 0));
+        m[e+1] = _mm256_shuffle_ps (t0, t1, _MM_SHUFFLE (3, 2, 3, 2));
+        m[e+2] = _mm256_shuffle_ps (t2, t3, _MM_SHUFFLE (1, 0, 1, 0));
+        m[e+3] = _mm256_shuffle_ps (t2, t3, _MM_SHUFFLE (3, 2, 3, 2));
+      }
+      px = _mm256_add_ps (px, _mm256_mul_ps (w, _mm256_add_ps (_mm256_add_ps (_mm256_add_ps (_mm256_mul_ps (x, m[0]), _mm256_mul_ps (y, m[3])), _mm256_mul_ps (z, m[6])), m[9])));
+      py = _mm256_add_ps (py, _mm256_mul_ps (w, _mm256_add_ps (_mm256_add_ps (_mm256_add_ps (_mm256_mul_ps (x, m[1]), _mm256_mul_ps (y, m[4])), _mm256_mul_ps (z, m[7])), m[10])));
+      pz = _mm256_add_ps (pz, _mm256_mul_ps (w, _mm256_add_ps (_mm256_add_ps (_mm256_add_ps (_mm256_mul_ps (x, m[2]), _mm256_mul_ps (y, m[5])), _mm256_mul_ps (z, m[8])), m[11])));
+      qx = _mm256_add_ps (qx, _mm256_mul_ps (w, _mm256_add_ps (_mm256_add_ps (_mm256_mul_ps (nx, m[0]), _mm256_mul_ps (ny, m[3])), _mm256_mul_ps (nz, m[6]))));
+      qy = _mm256_add_ps (qy, _mm256_mul_ps (w, _mm256_add_ps (_mm256_add_ps (_mm256_mul_ps (nx, m[1]), _mm256_mul_ps (ny, m[4])), _mm256_mul_ps (nz, m[7]))));
+      qz = _mm256_add_ps (qz, _mm256_mul_ps (w, _mm256_add_ps (_mm256_add_ps (_mm256_mul_ps (nx, m[2]), _mm256_mul_ps (ny, m[5])), _mm256_mul_ps (nz, m[8]))));
+    }
+    _mm256_store_ps (&out->x[i],  px);
+    _mm256_store_ps (&out->y[i],  py);
+    _mm256_store_ps (&out->z[i],  pz);
+    _mm256_store_ps (&out->nx[i], qx);
+    _mm256_store_ps (&out->ny[i], qy);
+    _mm256_store_ps (&out->nz[i], qz);
+  }
+}
+
+#endif
+
+/*____________________________________________________________________
+|
+| Function: Get_Best_Kernel
+|
+| Input: Called from Skin_Get_Kernel(), Skin_Set_Kernel()
+| Output: Returns the fastest kernel the CPU (and OS) supports.
+|___________________________________________________________________*/
+
+static int Get_Best_Kernel ()
+{
+#ifdef SKIN_X86
+#ifdef _MSC_VER
+  int info[4];
+
+  __cpuid (info, 0);
+  if (info[0] >= 7) {
+    __cpuid (info, 1);
+    // AVX needs OSXSAVE, and the OS must save the AVX registers
+    if ((info[2] & (1 << 27)) && (info[2] & (1 << 28)) && ((_xgetbv (0) & 6) == 6)) {
+      __cpuidex (info, 7, 0);
+      if (info[1] & (1 << 5))
+        return (SKIN_KERNEL_AVX2);
+    }
+  }
+  return (SKIN_KERNEL_SSE);
+#else
+  __builtin_cpu_init ();
+  if (__builtin_cpu_supports ("avx2"))
+    return (SKIN_KERNEL_AVX2);
+  if (__builtin_cpu_supports ("sse2"))
+    return (SKIN_KERNEL_SSE);
+#endif
+#endif
+
+  return (SKIN_KERNEL_SCALAR);
+}
+
+/*____________________________________________________________________
+|
+| Function: Alloc_Aligned
+|
+| Input: Called from Skin_Init_Mesh(), Skin_Init_Output()
+| Output: Returns size bytes aligned to SKIN_ALIGN, or 0 on error.
+|   *memory is set to the pointer to free.
+|___________________________________________________________________*/
+
+static void *Alloc_Aligned (size_t size, void **memory)
+{
+  *memory = malloc (size + SKIN_ALIGN - 1);
+  if (*memory == 0)
+    return (0);
+
+  return ((void *)(((size_t)*memory + SKIN_ALIGN - 1) & ~(size_t)(SKIN_ALIGN - 1)));
+}
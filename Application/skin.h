@@ -0,0 +1,99 @@
+/*____________________________________________________________________
+|
+| File: skin.h
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+#ifndef _SKIN_H_
+#define _SKIN_H_
+
+#include "mesh_file.h"
+
+/*___________________
+|
+| Constants
+|__________________*/
+
+#define SKIN_MAX_INFLUENCES 4
+#define SKIN_BLOCK          8     // vertices are processed (and streams padded) in blocks of this many
+
+// Kernels
+#define SKIN_KERNEL_SCALAR  0
+#define SKIN_KERNEL_SSE     1
+#define SKIN_KERNEL_AVX2    2
+
+/*___________________
+|
+| Type definitions
+|__________________*/
+
+// A bone transform for row vectors (like gx3dMatrix): rows 0-2 rotate and
+//   scale, row 3 translates
+typedef struct {
+  float m[4][3];
+} SkinMatrix;
+
+// Positions and normals, one stream per component
+typedef struct {
+  float *x, *y, *z;
+  float *nx, *ny, *nz;
+  void  *memory;
+} SkinStreams;
+
+// A mesh to skin, with bind pose positions/normals and skin in separate streams
+typedef struct {
+  int          num_vertices;
+  int          num_padded;        // num_vertices rounded up to SKIN_BLOCK
+  int          num_bones;
+  SkinStreams  bind;
+  int         *bone   [SKIN_MAX_INFLUENCES];  // bone index (always < num_bones)
+  float       *weight [SKIN_MAX_INFLUENCES];  // 0 for unused influences and padding
+  void        *memory;
+} SkinMesh;
+
+/*___________________
+|
+| Functions
+|__________________*/
+
+// Builds a mesh from mesh file vertices and skin streams, returns true on success
+bool Skin_Init_Mesh (
+  SkinMesh             *mesh,
+  const MeshFileVertex *vertices,
+  const MeshFileSkin   *skin,
+  int                   num_vertices,
+  int                   num_bones );    // bone indices past this are skinned to bone 0
+
+// Frees a mesh
+void Skin_Free_Mesh (SkinMesh *mesh);
+
+// Allocates output streams for a mesh, returns true on success
+bool Skin_Init_Output (SkinStreams *out, const SkinMesh *mesh);
+
+// Frees output streams
+void Skin_Free_Output (SkinStreams *out);
+
+// Returns the kernel in use (the fastest the CPU supports unless set)
+int Skin_Get_Kernel ();
+
+// Selects a kernel (SKIN_KERNEL_...), returns the kernel used if that one isn't supported
+int Skin_Set_Kernel (int kernel);
+
+// Skins a range of vertices - first must be a multiple of SKIN_BLOCK
+void Skin_Vertices (
+  const SkinMesh   *mesh,
+  const SkinMatrix *bones,      // mesh->num_bones matrices
+  SkinStreams      *out,
+  int               first,
+  int               count );
+
+// Skins a whole mesh, splitting large meshes across up to num_threads threads
+void Skin_Mesh (
+  const SkinMesh   *mesh,
+  const SkinMatrix *bones,
+  SkinStreams      *out,
+  int               num_threads );
+
+#endif
@@ -0,0 +1,697 @@
+/*____________________________________________________________________
+|
+| File: texture_file.cpp
+|
+| Description: Baked texture files.  A color BMP and its optional _fa
+|   alpha BMP are merged into one RGBA image, a mipmap chain is built
+|   with a box filter and every level is block compressed (BC1 for
+|   opaque textures, BC3 when there is alpha).  The result is written in
+|   the DDS format, so the data can be copied straight into a compressed
+|   Direct3D texture, one level at a time.  Loading is one read of the
+|   whole file plus a header check.
+|
+| Functions: TextureImage_Read_BMP
+|            TextureImage_Free
+|            TextureImage_Has_Alpha
+|            TextureFile_Bake
+|            TextureFile_Load
+|            TextureFile_Free
+|            TextureFile_Level_Size
+|            TextureFile_Encode_Block
+|             Read_BMP
+|             Build_Mipmap
+|             Encode_Color_Block
+|             Encode_Alpha_Block
+|             To_565
+|             From_565
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+/*___________________
+|
+| Include Files
+|__________________*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "texture_file.h"
+
+/*___________________
+|
+| Function Prototypes
+|__________________*/
+
+static bool     Read_BMP (const char *filename, int *width, int *height, unsigned char **rgb);
+static void     Build_Mipmap (const TextureImage *src, TextureImage *dst);
+static void     Encode_Color_Block (const unsigned char *block, unsigned char *out);
+static void     Encode_Alpha_Block (const unsigned char *block, unsigned char *out);
+static unsigned To_565 (const int *color);
+static void     From_565 (unsigned c, int *color);
+
+/*___________________
+|
+| Constants
+|__________________*/
+
+#define DDS_MAGIC        0x20534444   // "DDS "
+#define DDS_HEADER_SIZE  128          // including magic
+#define DDS_FOURCC_DXT1  0x31545844
+#define DDS_FOURCC_DXT5  0x35545844
+
+// DDS header flags
+#define DDSD_CAPS        0x1
+#define DDSD_HEIGHT      0x2
+#define DDSD_WIDTH       0x4
+#define DDSD_PIXELFORMAT 0x1000
+#define DDSD_MIPMAPCOUNT 0x20000
+#define DDSD_LINEARSIZE  0x80000
+#define DDPF_FOURCC      0x4
+#define DDSCAPS_COMPLEX  0x8
+#define DDSCAPS_TEXTURE  0x1000
+#define DDSCAPS_MIPMAP   0x400000
+
+// Offsets of DDS header fields, in 32-bit words from the start of the file
+#define DDS_WORD_SIZE        1
+#define DDS_WORD_FLAGS       2
+#define DDS_WORD_HEIGHT      3
+#define DDS_WORD_WIDTH       4
+#define DDS_WORD_LINEARSIZE  5
+#define DDS_WORD_MIPMAPCOUNT 7
+#define DDS_WORD_PF_SIZE     19
+#define DDS_WORD_PF_FLAGS    20
+#define DDS_WORD_PF_FOURCC   21
+#define DDS_WORD_CAPS        27
+
+/*____________________________________________________________________
+|
+| Function: TextureImage_Read_BMP
+|
+| Input: Called from ____
+| Output: Reads a BMP file into an RGBA image.  If alpha_filename is
+|   given, alpha is the brightness of that image (which must be the same
+|   size), else alpha is 255.  Returns true on success.
+|___________________________________________________________________*/
+
+bool TextureImage_Read_BMP (const char *filename, const char *alpha_filename, TextureImage *image)
+{
+  int i, n, width, height, alpha_width, alpha_height;
+  unsigned char *rgb, *alpha_rgb;
+
+  memset (image, 0, sizeof(TextureImage));
+
+  if (! Read_BMP (filename, &width, &height, &rgb))
+    return (false);
+  alpha_rgb = 0;
+  if (alpha_filename) {
+    if ((! Read_BMP (alpha_filename, &alpha_width, &alpha_height, &alpha_rgb)) ||
+        (alpha_width != width) || (alpha_height != height)) {
+      free (rgb);
+      if (alpha_rgb)
+        free (alpha_rgb);
+      return (false);
+    }
+  }
+
+  n = width * height;
+  image->pixels = (unsigned char *) malloc (n * 4);
+  if (image->pixels) {
+    image->width  = width;
+    image->height = height;
+    for (i=0; i<n; i++) {
+      image->pixels[i*4]   = rgb[i*3];
+      image->pixels[i*4+1] = rgb[i*3+1];
+      image->pixels[i*4+2] = rgb[i*3+2];
+      if (alpha_rgb)
+        image->pixels[i*4+3] = (unsigned char) ((alpha_rgb[i*3] * 77 + alpha_rgb[i*3+1] * 150 + alpha_rgb[i*3+2] * 29) >> 8);
+      else
+        image->pixels[i*4+3] = 255;
+    }
+  }
+  free (rgb);
+  if (alpha_rgb)
+    free (alpha_rgb);
+
+  return (image->pixels != 0);
+}
+
+/*____________________________________________________________________
+|
+| Function: TextureImage_Free
+|
+| Input: Called from ____
+| Output: Frees an image.
+|___________________________________________________________________*/
+
+void TextureImage_Free (TextureImage *image)
+{
+  if (image->pixels)
+    free (image->pixels);
+  memset (image, 0, sizeof(TextureImage));
+}
+
+/*____________________________________________________________________
+|
+| Function: TextureImage_Has_Alpha
+|
+| Input: Called from ____
+| Output: Returns true if any pixel isn't fully opaque.
+|___________________________________________________________________*/
+
+bool TextureImage_Has_Alpha (TextureImage *image)
+{
+  int i, n = image->width * image->height;
+
+  for (i=0; i<n; i++)
+    if (image->pixels[i*4+3] != 255)
+      return (true);
+
+  return (false);
+}
+
+/*____________________________________________________________________
+|
+| Function: TextureFile_Bake
+|
+| Input: Called from ____
+| Output: Builds a full mipmap chain (down to 1x1), compresses each
+|   level and writes a DDS file.  Returns true on success.
+|___________________________________________________________________*/
+
+bool TextureFile_Bake (const char *filename, TextureImage *image, int format)
+{
+  int i, level, num_levels, x, y, bx, by, sx, sy, block_size;
+  unsigned header [DDS_HEADER_SIZE / 4];
+  unsigned char block [16*4], *data, *out;
+  TextureImage levels [TEXTURE_FILE_MAX_LEVELS];
+  unsigned size, total;
+  FILE *fp;
+  bool ok = false;
+
+  if ((format != TEXTURE_FORMAT_BC1) && (format != TEXTURE_FORMAT_BC3))
+    return (false);
+  block_size = (format == TEXTURE_FORMAT_BC1) ? 8 : 16;
+
+/*____________________________________________________________________
+|
+| Build mipmaps
+|___________________________________________________________________*/
+
+  levels[0] = *image;
+  for (num_levels=1; num_levels<TEXTURE_FILE_MAX_LEVELS; num_levels++) {
+    if ((levels[num_levels-1].width == 1) && (levels[num_levels-1].height == 1))
+      break;
+    Build_Mipmap (&levels[num_levels-1], &levels[num_levels]);
+    if (levels[num_levels].pixels == 0)
+      break;
+  }
+
+  total = 0;
+  for (level=0; level<num_levels; level++)
+    total += TextureFile_Level_Size (format, levels[level].width, levels[level].height);
+
+/*____________________________________________________________________
+|
+| Compress each level
+|___________________________________________________________________*/
+
+  data = (unsigned char *) malloc (DDS_HEADER_SIZE + total);
+  if (data) {
+    memset (header, 0, sizeof(header));
+    header[0]                    = DDS_MAGIC;
+    header[DDS_WORD_SIZE]        = 124;
+    header[DDS_WORD_FLAGS]       = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT | DDSD_LINEARSIZE;
+    header[DDS_WORD_HEIGHT]      = image->height;
+    header[DDS_WORD_WIDTH]       = image->width;
+    header[DDS_WORD_LINEARSIZE]  = TextureFile_Level_Size (format, image->width, image->height);
+    header[DDS_WORD_MIPMAPCOUNT] = num_levels;
+    header[DDS_WORD_PF_SIZE]     = 32;
+    header[DDS_WORD_PF_FLAGS]    = DDPF_FOURCC;
+    header[DDS_WORD_PF_FOURCC]   = (format == TEXTURE_FORMAT_BC1) ? DDS_FOURCC_DXT1 : DDS_FOURCC_DXT5;
+    header[DDS_WORD_CAPS]        = DDSCAPS_TEXTURE | DDSCAPS_MIPMAP | DDSCAPS_COMPLEX;
+    memcpy (data, header, DDS_HEADER_SIZE);
+
+    out = data + DDS_HEADER_SIZE;
+    for (level=0; level<num_levels; level++) {
+      TextureImage *src = &levels[level];
+      for (by=0; by<src->height; by+=4)
+        for (bx=0; bx<src->width; bx+=4) {
+          // Edge blocks of small levels repeat the last row/column
+          for (y=0, i=0; y<4; y++)
+            for (x=0; x<4; x++, i++) {
+              sx = (bx + x < src->width)  ? bx + x : src->width - 1;
+              sy = (by + y < src->height) ? by + y : src->height - 1;
+              memcpy (&block[i*4], &src->pixels[(sy * src->width + sx) * 4], 4);
+            }
+          TextureFile_Encode_Block (format, block, out);
+          out += block_size;
+        }
+    }
+
+    fp = fopen (filename, "wb");
+    if (fp) {
+      size = DDS_HEADER_SIZE + total;
+      ok = (fwrite (data, size, 1, fp) == 1);
+      if (fclose (fp) != 0)
+        ok = false;
+    }
+    free (data);
+  }
+
+  for (level=1; level<num_levels; level++)
+    TextureImage_Free (&levels[level]);
+
+  return (ok);
+}
+
+/*____________________________________________________________________
+|
+| Function: TextureFile_Load
+|
+| Input: Called from ____
+| Output: Reads a texture file in one read and sets pointers to each
+|   mipmap level.  Returns true on success.
+|___________________________________________________________________*/
+
+bool TextureFile_Load (const char *filename, TextureFile *texture)
+{
+  FILE *fp;
+  long size;
+  int level, width, height;
+  unsigned offset, header [DDS_HEADER_SIZE / 4];
+  bool ok;
+
+  memset (texture, 0, sizeof(TextureFile));
+
+  fp = fopen (filename, "rb");
+  if (fp == 0)
+    return (false);
+  fseek (fp, 0, SEEK_END);
+  size = ftell (fp);
+  fseek (fp, 0, SEEK_SET);
+  if (size > DDS_HEADER_SIZE) {
+    texture->buffer = malloc (size);
+    if (texture->buffer && (fread (texture->buffer, size, 1, fp) != 1)) {
+      free (texture->buffer);
+      texture->buffer = 0;
+    }
+  }
+  fclose (fp);
+  if (texture->buffer == 0)
+    return (false);
+  texture->size = (unsigned) size;
+
+/*____________________________________________________________________
+|
+| Check the header and find each level
+|___________________________________________________________________*/
+
+  memcpy (header, texture->buffer, DDS_HEADER_SIZE);
+  ok = (header[0] == DDS_MAGIC) && (header[DDS_WORD_SIZE] == 124) && (header[DDS_WORD_PF_FLAGS] & DDPF_FOURCC);
+  if (ok) {
+    if (header[DDS_WORD_PF_FOURCC] == DDS_FOURCC_DXT1)
+      texture->format = TEXTURE_FORMAT_BC1;
+    else if (header[DDS_WORD_PF_FOURCC] == DDS_FOURCC_DXT5)
+      texture->format = TEXTURE_FORMAT_BC3;
+    else
+      ok = false;
+  }
+  if (ok) {
+    texture->width      = (int) header[DDS_WORD_WIDTH];
+    texture->height     = (int) header[DDS_WORD_HEIGHT];
+    texture->num_levels = (header[DDS_WORD_FLAGS] & DDSD_MIPMAPCOUNT) ? (int) header[DDS_WORD_MIPMAPCOUNT] : 1;
+    if ((texture->width <= 0) || (texture->height <= 0) || (texture->width > 16384) || (texture->height > 16384) ||
+        (texture->num_levels < 1) || (texture->num_levels > TEXTURE_FILE_MAX_LEVELS))
+      ok = false;
+  }
+  if (ok) {
+    offset = DDS_HEADER_SIZE;
+    width  = texture->width;
+    height = texture->height;
+    for (level=0; (level<texture->num_levels) && ok; level++) {
+      texture->level_data[level] = (const unsigned char *) texture->buffer + offset;
+      texture->level_size[level] = TextureFile_Level_Size (texture->format, width, height);
+      offset += texture->level_size[level];
+      if (offset > texture->size)
+        ok = false;
+      width  = (width > 1) ? width / 2 : 1;
+      height = (height > 1) ? height / 2 : 1;
+    }
+  }
+  if (! ok)
+    TextureFile_Free (texture);
+
+  return (ok);
+}
+
+/*____________________________________________________________________
+|
+| Function: TextureFile_Free
+|
+| Input: Called from ____
+| Output: Frees a texture file.
+|___________________________________________________________________*/
+
+void TextureFile_Free (TextureFile *texture)
+{
+  if (texture->buffer)
+    free (texture->buffer);
+  memset (texture, 0, sizeof(TextureFile));
+}
+
+/*____________________________________________________________________
+|
+| Function: TextureFile_Level_Size
+|
+| Input: Called from ____
+| Output: Returns the size in bytes of one compressed level.
+|___________________________________________________________________*/
+
+unsigned TextureFile_Level_Size (int format, int width, int height)
+{
+  unsigned blocks_x = (width + 3) / 4, blocks_y = (height + 3) / 4;
+
+  if (blocks_x == 0)
+    blocks_x = 1;
+  if (blocks_y == 0)
+    blocks_y = 1;
+
+  return (blocks_x * blocks_y * ((format == TEXTURE_FORMAT_BC1) ? 8 : 16));
+}
+
+/*____________________________________________________________________
+|
+| Function: TextureFile_Encode_Block
+|
+| Input: Called from TextureFile_Bake()
+| Output: Compresses a 4x4 block.  BC3 is an alpha block followed by a
+|   color block, BC1 is just the color block.
+|___________________________________________________________________*/
+
+void TextureFile_Encode_Block (int format, const unsigned char *block, unsigned char *out)
+{
+  if (format == TEXTURE_FORMAT_BC3) {
+    Encode_Alpha_Block (block, out);
+    out += 8;
+  }
+  Encode_Color_Block (block, out);
+}
+
+/*____________________________________________________________________
+|
+| Function: Read_BMP
+|
+| Input: Called from TextureImage_Read_BMP()
+| Output: Reads an uncompressed 24-bit or 8-bit (palette) BMP file into
+|   a top-down rgb buffer.  Returns true on success.
+|___________________________________________________________________*/
+
+static bool Read_BMP (const char *filename, int *width, int *height, unsigned char **rgb)
+{
+  FILE *fp;
+  long size;
+  unsigned char *file, *row, *pixel;
+  unsigned offset, header_size, bits, compression, num_colors, stride;
+  int x, y, w, h;
+  bool top_down, ok = false;
+
+  *rgb = 0;
+
+  fp = fopen (filename, "rb");
+  if (fp == 0)
+    return (false);
+  fseek (fp, 0, SEEK_END);
+  size = ftell (fp);
+  fseek (fp, 0, SEEK_SET);
+  file = (size > 54) ? (unsigned char *) malloc (size) : 0;
+  if (file && (fread (file, size, 1, fp) != 1)) {
+    free (file);
+    file = 0;
+  }
+  fclose (fp);
+  if (file == 0)
+    return (false);
+
+/*____________________________________________________________________
+|
+| Check the headers (all values are little-endian)
+|___________________________________________________________________*/
+
+#define U16(p) ((unsigned) (p)[0] | ((unsigned) (p)[1] << 8))
+#define U32(p) (U16(p) | (U16((p)+2) << 16))
+
+  offset      = U32(file + 10);
+  header_size = U32(file + 14);
+  w           = (int) U32(file + 18);
+  h           = (int) U32(file + 22);
+  bits        = U16(file + 28);
+  compression = U32(file + 30);
+  num_colors  = (header_size >= 40) ? U32(file + 46) : 0;
+  if ((num_colors == 0) && (bits == 8))
+    num_colors = 256;
+  top_down = (h < 0);
+  if (top_down)
+    h = -h;
+  stride = ((w * bits + 31) / 32) * 4;
+
+  if ((file[0] == 'B') && (file[1] == 'M') && (compression == 0) && ((bits == 24) || (bits == 8)) &&
+      (w > 0) && (h > 0) && (w <= 16384) && (h <= 16384) && (num_colors <= 256) &&
+      (14 + header_size + num_colors * 4 <= (unsigned long) size) &&
+      ((unsigned long) offset + (unsigned long) stride * h <= (unsigned long) size)) {
+
+/*____________________________________________________________________
+|
+| Convert to top-down rgb
+|___________________________________________________________________*/
+
+    *rgb = (unsigned char *) malloc (w * h * 3);
+    if (*rgb) {
+      for (y=0; y<h; y++) {
+        row   = file + offset + stride * (top_down ? y : h - 1 - y);
+        pixel = *rgb + y * w * 3;
+        for (x=0; x<w; x++, pixel+=3) {
+          if (bits == 24) {
+            pixel[0] = row[x*3+2];
+            pixel[1] = row[x*3+1];
+            pixel[2] = row[x*3];
+          }
+          else {
+            const unsigned char *color = file + 14 + header_size + (row[x] < num_colors ? row[x] : 0) * 4;
+            pixel[0] = color[2];
+            pixel[1] = color[1];
+            pixel[2] = color[0];
+          }
+        }
+      }
+      *width  = w;
+      *height = h;
+      ok = true;
+    }
+  }
+
+#undef U16
+#undef U32
+
+  free (file);
+
+  return (ok);
+}
+
+/*____________________________________________________________________
+|
+| Function: Build_Mipmap
+|
+| Input: Called from TextureFile_Bake()
+| Output: Makes the next smaller mipmap level by averaging 2x2 pixels.
+|   dst->pixels is 0 on error.
+|___________________________________________________________________*/
+
+static void Build_Mipmap (const TextureImage *src, TextureImage *dst)
+{
+  int x, y, c, x0, x1, y0, y1;
+  const unsigned char *p;
+
+  dst->width  = (src->width > 1) ? src->width / 2 : 1;
+  dst->height = (src->height > 1) ? src->height / 2 : 1;
+  dst->pixels = (unsigned char *) malloc (dst->width * dst->height * 4);
+  if (dst->pixels == 0)
+    return;
+
+  for (y=0; y<dst->height; y++) {
+    y0 = (y * 2 < src->height) ? y * 2 : src->height - 1;
+    y1 = (y * 2 + 1 < src->height) ? y * 2 + 1 : src->height - 1;
+    for (x=0; x<dst->width; x++) {
+      x0 = (x * 2 < src->width) ? x * 2 : src->width - 1;
+      x1 = (x * 2 + 1 < src->width) ? x * 2 + 1 : src->width - 1;
+      for (c=0; c<4; c++) {
+        p = src->pixels + c;
+        dst->pixels[(y * dst->width + x) * 4 + c] = (unsigned char)
+          ((p[(y0 * src->width + x0) * 4] + p[(y0 * src->width + x1) * 4] +
+            p[(y1 * src->width + x0) * 4] + p[(y1 * src->width + x1) * 4] + 2) >> 2);
+      }
+    }
+  }
+}
+
+/*____________________________________________________________________
+|
+| Function: Encode_Color_Block
+|
+| Input: Called from TextureFile_Encode_Block()
+| Output: Compresses the rgb of a 4x4 block into 8 bytes - two 565
+|   endpoints and 2-bit indices into a 4 color palette.  Endpoints are
+|   the corners of the block's color bounding box, inset slightly and
+|   picking the box diagonal that follows the colors (by the sign of
+|   the red/green and blue/green covariance).
+|___________________________________________________________________*/
+
+static void Encode_Color_Block (const unsigned char *block, unsigned char *out)
+{
+  int i, c, min[3], max[3], center[3], inset, t, d, best, best_d;
+  int cov_rg, cov_bg, palette[4][3];
+  unsigned c0, c1, indices;
+
+  for (c=0; c<3; c++) {
+    min[c] = 255;
+    max[c] = 0;
+  }
+  for (i=0; i<16; i++)
+    for (c=0; c<3; c++) {
+      if (block[i*4+c] < min[c]) min[c] = block[i*4+c];
+      if (block[i*4+c] > max[c]) max[c] = block[i*4+c];
+    }
+
+  cov_rg = cov_bg = 0;
+  for (c=0; c<3; c++)
+    center[c] = (min[c] + max[c] + 1) >> 1;
+  for (i=0; i<16; i++) {
+    cov_rg += (block[i*4]   - center[0]) * (block[i*4+1] - center[1]);
+    cov_bg += (block[i*4+2] - center[2]) * (block[i*4+1] - center[1]);
+  }
+
+  // Inset the box by 1/16 of its size - the endpoints are rarely used exactly
+  for (c=0; c<3; c++) {
+    inset = (max[c] - min[c]) >> 4;
+    min[c] += inset;
+    max[c] -= inset;
+  }
+  if (cov_rg < 0) {
+    t = min[0]; min[0] = max[0]; max[0] = t;
+  }
+  if (cov_bg < 0) {
+    t = min[2]; min[2] = max[2]; max[2] = t;
+  }
+
+  // Endpoint 0 must be greater for 4 color mode
+  c0 = To_565 (max);
+  c1 = To_565 (min);
+  if (c0 < c1) {
+    t = c0; c0 = c1; c1 = t;
+  }
+
+  indices = 0;
+  if (c0 != c1) {
+    From_565 (c0, palette[0]);
+    From_565 (c1, palette[1]);
+    for (c=0; c<3; c++) {
+      palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+      palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    }
+    for (i=0; i<16; i++) {
+      best   = 0;
+      best_d = 0x7FFFFFFF;
+      for (t=0; t<4; t++) {
+        d = (block[i*4]   - palette[t][0]) * (block[i*4]   - palette[t][0]) +
+            (block[i*4+1] - palette[t][1]) * (block[i*4+1] - palette[t][1]) +
+            (block[i*4+2] - palette[t][2]) * (block[i*4+2] - palette[t][2]);
+        if (d < best_d) {
+          best_d = d;
+          best   = t;
+        }
+      }
+      indices |= (unsigned) best << (i * 2);
+    }
+  }
+
+  out[0] = (unsigned char) c0;
+  out[1] = (unsigned char) (c0 >> 8);
+  out[2] = (unsigned char) c1;
+  out[3] = (unsigned char) (c1 >> 8);
+  out[4] = (unsigned char) indices;
+  out[5] = (unsigned char) (indices >> 8);
+  out[6] = (unsigned char) (indices >> 16);
+  out[7] = (unsigned char) (indices >> 24);
+}
+
+/*____________________________________________________________________
+|
+| Function: Encode_Alpha_Block
+|
+| Input: Called from TextureFile_Encode_Block()
+| Output: Compresses the alpha of a 4x4 block into 8 bytes - the min and
+|   max alpha and 3-bit indices into an 8 value ramp between them.
+|___________________________________________________________________*/
+
+static void Encode_Alpha_Block (const unsigned char *block, unsigned char *out)
+{
+  int i, t, a0, a1, d, best, best_d, palette[8];
+  unsigned long long indices;
+
+  a0 = 0;
+  a1 = 255;
+  for (i=0; i<16; i++) {
+    if (block[i*4+3] > a0) a0 = block[i*4+3];
+    if (block[i*4+3] < a1) a1 = block[i*4+3];
+  }
+
+  indices = 0;
+  if (a0 != a1) {
+    palette[0] = a0;
+    palette[1] = a1;
+    for (t=1; t<7; t++)
+      palette[t+1] = ((7 - t) * a0 + t * a1) / 7;
+    for (i=0; i<16; i++) {
+      best   = 0;
+      best_d = 256;
+      for (t=0; t<8; t++) {
+        d = abs (block[i*4+3] - palette[t]);
+        if (d < best_d) {
+          best_d = d;
+          best   = t;
+        }
+      }
+      indices |= (unsigned long long) best << (i * 3);
+    }
+  }
+
+  out[0] = (unsigned char) a0;
+  out[1] = (unsigned char) a1;
+  for (i=0; i<6; i++)
+    out[2+i] = (unsigned char) (indices >> (i * 8));
+}
+
+/*____________________________________________________________________
+|
+| Function: To_565, From_565
+|
+| Input: Called from Encode_Color_Block()
+| Output: Converts between 8-bit rgb and a 16-bit 565 color.  From_565
+|   replicates high bits into the low bits, as the hardware does.
+|___________________________________________________________________*/
+
+static unsigned To_565 (const int *color)
+{
+  return ((((color[0] * 31 + 127) / 255) << 11) | (((color[1] * 63 + 127) / 255) << 5) | ((color[2] * 31 + 127) / 255));
+}
+
+static void From_565 (unsigned c, int *color)
+{
+  int r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+
+  color[0] = (r << 3) | (r >> 2);
+  color[1] = (g << 2) | (g >> 4);
+  color[2] = (b << 3) | (b >> 2);
+}
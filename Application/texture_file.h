@@ -0,0 +1,80 @@
+/*____________________________________________________________________
+|
+| File: texture_file.h
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+#ifndef _TEXTURE_FILE_H_
+#define _TEXTURE_FILE_H_
+
+/*___________________
+|
+| Constants
+|__________________*/
+
+#define TEXTURE_FILE_EXTENSION  ".dds"
+#define TEXTURE_FILE_MAX_LEVELS 16
+
+// Block compressed formats
+#define TEXTURE_FORMAT_BC1 1    // DXT1 - rgb, 8 bytes per 4x4 block
+#define TEXTURE_FORMAT_BC3 3    // DXT5 - rgb + interpolated alpha, 16 bytes per 4x4 block
+
+/*___________________
+|
+| Type definitions
+|__________________*/
+
+// An uncompressed image, 4 bytes per pixel (r,g,b,a), top row first
+typedef struct {
+  int            width;
+  int            height;
+  unsigned char *pixels;
+} TextureImage;
+
+// A baked texture in memory
+typedef struct {
+  int                  format;      // TEXTURE_FORMAT_...
+  int                  width;
+  int                  height;
+  int                  num_levels;  // mipmap levels, level 0 is full size
+  const unsigned char *level_data [TEXTURE_FILE_MAX_LEVELS];
+  unsigned             level_size [TEXTURE_FILE_MAX_LEVELS];
+  void                *buffer;      // entire file
+  unsigned             size;
+} TextureFile;
+
+/*___________________
+|
+| Functions
+|__________________*/
+
+// Reads a 24-bit or 8-bit BMP file, merging alpha from a second BMP if given, returns true on success
+bool TextureImage_Read_BMP (
+  const char   *filename,
+  const char   *alpha_filename,     // can be 0, else alpha = brightness of this image
+  TextureImage *image );
+
+// Frees an image
+void TextureImage_Free (TextureImage *image);
+
+// Returns true if any pixel in the image isn't opaque
+bool TextureImage_Has_Alpha (TextureImage *image);
+
+// Builds a mipmap chain, compresses it and writes a texture file, returns true on success
+bool TextureFile_Bake (const char *filename, TextureImage *image, int format);
+
+// Loads a texture file with a single read, returns true on success
+bool TextureFile_Load (const char *filename, TextureFile *texture);
+
+// Frees a texture file loaded with TextureFile_Load()
+void TextureFile_Free (TextureFile *texture);
+
+// Returns the number of bytes in one compressed mipmap level
+unsigned TextureFile_Level_Size (int format, int width, int height);
+
+// Compresses one 4x4 block of pixels (r,g,b,a, 16 pixels in rows)
+void TextureFile_Encode_Block (int format, const unsigned char *block, unsigned char *out);
+
+#endif
@@ -0,0 +1,277 @@
+/*____________________________________________________________________
+|
+| File: trace.cpp
+|
+| Description: Records timed spans (startup phases, asset reads and
+|   loads) and writes them as Chrome trace event JSON, so where startup
+|   time goes can be seen on a timeline, one row per thread.
+|
+|   Spans can be recorded from any thread.  Each span takes a slot in a
+|   fixed table with an interlocked increment and only its own thread
+|   writes to the slot, so recording takes no lock.  Spans that begin
+|   once the table is full are dropped.  Nesting spans on a thread shows
+|   the inner ones below the outer one in the viewer.
+|
+| Functions: Trace_Init
+|            Trace_Begin
+|            Trace_End
+|            Trace_End_Bytes
+|            Trace_Name_Thread
+|            Trace_Write
+|             Write_String
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+/*___________________
+|
+| Include Files
+|__________________*/
+
+#include <windows.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "trace.h"
+
+/*___________________
+|
+| Constants
+|__________________*/
+
+#define MAX_EVENTS       1024
+#define MAX_THREAD_NAMES 16
+#define MAX_NAME_SIZE    64
+
+/*___________________
+|
+| Type definitions
+|__________________*/
+
+typedef struct {
+  char          name [MAX_NAME_SIZE];
+  const char   *category;
+  LONGLONG      start;
+  volatile LONGLONG end;          // 0 until the span ends
+  DWORD         thread;
+  unsigned      bytes;
+  bool          has_bytes;
+} TraceEvent;
+
+typedef struct {
+  DWORD       thread;
+  const char *name;
+} ThreadName;
+
+/*___________________
+|
+| Function Prototypes
+|__________________*/
+
+static void Write_String (FILE *fp, const char *str);
+
+/*___________________
+|
+| Global variables
+|__________________*/
+
+static TraceEvent    events [MAX_EVENTS];
+static volatile LONG num_events;
+static ThreadName    thread_names [MAX_THREAD_NAMES];
+static volatile LONG num_thread_names;
+static LONGLONG      start_ticks;
+static double        ticks_per_us;
+static volatile bool recording;
+
+/*____________________________________________________________________
+|
+| Function: Trace_Init
+|
+| Input: Called from CMainApp::InitInstance()
+| Output: Starts recording.
+|___________________________________________________________________*/
+
+void Trace_Init ()
+{
+  LARGE_INTEGER frequency, now;
+
+  QueryPerformanceFrequency (&frequency);
+  QueryPerformanceCounter (&now);
+  ticks_per_us     = (double) frequency.QuadPart / 1000000.0;
+  start_ticks      = now.QuadPart;
+  num_events       = 0;
+  num_thread_names = 0;
+  recording        = true;
+}
+
+/*____________________________________________________________________
+|
+| Function: Trace_Begin
+|
+| Input: Called from ____
+| Output: Starts a span on the calling thread.  Returns the event id,
+|   or -1 if not recording or the table is full.
+|___________________________________________________________________*/
+
+int Trace_Begin (const char *category, const char *name)
+{
+  int id;
+  LARGE_INTEGER now;
+  TraceEvent *event;
+
+  if (! recording)
+    return (-1);
+  id = (int) InterlockedIncrement (&num_events) - 1;
+  if (id >= MAX_EVENTS)
+    return (-1);
+
+  event = &events[id];
+  strncpy (event->name, name, MAX_NAME_SIZE - 1);
+  event->name[MAX_NAME_SIZE - 1] = 0;
+  event->category  = category;
+  event->thread    = GetCurrentThreadId ();
+  event->bytes     = 0;
+  event->has_bytes = false;
+  event->end       = 0;
+  QueryPerformanceCounter (&now);
+  event->start     = now.QuadPart;
+
+  return (id);
+}
+
+/*____________________________________________________________________
+|
+| Function: Trace_End
+|
+| Input: Called from ____
+| Output: Ends a span.
+|___________________________________________________________________*/
+
+void Trace_End (int event)
+{
+  LARGE_INTEGER now;
+
+  if (event >= 0) {
+    QueryPerformanceCounter (&now);
+    // Never 0, so the span reads as ended
+    events[event].end = (now.QuadPart > events[event].start) ? now.QuadPart : events[event].start + 1;
+  }
+}
+
+/*____________________________________________________________________
+|
+| Function: Trace_End_Bytes
+|
+| Input: Called from ____
+| Output: Ends a span, recording a byte count with it.
+|___________________________________________________________________*/
+
+void Trace_End_Bytes (int event, unsigned bytes)
+{
+  if (event >= 0) {
+    events[event].bytes     = bytes;
+    events[event].has_bytes = true;
+    Trace_End (event);
+  }
+}
+
+/*____________________________________________________________________
+|
+| Function: Trace_Name_Thread
+|
+| Input: Called from ____
+| Output: Names the calling thread.
+|___________________________________________________________________*/
+
+void Trace_Name_Thread (const char *name)
+{
+  int id;
+
+  if (! recording)
+    return;
+  id = (int) InterlockedIncrement (&num_thread_names) - 1;
+  if (id < MAX_THREAD_NAMES) {
+    thread_names[id].thread = GetCurrentThreadId ();
+    thread_names[id].name   = name;
+  }
+}
+
+/*____________________________________________________________________
+|
+| Function: Trace_Write
+|
+| Input: Called from Program_Run()
+| Output: Stops recording and writes the trace.  Spans still open are
+|   left out.  Returns true on success.
+|___________________________________________________________________*/
+
+bool Trace_Write (const char *filename)
+{
+  int i, n;
+  bool first;
+  FILE *fp;
+  TraceEvent *event;
+
+  recording = false;
+
+  fp = fopen (filename, "w");
+  if (fp == 0)
+    return (false);
+
+  fprintf (fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  first = true;
+
+  n = (num_thread_names < MAX_THREAD_NAMES) ? (int) num_thread_names : MAX_THREAD_NAMES;
+  for (i=0; i<n; i++) {
+    fprintf (fp, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%lu,\"args\":{\"name\":", first ? "" : ",\n", (unsigned long) thread_names[i].thread);
+    Write_String (fp, thread_names[i].name);
+    fprintf (fp, "}}");
+    first = false;
+  }
+
+  n = (num_events < MAX_EVENTS) ? (int) num_events : MAX_EVENTS;
+  for (i=0; i<n; i++) {
+    event = &events[i];
+    if (event->end == 0)
+      continue;
+    fprintf (fp, "%s{\"name\":", first ? "" : ",\n");
+    Write_String (fp, event->name);
+    fprintf (fp, ",\"cat\":");
+    Write_String (fp, event->category);
+    fprintf (fp, ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%lu",
+             (event->start - start_ticks) / ticks_per_us, (event->end - event->start) / ticks_per_us,
+             (unsigned long) event->thread);
+    if (event->has_bytes)
+      fprintf (fp, ",\"args\":{\"bytes\":%u}", event->bytes);
+    fprintf (fp, "}");
+    first = false;
+  }
+
+  fprintf (fp, "\n]}\n");
+
+  return (fclose (fp) == 0);
+}
+
+/*____________________________________________________________________
+|
+| Function: Write_String
+|
+| Input: Called from Trace_Write()
+| Output: Writes a string as a quoted JSON string (filenames have
+|   backslashes).
+|___________________________________________________________________*/
+
+static void Write_String (FILE *fp, const char *str)
+{
+  fputc ('"', fp);
+  for (; *str; str++) {
+    if ((*str == '"') || (*str == '\\'))
+      fprintf (fp, "\\%c", *str);
+    else if ((unsigned char) *str < ' ')
+      fprintf (fp, "\\u%04x", (unsigned char) *str);
+    else
+      fputc (*str, fp);
+  }
+  fputc ('"', fp);
+}
@@ -0,0 +1,38 @@
+/*____________________________________________________________________
+|
+| File: trace.h
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+/*___________________
+|
+| Functions
+|__________________*/
+
+// Starts recording, times are measured from this call
+void Trace_Init ();
+
+// Starts timing a span on the calling thread, returns an event id or -1 if not recording
+int Trace_Begin (
+  const char *category,       // must be a string constant, for example "startup"
+  const char *name );         // copied
+
+// Ends a span (ignores -1)
+void Trace_End (int event);
+
+// Ends a span and records the number of bytes it read or created
+void Trace_End_Bytes (int event, unsigned bytes);
+
+// Names the calling thread in the trace
+void Trace_Name_Thread (const char *name);
+
+// Stops recording and writes all ended spans as Chrome trace event JSON
+//   (open in chrome://tracing or Perfetto), returns true on success
+bool Trace_Write (const char *filename);
+
+#endif
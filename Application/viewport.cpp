@@ -0,0 +1,143 @@
+/*____________________________________________________________________
+|
+| File: viewport.cpp
+|
+| Description: Screen layouts of one or two viewports, each drawn from
+|   its own camera (see camera.cpp).  Cameras only compute matrices, so
+|   any number of them can be kept and moved independently, and the
+|   view and projection are set in the graphics state only when a
+|   viewport is begun.  Each camera's projection takes the aspect ratio
+|   of its viewport and its frustum planes are updated once per layout,
+|   for culling by anything drawn in that viewport.
+|
+| Functions: Viewport_Layout
+|            Viewport_Begin
+|            Viewport_Get_Camera
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+/*___________________
+|
+| Include Files
+|__________________*/
+
+#include <first_header.h>
+#include <string.h>
+
+#include "dp.h"
+
+#include "camera.h"
+#include "viewport.h"
+#include "benchmark_count.h"
+
+/*___________________
+|
+| Constants
+|__________________*/
+
+#define PICTURE_SIZE    3     // picture in picture is 1/3 of the screen across and down
+#define PICTURE_MARGIN  16    // pixels from the corner of the screen
+
+/*____________________________________________________________________
+|
+| Function: Viewport_Layout
+|
+| Input: Called from Program_Run()
+| Output: Fills in the viewports for a layout, returns the number of
+|   viewports.  Modes needing a second camera fall back to a single
+|   viewport if there isn't one.
+|___________________________________________________________________*/
+
+int Viewport_Layout (
+  int          mode,
+  gxRectangle *screen,
+  Camera      *main_camera,
+  Camera      *second_camera,
+  float        fov,
+  float        near_plane,
+  float        far_plane,
+  Viewport    *viewports )
+{
+  int i, n, width, height;
+
+  if (second_camera == 0)
+    mode = VIEWPORT_MODE_SINGLE;
+
+  width  = screen->xright - screen->xleft + 1;
+  height = screen->ybottom - screen->ytop + 1;
+
+  viewports[0].rect   = *screen;
+  viewports[0].camera = main_camera;
+  n = 1;
+  switch (mode) {
+    case VIEWPORT_MODE_SPLIT:
+      viewports[0].rect.xright = screen->xleft + width / 2 - 1;
+      viewports[1].rect        = *screen;
+      viewports[1].rect.xleft  = screen->xleft + width / 2;
+      viewports[1].camera      = second_camera;
+      n = 2;
+      break;
+    case VIEWPORT_MODE_PICTURE:
+      viewports[1].rect.xright  = screen->xright - PICTURE_MARGIN;
+      viewports[1].rect.xleft   = viewports[1].rect.xright - width / PICTURE_SIZE + 1;
+      viewports[1].rect.ytop    = screen->ytop + PICTURE_MARGIN;
+      viewports[1].rect.ybottom = viewports[1].rect.ytop + height / PICTURE_SIZE - 1;
+      viewports[1].camera       = second_camera;
+      n = 2;
+      break;
+  }
+
+  // Give each camera the projection for its viewport
+  for (i=0; i<n; i++) {
+    width  = viewports[i].rect.xright - viewports[i].rect.xleft + 1;
+    height = viewports[i].rect.ybottom - viewports[i].rect.ytop + 1;
+    Camera_Set_Projection (viewports[i].camera, fov, (float)width / (float)height, near_plane, far_plane);
+    Camera_Update_Frustum (viewports[i].camera);
+  }
+
+  return (n);
+}
+
+/*____________________________________________________________________
+|
+| Function: Viewport_Begin
+|
+| Input: Called from Program_Run()
+| Output: Sets the viewport, and its camera's projection and view
+|   matrices.  The projection is set after the viewport so it takes the
+|   viewport's aspect ratio, like the camera's.
+|___________________________________________________________________*/
+
+void Viewport_Begin (Viewport *viewport)
+{
+  Camera *camera = viewport->camera;
+  gx3dMatrix m;
+
+  gx3d_SetViewport (&viewport->rect);
+  gx3d_SetProjectionMatrix (camera->fov, camera->near_plane, camera->far_plane);
+  // gx3dMatrix is a row major 4x4 like the camera's
+  memcpy (&m, camera->view, sizeof(gx3dMatrix));
+  gx3d_SetViewMatrix (&m);
+}
+
+/*____________________________________________________________________
+|
+| Function: Viewport_Get_Camera
+|
+| Input: Called from Program_Run()
+| Output: Returns a viewport's camera position and heading.
+|___________________________________________________________________*/
+
+void Viewport_Get_Camera (Viewport *viewport, gx3dVector *position, gx3dVector *heading)
+{
+  Camera *camera = viewport->camera;
+
+  position->x = camera->position[0];
+  position->y = camera->position[1];
+  position->z = camera->position[2];
+  heading->x  = camera->heading[0];
+  heading->y  = camera->heading[1];
+  heading->z  = camera->heading[2];
+}
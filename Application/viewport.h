@@ -0,0 +1,38 @@
+/*____________________________________________________________________
+|
+| File: viewport.h
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+// Layouts
+#define VIEWPORT_MODE_SINGLE   0    // main camera full screen
+#define VIEWPORT_MODE_SPLIT    1    // main camera on the left half, second camera on the right half
+#define VIEWPORT_MODE_PICTURE  2    // main camera full screen, second camera in the top right corner
+#define VIEWPORT_NUM_MODES     3
+
+#define VIEWPORT_MAX           2    // most viewports in a layout
+
+typedef struct {
+  gxRectangle rect;
+  Camera     *camera;
+} Viewport;
+
+// Fills in the viewports for a layout, giving each camera the projection for its
+//   viewport, returns the number of viewports (the first is always the main camera's)
+int Viewport_Layout (
+  int          mode,
+  gxRectangle *screen,
+  Camera      *main_camera,
+  Camera      *second_camera,
+  float        fov,                 // vertical field of view in degrees
+  float        near_plane,
+  float        far_plane,
+  Viewport    *viewports );         // array of VIEWPORT_MAX
+
+// Makes a viewport the one drawn to, setting its camera's view and projection
+void Viewport_Begin (Viewport *viewport);
+
+// Gets a viewport's camera position and heading
+void Viewport_Get_Camera (Viewport *viewport, gx3dVector *position, gx3dVector *heading);
@@ -28,6 +28,8 @@
 #include "CMainApp.h"
 #include "splash.h"
 
+#include "..\Application\trace.h"
+
 /*____________________
 |
 |	Constants
@@ -69,11 +71,19 @@ BOOL CMainApp::InitInstance (void)
   DWORD dwDxVersion;
   char str[80];
   BOOL initialized = FALSE;
+  int trace_init, trace_event;
+
+  // Time startup from here until everything is loaded
+  Trace_Init ();
+  Trace_Name_Thread ("main");
+  trace_init = Trace_Begin ("startup", "InitInstance");
 
   CoInitialize (0); 
 
   // Check for the correct version of DX or greater
+  trace_event = Trace_Begin ("startup", "GetDXVersion");
   dwDxVersion = GetDXVersion ();
+  Trace_End (trace_event);
   if (dwDxVersion < DIRECTX_VERSION_REQUIRED) {
     sprintf (str, "This program requires DirectX %s or greater.", DIRECTX_VERSION_STR);
     MessageBox (NULL, str, "Error", MB_OK | MB_ICONSTOP);
@@ -83,7 +93,11 @@ BOOL CMainApp::InitInstance (void)
 	  The_window = new CMainFrame;
     if (The_window) {
       sprintf (str, "%s %s", APPLICATION_NAME, APPLICATION_VERSION);
-      if (The_window->Init (str, IDI_ICON)) {
+      // Includes the splash screen
+      trace_event = Trace_Begin ("startup", "Create window");
+      initialized = The_window->Init (str, IDI_ICON);
+      Trace_End (trace_event);
+      if (initialized) {
 			  // Tell base class about the window created for this application
 			  m_pMainWnd = The_window;
 			  // Make sure m_pMainWnd is not NULL
@@ -98,6 +112,7 @@ BOOL CMainApp::InitInstance (void)
       }
     }
   }
+  Trace_End (trace_init);
 
   return (initialized);
 }
@@ -17,6 +17,7 @@
 |							CMainFrame::EventQueue_Add
 |             CMainFrame::EventQueue_Remove                      
 |             CMainFrame::EventQueue_Flush
+|             CMainFrame::EventQueue_Capture_Time
 |             CMainFrame::CallbackQueue_Add
 |             CMainFrame::CallbackQueue_Flush
 |             CMainFrame::CallbackQueue_Process
@@ -53,6 +54,8 @@
 #include "version.h"
 
 #include "..\Application\main.h"
+#include "..\Application\trace.h"
+#include "..\Application\latency.h"
 
 #include "CMainFrame.h"
 #include "splash.h"
@@ -62,9 +65,10 @@
 | Type definitions
 |___________________*/
 
-struct CallbackQueueEntry {
-  void (*callback) (void *params); 
-  void *params;
+// An event queue entry, stamped when it was captured
+struct StampedEvent {
+  EventQueueEntry qentry;
+  long long       capture_time;   // from Latency_Now()
 };
 
 /*____________________
@@ -114,14 +118,14 @@ static volatile byte program_initialized = FALSE;
 CMainFrame::CMainFrame ()
 {
   // Init event queue
-  InitializeCriticalSection (&event_critsection);
-  event_queue = queue_Init (SIZE_EVENT_QUEUE, sizeof (EventQueueEntry));
+  InitializeCriticalSection (&event_add_critsection);
+  event_ring = Spsc_Ring_Create (SIZE_EVENT_QUEUE, sizeof (StampedEvent));
+  event_capture_time = 0;
   generate_keypress_events = FALSE;
   preferences = NULL;
 
   // Init callback queue
-  InitializeCriticalSection (&callback_critsection);
-  callback_queue = queue_Init (SIZE_CALLBACK_QUEUE, sizeof (CallbackQueueEntry));
+  callback_queue = Callback_Queue_Create (SIZE_CALLBACK_QUEUE);
 
   // Init cursor state (visible by default)
   cursor_state = 1;
@@ -140,12 +144,11 @@ CMainFrame::CMainFrame ()
 CMainFrame::~CMainFrame ()
 {
   // Free callback queue
-  queue_Free (callback_queue);
-  DeleteCriticalSection (&callback_critsection);
+  Callback_Queue_Free (callback_queue);
 
   // Free event queue
-  queue_Free (event_queue);
-  DeleteCriticalSection (&event_critsection);
+  Spsc_Ring_Free (event_ring);
+  DeleteCriticalSection (&event_add_critsection);
 
   // Print abort string?
   if (abort_string[0]) {
@@ -281,39 +284,65 @@ void CMainFrame::Abort_Program (char *str)
 |
 |	Function: CMainFrame::EventQueue_Add
 | 
-|	Output: Adds an entry to the event queue.
+|	Output: Adds an entry to the event queue (dropped if the queue is
+|   full).  The event ring has one producer, so adds from different
+|   threads take turns, but never wait on the program thread removing
+|   events.  Every event is stamped with the time it was captured, for
+|   measuring input latency.
 |___________________________________________________________________*/
 
 void CMainFrame::EventQueue_Add (EventQueueEntry *qentry)
 {
-	EnterCriticalSection (&event_critsection);
-	queue_Add (event_queue, qentry);
-	LeaveCriticalSection (&event_critsection);
+  StampedEvent event;
+
+  event.capture_time = Latency_Now ();
+  event.qentry       = *qentry;
+	EnterCriticalSection (&event_add_critsection);
+	Spsc_Ring_Push (event_ring, &event);
+	LeaveCriticalSection (&event_add_critsection);
 }
 
 /*___________________________________________________________________
 |
 |	Function: CMainFrame::EventQueue_Remove
 | 
-|	Output: Removes an entry from the event queue.
+|	Output: Removes an entry from the event queue, without a lock (from
+|   the program thread only).
 |___________________________________________________________________*/
 
 int CMainFrame::EventQueue_Remove (EventQueueEntry *qentry)
 {
 	int event_ready;
+  StampedEvent event;
 
-  EnterCriticalSection (&event_critsection);
-	event_ready = queue_Remove (event_queue, qentry);
-	LeaveCriticalSection (&event_critsection);
+	event_ready = Spsc_Ring_Pop (event_ring, &event) ? TRUE : FALSE;
+  if (event_ready) {
+    *qentry = event.qentry;
+    event_capture_time = event.capture_time;
+  }
 
   return (event_ready);
 }
 
+/*___________________________________________________________________
+|
+|	Function: CMainFrame::EventQueue_Capture_Time
+| 
+|	Input: Called from win_EventQueue_Capture_Time() (on the program thread)
+| Output: Returns the time the last entry removed from the event queue
+|   was captured (from Latency_Now()).
+|___________________________________________________________________*/
+
+long long CMainFrame::EventQueue_Capture_Time (void)
+{
+  return (event_capture_time);
+}
+
 /*___________________________________________________________________
 |
 |	Function: CMainFrame::EventQueue_Flush
 | 
-|	Input: Called from ____
+|	Input: Called from ____ (on the program thread)
 | Output: Flushes all events contained in the eventmask from the event queue.
 |___________________________________________________________________*/
 
@@ -322,7 +351,7 @@ static int Entry_Is_Type (void *event, void *event_type_mask)
 {
   int same;
 
-  if (((EventQueueEntry *)event)->type & *((unsigned *)event_type_mask))
+  if (((StampedEvent *)event)->qentry.type & *((unsigned *)event_type_mask))
     same = TRUE;
   else
     same = FALSE;
@@ -332,44 +361,22 @@ static int Entry_Is_Type (void *event, void *event_type_mask)
 
 void CMainFrame::EventQueue_Flush (unsigned event_type_mask)
 {
-  EnterCriticalSection (&event_critsection);
-	queue_Remove_Selected_Entries (event_queue, &event_type_mask, Entry_Is_Type);
-	LeaveCriticalSection (&event_critsection);
+	Spsc_Ring_Remove_Selected (event_ring, &event_type_mask, Entry_Is_Type);
 }
 
 /*___________________________________________________________________
 |
 |	Function: CMainFrame::CallbackQueue_Add
 | 
-|	Output: Adds an entry to the callback queue.
+|	Output: Adds an entry to the callback queue, with a copy of its params
+|   (kept in the queue, not allocated, unless they're large).
 |___________________________________________________________________*/
 
 void CMainFrame::CallbackQueue_Add (void (*callback) (void *params), void *params, unsigned size_params)
 {
-  int error = FALSE;
-
-  CallbackQueueEntry data;
-
-  // Create a struct for the data
-  data.callback = callback;
-  data.params   = NULL;
-  if (size_params) {
-    data.params = (void *) malloc (size_params);
-    if (data.params) 
-      memcpy (data.params, params, size_params);
-    else 
-      error = TRUE;
-  }
-
-  if (NOT error) {
-    // Add this to the callback queue
-    EnterCriticalSection (&callback_critsection);
-    queue_Add (callback_queue, (byte *)&data);
-    LeaveCriticalSection (&callback_critsection);
-  	  
+  if (Callback_Queue_Add (callback_queue, callback, params, size_params))
     // Send a message to indicate an entry has been entered in the callback queue
 	  ::PostMessage (m_hWnd, USER_CALLBACK_MSG, 0, 0);
-  }
 }
 
 /*___________________________________________________________________
@@ -382,13 +389,7 @@ void CMainFrame::CallbackQueue_Add (void (*callback) (void *params), void *param
 
 void CMainFrame::CallbackQueue_Flush (void)
 {
-  CallbackQueueEntry data;
-
-  EnterCriticalSection (&callback_critsection);
-  while (queue_Remove (callback_queue, (byte *)&data))
-    if (data.params)
-      free (data.params);
-	LeaveCriticalSection (&callback_critsection);
+  Callback_Queue_Flush (callback_queue);
 }
 
 /*___________________________________________________________________
@@ -396,24 +397,14 @@ void CMainFrame::CallbackQueue_Flush (void)
 |	Function: CMainFrame::CallbackQueue_Process
 | 
 |	Input: Called from ____
-| Output: Processes an entry in the callback queue, if any.
+| Output: Processes an entry in the callback queue, if any.  The user
+|   function is called after the entry is removed, outside the queue's
+|   lock, so threads adding callbacks don't wait on it.
 |___________________________________________________________________*/
 
 void CMainFrame::CallbackQueue_Process (void)
 {
-  CallbackQueueEntry data;
-
-  EnterCriticalSection (&callback_critsection);
-  // If any entry in the queue
-  if (queue_Remove (callback_queue, (byte *)&data)) {
-    // Call back the user function
-    (*data.callback) (data.params);   
-    // Free memory for this queue entry
-    if (data.params)
-      free (data.params);
-  }
-    
-  LeaveCriticalSection (&callback_critsection);
+  Callback_Queue_Process (callback_queue);
 }
 
 /*___________________________________________________________________
@@ -426,9 +417,15 @@ void CMainFrame::CallbackQueue_Process (void)
 
 void CMainFrame::Start_Program_Thread (void)
 {
+  int trace_event, initialized;
+
   ShowCursor (FALSE);
 
-  if (Program_Init (preferences, &generate_keypress_events)) { 
+  trace_event = Trace_Begin ("startup", "Program_Init");
+  initialized = Program_Init (preferences, &generate_keypress_events);
+  Trace_End (trace_event);
+
+  if (initialized) { 
     program_initialized = TRUE;
     ShowCursor (FALSE);
     // Start a new thread here to run application program 
@@ -454,6 +451,7 @@ void CMainFrame::Start_Program_Thread (void)
 unsigned Program_Thread (LPVOID pParam)
 {            
   ShowCursor (FALSE);
+  Trace_Name_Thread ("program");
 	Program_Run ();
 
 	// Send a message to primary thread to indicate program thread is ending
@@ -479,8 +477,10 @@ afx_msg int CMainFrame::OnCreate (LPCREATESTRUCT lpCreateStruct)
 #ifdef SPLASH_SOUND
   PlaySound (MAKEINTRESOURCE(IDR_WAVE1), NULL, SND_RESOURCE | SND_ASYNC);
 #endif
+  int trace_event = Trace_Begin ("startup", "Splash screen");
   SplashScreen::ShowSplashScreen (this);
   Sleep (SPLASH_TIME);
+  Trace_End (trace_event);
 #endif
 
   ::PostMessage (m_hWnd, USER_START_PROGRAM_THREAD_MSG, 0, 0);
@@ -503,9 +503,7 @@ afx_msg void CMainFrame::OnClose ()
 	  // Generate a close event for program thread
     static EventQueueEntry qentry;
 	  qentry.type = evTYPE_WINDOW_CLOSE;
-    EnterCriticalSection (&event_critsection);
-    queue_Add (event_queue, &qentry);
-    LeaveCriticalSection (&event_critsection);
+    EventQueue_Add (&qentry);
 
     // Wait until program thread closes (or 10 seconds max)
 		WaitForSingleObject (program_thread_handle, 10*1000);
@@ -569,9 +567,7 @@ afx_msg void CMainFrame::OnActivateApp (BOOL bActive, DWORD hTask)
     DEBUG_WRITE ("Inside OnActivateApp() - generating evTYPE_WINDOW_INACTIVE")
 #endif
 
-  EnterCriticalSection (&event_critsection);
-  queue_Add (event_queue, &qentry);
-  LeaveCriticalSection (&event_critsection);
+  EventQueue_Add (&qentry);
 }
 
 /*___________________________________________________________________
@@ -705,9 +701,7 @@ void CMainFrame::On_Key_Press (int event_keycode)
 
   qentry.type		 = evTYPE_KEY_PRESS;
   qentry.keycode = event_keycode;
-  EnterCriticalSection (&event_critsection);
-  queue_Add (event_queue, &qentry);
-  LeaveCriticalSection (&event_critsection);
+  EventQueue_Add (&qentry);
 }
 
 /*___________________________________________________________________
@@ -12,6 +12,8 @@
 |___________________*/
                                                           
 #include <events.h>
+#include "spsc_ring.h"
+#include "callback_queue.h"
 
 /*____________________
 |
@@ -42,6 +44,7 @@ public:
   void EventQueue_Add    (EventQueueEntry *qentry);
   int  EventQueue_Remove (EventQueueEntry *qentry);
   void EventQueue_Flush  (unsigned event_type_mask);
+  long long EventQueue_Capture_Time (void);
 
   void CallbackQueue_Add     (void (*callback) (void *params), void *params, unsigned size_params);
   void CallbackQueue_Flush   (void);
@@ -66,15 +69,15 @@ private:
   void Show_MFC_Cursor ();
   void Hide_MFC_Cursor ();
 
-	// Event queue
-  Queue event_queue;
-  CRITICAL_SECTION event_critsection;
+	// Event queue (read by the program thread without a lock)
+  SpscRing *event_ring;
+  CRITICAL_SECTION event_add_critsection;   // serializes threads adding events
+  long long event_capture_time;             // of the last event removed
   int generate_keypress_events;
   void *preferences;
 
   // Callback queue
-  Queue	callback_queue;
-  CRITICAL_SECTION callback_critsection;
+  CallbackQueue *callback_queue;
 
 	// Program thread object
 	HANDLE program_thread_handle;
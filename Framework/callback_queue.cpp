@@ -0,0 +1,288 @@
+/*____________________________________________________________________
+|
+| File: callback_queue.cpp
+|
+| Description: Queue of callbacks to be run on the main thread, each
+|   with its own copy of the params it was added with.  Nothing is
+|   allocated per callback: small params are copied into the entry
+|   itself, and larger ones into a block of a slab allocated with the
+|   queue.  Only params too big for a slab block (or added when every
+|   block is in use) fall back to the heap.
+|
+|   Any thread can add callbacks.  The lock is held only to copy an
+|   entry in or out, never while a callback runs, so a slow callback
+|   doesn't hold up threads adding more.
+|
+| Functions: Callback_Queue_Create
+|            Callback_Queue_Free
+|            Callback_Queue_Add
+|            Callback_Queue_Process
+|            Callback_Queue_Flush
+|             Release_Params
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+/*___________________
+|
+| Include Files
+|__________________*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <mutex>
+
+#include "callback_queue.h"
+
+/*___________________
+|
+| Constants
+|__________________*/
+
+// Where an entry's params are kept
+#define PARAMS_NONE    0
+#define PARAMS_INLINE  1
+#define PARAMS_SLAB    2
+#define PARAMS_HEAP    3
+
+#define SLAB_FRACTION  4    // slab blocks for 1/4 of the entries
+
+/*___________________
+|
+| Type definitions
+|__________________*/
+
+typedef struct {
+  void  (*callback) (void *params);
+  int     storage;                // PARAMS_NONE, etc.
+  int     block;                  // slab block, if PARAMS_SLAB
+  void   *heap;                   // if PARAMS_HEAP
+  union {
+    double        align;
+    void         *align_ptr;
+    unsigned char bytes [CALLBACK_QUEUE_INLINE_SIZE];
+  } params;                       // if PARAMS_INLINE
+} Entry;
+
+struct CallbackQueue {
+  std::mutex     lock;
+  Entry         *entries;
+  int            capacity;
+  int            first, num;      // oldest entry and number of entries
+  unsigned char *slab;
+  int           *free_blocks;     // stack of unused slab blocks
+  int            num_blocks, num_free;
+};
+
+/*___________________
+|
+| Function Prototypes
+|__________________*/
+
+static void Release_Params (CallbackQueue *queue, Entry *entry);
+
+/*____________________________________________________________________
+|
+| Function: Callback_Queue_Create
+|
+| Input: Called from CMainFrame::CMainFrame()
+| Output: Returns an empty queue, or 0 on any error.
+|___________________________________________________________________*/
+
+CallbackQueue *Callback_Queue_Create (int capacity)
+{
+  int i;
+  CallbackQueue *queue;
+
+  if (capacity < 1)
+    return (0);
+
+  queue = new CallbackQueue;
+  queue->capacity    = capacity;
+  queue->first       = 0;
+  queue->num         = 0;
+  queue->num_blocks  = (capacity + SLAB_FRACTION - 1) / SLAB_FRACTION;
+  queue->num_free    = queue->num_blocks;
+  queue->entries     = (Entry *) malloc (capacity * sizeof(Entry));
+  queue->slab        = (unsigned char *) malloc (queue->num_blocks * CALLBACK_QUEUE_SLAB_SIZE);
+  queue->free_blocks = (int *) malloc (queue->num_blocks * sizeof(int));
+  if ((queue->entries == 0) || (queue->slab == 0) || (queue->free_blocks == 0)) {
+    Callback_Queue_Free (queue);
+    return (0);
+  }
+  for (i=0; i<queue->num_blocks; i++)
+    queue->free_blocks[i] = i;
+
+  return (queue);
+}
+
+/*____________________________________________________________________
+|
+| Function: Callback_Queue_Free
+|
+| Input: Called from CMainFrame::~CMainFrame(), Callback_Queue_Create()
+| Output: Frees a queue.
+|___________________________________________________________________*/
+
+void Callback_Queue_Free (CallbackQueue *queue)
+{
+  if (queue) {
+    if (queue->entries)
+      Callback_Queue_Flush (queue);
+    free (queue->entries);
+    free (queue->slab);
+    free (queue->free_blocks);
+    delete queue;
+  }
+}
+
+/*____________________________________________________________________
+|
+| Function: Callback_Queue_Add
+|
+| Input: Called from CMainFrame::CallbackQueue_Add()
+| Output: Adds a callback to the end of the queue.  Returns false if
+|   the queue is full (or params couldn't be stored).
+|___________________________________________________________________*/
+
+bool Callback_Queue_Add (CallbackQueue *queue, void (*callback) (void *params), void *params, unsigned size_params)
+{
+  bool added = false;
+  void *heap = 0;
+  Entry *entry;
+
+  // Params too big for a slab block are copied before taking the lock
+  if (size_params > CALLBACK_QUEUE_SLAB_SIZE) {
+    heap = malloc (size_params);
+    if (heap == 0)
+      return (false);
+    memcpy (heap, params, size_params);
+  }
+
+  {
+    std::lock_guard<std::mutex> guard (queue->lock);
+    if (queue->num < queue->capacity) {
+      entry = &queue->entries[(queue->first + queue->num) % queue->capacity];
+      entry->callback = callback;
+      entry->storage  = PARAMS_NONE;
+      if (heap) {
+        entry->storage = PARAMS_HEAP;
+        entry->heap    = heap;
+        heap = 0;
+      }
+      else if (size_params == 0)
+        ;
+      else if (size_params <= CALLBACK_QUEUE_INLINE_SIZE) {
+        entry->storage = PARAMS_INLINE;
+        memcpy (entry->params.bytes, params, size_params);
+      }
+      else if (queue->num_free) {
+        entry->storage = PARAMS_SLAB;
+        entry->block   = queue->free_blocks[--queue->num_free];
+        memcpy (queue->slab + entry->block * CALLBACK_QUEUE_SLAB_SIZE, params, size_params);
+      }
+      else {
+        // Every slab block is in use, so this one goes on the heap after all
+        entry->heap = malloc (size_params);
+        if (entry->heap) {
+          entry->storage = PARAMS_HEAP;
+          memcpy (entry->heap, params, size_params);
+        }
+      }
+      if ((entry->storage != PARAMS_NONE) || (size_params == 0)) {
+        queue->num++;
+        added = true;
+      }
+    }
+  }
+
+  // Not added
+  if (heap)
+    free (heap);
+
+  return (added);
+}
+
+/*____________________________________________________________________
+|
+| Function: Callback_Queue_Process
+|
+| Input: Called from CMainFrame::CallbackQueue_Process()
+| Output: Removes the oldest callback and calls it.  The entry is
+|   copied out under the lock and the callback runs after the lock is
+|   released.  Returns false if the queue was empty.
+|___________________________________________________________________*/
+
+bool Callback_Queue_Process (CallbackQueue *queue)
+{
+  void *params;
+  Entry entry;
+
+  {
+    std::lock_guard<std::mutex> guard (queue->lock);
+    if (queue->num == 0)
+      return (false);
+    entry = queue->entries[queue->first];
+    queue->first = (queue->first + 1) % queue->capacity;
+    queue->num--;
+  }
+
+  // A slab block stays in use until the callback returns
+  switch (entry.storage) {
+    case PARAMS_INLINE: params = entry.params.bytes;
+                        break;
+    case PARAMS_SLAB:   params = queue->slab + entry.block * CALLBACK_QUEUE_SLAB_SIZE;
+                        break;
+    case PARAMS_HEAP:   params = entry.heap;
+                        break;
+    default:            params = 0;
+                        break;
+  }
+  (*entry.callback) (params);
+
+  if (entry.storage == PARAMS_SLAB) {
+    std::lock_guard<std::mutex> guard (queue->lock);
+    Release_Params (queue, &entry);
+  }
+  else
+    Release_Params (queue, &entry);
+
+  return (true);
+}
+
+/*____________________________________________________________________
+|
+| Function: Callback_Queue_Flush
+|
+| Input: Called from CMainFrame::CallbackQueue_Flush(),
+|   Callback_Queue_Free()
+| Output: Drops every callback in the queue without calling it.
+|___________________________________________________________________*/
+
+void Callback_Queue_Flush (CallbackQueue *queue)
+{
+  std::lock_guard<std::mutex> guard (queue->lock);
+
+  for (; queue->num; queue->num--) {
+    Release_Params (queue, &queue->entries[queue->first]);
+    queue->first = (queue->first + 1) % queue->capacity;
+  }
+}
+
+/*____________________________________________________________________
+|
+| Function: Release_Params
+|
+| Input: Called from Callback_Queue_Process(), Callback_Queue_Flush()
+|   (with the lock held if the params are in the slab)
+| Output: Frees the storage for an entry's params.
+|___________________________________________________________________*/
+
+static void Release_Params (CallbackQueue *queue, Entry *entry)
+{
+  if (entry->storage == PARAMS_SLAB)
+    queue->free_blocks[queue->num_free++] = entry->block;
+  else if (entry->storage == PARAMS_HEAP)
+    free (entry->heap);
+}
@@ -0,0 +1,52 @@
+/*____________________________________________________________________
+|
+| File: callback_queue.h
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+#ifndef _CALLBACK_QUEUE_H_
+#define _CALLBACK_QUEUE_H_
+
+/*___________________
+|
+| Constants
+|__________________*/
+
+#define CALLBACK_QUEUE_INLINE_SIZE  64    // params up to this size are kept in the entry
+#define CALLBACK_QUEUE_SLAB_SIZE    1024  // larger params up to this size are kept in a slab block
+
+/*___________________
+|
+| Type definitions
+|__________________*/
+
+typedef struct CallbackQueue CallbackQueue;
+
+/*___________________
+|
+| Functions
+|__________________*/
+
+// Creates an empty queue, returns 0 on any error
+CallbackQueue *Callback_Queue_Create (int capacity);
+
+// Frees a queue, dropping any callbacks still in it
+void Callback_Queue_Free (CallbackQueue *queue);
+
+// Adds a callback with a copy of its params, returns false if the queue is full (any thread)
+bool Callback_Queue_Add (
+  CallbackQueue *queue,
+  void         (*callback) (void *params),
+  void          *params,
+  unsigned       size_params );     // bytes to copy from params, may be 0
+
+// Removes the oldest callback and calls it outside the lock, returns false if the queue
+//   is empty
+bool Callback_Queue_Process (CallbackQueue *queue);
+
+// Drops every callback in the queue
+void Callback_Queue_Flush (CallbackQueue *queue);
+
+#endif
@@ -0,0 +1,209 @@
+/*____________________________________________________________________
+|
+| File: spsc_ring.cpp
+|
+| Description: A bounded ring buffer for one producer thread and one
+|   consumer thread that takes no lock.  The producer only writes the
+|   head index and the consumer only writes the tail index, each
+|   publishing its entries with a release store that the other side
+|   reads with an acquire load.
+|
+|   The head and tail are on separate cache lines, so the two threads
+|   don't invalidate each other's line on every push and pop.  Each side
+|   also keeps its own copy of the other side's index and only reloads
+|   it when the ring looks full (producer) or empty (consumer), so in
+|   the common case a push or pop touches no line written by the other
+|   thread except the entry itself.
+|
+|   The consumer owns every entry between the tail and the head it last
+|   loaded, so it can also drop selected entries in place: kept entries
+|   are moved toward the head and the tail is advanced past the gap.
+|
+|   Tools/spsc_bench.cpp builds this file on its own to stress test the
+|   ring on Linux, so it uses only the standard library.
+|
+| Functions: Spsc_Ring_Create
+|            Spsc_Ring_Free
+|            Spsc_Ring_Push
+|            Spsc_Ring_Pop
+|            Spsc_Ring_Remove_Selected
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+/*___________________
+|
+| Include Files
+|__________________*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+
+#include "spsc_ring.h"
+
+/*___________________
+|
+| Constants
+|__________________*/
+
+#define CACHE_LINE_SIZE 64
+
+/*___________________
+|
+| Type definitions
+|__________________*/
+
+// Indexes count up and wrap at 2^32, the slot is index & mask
+struct SpscRing {
+  unsigned char        *entries;        // read only after create
+  unsigned              mask;
+  unsigned              capacity;
+  int                   entry_size;
+  char                  pad0 [CACHE_LINE_SIZE];
+  // Producer's line
+  std::atomic<unsigned> head;           // next index pushed
+  unsigned              cached_tail;    // tail as last loaded by the producer
+  char                  pad1 [CACHE_LINE_SIZE];
+  // Consumer's line
+  std::atomic<unsigned> tail;           // next index popped
+  unsigned              cached_head;    // head as last loaded by the consumer
+  char                  pad2 [CACHE_LINE_SIZE];
+};
+
+/*____________________________________________________________________
+|
+| Function: Spsc_Ring_Create
+|
+| Input: Called from CMainFrame::CMainFrame()
+| Output: Returns an empty ring, or 0 on any error.
+|___________________________________________________________________*/
+
+SpscRing *Spsc_Ring_Create (int capacity, int entry_size)
+{
+  unsigned n;
+  SpscRing *ring;
+
+  if ((capacity < 1) || (capacity > (1 << 30)) || (entry_size < 1))
+    return (0);
+  for (n=1; n<(unsigned)capacity; n*=2);
+
+  ring = new SpscRing;
+  ring->entries = (unsigned char *) malloc (n * entry_size);
+  if (ring->entries == 0) {
+    delete ring;
+    return (0);
+  }
+  ring->mask        = n - 1;
+  ring->capacity    = n;
+  ring->entry_size  = entry_size;
+  ring->head.store (0, std::memory_order_relaxed);
+  ring->tail.store (0, std::memory_order_relaxed);
+  ring->cached_tail = 0;
+  ring->cached_head = 0;
+
+  return (ring);
+}
+
+/*____________________________________________________________________
+|
+| Function: Spsc_Ring_Free
+|
+| Input: Called from CMainFrame::~CMainFrame()
+| Output: Frees a ring.
+|___________________________________________________________________*/
+
+void Spsc_Ring_Free (SpscRing *ring)
+{
+  if (ring) {
+    free (ring->entries);
+    delete ring;
+  }
+}
+
+/*____________________________________________________________________
+|
+| Function: Spsc_Ring_Push
+|
+| Input: Called from CMainFrame::EventQueue_Add()
+| Output: Adds an entry.  Returns false if the ring is full.
+|___________________________________________________________________*/
+
+bool Spsc_Ring_Push (SpscRing *ring, const void *entry)
+{
+  unsigned head = ring->head.load (std::memory_order_relaxed);
+
+  if (head - ring->cached_tail == ring->capacity) {
+    ring->cached_tail = ring->tail.load (std::memory_order_acquire);
+    if (head - ring->cached_tail == ring->capacity)
+      return (false);
+  }
+
+  memcpy (ring->entries + (head & ring->mask) * ring->entry_size, entry, ring->entry_size);
+  ring->head.store (head + 1, std::memory_order_release);
+
+  return (true);
+}
+
+/*____________________________________________________________________
+|
+| Function: Spsc_Ring_Pop
+|
+| Input: Called from CMainFrame::EventQueue_Remove()
+| Output: Removes the oldest entry.  Returns false if the ring is
+|   empty.
+|___________________________________________________________________*/
+
+bool Spsc_Ring_Pop (SpscRing *ring, void *entry)
+{
+  unsigned tail = ring->tail.load (std::memory_order_relaxed);
+
+  if (tail == ring->cached_head) {
+    ring->cached_head = ring->head.load (std::memory_order_acquire);
+    if (tail == ring->cached_head)
+      return (false);
+  }
+
+  memcpy (entry, ring->entries + (tail & ring->mask) * ring->entry_size, ring->entry_size);
+  ring->tail.store (tail + 1, std::memory_order_release);
+
+  return (true);
+}
+
+/*____________________________________________________________________
+|
+| Function: Spsc_Ring_Remove_Selected
+|
+| Input: Called from CMainFrame::EventQueue_Flush()
+| Output: Removes the selected entries pushed so far.  Works from the
+|   newest entry back, moving each kept entry up past the removed ones,
+|   so the producer never sees a slot change that it could write to.
+|   Returns the number removed.
+|___________________________________________________________________*/
+
+int Spsc_Ring_Remove_Selected (SpscRing *ring, void *data, int (*selected) (void *entry, void *data))
+{
+  int removed = 0;
+  unsigned tail, src, dst;
+  unsigned char *entry;
+
+  tail = ring->tail.load (std::memory_order_relaxed);
+  ring->cached_head = ring->head.load (std::memory_order_acquire);
+
+  for (src=dst=ring->cached_head; src!=tail; ) {
+    src--;
+    entry = ring->entries + (src & ring->mask) * ring->entry_size;
+    if ((*selected) (entry, data))
+      removed++;
+    else {
+      dst--;
+      if (dst != src)
+        memcpy (ring->entries + (dst & ring->mask) * ring->entry_size, entry, ring->entry_size);
+    }
+  }
+  if (removed)
+    ring->tail.store (dst, std::memory_order_release);
+
+  return (removed);
+}
@@ -0,0 +1,46 @@
+/*____________________________________________________________________
+|
+| File: spsc_ring.h
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+#ifndef _SPSC_RING_H_
+#define _SPSC_RING_H_
+
+/*___________________
+|
+| Type definitions
+|__________________*/
+
+typedef struct SpscRing SpscRing;
+
+/*___________________
+|
+| Functions
+|__________________*/
+
+// Creates a ring of fixed size entries, returns 0 on any error
+SpscRing *Spsc_Ring_Create (
+  int capacity,                   // rounded up to a power of 2
+  int entry_size );               // bytes
+
+// Frees a ring (no thread may be using it)
+void Spsc_Ring_Free (SpscRing *ring);
+
+// Copies an entry in at the back, returns false if the ring is full (producer thread only)
+bool Spsc_Ring_Push (SpscRing *ring, const void *entry);
+
+// Copies the entry at the front out and removes it, returns false if the ring is empty
+//   (consumer thread only)
+bool Spsc_Ring_Pop (SpscRing *ring, void *entry);
+
+// Removes every entry for which selected() returns true, keeping the others in order,
+//   returns the number removed (consumer thread only)
+int Spsc_Ring_Remove_Selected (
+  SpscRing *ring,
+  void     *data,                 // passed to selected()
+  int     (*selected) (void *entry, void *data) );
+
+#endif
@@ -13,8 +13,10 @@
 |							win_EventQueue_Add
 |							win_EventQueue_Remove
 |							win_EventQueue_Flush
+|							win_EventQueue_Capture_Time
 |							win_CallbackQueue_Add
 |							win_CallbackQueue_Flush
+|							win_Get_Refresh_Rate
 |
 | (C) Copyright 2013 Abonvita Software LLC.
 | Licensed under the GX Toolkit License, Version 1.0.
@@ -191,6 +193,20 @@ void win_EventQueue_Flush (unsigned event_type_mask)
   The_window->EventQueue_Flush (event_type_mask);
 }
 
+/*___________________________________________________________________
+|
+|	Function: win_EventQueue_Capture_Time
+| 
+|	Input: Called from ____
+| Output: Returns the time the last event removed from the event queue
+|   was captured.
+|___________________________________________________________________*/
+
+long long win_EventQueue_Capture_Time (void)
+{
+  return (The_window->EventQueue_Capture_Time ());
+}
+
 /*___________________________________________________________________
 |
 |	Function: win_CallbackQueue_Add
@@ -216,3 +232,25 @@ void win_CallbackQueue_Flush (void)
 {
   The_window->CallbackQueue_Flush ();
 }
+
+/*___________________________________________________________________
+|
+|	Function: win_Get_Refresh_Rate
+| 
+|	Input: Called from ____
+| Output: Returns the refresh rate of the display in Hz, or 0 if it's
+|   unknown.
+|___________________________________________________________________*/
+
+int win_Get_Refresh_Rate (void)
+{
+  DEVMODE mode;
+
+  memset (&mode, 0, sizeof(mode));
+  mode.dmSize = sizeof(mode);
+  // 0 and 1 mean the display's default rate
+  if ((NOT EnumDisplaySettings (NULL, ENUM_CURRENT_SETTINGS, &mode)) OR (mode.dmDisplayFrequency <= 1))
+    return (0);
+
+  return ((int) mode.dmDisplayFrequency);
+}
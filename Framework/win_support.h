@@ -46,10 +46,17 @@ int win_EventQueue_Remove (EventQueueEntry *qentry);
 // Flushes the event queue
 void win_EventQueue_Flush (unsigned event_type_mask);
 
+// Returns the time the last event removed from the event queue was captured
+//   (see Latency_Now())
+long long win_EventQueue_Capture_Time (void);
+
 // Adds an entry to the callback queue
 void win_CallbackQueue_Add (void (*callback) (void *params), void *params, unsigned size_params);
 
 // Flushes the callback queue
 void win_CallbackQueue_Flush (void);
 
+// Returns the refresh rate of the display in Hz, or 0 if unknown
+int win_Get_Refresh_Rate (void);
+
 #endif
@@ -0,0 +1,477 @@
+/*____________________________________________________________________
+|
+| File: blend_bench.cpp
+|
+| Description: Command line tool that benchmarks blend graphs on motion
+|   files (.gxa, see lws_convert).  A crowd of characters each blends
+|   idle, step and run tracks by its own speed.  The crowd is evaluated
+|   one graph at a time on one thread, then queued as jobs on the job
+|   pool, and the two are checked against each other and against a
+|   plain merge done one bone at a time.
+|
+|   Then the crowd is spread out and animated with animation LOD (see
+|   anim_lod.cpp): the graphs sampled per frame, the time per frame and
+|   the error from sampling every frame are shown, for blending between
+|   LOD poses and for holding them.
+|
+|   Usage: blend_bench [-t threads] [-n characters] idle.gxa [step.gxa [run.gxa]]
+|     -t  worker threads (default 0 = one less than the processors)
+|     -n  characters (default 200)
+|   A missing step or run motion is the previous motion played faster.
+|
+|   Example: blend_bench "../Motions/tifa movement.gxa"
+|
+|   Build: g++ -O2 -pthread -I../Application -o blend_bench blend_bench.cpp
+|            ../Application/blend_graph.cpp ../Application/job_pool.cpp
+|            ../Application/anim_lod.cpp ../Application/motion_file.cpp ../Application/mesh_file.cpp
+|            ../Application/file_map.cpp
+|
+| Functions: main
+|             Bench_Lod
+|             Set_Tracks
+|             Wraps
+|             Reference_Difference
+|             Pose_Difference
+|             Pose_Error
+|             Time_Ms
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+/*___________________
+|
+| Include Files
+|__________________*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+
+#include "motion_file.h"
+#include "job_pool.h"
+#include "blend_graph.h"
+#include "anim_lod.h"
+
+/*___________________
+|
+| Constants
+|__________________*/
+
+#define NUM_TRIALS  100
+#define STEP_SPEED  1.5f
+#define RUN_SPEED   4.0f
+#define MAX_SPEED   5.0f
+
+#define FULL_DISTANCE  15.0f
+#define HALF_DISTANCE  35.0f
+#define MAX_DISTANCE   60.0f
+#define FRAME_TIME     (1 / 30.0f)    // one frame of the motion at the step rate
+
+/*___________________
+|
+| Type definitions
+|__________________*/
+
+typedef struct {
+  BlendGraph *graph;
+  float       speed;
+  float       phase;                 // frames ahead of the first character
+  float       distance;              // from the camera, for the LOD test
+  bool        visible;
+  AnimLod     lod;
+} Character;
+
+/*___________________
+|
+| Function Prototypes
+|__________________*/
+
+static void   Bench_Lod (std::vector<Character> &characters, const MotionFile *motions, int num_bones);
+static void   Set_Tracks (BlendGraph *graph, const Character &character, const MotionFile *motions, float trial);
+static bool   Wraps (const Character &character, const MotionFile *motions, int trial);
+static float  Reference_Difference (const Character &character, const MotionFile *motions, int trial, int num_bones);
+static float  Pose_Difference (const BlendPose *a, const BlendPose *b, int num_bones);
+static void   Pose_Error (const BlendPose *a, const BlendPose *b, int num_bones, float *position, float *angle);
+static double Time_Ms (std::chrono::high_resolution_clock::time_point start);
+
+// Playback rate of each track relative to its motion's frame rate
+static const float track_rates[3] = { 0, 1, 2 };
+
+/*____________________________________________________________________
+|
+| Function: main
+|
+| Input: Called from the command line
+| Output: Benchmarks the motion files on the command line.
+|___________________________________________________________________*/
+
+int main (int argc, char **argv)
+{
+  int i, t, num_threads = 0, num_characters = 200, num_files = 0, num_bones;
+  const char *filenames[3];
+  MotionFile motions[3];
+  std::vector<Character> characters;
+  std::vector<BlendPose> serial;
+  std::vector<float> copies;
+  float diff, ref_diff;
+  double ms_serial, ms_jobs;
+  std::chrono::high_resolution_clock::time_point start;
+
+  for (i=1; i<argc; i++) {
+    if ((strcmp (argv[i], "-t") == 0) && (i+1 < argc))
+      num_threads = atoi (argv[++i]);
+    else if ((strcmp (argv[i], "-n") == 0) && (i+1 < argc))
+      num_characters = atoi (argv[++i]);
+    else if (num_files < 3)
+      filenames[num_files++] = argv[i];
+  }
+  if ((num_files == 0) || (num_characters < 1)) {
+    fprintf (stderr, "usage: blend_bench [-t threads] [-n characters] idle.gxa [step.gxa [run.gxa]]\n");
+    return (1);
+  }
+  for (i=0; i<num_files; i++)
+    if (! MotionFile_Open (filenames[i], &motions[i])) {
+      fprintf (stderr, "%s: can't open motion file\n", filenames[i]);
+      return (1);
+    }
+  for (; i<3; i++)
+    motions[i] = motions[i-1];
+  num_bones = (int) motions[0].header->num_bones;
+
+  characters.resize (num_characters);
+  srand (1);
+  for (i=0; i<num_characters; i++) {
+    characters[i].graph = Blend_Graph_Create (num_bones);
+    characters[i].speed = (float) rand () / RAND_MAX * MAX_SPEED;
+    characters[i].phase = (float) rand () / RAND_MAX * motions[0].header->num_frames;
+    characters[i].distance = (float) rand () / RAND_MAX * MAX_DISTANCE;
+    characters[i].visible  = (rand () % 4 != 0);
+  }
+  if (! Blend_Graph_Set_Track (characters[0].graph, BLEND_TRACK_STEP, &motions[BLEND_TRACK_STEP], 0, 1) ||
+      ! Blend_Graph_Set_Track (characters[0].graph, BLEND_TRACK_RUN, &motions[BLEND_TRACK_RUN], 0, 1)) {
+    fprintf (stderr, "motions are for different skeletons\n");
+    return (1);
+  }
+  if (! Job_Pool_Init (num_threads))
+    fprintf (stderr, "can't start all the worker threads\n");
+  printf ("%d characters, %d bones, %d worker threads\n", num_characters, num_bones, Job_Pool_Num_Threads ());
+
+  // One graph at a time on this thread
+  start = std::chrono::high_resolution_clock::now ();
+  for (t=0; t<NUM_TRIALS; t++) {
+    for (i=0; i<num_characters; i++) {
+      Set_Tracks (characters[i].graph, characters[i], motions, (float) t);
+      Blend_Graph_Evaluate (characters[i].graph);
+    }
+  }
+  ms_serial = Time_Ms (start) / NUM_TRIALS;
+
+  // Keep the last trial's poses to check the jobs against
+  copies.resize ((size_t) num_characters * 10 * num_bones);
+  serial.resize (num_characters);
+  for (i=0; i<num_characters; i++) {
+    const BlendPose *pose = Blend_Graph_Get_Pose (characters[i].graph);
+    float *c = &copies[(size_t) i * 10 * num_bones];
+    const float *streams[10] = { pose->px, pose->py, pose->pz, pose->qx, pose->qy, pose->qz, pose->qw, pose->sx, pose->sy, pose->sz };
+    float **out[10] = { &serial[i].px, &serial[i].py, &serial[i].pz, &serial[i].qx, &serial[i].qy, &serial[i].qz, &serial[i].qw,
+                        &serial[i].sx, &serial[i].sy, &serial[i].sz };
+    for (t=0; t<10; t++) {
+      memcpy (c + t * num_bones, streams[t], num_bones * sizeof(float));
+      *out[t] = c + t * num_bones;
+    }
+  }
+
+  // Every graph queued as jobs
+  start = std::chrono::high_resolution_clock::now ();
+  for (t=0; t<NUM_TRIALS; t++) {
+    for (i=0; i<num_characters; i++) {
+      Set_Tracks (characters[i].graph, characters[i], motions, (float) t);
+      Blend_Graph_Queue (characters[i].graph);
+    }
+    Job_Run ();
+  }
+  ms_jobs = Time_Ms (start) / NUM_TRIALS;
+
+  diff = ref_diff = 0;
+  for (i=0; i<num_characters; i++) {
+    diff     = fmaxf (diff, Pose_Difference (&serial[i], Blend_Graph_Get_Pose (characters[i].graph), num_bones));
+    ref_diff = fmaxf (ref_diff, Reference_Difference (characters[i], motions, NUM_TRIALS-1, num_bones));
+  }
+
+  printf ("  %-8s %8.4f ms  %7.1f characters/ms\n", "serial", ms_serial, num_characters / ms_serial);
+  printf ("  %-8s %8.4f ms  %7.1f characters/ms  max difference from serial %g\n", "jobs", ms_jobs, num_characters / ms_jobs, diff);
+  printf ("  max difference from per bone merge %g\n", ref_diff);
+
+  Bench_Lod (characters, motions, num_bones);
+
+  Job_Pool_Free ();
+  for (i=0; i<num_characters; i++)
+    Blend_Graph_Free (characters[i].graph);
+  for (i=0; i<num_files; i++)
+    MotionFile_Close (&motions[i]);
+  return (0);
+}
+
+/*____________________________________________________________________
+|
+| Function: Bench_Lod
+|
+| Input: Called from main()
+| Output: Animates the crowd with animation LOD for NUM_TRIALS frames,
+|   checking each visible character against its pose sampled that
+|   frame.
+|___________________________________________________________________*/
+
+static void Bench_Lod (std::vector<Character> &characters, const MotionFile *motions, int num_bones)
+{
+  int i, f, n, r, num_checked, min_samples, max_samples, total_samples;
+  float time, position, angle, blend[2], hold[2];
+  double ms;
+  AnimLodScheduler sched;
+  BlendGraph *check;
+  std::vector<BlendPose> prev (characters.size ()), out (characters.size ());
+  std::chrono::high_resolution_clock::time_point start;
+
+  check = Blend_Graph_Create (num_bones);
+  Anim_Lod_Init (&sched, FULL_DISTANCE, HALF_DISTANCE);
+  for (i=0; i<(int) characters.size (); i++) {
+    Blend_Pose_Create (&prev[i], num_bones);
+    Blend_Pose_Create (&out[i], num_bones);
+    Anim_Lod_Add (&sched, &characters[i].lod);
+    Anim_Lod_Set_View (&sched, &characters[i].lod, characters[i].distance, characters[i].visible);
+  }
+
+  ms = 0;
+  blend[0] = blend[1] = hold[0] = hold[1] = 0;
+  num_checked = total_samples = max_samples = 0;
+  min_samples = (int) characters.size () * 2;
+  for (f=0; f<NUM_TRIALS; f++) {
+    time = f * FRAME_TIME;
+    start = std::chrono::high_resolution_clock::now ();
+    Anim_Lod_Begin_Frame (&sched);
+    for (i=n=0; i<(int) characters.size (); i++) {
+      Character &c = characters[i];
+      r = Anim_Lod_Update (&sched, &c.lod, time, FRAME_TIME);
+      if (r == ANIM_LOD_HOLD)
+        continue;
+      if ((r == ANIM_LOD_RESTART) && (c.lod.next_time > c.lod.prev_time)) {
+        Set_Tracks (c.graph, c, motions, c.lod.prev_time / FRAME_TIME);
+        Blend_Graph_Evaluate (c.graph);
+        n++;
+      }
+      Blend_Pose_Copy (&prev[i], Blend_Graph_Get_Pose (c.graph), num_bones);
+      Set_Tracks (c.graph, c, motions, c.lod.next_time / FRAME_TIME);
+      Blend_Graph_Queue (c.graph);
+      n++;
+    }
+    Job_Run ();
+    for (i=0; i<(int) characters.size (); i++)
+      if (characters[i].visible)
+        Blend_Pose_Lerp (&out[i], &prev[i], Blend_Graph_Get_Pose (characters[i].graph), Anim_Lod_Blend (&characters[i].lod, time), num_bones);
+    ms += Time_Ms (start);
+
+    // Every character restarts on the first frame
+    if (f > 0) {
+      if (n < min_samples)
+        min_samples = n;
+      if (n > max_samples)
+        max_samples = n;
+      total_samples += n;
+    }
+
+    // Check against sampling every frame, except where the blend may cross the end of the motion
+    for (i=0; i<(int) characters.size (); i++)
+      if (characters[i].visible && (! Wraps (characters[i], motions, f))) {
+        Set_Tracks (check, characters[i], motions, (float) f);
+        Blend_Graph_Evaluate (check);
+        Pose_Error (&out[i], Blend_Graph_Get_Pose (check), num_bones, &position, &angle);
+        blend[0] = fmaxf (blend[0], position);
+        blend[1] = fmaxf (blend[1], angle);
+        Pose_Error (&prev[i], Blend_Graph_Get_Pose (check), num_bones, &position, &angle);
+        hold[0] = fmaxf (hold[0], position);
+        hold[1] = fmaxf (hold[1], angle);
+        num_checked++;
+      }
+  }
+
+  printf ("LOD (every frame within %g, every 2nd within %g, else every 4th, 1/4 not visible):\n", FULL_DISTANCE, HALF_DISTANCE);
+  printf ("  %8.4f ms per frame  %d to %d graphs sampled per frame after the first (average %.1f of %d)\n",
+          ms / NUM_TRIALS, min_samples, max_samples, (double) total_samples / (NUM_TRIALS - 1), (int) characters.size ());
+  if (num_checked) {
+    printf ("  max difference from sampling every frame:\n");
+    printf ("    blend  position %g, rotation %g degrees\n", blend[0], blend[1]);
+    printf ("    hold   position %g, rotation %g degrees\n", hold[0], hold[1]);
+  }
+
+  for (i=0; i<(int) characters.size (); i++) {
+    Anim_Lod_Remove (&sched, &characters[i].lod);
+    Blend_Pose_Free (&prev[i]);
+    Blend_Pose_Free (&out[i]);
+  }
+  Blend_Graph_Free (check);
+}
+
+/*____________________________________________________________________
+|
+| Function: Set_Tracks
+|
+| Input: Called from main(), Bench_Lod()
+| Output: Sets a graph's tracks for a character at a trial (one trial
+|   is one frame of the motion at the step rate).
+|___________________________________________________________________*/
+
+static void Set_Tracks (BlendGraph *graph, const Character &character, const MotionFile *motions, float trial)
+{
+  int k;
+  float weights[3], frame;
+
+  Blend_Locomotion_Weights (character.speed, STEP_SPEED, RUN_SPEED, weights);
+  for (k=0; k<3; k++) {
+    frame = fmodf (character.phase + trial * track_rates[k], (float)(motions[k].header->num_frames - 1));
+    Blend_Graph_Set_Track (graph, k, &motions[k], frame, weights[k]);
+  }
+}
+
+/*____________________________________________________________________
+|
+| Function: Wraps
+|
+| Input: Called from Bench_Lod()
+| Output: Returns true if any of a character's tracks in use loops
+|   within ANIM_LOD_MAX_RATE trials of this one.
+|___________________________________________________________________*/
+
+static bool Wraps (const Character &character, const MotionFile *motions, int trial)
+{
+  int k;
+  float weights[3], n;
+
+  Blend_Locomotion_Weights (character.speed, STEP_SPEED, RUN_SPEED, weights);
+  for (k=0; k<3; k++) {
+    if (weights[k] <= 0)
+      continue;
+    n = (float)(motions[k].header->num_frames - 1);
+    if (floorf ((character.phase + (trial - ANIM_LOD_MAX_RATE) * track_rates[k]) / n) !=
+        floorf ((character.phase + (trial + ANIM_LOD_MAX_RATE) * track_rates[k]) / n))
+      return (true);
+  }
+
+  return (false);
+}
+
+/*____________________________________________________________________
+|
+| Function: Reference_Difference
+|
+| Input: Called from main()
+| Output: Blends a character's tracks for a trial one bone at a time
+|   and returns the largest difference from its graph's pose.
+|___________________________________________________________________*/
+
+static float Reference_Difference (const Character &character, const MotionFile *motions, int trial, int num_bones)
+{
+  int b, j, k;
+  float weights[3], total, frame, p[3], q[4], s[3], ref[4], dot, len, w;
+  float pos[3], rot[4], scl[3], diff = 0;
+  bool first;
+  const BlendPose *pose = Blend_Graph_Get_Pose (character.graph);
+
+  Blend_Locomotion_Weights (character.speed, STEP_SPEED, RUN_SPEED, weights);
+  total = weights[0] + weights[1] + weights[2];
+  for (b=0; b<num_bones; b++) {
+    memset (pos, 0, sizeof(pos));
+    memset (rot, 0, sizeof(rot));
+    memset (scl, 0, sizeof(scl));
+    first = true;
+    for (k=0; k<3; k++) {
+      if (weights[k] <= 0)
+        continue;
+      frame = fmodf (character.phase + trial * track_rates[k], (float)(motions[k].header->num_frames - 1));
+      MotionFile_Sample (&motions[k], b, frame, p, q, s);
+      if (first) {
+        memcpy (ref, q, sizeof(ref));
+        first = false;
+      }
+      w = weights[k] / total;
+      dot = q[0]*ref[0] + q[1]*ref[1] + q[2]*ref[2] + q[3]*ref[3];
+      for (j=0; j<3; j++) {
+        pos[j] += w * p[j];
+        scl[j] += w * s[j];
+      }
+      for (j=0; j<4; j++)
+        rot[j] += ((dot < 0) ? -w : w) * q[j];
+    }
+    len = sqrtf (rot[0]*rot[0] + rot[1]*rot[1] + rot[2]*rot[2] + rot[3]*rot[3]);
+    const float expect[10] = { pos[0], pos[1], pos[2], rot[0]/len, rot[1]/len, rot[2]/len, rot[3]/len, scl[0], scl[1], scl[2] };
+    const float actual[10] = { pose->px[b], pose->py[b], pose->pz[b], pose->qx[b], pose->qy[b], pose->qz[b], pose->qw[b],
+                               pose->sx[b], pose->sy[b], pose->sz[b] };
+    for (j=0; j<10; j++)
+      diff = fmaxf (diff, fabsf (expect[j] - actual[j]));
+  }
+
+  return (diff);
+}
+
+/*____________________________________________________________________
+|
+| Function: Pose_Difference
+|
+| Input: Called from main()
+| Output: Returns the largest difference between two poses.
+|___________________________________________________________________*/
+
+static float Pose_Difference (const BlendPose *a, const BlendPose *b, int num_bones)
+{
+  int i, j;
+  float diff = 0;
+  const float *sa[10] = { a->px, a->py, a->pz, a->qx, a->qy, a->qz, a->qw, a->sx, a->sy, a->sz };
+  const float *sb[10] = { b->px, b->py, b->pz, b->qx, b->qy, b->qz, b->qw, b->sx, b->sy, b->sz };
+
+  for (j=0; j<10; j++)
+    for (i=0; i<num_bones; i++)
+      diff = fmaxf (diff, fabsf (sa[j][i] - sb[j][i]));
+
+  return (diff);
+}
+
+/*____________________________________________________________________
+|
+| Function: Pose_Error
+|
+| Input: Called from Bench_Lod()
+| Output: Gets the largest distance between two poses' bone positions
+|   and the largest angle (degrees) between their rotations.
+|___________________________________________________________________*/
+
+static void Pose_Error (const BlendPose *a, const BlendPose *b, int num_bones, float *position, float *angle)
+{
+  int i;
+  float dx, dy, dz, dot;
+
+  *position = *angle = 0;
+  for (i=0; i<num_bones; i++) {
+    dx = a->px[i] - b->px[i];
+    dy = a->py[i] - b->py[i];
+    dz = a->pz[i] - b->pz[i];
+    *position = fmaxf (*position, sqrtf (dx*dx + dy*dy + dz*dz));
+    dot = fabsf (a->qx[i]*b->qx[i] + a->qy[i]*b->qy[i] + a->qz[i]*b->qz[i] + a->qw[i]*b->qw[i]);
+    *angle = fmaxf (*angle, 2 * acosf (fminf (dot, 1)) * 180 / 3.14159265f);
+  }
+}
+
+/*____________________________________________________________________
+|
+| Function: Time_Ms
+|
+| Input: Called from main()
+| Output: Returns milliseconds elapsed since start.
+|___________________________________________________________________*/
+
+static double Time_Ms (std::chrono::high_resolution_clock::time_point start)
+{
+  return (std::chrono::duration<double, std::milli> (std::chrono::high_resolution_clock::now () - start).count ());
+}
@@ -0,0 +1,327 @@
+/*____________________________________________________________________
+|
+| File: camera_bench.cpp
+|
+| Description: Command line tool that benchmarks the camera core
+|   (camera.cpp) against the way Position_Update() used to turn the
+|   camera: rotate x and y matrices multiplied together, the start
+|   heading multiplied by them and normalized, the right vector from a
+|   cross product and normalize for each sideways move, and a look-at
+|   view matrix built from a 'to' point.  The gx3d math is done here the
+|   way D3DX does it.  Both are run on the same random mouse movements
+|   and moves and their headings and view matrices compared.
+|
+|   Usage: camera_bench [-n updates]
+|     -n  updates per trial (default 100000)
+|
+|   Build: g++ -O2 -I../Application -o camera_bench camera_bench.cpp
+|            ../Application/camera.cpp
+|
+| Functions: main
+|             Old_Init
+|             Old_Update
+|             Look_At
+|             Normalize
+|             Time_Ms
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+/*___________________
+|
+| Include Files
+|__________________*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+
+#include "camera.h"
+
+/*___________________
+|
+| Constants
+|__________________*/
+
+#define NUM_TRIALS  5
+#define CAMERA_DISTANCE 10
+#define DEGREES_TO_RADIANS (3.14159265f / 180)
+
+/*___________________
+|
+| Type definitions
+|__________________*/
+
+typedef struct {
+  int  dx, dy;
+  bool forward, right;
+} Input;
+
+// The camera state Position_Update() used to keep
+typedef struct {
+  float position[3];
+  float start_heading[3];
+  float heading[3];
+  float xrotate, yrotate;
+  float view[4][4];
+} OldCamera;
+
+/*___________________
+|
+| Function Prototypes
+|__________________*/
+
+static void   Old_Init (OldCamera *camera, const float position[3], const float heading[3]);
+static void   Old_Update (OldCamera *camera, const Input *input, float move_amount);
+static void   Look_At (const float eye[3], const float to[3], const float world_up[3], float m[4][4]);
+static void   Normalize (float v[3]);
+static double Time_Ms (std::chrono::high_resolution_clock::time_point start);
+
+/*____________________________________________________________________
+|
+| Function: main
+|
+| Input: Called from the command line
+| Output: Times and compares the old and new camera updates.
+|___________________________________________________________________*/
+
+int main (int argc, char **argv)
+{
+  int i, j, k, t, num_updates = 100000;
+  float diff_heading, diff_view, move_amount = 0.12f;
+  float position[3] = { 0, 15, -130 }, heading[3] = { 0, 0, 1 };
+  double ms_old, ms_new, best_old = 0, best_new = 0;
+  std::vector<Input> inputs;
+  OldCamera old_camera;
+  Camera camera;
+  std::chrono::high_resolution_clock::time_point start;
+
+  for (i=1; i<argc; i++)
+    if ((strcmp (argv[i], "-n") == 0) && (i+1 < argc))
+      num_updates = atoi (argv[++i]);
+  if (num_updates < 1) {
+    fprintf (stderr, "usage: camera_bench [-n updates]\n");
+    return (1);
+  }
+
+  // Mouse movements of a few pixels, most frames turning and half moving
+  srand (1);
+  inputs.resize (num_updates);
+  for (i=0; i<num_updates; i++) {
+    inputs[i].dx      = (rand () % 4 == 0) ? 0 : (rand () % 41) - 20;
+    inputs[i].dy      = (rand () % 4 == 0) ? 0 : (rand () % 21) - 10;
+    inputs[i].forward = (rand () % 2 == 0);
+    inputs[i].right   = (rand () % 4 == 0);
+  }
+
+  for (t=0; t<NUM_TRIALS; t++) {
+    Old_Init (&old_camera, position, heading);
+    start = std::chrono::high_resolution_clock::now ();
+    for (i=0; i<num_updates; i++)
+      Old_Update (&old_camera, &inputs[i], move_amount);
+    ms_old = Time_Ms (start);
+
+    Camera_Init (&camera, position, heading);
+    start = std::chrono::high_resolution_clock::now ();
+    for (i=0; i<num_updates; i++) {
+      Camera_Rotate (&camera, Camera_Smooth_Delta (-inputs[i].dy) * 0.5f, Camera_Smooth_Delta (inputs[i].dx) * 0.5f);
+      Camera_Move (&camera, inputs[i].forward ? move_amount : 0, inputs[i].right ? move_amount : 0);
+      Camera_Update (&camera);
+    }
+    ms_new = Time_Ms (start);
+
+    if ((t == 0) || (ms_old < best_old))
+      best_old = ms_old;
+    if ((t == 0) || (ms_new < best_new))
+      best_new = ms_new;
+  }
+
+  diff_heading = diff_view = 0;
+  for (j=0; j<3; j++)
+    diff_heading = fmaxf (diff_heading, fabsf (old_camera.heading[j] - camera.heading[j]));
+  for (j=0; j<4; j++)
+    for (k=0; k<4; k++)
+      diff_view = fmaxf (diff_view, fabsf (old_camera.view[j][k] - camera.view[j][k]));
+
+  printf ("%d updates (best of %d):\n", num_updates, NUM_TRIALS);
+  printf ("  %-8s %8.3f ms  %6.1f ns per update\n", "old", best_old, best_old * 1e6 / num_updates);
+  printf ("  %-8s %8.3f ms  %6.1f ns per update\n", "camera", best_new, best_new * 1e6 / num_updates);
+  printf ("  after the last update: max difference heading %g, view matrix %g\n", diff_heading, diff_view);
+  printf ("  position %.3f %.3f %.3f vs %.3f %.3f %.3f\n",
+          old_camera.position[0], old_camera.position[1], old_camera.position[2],
+          camera.position[0], camera.position[1], camera.position[2]);
+
+  return (0);
+}
+
+/*____________________________________________________________________
+|
+| Function: Old_Init
+|
+| Input: Called from main()
+| Output: Sets up the old camera like Position_Init() did.
+|___________________________________________________________________*/
+
+static void Old_Init (OldCamera *camera, const float position[3], const float heading[3])
+{
+  Input input = { 0, 0, false, false };
+
+  memcpy (camera->position, position, sizeof(camera->position));
+  memcpy (camera->heading, heading, sizeof(camera->heading));
+  Normalize (camera->heading);
+  memcpy (camera->start_heading, camera->heading, sizeof(camera->heading));
+  camera->xrotate = 0;
+  camera->yrotate = 0;
+  Old_Update (camera, &input, 0);
+}
+
+/*____________________________________________________________________
+|
+| Function: Old_Update
+|
+| Input: Called from main(), Old_Init()
+| Output: Updates the old camera like Position_Update() did.
+|___________________________________________________________________*/
+
+static void Old_Update (OldCamera *camera, const Input *input, float move_amount)
+{
+  int i, j, n, xrotate, yrotate;
+  float a, s, c, mx[4][4], my[4][4], mxy[4][4], v[3], right[3], to[3];
+  const float world_up[3] = { 0, 1, 0 };
+
+  n = -input->dy;
+  xrotate = (int) sqrt ((double)(abs (n)));
+  if (n < 0)
+    xrotate = -xrotate;
+  n = input->dx;
+  yrotate = (int) sqrt ((double)(abs (n)));
+  if (n < 0)
+    yrotate = -yrotate;
+
+  camera->xrotate += (float)xrotate * 0.5f;
+  if (camera->xrotate < -89)
+    camera->xrotate = -89;
+  else if (camera->xrotate > 89)
+    camera->xrotate = 89;
+  camera->yrotate += (float)yrotate * 0.5f;
+  while (camera->yrotate < -360)
+    camera->yrotate += 360;
+  while (camera->yrotate > 360)
+    camera->yrotate -= 360;
+
+  if ((xrotate != 0) || (yrotate != 0)) {
+    // gx3d_GetRotateXMatrix(), gx3d_GetRotateYMatrix(), gx3d_MultiplyMatrix()
+    memset (mx, 0, sizeof(mx));
+    memset (my, 0, sizeof(my));
+    a = camera->xrotate * DEGREES_TO_RADIANS;
+    s = sinf (a);
+    c = cosf (a);
+    mx[0][0] = 1;  mx[1][1] = c;  mx[1][2] = s;  mx[2][1] = -s;  mx[2][2] = c;  mx[3][3] = 1;
+    a = camera->yrotate * DEGREES_TO_RADIANS;
+    s = sinf (a);
+    c = cosf (a);
+    my[0][0] = c;  my[0][2] = -s;  my[1][1] = 1;  my[2][0] = s;  my[2][2] = c;  my[3][3] = 1;
+    for (i=0; i<4; i++)
+      for (j=0; j<4; j++)
+        mxy[i][j] = mx[i][0]*my[0][j] + mx[i][1]*my[1][j] + mx[i][2]*my[2][j] + mx[i][3]*my[3][j];
+    // gx3d_MultiplyVectorMatrix(), gx3d_NormalizeVector()
+    for (j=0; j<3; j++)
+      camera->heading[j] = camera->start_heading[0]*mxy[0][j] + camera->start_heading[1]*mxy[1][j] +
+                           camera->start_heading[2]*mxy[2][j] + mxy[3][j];
+    Normalize (camera->heading);
+  }
+
+  if (input->forward)
+    for (j=0; j<3; j++)
+      camera->position[j] += move_amount * camera->heading[j];
+  if (input->right) {
+    // gx3d_VectorCrossProduct(), gx3d_NormalizeVector()
+    right[0] = world_up[1]*camera->heading[2] - world_up[2]*camera->heading[1];
+    right[1] = world_up[2]*camera->heading[0] - world_up[0]*camera->heading[2];
+    right[2] = world_up[0]*camera->heading[1] - world_up[1]*camera->heading[0];
+    Normalize (right);
+    for (j=0; j<3; j++)
+      camera->position[j] += move_amount * right[j];
+  }
+
+  if ((xrotate != 0) || (yrotate != 0) || input->forward || input->right) {
+    for (j=0; j<3; j++) {
+      v[j]  = CAMERA_DISTANCE * camera->heading[j];
+      to[j] = camera->position[j] + v[j];
+    }
+    Look_At (camera->position, to, world_up, camera->view);
+  }
+}
+
+/*____________________________________________________________________
+|
+| Function: Look_At
+|
+| Input: Called from Old_Update()
+| Output: Computes a left handed look-at view matrix like
+|   gx3d_ComputeViewMatrix().
+|___________________________________________________________________*/
+
+static void Look_At (const float eye[3], const float to[3], const float world_up[3], float m[4][4])
+{
+  int j;
+  float x[3], y[3], z[3];
+
+  for (j=0; j<3; j++)
+    z[j] = to[j] - eye[j];
+  Normalize (z);
+  x[0] = world_up[1]*z[2] - world_up[2]*z[1];
+  x[1] = world_up[2]*z[0] - world_up[0]*z[2];
+  x[2] = world_up[0]*z[1] - world_up[1]*z[0];
+  Normalize (x);
+  y[0] = z[1]*x[2] - z[2]*x[1];
+  y[1] = z[2]*x[0] - z[0]*x[2];
+  y[2] = z[0]*x[1] - z[1]*x[0];
+
+  for (j=0; j<3; j++) {
+    m[j][0] = x[j];
+    m[j][1] = y[j];
+    m[j][2] = z[j];
+    m[j][3] = 0;
+  }
+  m[3][0] = -(x[0]*eye[0] + x[1]*eye[1] + x[2]*eye[2]);
+  m[3][1] = -(y[0]*eye[0] + y[1]*eye[1] + y[2]*eye[2]);
+  m[3][2] = -(z[0]*eye[0] + z[1]*eye[1] + z[2]*eye[2]);
+  m[3][3] = 1;
+}
+
+/*____________________________________________________________________
+|
+| Function: Normalize
+|
+| Input: Called from Old_Init(), Old_Update(), Look_At()
+| Output: Normalizes a vector.
+|___________________________________________________________________*/
+
+static void Normalize (float v[3])
+{
+  float len = sqrtf (v[0]*v[0] + v[1]*v[1] + v[2]*v[2]);
+
+  if (len > 0) {
+    v[0] /= len;
+    v[1] /= len;
+    v[2] /= len;
+  }
+}
+
+/*____________________________________________________________________
+|
+| Function: Time_Ms
+|
+| Input: Called from main()
+| Output: Returns milliseconds elapsed since start.
+|___________________________________________________________________*/
+
+static double Time_Ms (std::chrono::high_resolution_clock::time_point start)
+{
+  return (std::chrono::duration<double, std::milli> (std::chrono::high_resolution_clock::now () - start).count ());
+}
@@ -0,0 +1,463 @@
+/*____________________________________________________________________
+|
+| File: job_bench.cpp
+|
+| Description: Command line tool that checks the work stealing job
+|   pool (Application/job_pool.cpp) and measures how it scales with the
+|   number of worker threads.
+|
+|   The checks run with the most threads: many small jobs spawned on
+|   one counter must each run exactly once, a recursive sum whose jobs
+|   spawn and wait for their own children must add up, and a graph of
+|   jobs must run each job after the ones it depends on.
+|
+|   The benchmarks time the same work with 0 worker threads (the
+|   calling thread does everything) up to the most threads:
+|     flat       many equal jobs spawned from the calling thread, like a
+|                frame splitting culling or particles into chunks
+|     recursive  a range split in half by each job until it's small, so
+|                most jobs are spawned (and stolen) from worker threads
+|     graph      fan out and fan in through Job_Add()/Job_Run(), like
+|                blend graphs
+|
+|   Usage: job_bench [-t threads] [-n jobs]
+|     -t  most worker threads (default one less than the processors)
+|     -n  jobs per benchmark (default 4096)
+|
+|   Build: g++ -O2 -pthread -I../Application -o job_bench job_bench.cpp
+|            ../Application/job_pool.cpp
+|
+| Functions: main
+|             Check
+|             Bench
+|             Run_Flat
+|             Flat_Job
+|             Run_Recursive
+|             Run_Graph
+|             Work
+|             Count_Job
+|             Sum_Job
+|             Order_Job
+|             Time_Ms
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+/*___________________
+|
+| Include Files
+|__________________*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "job_pool.h"
+
+/*___________________
+|
+| Constants
+|__________________*/
+
+#define NUM_TRIALS      5
+#define WORK_ITERATIONS 2000    // per job, a few microseconds
+#define RECURSE_LEAF    4       // jobs a recursive job runs itself instead of splitting
+#define GRAPH_FAN       8       // jobs between each fan out and fan in
+#define CHECK_JOBS      100000
+
+/*___________________
+|
+| Type definitions
+|__________________*/
+
+// A range of jobs for the recursive benchmark and check
+typedef struct {
+  int     first, num;
+  double *results;
+  double  sum;
+} Range;
+
+// A graph job that checks its dependencies ran first
+typedef struct {
+  int               id;
+  int               depends [GRAPH_FAN];
+  int               num_depends;
+  std::atomic<int> *done;
+  std::atomic<int> *errors;
+} OrderJob;
+
+/*___________________
+|
+| Function Prototypes
+|__________________*/
+
+static bool   Check (int num_jobs);
+static double Bench (int num_threads, int num_jobs, int which);
+static void   Run_Flat (int num_jobs, double *results);
+static void   Flat_Job (void *data);
+static void   Run_Recursive (int num_jobs, double *results);
+static void   Run_Graph (int num_jobs, double *results);
+static double Work (int seed);
+static void   Count_Job (void *data);
+static void   Sum_Job (void *data);
+static void   Order_Job (void *data);
+static double Time_Ms (std::chrono::high_resolution_clock::time_point start);
+
+/*___________________
+|
+| Global variables
+|__________________*/
+
+static const char *Bench_Names [] = { "flat", "recursive", "graph" };
+
+/*____________________________________________________________________
+|
+| Function: main
+|
+| Input: Called from the command line
+| Output: Runs the checks, then the benchmarks.  Returns 1 if a check
+|   fails.
+|___________________________________________________________________*/
+
+int main (int argc, char **argv)
+{
+  int i, b, t, num_jobs = 4096, max_threads = -1, num_counts, counts[16];
+  double ms, base;
+
+  for (i=1; i<argc; i++) {
+    if ((strcmp (argv[i], "-t") == 0) && (i+1 < argc))
+      max_threads = atoi (argv[++i]);
+    else if ((strcmp (argv[i], "-n") == 0) && (i+1 < argc))
+      num_jobs = atoi (argv[++i]);
+  }
+  if (max_threads < 0)
+    max_threads = (int) std::thread::hardware_concurrency () - 1;
+  if (max_threads < 0)
+    max_threads = 0;
+  if (num_jobs < 1) {
+    fprintf (stderr, "usage: job_bench [-t threads] [-n jobs]\n");
+    return (1);
+  }
+
+  if (! Job_Pool_Init (max_threads > 0 ? max_threads : -1))
+    return (1);
+  printf ("checks with %d worker threads\n", Job_Pool_Num_Threads ());
+  if (! Check (num_jobs)) {
+    Job_Pool_Free ();
+    return (1);
+  }
+  Job_Pool_Free ();
+
+  printf ("%d jobs of %d iterations (best of %d), %u processors:\n", num_jobs, WORK_ITERATIONS, NUM_TRIALS, std::thread::hardware_concurrency ());
+  // 0, 1, 2, 4 ... worker threads, and the most
+  counts[0] = 0;
+  for (num_counts=1, t=1; t<max_threads; t*=2)
+    counts[num_counts++] = t;
+  if (max_threads > 0)
+    counts[num_counts++] = max_threads;
+  for (b=0; b<3; b++) {
+    base = 0;
+    for (i=0; i<num_counts; i++) {
+      ms = Bench (counts[i], num_jobs, b);
+      if (i == 0)
+        base = ms;
+      printf ("  %-10s %2d threads %9.3f ms  %5.2fx\n", Bench_Names[b], counts[i], ms, base / ms);
+    }
+  }
+
+  return (0);
+}
+
+/*____________________________________________________________________
+|
+| Function: Check
+|
+| Input: Called from main()
+| Output: Returns true if every check passes.
+|___________________________________________________________________*/
+
+static bool Check (int num_jobs)
+{
+  int i, j, d, n, wrong;
+  bool ok = true;
+  double expected;
+  std::vector<std::atomic<int> > counts (CHECK_JOBS);
+  std::vector<double> results (num_jobs);
+  std::vector<OrderJob> order (num_jobs);
+  std::vector<std::atomic<int> > finished (num_jobs);
+  std::atomic<int> errors (0);
+  JobCounter counter = {};
+  Range range;
+
+  // Every job spawned runs once
+  for (i=0; i<CHECK_JOBS; i++)
+    counts[i] = 0;
+  for (i=0; i<CHECK_JOBS; i++)
+    Job_Spawn (Count_Job, &counts[i], &counter);
+  Job_Wait (&counter);
+  for (i=0, wrong=0; i<CHECK_JOBS; i++)
+    if (counts[i] != 1)
+      wrong++;
+  printf ("  spawn:     %s (%d of %d jobs didn't run once)\n", wrong ? "FAILED" : "passed", wrong, CHECK_JOBS);
+  ok = ok && (wrong == 0) && (counter.pending == 0);
+
+  // Jobs that spawn and wait for their own children
+  for (i=0, expected=0; i<num_jobs; i++)
+    expected += Work (i);
+  range.first   = 0;
+  range.num     = num_jobs;
+  range.results = &results[0];
+  Sum_Job (&range);
+  wrong = (range.sum != expected);
+  printf ("  recursive: %s (sum %.6f, expected %.6f)\n", wrong ? "FAILED" : "passed", range.sum, expected);
+  ok = ok && (! wrong);
+
+  // Each job of a graph depends on some of the jobs added just before it
+  for (i=0; i<num_jobs; i++) {
+    order[i].id          = i;
+    order[i].num_depends = 0;
+    order[i].done        = &finished[0];
+    order[i].errors      = &errors;
+    finished[i]          = 0;
+  }
+  // Job ids start at 0 in each graph, and a graph holds at most 1024 jobs
+  for (i=0; i<num_jobs; i+=n) {
+    n = (num_jobs - i < 1000) ? num_jobs - i : 1000;
+    for (j=0; j<n; j++)
+      Job_Add (Order_Job, &order[i+j]);
+    for (j=0; j<n; j++)
+      for (d=1; (d<=GRAPH_FAN) && (j-d >= 0); d+=3) {
+        Job_Add_Depend (j, j-d);
+        order[i+j].depends[order[i+j].num_depends++] = i + j-d;
+      }
+    Job_Run ();
+  }
+  for (i=0, wrong=0; i<num_jobs; i++)
+    if (finished[i] != 1)
+      wrong++;
+  printf ("  graph:     %s (%d jobs ran before a dependency, %d didn't run once)\n", (errors || wrong) ? "FAILED" : "passed", (int) errors, wrong);
+  ok = ok && (errors == 0) && (wrong == 0);
+
+  return (ok);
+}
+
+/*____________________________________________________________________
+|
+| Function: Bench
+|
+| Input: Called from main()
+| Output: Returns the best milliseconds of the trials of a benchmark.
+|___________________________________________________________________*/
+
+static double Bench (int num_threads, int num_jobs, int which)
+{
+  int t;
+  double ms, best = 0;
+  std::vector<double> results (num_jobs);
+  std::chrono::high_resolution_clock::time_point start;
+
+  Job_Pool_Init (num_threads > 0 ? num_threads : -1);
+  for (t=0; t<NUM_TRIALS; t++) {
+    start = std::chrono::high_resolution_clock::now ();
+    switch (which) {
+      case 0: Run_Flat (num_jobs, &results[0]);
+              break;
+      case 1: Run_Recursive (num_jobs, &results[0]);
+              break;
+      case 2: Run_Graph (num_jobs, &results[0]);
+              break;
+    }
+    ms = Time_Ms (start);
+    if ((t == 0) || (ms < best))
+      best = ms;
+  }
+  Job_Pool_Free ();
+
+  return (best);
+}
+
+/*____________________________________________________________________
+|
+| Function: Run_Flat
+|
+| Input: Called from Bench()
+| Output: Spawns every job from this thread and waits for them.
+|___________________________________________________________________*/
+
+// The result holds the job's seed going in
+static void Flat_Job (void *data)
+{
+  double *result = (double *) data;
+
+  *result = Work ((int)(*result));
+}
+
+static void Run_Flat (int num_jobs, double *results)
+{
+  int i;
+  JobCounter counter = {};
+
+  for (i=0; i<num_jobs; i++) {
+    results[i] = i;
+    Job_Spawn (Flat_Job, &results[i], &counter);
+  }
+  Job_Wait (&counter);
+}
+
+/*____________________________________________________________________
+|
+| Function: Run_Recursive
+|
+| Input: Called from Bench()
+| Output: Runs a job that splits the jobs in half until they're small.
+|___________________________________________________________________*/
+
+static void Run_Recursive (int num_jobs, double *results)
+{
+  Range range;
+
+  range.first   = 0;
+  range.num     = num_jobs;
+  range.results = results;
+  Sum_Job (&range);
+}
+
+/*____________________________________________________________________
+|
+| Function: Run_Graph
+|
+| Input: Called from Bench()
+| Output: Runs graphs of GRAPH_FAN jobs fanned out from one job and
+|   back into one.
+|___________________________________________________________________*/
+
+static void Run_Graph (int num_jobs, double *results)
+{
+  int i, j, n, first, last, fan;
+
+  for (i=0; i<num_jobs; i++)
+    results[i] = i;
+  // 100 fans of GRAPH_FAN+2 jobs fit in a graph
+  for (i=0; i+GRAPH_FAN+2<=num_jobs; ) {
+    for (n=0; (n<100) && (i+GRAPH_FAN+2<=num_jobs); n++, i+=GRAPH_FAN+2) {
+      first = Job_Add (Flat_Job, &results[i]);
+      last  = Job_Add (Flat_Job, &results[i+GRAPH_FAN+1]);
+      for (j=0; j<GRAPH_FAN; j++) {
+        fan = Job_Add (Flat_Job, &results[i+1+j]);
+        Job_Add_Depend (fan, first);
+        Job_Add_Depend (last, fan);
+      }
+    }
+    Job_Run ();
+  }
+}
+
+/*____________________________________________________________________
+|
+| Function: Work
+|
+| Input: Called from Check(), Flat_Job(), Sum_Job()
+| Output: Returns a value that takes WORK_ITERATIONS to compute.
+|___________________________________________________________________*/
+
+static double Work (int seed)
+{
+  int i;
+  double x = seed * 0.001;
+
+  for (i=0; i<WORK_ITERATIONS; i++)
+    x = x * 0.999 + 0.5 / (1.0 + x);
+
+  return (x);
+}
+
+/*____________________________________________________________________
+|
+| Function: Count_Job
+|
+| Input: Called from Check() (through the job pool)
+| Output: Counts a run of this job.
+|___________________________________________________________________*/
+
+static void Count_Job (void *data)
+{
+  ((std::atomic<int> *) data)->fetch_add (1);
+}
+
+/*____________________________________________________________________
+|
+| Function: Sum_Job
+|
+| Input: Called from Check(), Run_Recursive() and itself (through the
+|   job pool)
+| Output: Sums the work of a range, spawning two jobs for its halves
+|   and waiting for them if it's big.
+|___________________________________________________________________*/
+
+static void Sum_Job (void *data)
+{
+  int i;
+  Range *range = (Range *) data;
+  Range half [2];
+  JobCounter counter = {};
+
+  if (range->num <= RECURSE_LEAF) {
+    range->sum = 0;
+    for (i=0; i<range->num; i++) {
+      range->results[range->first + i] = Work (range->first + i);
+      range->sum += range->results[range->first + i];
+    }
+    return;
+  }
+
+  half[0]         = *range;
+  half[0].num     = range->num / 2;
+  half[1]         = *range;
+  half[1].first   = range->first + half[0].num;
+  half[1].num     = range->num - half[0].num;
+  Job_Spawn (Sum_Job, &half[0], &counter);
+  Job_Spawn (Sum_Job, &half[1], &counter);
+  Job_Wait (&counter);
+
+  // Added in the same order however the halves ran, so the sum is exact
+  range->sum = 0;
+  for (i=0; i<range->num; i++)
+    range->sum += range->results[range->first + i];
+}
+
+/*____________________________________________________________________
+|
+| Function: Order_Job
+|
+| Input: Called from Check() (through the job pool)
+| Output: Counts an error if a dependency hasn't finished, then marks
+|   this job finished.
+|___________________________________________________________________*/
+
+static void Order_Job (void *data)
+{
+  int i;
+  OrderJob *job = (OrderJob *) data;
+
+  for (i=0; i<job->num_depends; i++)
+    if (job->done[job->depends[i]] != 1)
+      job->errors->fetch_add (1);
+  job->done[job->id].fetch_add (1);
+}
+
+/*____________________________________________________________________
+|
+| Function: Time_Ms
+|
+| Input: Called from Bench()
+| Output: Returns milliseconds elapsed since start.
+|___________________________________________________________________*/
+
+static double Time_Ms (std::chrono::high_resolution_clock::time_point start)
+{
+  return (std::chrono::duration<double, std::milli> (std::chrono::high_resolution_clock::now () - start).count ());
+}
@@ -0,0 +1,678 @@
+/*____________________________________________________________________
+|
+| File: lwo2.cpp
+|
+| Description: Reads the geometry of a LightWave LWO2 object file -
+|   tags, layers, points, FACE polygons, surface tags and vertex maps.
+|   Surface and clip chunks are skipped.  All values in the file are
+|   big-endian and chunks are padded to an even length.  Older LWOB
+|   files (points, polygons and surface names) are read too.
+|
+|   Files are read one chunk at a time into a buffer that is reused, so
+|   memory use is the size of the largest chunk, not the file.  Every
+|   size and index is checked: a chunk that runs past the end of the
+|   file, a polygon or vertex map entry that refers to a point or
+|   polygon that doesn't exist, a texture (TXUV) or weight (WGHT) map
+|   without 2 or 1 values per entry, or a point that isn't a number
+|   fails the read with a message in object->error, rather than
+|   producing a mesh that would crash whatever uses it.
+|
+|   Polygons of any size are triangulated by ear clipping.
+|
+| Functions: Lwo2_Read
+|            Lwo2_Parse
+|            Lwo2_Triangulate
+|             Read_Header
+|             Read_Chunk
+|             Read_Polygons
+|             Get_Layer
+|             Fail
+|             Read_U2
+|             Read_U4
+|             Read_F4
+|             Read_VX
+|             Read_S0
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+/*___________________
+|
+| Include Files
+|__________________*/
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "lwo2.h"
+
+/*___________________
+|
+| Type definitions
+|__________________*/
+
+// Read position in a chunk
+struct Cursor {
+  const unsigned char *p;
+  const unsigned char *end;
+  bool                 ok;
+};
+
+// State carried from chunk to chunk
+struct ReadState {
+  Lwo2Object *object;
+  unsigned    form_type;    // 'LWO2' or 'LWOB'
+  Lwo2Layer  *layer;        // current layer or 0
+  unsigned    pols_type;    // type of the last POLS chunk
+  unsigned    poly_base;    // first polygon of the last POLS chunk
+};
+
+/*___________________
+|
+| Function Prototypes
+|__________________*/
+
+static bool        Read_Header (ReadState *state, const unsigned char *header, size_t file_size, unsigned *form_size);
+static bool        Read_Chunk (ReadState *state, unsigned id, Cursor *chunk);
+static bool        Read_Polygons (ReadState *state, Cursor *chunk);
+static Lwo2Layer  *Get_Layer (ReadState *state);
+static bool        Fail (ReadState *state, unsigned id, const char *message);
+static unsigned    Read_U2 (Cursor *c);
+static unsigned    Read_U4 (Cursor *c);
+static float       Read_F4 (Cursor *c);
+static unsigned    Read_VX (Cursor *c);
+static std::string Read_S0 (Cursor *c);
+
+/*___________________
+|
+| Constants
+|__________________*/
+
+#define ID4(a,b,c,d) (((unsigned)(a)<<24) | ((unsigned)(b)<<16) | ((unsigned)(c)<<8) | (unsigned)(d))
+
+#define MAX_VMAP_DIMENSION 16
+
+/*____________________________________________________________________
+|
+| Function: Lwo2_Read
+|
+| Input: Called from ____
+| Output: Reads an LWO2 or LWOB file a chunk at a time.  Returns true on
+|   success, else false with the reason in object->error.
+|___________________________________________________________________*/
+
+bool Lwo2_Read (const char *filename, Lwo2Object *object)
+{
+  FILE *fp;
+  long file_size;
+  unsigned char header[12];
+  unsigned form_size, id, size, pad, left;
+  std::vector<unsigned char> buffer;
+  Cursor chunk;
+  ReadState state;
+  bool ok;
+
+  object->tags.clear ();
+  object->layers.clear ();
+  object->error.clear ();
+  memset (&state, 0, sizeof(state));
+  state.object = object;
+
+  fp = fopen (filename, "rb");
+  if (fp == 0)
+    return (Fail (&state, 0, "can't open file"));
+  fseek (fp, 0, SEEK_END);
+  file_size = ftell (fp);
+  fseek (fp, 0, SEEK_SET);
+
+  ok = (file_size >= 12) && (fread (header, 12, 1, fp) == 1) && Read_Header (&state, header, (size_t) file_size, &form_size);
+  if (! ok) {
+    fclose (fp);
+    return (file_size < 12 ? Fail (&state, 0, "file is too short") : false);
+  }
+
+  // Chunks follow the 4 byte form type
+  left = form_size - 4;
+  while (ok && (left >= 8)) {
+    if (fread (header, 8, 1, fp) != 1) {
+      ok = Fail (&state, 0, "file is truncated");
+      break;
+    }
+    id   = ((unsigned)header[0] << 24) | ((unsigned)header[1] << 16) | ((unsigned)header[2] << 8) | header[3];
+    size = ((unsigned)header[4] << 24) | ((unsigned)header[5] << 16) | ((unsigned)header[6] << 8) | header[7];
+    left -= 8;
+    if (size > left) {
+      ok = Fail (&state, id, "chunk runs past the end of the file");
+      break;
+    }
+    // Read the pad byte with the chunk, if there is one
+    pad = ((size & 1) && (left > size)) ? 1 : 0;
+    if (buffer.size () < size + pad)
+      buffer.resize (size + pad);
+    if ((size + pad > 0) && (fread (&buffer[0], size + pad, 1, fp) != 1)) {
+      ok = Fail (&state, id, "file is truncated");
+      break;
+    }
+    left -= size + pad;
+    chunk.p   = buffer.empty () ? 0 : &buffer[0];
+    chunk.end = chunk.p + size;
+    chunk.ok  = true;
+    ok = Read_Chunk (&state, id, &chunk);
+  }
+  fclose (fp);
+
+  return (ok);
+}
+
+/*____________________________________________________________________
+|
+| Function: Lwo2_Parse
+|
+| Input: Called from ____
+| Output: Reads an LWO2 or LWOB file from memory.  Returns true on
+|   success, else false with the reason in object->error.
+|___________________________________________________________________*/
+
+bool Lwo2_Parse (const void *data, size_t size, Lwo2Object *object)
+{
+  const unsigned char *p, *end;
+  unsigned form_size, id, chunk_size;
+  Cursor chunk;
+  ReadState state;
+
+  object->tags.clear ();
+  object->layers.clear ();
+  object->error.clear ();
+  memset (&state, 0, sizeof(state));
+  state.object = object;
+
+  if (size < 12)
+    return (Fail (&state, 0, "file is too short"));
+  p = (const unsigned char *) data;
+  if (! Read_Header (&state, p, size, &form_size))
+    return (false);
+  end = p + 8 + form_size;
+  p  += 12;
+
+  while (end - p >= 8) {
+    id         = ((unsigned)p[0] << 24) | ((unsigned)p[1] << 16) | ((unsigned)p[2] << 8) | p[3];
+    chunk_size = ((unsigned)p[4] << 24) | ((unsigned)p[5] << 16) | ((unsigned)p[6] << 8) | p[7];
+    p += 8;
+    if ((size_t)(end - p) < chunk_size)
+      return (Fail (&state, id, "chunk runs past the end of the file"));
+    chunk.p   = p;
+    chunk.end = p + chunk_size;
+    chunk.ok  = true;
+    p += chunk_size;
+    if ((chunk_size & 1) && (p < end))
+      p++;
+    if (! Read_Chunk (&state, id, &chunk))
+      return (false);
+  }
+
+  return (true);
+}
+
+/*____________________________________________________________________
+|
+| Function: Lwo2_Triangulate
+|
+| Input: Called from ____
+| Output: Triangulates a polygon by ear clipping and appends the
+|   triangles as corner numbers, in the polygon's winding order.  The
+|   polygon is projected onto the plane its normal is closest to, then
+|   a corner is cut off whenever it is convex and no other corner lies
+|   inside the triangle it makes.  If a whole trip round the polygon
+|   finds no such corner (it's self intersecting or degenerate) the rest
+|   is fan triangulated, so n-2 triangles are always appended and bad
+|   input can't take more than one extra trip.  Returns the number of
+|   triangles.
+|___________________________________________________________________*/
+
+int Lwo2_Triangulate (const float *points, const unsigned *poly, int n, std::vector<unsigned> *triangles)
+{
+  // Scratch space reused between calls (the tools are single threaded)
+  static std::vector<float> x, y;
+  static std::vector<int> prev, next;
+  int i, j, k, u, v, a, b, c, left, misses;
+  float normal[3], ax, ay, bx, by, cx, cy, d0, d1, d2;
+  const float *p0, *p1;
+  bool ear, stuck;
+
+  if (n < 3)
+    return (0);
+  if (n == 3) {
+    triangles->push_back (0);
+    triangles->push_back (1);
+    triangles->push_back (2);
+    return (1);
+  }
+
+  // Newell's method handles non-planar polygons
+  normal[0] = normal[1] = normal[2] = 0;
+  for (i=0; i<n; i++) {
+    p0 = &points[poly[i]*3];
+    p1 = &points[poly[(i+1) % n]*3];
+    normal[0] += (p0[1] - p1[1]) * (p0[2] + p1[2]);
+    normal[1] += (p0[2] - p1[2]) * (p0[0] + p1[0]);
+    normal[2] += (p0[0] - p1[0]) * (p0[1] + p1[1]);
+  }
+
+  // Project onto the axis plane the polygon faces most, keeping it counter-clockwise
+  k = 0;
+  if (fabs (normal[1]) > fabs (normal[k]))
+    k = 1;
+  if (fabs (normal[2]) > fabs (normal[k]))
+    k = 2;
+  u = (k + 1) % 3;
+  v = (k + 2) % 3;
+  x.resize (n);
+  y.resize (n);
+  prev.resize (n);
+  next.resize (n);
+  for (i=0; i<n; i++) {
+    x[i] = points[poly[i]*3+u];
+    y[i] = (normal[k] < 0) ? -points[poly[i]*3+v] : points[poly[i]*3+v];
+    prev[i] = (i + n - 1) % n;
+    next[i] = (i + 1) % n;
+  }
+
+  i = 0;
+  misses = 0;
+  stuck = false;
+  for (left=n; left>3; ) {
+    a = prev[i];
+    b = i;
+    c = next[i];
+    ax = x[a]; ay = y[a];
+    bx = x[b]; by = y[b];
+    cx = x[c]; cy = y[c];
+
+    // Convex, and no other corner in the triangle?
+    ear = stuck || ((bx - ax) * (cy - ay) - (by - ay) * (cx - ax) > 0);
+    for (j=next[c]; ear && (! stuck) && (j != a); j=next[j]) {
+      if (((x[j] == ax) && (y[j] == ay)) || ((x[j] == bx) && (y[j] == by)) || ((x[j] == cx) && (y[j] == cy)))
+        continue;
+      d0 = (bx - ax) * (y[j] - ay) - (by - ay) * (x[j] - ax);
+      d1 = (cx - bx) * (y[j] - by) - (cy - by) * (x[j] - bx);
+      d2 = (ax - cx) * (y[j] - cy) - (ay - cy) * (x[j] - cx);
+      ear = (d0 < 0) || (d1 < 0) || (d2 < 0);
+    }
+
+    // After going all the way round without an ear, cut the rest into a fan
+    if ((! ear) && (++misses > left))
+      stuck = ear = true;
+    if (ear) {
+      triangles->push_back (a);
+      triangles->push_back (b);
+      triangles->push_back (c);
+      next[a] = c;
+      prev[c] = a;
+      left--;
+      misses = 0;
+      i = a;
+    }
+    else
+      i = c;
+  }
+  triangles->push_back (prev[i]);
+  triangles->push_back (i);
+  triangles->push_back (next[i]);
+
+  return (n - 2);
+}
+
+/*____________________________________________________________________
+|
+| Function: Read_Header
+|
+| Input: Called from Lwo2_Read(), Lwo2_Parse()
+| Output: Checks the 12 byte FORM header against the file size.
+|   Returns true if it's an LWO2 or LWOB file.
+|___________________________________________________________________*/
+
+static bool Read_Header (ReadState *state, const unsigned char *header, size_t file_size, unsigned *form_size)
+{
+  Cursor c;
+
+  c.p   = header;
+  c.end = header + 12;
+  c.ok  = true;
+  if (Read_U4 (&c) != ID4('F','O','R','M'))
+    return (Fail (state, 0, "not an IFF file"));
+  *form_size = Read_U4 (&c);
+  if ((*form_size < 4) || (*form_size > file_size - 8))
+    return (Fail (state, 0, "FORM size doesn't match the file size"));
+  state->form_type = Read_U4 (&c);
+  if ((state->form_type != ID4('L','W','O','2')) && (state->form_type != ID4('L','W','O','B')))
+    return (Fail (state, 0, "not an LWO2 or LWOB file"));
+
+  return (true);
+}
+
+/*____________________________________________________________________
+|
+| Function: Read_Chunk
+|
+| Input: Called from Lwo2_Read(), Lwo2_Parse()
+| Output: Reads one chunk.  Returns false if it's invalid.
+|___________________________________________________________________*/
+
+static bool Read_Chunk (ReadState *state, unsigned id, Cursor *chunk)
+{
+  Lwo2Object *object = state->object;
+  Lwo2Layer *layer;
+  const unsigned char *p;
+  unsigned i, n, bits, poly, num_points, num_polys;
+  float f;
+
+  switch (id) {
+    case ID4('T','A','G','S'):
+    case ID4('S','R','F','S'):
+      while (chunk->ok && (chunk->p < chunk->end))
+        object->tags.push_back (Read_S0 (chunk));
+      break;
+
+    case ID4('L','A','Y','R'):
+      object->layers.push_back (Lwo2Layer ());
+      layer = state->layer = &object->layers.back ();
+      layer->number = Read_U2 (chunk);
+      Read_U2 (chunk);
+      for (i=0; i<3; i++)
+        layer->pivot[i] = Read_F4 (chunk);
+      layer->name   = Read_S0 (chunk);
+      layer->parent = (chunk->end - chunk->p >= 2) ? (int) Read_U2 (chunk) : -1;
+      break;
+
+    case ID4('P','N','T','S'):
+      layer = Get_Layer (state);
+      if ((chunk->end - chunk->p) % 12)
+        return (Fail (state, id, "size isn't a multiple of 12"));
+      n = (unsigned)(chunk->end - chunk->p) / 4;
+      i = (unsigned) layer->points.size ();
+      layer->points.resize (i + n);
+      for (p=chunk->p; p<chunk->end; p+=4, i++) {
+        bits = ((unsigned)p[0] << 24) | ((unsigned)p[1] << 16) | ((unsigned)p[2] << 8) | p[3];
+        memcpy (&f, &bits, sizeof(f));
+        // Not a number or infinite
+        if ((bits & 0x7F800000) == 0x7F800000)
+          return (Fail (state, id, "point isn't a number"));
+        layer->points[i] = f;
+      }
+      chunk->p = chunk->end;
+      break;
+
+    case ID4('P','O','L','S'):
+      if (! Read_Polygons (state, chunk))
+        return (false);
+      break;
+
+    case ID4('P','T','A','G'):
+      layer = state->layer;
+      if ((layer == 0) || (state->pols_type != ID4('F','A','C','E')) || (Read_U4 (chunk) != ID4('S','U','R','F')))
+        break;
+      num_polys = (unsigned) Lwo2_Num_Polys (layer);
+      while (chunk->ok && (chunk->p < chunk->end)) {
+        poly = state->poly_base + Read_VX (chunk);
+        n    = Read_U2 (chunk);
+        if (! chunk->ok)
+          break;
+        if (poly >= num_polys)
+          return (Fail (state, id, "polygon index out of range"));
+        if (n >= object->tags.size ())
+          return (Fail (state, id, "tag index out of range"));
+        layer->poly_surface[poly] = (int) n;
+      }
+      break;
+
+    case ID4('V','M','A','P'):
+    case ID4('V','M','A','D'): {
+      Lwo2VMap vmap;
+      bool vmad = (id == ID4('V','M','A','D'));
+      layer = Get_Layer (state);
+      num_points = (unsigned) layer->points.size () / 3;
+      num_polys  = (unsigned) Lwo2_Num_Polys (layer);
+      vmap.type          = Read_U4 (chunk);
+      vmap.dimension     = Read_U2 (chunk);
+      vmap.name          = Read_S0 (chunk);
+      vmap.discontinuous = vmad;
+      if (vmap.dimension > MAX_VMAP_DIMENSION)
+        return (Fail (state, id, "dimension is too large"));
+      if (((vmap.type == ID4('T','X','U','V')) && (vmap.dimension != 2)) ||
+          ((vmap.type == ID4('W','G','H','T')) && (vmap.dimension != 1)))
+        return (Fail (state, id, "dimension doesn't match the map type"));
+      while (chunk->ok && (chunk->p < chunk->end)) {
+        vmap.point.push_back (Read_VX (chunk));
+        if (vmap.point.back () >= num_points)
+          return (Fail (state, id, "point index out of range"));
+        if (vmad) {
+          vmap.poly.push_back (state->poly_base + Read_VX (chunk));
+          if (vmap.poly.back () >= num_polys)
+            return (Fail (state, id, "polygon index out of range"));
+        }
+        for (i=0; i<(unsigned)vmap.dimension; i++)
+          vmap.values.push_back (Read_F4 (chunk));
+      }
+      if (chunk->ok)
+        layer->vmaps.push_back (vmap);
+      break;
+    }
+  }
+  if (! chunk->ok)
+    return (Fail (state, id, "chunk is truncated"));
+
+  return (true);
+}
+
+/*____________________________________________________________________
+|
+| Function: Read_Polygons
+|
+| Input: Called from Read_Chunk()
+| Output: Reads a POLS chunk.  In an LWO2 file:
+|
+|     type (ID4), then for each polygon:
+|       U2 flags (top 6 bits) and number of points
+|       VX point ...
+|
+|   In an LWOB file, for each polygon:
+|       U2 number of points
+|       U2 point ...
+|       I2 surface (1 based, negative if detail polygons follow)
+|       U2 number of detail polygons (if surface is negative)
+|
+|   Detail polygons have the same layout, so they're read as polygons.
+|   Returns false if the chunk is invalid.
+|___________________________________________________________________*/
+
+static bool Read_Polygons (ReadState *state, Cursor *chunk)
+{
+  Lwo2Layer *layer;
+  unsigned i, n, point, num_points;
+  int surface;
+  bool lwob = (state->form_type == ID4('L','W','O','B'));
+
+  layer = Get_Layer (state);
+  state->pols_type = lwob ? ID4('F','A','C','E') : Read_U4 (chunk);
+  state->poly_base = (unsigned) Lwo2_Num_Polys (layer);
+  if (state->pols_type != ID4('F','A','C','E'))
+    return (true);
+
+  num_points = (unsigned) layer->points.size () / 3;
+  if (layer->poly_start.empty ())
+    layer->poly_start.push_back (0);
+  while (chunk->ok && (chunk->p < chunk->end)) {
+    n = Read_U2 (chunk);
+    if (! lwob)
+      n &= 0x3FF;
+    if (n == 0)
+      return (Fail (state, ID4('P','O','L','S'), "polygon has no points"));
+    for (i=0; i<n; i++) {
+      point = lwob ? Read_U2 (chunk) : Read_VX (chunk);
+      if (chunk->ok && (point >= num_points))
+        return (Fail (state, ID4('P','O','L','S'), "point index out of range"));
+      layer->poly_points.push_back (point);
+    }
+    surface = -1;
+    if (lwob) {
+      surface = (short) Read_U2 (chunk);
+      if (surface < 0) {
+        surface = -surface;
+        Read_U2 (chunk);
+      }
+      surface--;
+    }
+    if (! chunk->ok)
+      return (Fail (state, ID4('P','O','L','S'), "chunk is truncated"));
+    layer->poly_start.push_back ((unsigned) layer->poly_points.size ());
+    layer->poly_surface.push_back (surface);
+  }
+
+  return (true);
+}
+
+/*____________________________________________________________________
+|
+| Function: Get_Layer
+|
+| Input: Called from Read_Chunk(), Read_Polygons()
+| Output: Returns the current layer.  Geometry before the first LAYR
+|   chunk goes in a default layer.
+|___________________________________________________________________*/
+
+static Lwo2Layer *Get_Layer (ReadState *state)
+{
+  Lwo2Layer *layer;
+
+  if (state->layer == 0) {
+    state->object->layers.push_back (Lwo2Layer ());
+    layer = state->layer = &state->object->layers.back ();
+    layer->number = 0;
+    layer->parent = -1;
+    layer->pivot[0] = layer->pivot[1] = layer->pivot[2] = 0;
+  }
+
+  return (state->layer);
+}
+
+/*____________________________________________________________________
+|
+| Function: Fail
+|
+| Input: Called from Lwo2_Read(), Lwo2_Parse(), Read_Header(),
+|   Read_Chunk(), Read_Polygons()
+| Output: Sets the error message, with the chunk id if not 0.  Returns
+|   false.
+|___________________________________________________________________*/
+
+static bool Fail (ReadState *state, unsigned id, const char *message)
+{
+  char str[16];
+  int i;
+
+  state->object->error.clear ();
+  if (id) {
+    for (i=0; i<4; i++) {
+      str[i] = (char)(id >> (24 - i*8));
+      if ((str[i] < ' ') || (str[i] > '~'))
+        str[i] = '?';
+    }
+    str[4] = 0;
+    state->object->error = std::string (str) + ": ";
+  }
+  state->object->error += message;
+
+  return (false);
+}
+
+/*____________________________________________________________________
+|
+| Function: Read_U2, Read_U4, Read_F4
+|
+| Input: Called from Read_Chunk()
+| Output: Reads a big-endian value.  On reading past the end of the
+|   chunk, clears the ok flag and returns 0.
+|___________________________________________________________________*/
+
+static unsigned Read_U2 (Cursor *c)
+{
+  unsigned n = 0;
+
+  if (c->end - c->p < 2)
+    c->ok = false;
+  else {
+    n = ((unsigned)c->p[0] << 8) | c->p[1];
+    c->p += 2;
+  }
+  return (n);
+}
+
+static unsigned Read_U4 (Cursor *c)
+{
+  unsigned n = 0;
+
+  if (c->end - c->p < 4)
+    c->ok = false;
+  else {
+    n = ((unsigned)c->p[0] << 24) | ((unsigned)c->p[1] << 16) | ((unsigned)c->p[2] << 8) | c->p[3];
+    c->p += 4;
+  }
+  return (n);
+}
+
+static float Read_F4 (Cursor *c)
+{
+  unsigned n = Read_U4 (c);
+  float f;
+
+  memcpy (&f, &n, sizeof(f));
+  return (f);
+}
+
+/*____________________________________________________________________
+|
+| Function: Read_VX
+|
+| Input: Called from Read_Chunk(), Read_Polygons()
+| Output: Reads a variable length index - 2 bytes, or 4 bytes if the
+|   first byte is 0xFF.
+|___________________________________________________________________*/
+
+static unsigned Read_VX (Cursor *c)
+{
+  if ((c->p < c->end) && (c->p[0] == 0xFF))
+    return (Read_U4 (c) & 0x00FFFFFF);
+  else
+    return (Read_U2 (c));
+}
+
+/*____________________________________________________________________
+|
+| Function: Read_S0
+|
+| Input: Called from Read_Chunk()
+| Output: Reads a null terminated string padded to an even length.
+|___________________________________________________________________*/
+
+static std::string Read_S0 (Cursor *c)
+{
+  const unsigned char *start = c->p;
+  std::string s;
+
+  while ((c->p < c->end) && (*c->p != 0))
+    c->p++;
+  if (c->p >= c->end) {
+    c->ok = false;
+    return (s);
+  }
+  s.assign ((const char *) start, c->p - start);
+  c->p++;
+  if ((c->p - start) & 1)
+    c->p++;
+  if (c->p > c->end)
+    c->p = c->end;
+
+  return (s);
+}
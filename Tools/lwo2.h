@@ -0,0 +1,76 @@
+/*____________________________________________________________________
+|
+| File: lwo2.h
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+#ifndef _LWO2_H_
+#define _LWO2_H_
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+/*___________________
+|
+| Type definitions
+|__________________*/
+
+// A VMAP (per point) or VMAD (per polygon corner) chunk
+struct Lwo2VMap {
+  unsigned              type;     // ID4, for example 'TXUV' or 'WGHT'
+  std::string           name;
+  int                   dimension; // 2 for 'TXUV', 1 for 'WGHT'
+  bool                  discontinuous;
+  std::vector<unsigned> point;
+  std::vector<unsigned> poly;     // VMAD only
+  std::vector<float>    values;   // dimension floats per entry
+};
+
+// Polygon i has points poly_points [poly_start[i] .. poly_start[i+1]-1]
+struct Lwo2Layer {
+  std::string           name;
+  int                   number;
+  int                   parent;         // layer number or -1
+  float                 pivot[3];
+  std::vector<float>    points;         // x,y,z per point
+  std::vector<unsigned> poly_start;     // one more entry than polygons
+  std::vector<unsigned> poly_points;    // FACE polygons only
+  std::vector<int>      poly_surface;   // tag index for each polygon or -1
+  std::vector<Lwo2VMap> vmaps;
+};
+
+struct Lwo2Object {
+  std::vector<std::string> tags;
+  std::vector<Lwo2Layer>   layers;
+  std::string              error;       // why the last read failed
+};
+
+/*___________________
+|
+| Functions
+|__________________*/
+
+// Reads the geometry chunks of a LightWave object file one chunk at a time, returns true on success
+bool Lwo2_Read (const char *filename, Lwo2Object *object);
+
+// Same as Lwo2_Read() for a file already in memory
+bool Lwo2_Parse (const void *data, size_t size, Lwo2Object *object);
+
+// Returns the number of polygons in a layer
+inline int Lwo2_Num_Polys (const Lwo2Layer *layer)
+{
+  return (layer->poly_start.empty () ? 0 : (int) layer->poly_start.size () - 1);
+}
+
+// Triangulates a polygon by ear clipping, appends n-2 triangles (as corner numbers 0 to n-1)
+//   and returns how many were appended
+int Lwo2_Triangulate (
+  const float           *points,        // x,y,z per point
+  const unsigned        *poly,          // point index of each corner
+  int                    n,             // number of corners
+  std::vector<unsigned> *triangles );
+
+#endif
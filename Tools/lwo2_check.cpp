@@ -0,0 +1,412 @@
+/*____________________________________________________________________
+|
+| File: lwo2_check.cpp
+|
+| Description: Command line tool that benchmarks and fuzzes the LWO2
+|   reader.  For each file, times reading it a chunk at a time from
+|   disk, parsing it from memory and triangulating every polygon, then
+|   parses randomly damaged copies of it (bytes flipped, chunk sizes,
+|   indices and vertex map types and dimensions overwritten, the file
+|   cut short).  A damaged copy must either be rejected or produce a
+|   mesh whose indices are all in range and that converts (as
+|   mesh_convert does, see mesh_build.cpp) to mesh file layers whose
+|   indices and bones are in range - build with
+|   -fsanitize=address,undefined to also catch reads out of bounds.
+|
+|   Usage: lwo2_check [-n copies] [-s seed] file.lwo ...
+|     -n  damaged copies of each file (default 10000)
+|     -s  random seed (default 1)
+|
+|   Example: lwo2_check ../Objects/tifa.lwo ../Objects/bear.lwo
+|
+|   Build: g++ -O2 -I../Application -o lwo2_check lwo2_check.cpp lwo2.cpp
+|            mesh_build.cpp
+|
+| Functions: main
+|             Check_File
+|             Damage
+|             Check_Object
+|             Triangulate_All
+|             Build_All
+|             Random
+|             Time_Ms
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+/*___________________
+|
+| Include Files
+|__________________*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+
+#include "mesh_build.h"
+
+/*___________________
+|
+| Function Prototypes
+|__________________*/
+
+static bool     Check_File (const char *filename, int num_copies);
+static void     Damage (std::vector<unsigned char> *file);
+static bool     Check_Object (const Lwo2Object *object);
+static unsigned Triangulate_All (const Lwo2Object *object, std::vector<unsigned> *triangles);
+static bool     Build_All (Lwo2Object *object);
+static unsigned Random ();
+static double   Time_Ms (std::chrono::high_resolution_clock::time_point start);
+
+/*___________________
+|
+| Constants
+|__________________*/
+
+#define NUM_LOAD_TRIALS 20
+
+/*___________________
+|
+| Global variables
+|__________________*/
+
+static unsigned random_state = 1;
+
+/*____________________________________________________________________
+|
+| Function: main
+|
+| Input: Called from the command line
+| Output: Checks each file on the command line.
+|___________________________________________________________________*/
+
+int main (int argc, char **argv)
+{
+  int i, num_copies = 10000, errors = 0;
+
+  for (i=1; i<argc; i++) {
+    if ((strcmp (argv[i], "-n") == 0) && (i+1 < argc))
+      num_copies = atoi (argv[++i]);
+    else if ((strcmp (argv[i], "-s") == 0) && (i+1 < argc))
+      random_state = (unsigned) strtoul (argv[++i], 0, 10) | 1;
+    else if (! Check_File (argv[i], num_copies))
+      errors++;
+  }
+  if (argc < 2) {
+    fprintf (stderr, "usage: lwo2_check [-n copies] [-s seed] file.lwo ...\n");
+    return (1);
+  }
+
+  return (errors ? 1 : 0);
+}
+
+/*____________________________________________________________________
+|
+| Function: Check_File
+|
+| Input: Called from main()
+| Output: Benchmarks and fuzzes one file.  Returns false if the file
+|   can't be read or a damaged copy produced a bad mesh.
+|___________________________________________________________________*/
+
+static bool Check_File (const char *filename, int num_copies)
+{
+  FILE *fp;
+  long size;
+  int i, num_rejected;
+  unsigned num_points, num_polys, num_ngons, num_triangles, j;
+  std::vector<unsigned char> file, copy;
+  std::vector<unsigned> triangles;
+  Lwo2Object object;
+  double read_ms, parse_ms, triangulate_ms;
+  std::chrono::high_resolution_clock::time_point start;
+
+  fp = fopen (filename, "rb");
+  if (fp == 0) {
+    fprintf (stderr, "%s: can't open file\n", filename);
+    return (false);
+  }
+  fseek (fp, 0, SEEK_END);
+  size = ftell (fp);
+  fseek (fp, 0, SEEK_SET);
+  file.resize (size);
+  if ((size == 0) || (fread (&file[0], size, 1, fp) != 1))
+    file.clear ();
+  fclose (fp);
+
+/*____________________________________________________________________
+|
+| Benchmark
+|___________________________________________________________________*/
+
+  if (! Lwo2_Read (filename, &object)) {
+    fprintf (stderr, "%s: %s\n", filename, object.error.c_str ());
+    return (false);
+  }
+  start = std::chrono::high_resolution_clock::now ();
+  for (i=0; i<NUM_LOAD_TRIALS; i++)
+    Lwo2_Read (filename, &object);
+  read_ms = Time_Ms (start) / NUM_LOAD_TRIALS;
+
+  start = std::chrono::high_resolution_clock::now ();
+  for (i=0; i<NUM_LOAD_TRIALS; i++)
+    Lwo2_Parse (&file[0], file.size (), &object);
+  parse_ms = Time_Ms (start) / NUM_LOAD_TRIALS;
+
+  start = std::chrono::high_resolution_clock::now ();
+  for (i=0; i<NUM_LOAD_TRIALS; i++)
+    num_triangles = Triangulate_All (&object, &triangles);
+  triangulate_ms = Time_Ms (start) / NUM_LOAD_TRIALS;
+
+  if (! Check_Object (&object)) {
+    fprintf (stderr, "%s: mesh has indices out of range\n", filename);
+    return (false);
+  }
+  if (! Build_All (&object)) {
+    fprintf (stderr, "%s: converted mesh has indices or bones out of range\n", filename);
+    return (false);
+  }
+  num_points = num_polys = num_ngons = 0;
+  for (i=0; i<(int)object.layers.size (); i++) {
+    num_points += (unsigned) object.layers[i].points.size () / 3;
+    num_polys  += (unsigned) Lwo2_Num_Polys (&object.layers[i]);
+    for (j=0; j<(unsigned)Lwo2_Num_Polys (&object.layers[i]); j++)
+      if (object.layers[i].poly_start[j+1] - object.layers[i].poly_start[j] > 3)
+        num_ngons++;
+  }
+  printf ("%s: %u bytes, %u points, %u polygons (%u with more than 3 points) -> %u triangles\n",
+          filename, (unsigned) file.size (), num_points, num_polys, num_ngons, num_triangles);
+  printf ("  read %.3f ms (%.0f MB/s), parse %.3f ms, triangulate %.3f ms\n",
+          read_ms, file.size () / (read_ms * 1000), parse_ms, triangulate_ms);
+
+/*____________________________________________________________________
+|
+| Fuzz
+|___________________________________________________________________*/
+
+  num_rejected = 0;
+  for (i=0; i<num_copies; i++) {
+    copy = file;
+    Damage (&copy);
+    if (! Lwo2_Parse (copy.empty () ? 0 : &copy[0], copy.size (), &object))
+      num_rejected++;
+    else if (! Check_Object (&object)) {
+      fprintf (stderr, "%s: damaged copy %d gave a mesh with indices out of range\n", filename, i);
+      return (false);
+    }
+    else {
+      Triangulate_All (&object, &triangles);
+      if (! Build_All (&object)) {
+        fprintf (stderr, "%s: damaged copy %d converted to a mesh with indices or bones out of range\n", filename, i);
+        return (false);
+      }
+    }
+  }
+  printf ("  %d damaged copies: %d rejected, %d accepted, all accepted meshes valid and converted\n",
+          num_copies, num_rejected, num_copies - num_rejected);
+
+  return (true);
+}
+
+/*____________________________________________________________________
+|
+| Function: Damage
+|
+| Input: Called from Check_File()
+| Output: Makes 1 to 4 random changes to a file.
+|___________________________________________________________________*/
+
+static void Damage (std::vector<unsigned char> *file)
+{
+  int i, n;
+  unsigned at, value;
+  size_t size = file->size ();
+
+  if (size < 4)
+    return;
+  n = 1 + Random () % 4;
+  for (i=0; i<n; i++) {
+    at = Random () % (unsigned)(size - 3);
+    value = Random ();
+    switch (Random () % 7) {
+      // Flip a bit
+      case 0: (*file)[at] ^= (unsigned char)(1 << (value & 7));
+              break;
+      // Overwrite a byte
+      case 1: (*file)[at] = (unsigned char) value;
+              break;
+      // Overwrite 4 bytes (a chunk size, count or float) with a small or large value
+      case 2: if (value & 1)
+                value >>= 20;
+              (*file)[at]   = (unsigned char)(value >> 24);
+              (*file)[at+1] = (unsigned char)(value >> 16);
+              (*file)[at+2] = (unsigned char)(value >> 8);
+              (*file)[at+3] = (unsigned char) value;
+              break;
+      // Make an index 4 bytes long, or very large
+      case 3: (*file)[at] = 0xFF;
+              break;
+      // Zero 2 bytes (a polygon point count or index)
+      case 4: (*file)[at] = (*file)[at+1] = 0;
+              break;
+      // Cut the file short
+      case 5: file->resize (at + 4);
+              size = file->size ();
+              break;
+      // Give the next vertex map (VMAP or VMAD) a small dimension, or make it a texture or weight map
+      case 6: for (; at+14 <= size; at++)
+                if (memcmp (&(*file)[at], "VMA", 3) == 0)
+                  break;
+              if (at+14 > size)
+                break;
+              if (value & 1) {
+                (*file)[at+12] = 0;
+                (*file)[at+13] = (unsigned char)((value >> 1) % 4);
+              }
+              else
+                memcpy (&(*file)[at+8], (value & 2) ? "TXUV" : "WGHT", 4);
+              break;
+    }
+  }
+}
+
+/*____________________________________________________________________
+|
+| Function: Check_Object
+|
+| Input: Called from Check_File()
+| Output: Returns true if every index in an object is in range.
+|___________________________________________________________________*/
+
+static bool Check_Object (const Lwo2Object *object)
+{
+  unsigned i, j, num_points, num_polys;
+  const Lwo2Layer *layer;
+
+  for (i=0; i<object->layers.size (); i++) {
+    layer = &object->layers[i];
+    num_points = (unsigned) layer->points.size () / 3;
+    num_polys  = (unsigned) Lwo2_Num_Polys (layer);
+    if ((layer->points.size () % 3) || (num_polys && (layer->poly_start.back () != layer->poly_points.size ())) ||
+        (layer->poly_surface.size () != num_polys))
+      return (false);
+    for (j=0; j<num_polys; j++)
+      if (layer->poly_start[j] > layer->poly_start[j+1])
+        return (false);
+    for (j=0; j<layer->poly_points.size (); j++)
+      if (layer->poly_points[j] >= num_points)
+        return (false);
+    for (j=0; j<layer->vmaps.size (); j++) {
+      const Lwo2VMap *vmap = &layer->vmaps[j];
+      if (vmap->values.size () != vmap->point.size () * vmap->dimension)
+        return (false);
+      for (unsigned k=0; k<vmap->point.size (); k++)
+        if ((vmap->point[k] >= num_points) || (vmap->discontinuous && (vmap->poly[k] >= num_polys)))
+          return (false);
+    }
+  }
+
+  return (true);
+}
+
+/*____________________________________________________________________
+|
+| Function: Triangulate_All
+|
+| Input: Called from Check_File()
+| Output: Triangulates every polygon, checking the triangles.  Returns
+|   the number of triangles.
+|___________________________________________________________________*/
+
+static unsigned Triangulate_All (const Lwo2Object *object, std::vector<unsigned> *triangles)
+{
+  unsigned i, j, k, n, num_triangles = 0;
+  const Lwo2Layer *layer;
+
+  for (i=0; i<object->layers.size (); i++) {
+    layer = &object->layers[i];
+    for (j=0; j<(unsigned)Lwo2_Num_Polys (layer); j++) {
+      n = layer->poly_start[j+1] - layer->poly_start[j];
+      triangles->clear ();
+      num_triangles += Lwo2_Triangulate (&layer->points[0], &layer->poly_points[layer->poly_start[j]], (int) n, triangles);
+      for (k=0; k<triangles->size (); k++)
+        if ((*triangles)[k] >= n) {
+          fprintf (stderr, "triangulation returned corner %u of %u\n", (*triangles)[k], n);
+          exit (1);
+        }
+    }
+  }
+
+  return (num_triangles);
+}
+
+/*____________________________________________________________________
+|
+| Function: Build_All
+|
+| Input: Called from Check_File()
+| Output: Converts every layer the way mesh_convert does.  Returns true
+|   if every layer's triangles are in its own range of vertices and
+|   every skinned vertex's bones are weight maps that were found.
+|___________________________________________________________________*/
+
+static bool Build_All (Lwo2Object *object)
+{
+  unsigned i, j, k;
+  std::vector<std::string> bones;
+  std::vector<MeshFileLayer> layers;
+  std::vector<MeshBuildVertex> vertices;
+  std::vector<unsigned> indices;
+  const MeshFileLayer *layer;
+
+  layers.resize (object->layers.size ());
+  for (i=0; i<object->layers.size (); i++) {
+    Mesh_Build_Layer (&object->layers[i], &bones, &layers[i], &vertices, &indices);
+    layer = &layers[i];
+    if ((layer->first_vertex + layer->num_vertices != vertices.size ()) ||
+        (layer->first_index + layer->num_indices != indices.size ()) || (layer->num_indices % 3))
+      return (false);
+    for (j=layer->first_index; j<indices.size (); j++)
+      if (indices[j] >= layer->num_vertices)
+        return (false);
+  }
+  for (i=0; i<vertices.size (); i++)
+    for (k=0; k<4; k++)
+      if ((vertices[i].skin.weight[k] > 0) && (vertices[i].skin.bone[k] >= bones.size ()))
+        return (false);
+
+  return (true);
+}
+
+/*____________________________________________________________________
+|
+| Function: Random
+|
+| Input: Called from Damage()
+| Output: Returns a pseudo random number (xorshift).
+|___________________________________________________________________*/
+
+static unsigned Random ()
+{
+  random_state ^= random_state << 13;
+  random_state ^= random_state >> 17;
+  random_state ^= random_state << 5;
+
+  return (random_state);
+}
+
+/*____________________________________________________________________
+|
+| Function: Time_Ms
+|
+| Input: Called from Check_File()
+| Output: Returns milliseconds elapsed since start.
+|___________________________________________________________________*/
+
+static double Time_Ms (std::chrono::high_resolution_clock::time_point start)
+{
+  return (std::chrono::duration<double, std::milli> (std::chrono::high_resolution_clock::now () - start).count ());
+}
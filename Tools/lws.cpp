@@ -0,0 +1,312 @@
+/*____________________________________________________________________
+|
+| File: lws.cpp
+|
+| Description: Reads the items and motions of a LightWave scene file
+|   (LWSC version 3 and up) - objects, bones, bone rest poses, parents
+|   and motion envelopes.  Lights, cameras and plugin data are skipped.
+|   Envelopes are evaluated with Kochanek-Bartels (TCB) splines, linear
+|   and stepped spans.  Hermite and bezier spans are evaluated as TCB and
+|   pre/post behaviors as constant.
+|
+| Functions: Lws_Read
+|            Lws_Evaluate
+|             Read_Envelope
+|             Next_Line
+|             Skip_Word
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+/*___________________
+|
+| Include Files
+|__________________*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lws.h"
+
+/*___________________
+|
+| Function Prototypes
+|__________________*/
+
+static bool        Read_Envelope (char **p, LwsEnvelope *envelope);
+static char       *Next_Line (char **p);
+static const char *Skip_Word (const char *s);
+
+/*____________________________________________________________________
+|
+| Function: Lws_Read
+|
+| Input: Called from ____
+| Output: Reads an LWS file.  Returns true on success.
+|___________________________________________________________________*/
+
+bool Lws_Read (const char *filename, LwsScene *scene)
+{
+  FILE *fp;
+  long size;
+  std::vector<char> file;
+  char *p, *line;
+  const char *args;
+  int item, channel;
+  LwsItem new_item;
+
+  scene->first_frame = 0;
+  scene->last_frame  = 0;
+  scene->fps         = 30;
+  scene->items.clear ();
+
+  fp = fopen (filename, "rb");
+  if (fp == 0)
+    return (false);
+  fseek (fp, 0, SEEK_END);
+  size = ftell (fp);
+  fseek (fp, 0, SEEK_SET);
+  file.resize (size + 1);
+  if ((size < 4) || (fread (&file[0], size, 1, fp) != 1)) {
+    fclose (fp);
+    return (false);
+  }
+  fclose (fp);
+  file[size] = 0;
+  if (memcmp (&file[0], "LWSC", 4) != 0)
+    return (false);
+
+/*____________________________________________________________________
+|
+| Read lines.  item is the index of the item being read, or -1 while
+| reading a light, camera or scene settings.
+|___________________________________________________________________*/
+
+  item = -1;
+  p = &file[0];
+  while ((line = Next_Line (&p)) != 0) {
+    args = Skip_Word (line);
+
+    if (strncmp (line, "FramesPerSecond ", 16) == 0)
+      scene->fps = (float) atof (args);
+    else if (strncmp (line, "FirstFrame ", 11) == 0)
+      scene->first_frame = atoi (args);
+    else if (strncmp (line, "LastFrame ", 10) == 0)
+      scene->last_frame = atoi (args);
+
+    // A new item
+    else if ((strncmp (line, "LoadObjectLayer ", 16) == 0) || (strncmp (line, "AddNullObject ", 14) == 0) ||
+             (strncmp (line, "AddBone", 7) == 0)) {
+      memset (new_item.rest_position, 0, sizeof(new_item.rest_position));
+      memset (new_item.rest_direction, 0, sizeof(new_item.rest_direction));
+      new_item.rest_length  = 0;
+      new_item.parent_id    = 0;
+      new_item.active       = true;
+      new_item.num_channels = 0;
+      new_item.bone         = (line[3] == 'B');
+      if (line[0] == 'L')
+        args = Skip_Word (args);            // layer number
+      new_item.id = (unsigned) strtoul (args, 0, 16);
+      new_item.name = Skip_Word (args);
+      if (new_item.bone && (new_item.id == 0))
+        new_item.id = 0x40000000 + ((unsigned) scene->items.size () << 16);
+      scene->items.push_back (new_item);
+      item = (int) scene->items.size () - 1;
+    }
+    else if ((strncmp (line, "AddLight", 8) == 0) || (strncmp (line, "AddCamera", 9) == 0))
+      item = -1;
+    else if (item == -1)
+      continue;
+
+    // Properties of the current item
+    else if (strncmp (line, "BoneName ", 9) == 0)
+      scene->items[item].name = args;
+    else if (strncmp (line, "BoneActive ", 11) == 0)
+      scene->items[item].active = (atoi (args) != 0);
+    else if (strncmp (line, "BoneRestPosition ", 17) == 0)
+      sscanf (args, "%f %f %f", &scene->items[item].rest_position[0], &scene->items[item].rest_position[1], &scene->items[item].rest_position[2]);
+    else if (strncmp (line, "BoneRestDirection ", 18) == 0)
+      sscanf (args, "%f %f %f", &scene->items[item].rest_direction[0], &scene->items[item].rest_direction[1], &scene->items[item].rest_direction[2]);
+    else if (strncmp (line, "BoneRestLength ", 15) == 0)
+      scene->items[item].rest_length = (float) atof (args);
+    else if (strncmp (line, "ParentItem ", 11) == 0)
+      scene->items[item].parent_id = (unsigned) strtoul (args, 0, 16);
+    else if (strncmp (line, "NumChannels ", 12) == 0) {
+      scene->items[item].num_channels = atoi (args);
+      if ((scene->items[item].num_channels < 0) || (scene->items[item].num_channels > LWS_MAX_CHANNELS))
+        return (false);
+    }
+    else if (strncmp (line, "Channel ", 8) == 0) {
+      channel = atoi (args);
+      if ((channel < 0) || (channel >= scene->items[item].num_channels) ||
+          (!Read_Envelope (&p, &scene->items[item].channels[channel])))
+        return (false);
+    }
+  }
+
+  return (true);
+}
+
+/*____________________________________________________________________
+|
+| Function: Lws_Evaluate
+|
+| Input: Called from ____
+| Output: Returns the value of an envelope at a time.  Before the first
+|   key and after the last, the value of that key.
+|___________________________________________________________________*/
+
+float Lws_Evaluate (const LwsEnvelope *envelope, float time)
+{
+  int i, n;
+  float a, b, d, t, t2, t3, h1, h2, h3, h4, out, in;
+  const LwsKey *k0, *k1, *prev, *next;
+
+  n = (int) envelope->keys.size ();
+  if (n == 0)
+    return (0);
+  if ((n == 1) || (time <= envelope->keys[0].time))
+    return (envelope->keys[0].value);
+  if (time >= envelope->keys[n-1].time)
+    return (envelope->keys[n-1].value);
+
+  // Find the span
+  for (i=1; (i < n-1) && (envelope->keys[i].time < time); i++)
+    ;
+  k0   = &envelope->keys[i-1];
+  k1   = &envelope->keys[i];
+  prev = (i > 1) ? &envelope->keys[i-2] : 0;
+  next = (i < n-1) ? &envelope->keys[i+1] : 0;
+  t    = (time - k0->time) / (k1->time - k0->time);
+
+  if (k1->shape == LWS_SHAPE_STEPPED)
+    return (k0->value);
+  if (k1->shape == LWS_SHAPE_LINEAR)
+    return (k0->value + (k1->value - k0->value) * t);
+
+  // Outgoing tangent of k0
+  a = (1 - k0->tension) * (1 + k0->continuity) * (1 + k0->bias);
+  b = (1 - k0->tension) * (1 - k0->continuity) * (1 - k0->bias);
+  d = k1->value - k0->value;
+  if (prev)
+    out = (k1->time - k0->time) / (k1->time - prev->time) * (a * (k0->value - prev->value) + b * d);
+  else
+    out = b * d;
+
+  // Incoming tangent of k1
+  a = (1 - k1->tension) * (1 - k1->continuity) * (1 + k1->bias);
+  b = (1 - k1->tension) * (1 + k1->continuity) * (1 - k1->bias);
+  if (next)
+    in = (k1->time - k0->time) / (next->time - k0->time) * (b * (next->value - k1->value) + a * d);
+  else
+    in = a * d;
+
+  // Hermite basis
+  t2 = t * t;
+  t3 = t * t2;
+  h2 = 3 * t2 - 2 * t3;
+  h1 = 1 - h2;
+  h4 = t3 - t2;
+  h3 = h4 - t2 + t;
+
+  return (h1 * k0->value + h2 * k1->value + h3 * out + h4 * in);
+}
+
+/*____________________________________________________________________
+|
+| Function: Read_Envelope
+|
+| Input: Called from Lws_Read()
+| Output: Reads an envelope block:
+|
+|     { Envelope
+|       num_keys
+|       Key value time shape tension continuity bias p4 p5 p6
+|       ...
+|       Behaviors pre post
+|     }
+|
+|   Returns true on success.
+|___________________________________________________________________*/
+
+static bool Read_Envelope (char **p, LwsEnvelope *envelope)
+{
+  int i, n;
+  char *line;
+  LwsKey key;
+
+  envelope->keys.clear ();
+
+  line = Next_Line (p);
+  if ((line == 0) || (strncmp (line, "{ Envelope", 10) != 0))
+    return (false);
+  line = Next_Line (p);
+  if (line == 0)
+    return (false);
+  n = atoi (line);
+  for (i=0; i<n; i++) {
+    line = Next_Line (p);
+    if ((line == 0) || (strncmp (line, "Key ", 4) != 0))
+      return (false);
+    key.tension = key.continuity = key.bias = 0;
+    if (sscanf (line + 4, "%f %f %d %f %f %f", &key.value, &key.time, &key.shape, &key.tension, &key.continuity, &key.bias) < 3)
+      return (false);
+    if ((i > 0) && (key.time <= envelope->keys[i-1].time))
+      return (false);
+    envelope->keys.push_back (key);
+  }
+
+  // Skip to the end of the block
+  while ((line = Next_Line (p)) != 0)
+    if (line[0] == '}')
+      return (true);
+
+  return (false);
+}
+
+/*____________________________________________________________________
+|
+| Function: Next_Line
+|
+| Input: Called from Lws_Read(), Read_Envelope()
+| Output: Returns the next line with leading white space skipped and the
+|   line end replaced by 0, or 0 at the end of the file.
+|___________________________________________________________________*/
+
+static char *Next_Line (char **p)
+{
+  char *line, *s;
+
+  if (**p == 0)
+    return (0);
+  line = *p;
+  for (s=line; *s && (*s != '\n') && (*s != '\r'); s++)
+    ;
+  *p = s;
+  while ((**p == '\n') || (**p == '\r'))
+    *(*p)++ = 0;
+  while ((*line == ' ') || (*line == '\t'))
+    line++;
+
+  return (line);
+}
+
+/*____________________________________________________________________
+|
+| Function: Skip_Word
+|
+| Input: Called from Lws_Read()
+| Output: Returns s after the first word and the spaces following it.
+|___________________________________________________________________*/
+
+static const char *Skip_Word (const char *s)
+{
+  while (*s && (*s != ' ') && (*s != '\t'))
+    s++;
+  while ((*s == ' ') || (*s == '\t'))
+    s++;
+
+  return (s);
+}
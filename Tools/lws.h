@@ -0,0 +1,81 @@
+/*____________________________________________________________________
+|
+| File: lws.h
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+#ifndef _LWS_H_
+#define _LWS_H_
+
+#include <string>
+#include <vector>
+
+/*___________________
+|
+| Constants
+|__________________*/
+
+// Motion channels of an item, in file order
+#define LWS_CHANNEL_POSITION_X 0
+#define LWS_CHANNEL_HEADING    3    // rotations are in radians
+#define LWS_CHANNEL_SCALE_X    6
+#define LWS_MAX_CHANNELS       9
+
+// Key shapes
+#define LWS_SHAPE_TCB     0
+#define LWS_SHAPE_HERMITE 1
+#define LWS_SHAPE_BEZIER  2
+#define LWS_SHAPE_LINEAR  3
+#define LWS_SHAPE_STEPPED 4
+
+/*___________________
+|
+| Type definitions
+|__________________*/
+
+struct LwsKey {
+  float value;
+  float time;                     // in seconds
+  int   shape;                    // shape of the curve from the previous key to this one
+  float tension, continuity, bias;
+};
+
+struct LwsEnvelope {
+  std::vector<LwsKey> keys;
+};
+
+// An object or bone.  Lights and cameras are skipped.
+struct LwsItem {
+  unsigned    id;                 // for example 0x10000000 for the first object, 0x40000000 for its first bone
+  unsigned    parent_id;          // 0 if none
+  bool        bone;
+  bool        active;
+  std::string name;
+  float       rest_position[3];
+  float       rest_direction[3];  // heading, pitch, bank in degrees
+  float       rest_length;
+  int         num_channels;
+  LwsEnvelope channels [LWS_MAX_CHANNELS];
+};
+
+struct LwsScene {
+  int                  first_frame;
+  int                  last_frame;
+  float                fps;
+  std::vector<LwsItem> items;
+};
+
+/*___________________
+|
+| Functions
+|__________________*/
+
+// Reads the items and motions of a LightWave scene file, returns true on success
+bool Lws_Read (const char *filename, LwsScene *scene);
+
+// Returns the value of an envelope at a time in seconds
+float Lws_Evaluate (const LwsEnvelope *envelope, float time);
+
+#endif
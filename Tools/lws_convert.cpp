@@ -0,0 +1,353 @@
+/*____________________________________________________________________
+|
+| File: lws_convert.cpp
+|
+| Description: Command line tool that converts the skeleton and bone
+|   motions of LightWave scenes to binary motion files (.gxa).  Samples
+|   every bone channel at the scene frame rate, converts rotations to
+|   quaternions and lets MotionFile_Write() quantize the tracks and drop
+|   the keys that interpolation reproduces within tolerance.  Reports
+|   file sizes, key counts, the largest error and parse/load times.
+|
+|   Usage: lws_convert [-f] [-p units] [-r degrees] file.lws ...
+|     -f  convert even if the .gxa file is current
+|     -p  position and scale tolerance (default 0.0005)
+|     -r  rotation tolerance (default 0.05)
+|
+|   Build: g++ -O2 -I../Application -o lws_convert lws_convert.cpp lws.cpp
+|            ../Application/motion_file.cpp ../Application/mesh_file.cpp
+|            ../Application/file_map.cpp
+|
+| Functions: main
+|             Convert
+|             Hpb_To_Quaternion
+|             Time_Ms
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+/*___________________
+|
+| Include Files
+|__________________*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "lws.h"
+#include "mesh_file.h"
+#include "motion_file.h"
+
+/*___________________
+|
+| Function Prototypes
+|__________________*/
+
+static bool   Convert (const char *filename, bool force);
+static void   Hpb_To_Quaternion (float heading, float pitch, float bank, float *q);
+static double Time_Ms (std::chrono::high_resolution_clock::time_point start);
+
+/*___________________
+|
+| Constants
+|__________________*/
+
+#define NUM_LOAD_TRIALS 20
+#define DEGREES_TO_RADIANS(_d_) ((_d_) * 3.14159265f / 180)
+#define RADIANS_TO_DEGREES(_r_) ((_r_) * 180 / 3.14159265f)
+
+/*___________________
+|
+| Global variables
+|__________________*/
+
+static float position_tolerance = 0.0005f;
+static float rotation_tolerance = 0.05f;    // degrees
+
+/*____________________________________________________________________
+|
+| Function: main
+|
+| Input: Called from the command line
+| Output: Converts each file on the command line.
+|___________________________________________________________________*/
+
+int main (int argc, char **argv)
+{
+  int i, errors = 0;
+  bool force = false;
+
+  if (argc < 2) {
+    fprintf (stderr, "usage: lws_convert [-f] [-p units] [-r degrees] file.lws ...\n");
+    return (1);
+  }
+  for (i=1; i<argc; i++) {
+    if (strcmp (argv[i], "-f") == 0)
+      force = true;
+    else if ((strcmp (argv[i], "-p") == 0) && (i+1 < argc))
+      position_tolerance = (float) atof (argv[++i]);
+    else if ((strcmp (argv[i], "-r") == 0) && (i+1 < argc))
+      rotation_tolerance = (float) atof (argv[++i]);
+    else if (! Convert (argv[i], force))
+      errors++;
+  }
+
+  return (errors ? 1 : 0);
+}
+
+/*____________________________________________________________________
+|
+| Function: Convert
+|
+| Input: Called from main()
+| Output: Converts one LWS file to a .gxa file in the same directory.
+|   Returns true on success.
+|___________________________________________________________________*/
+
+static bool Convert (const char *filename, bool force)
+{
+  int i, j, c, f, num_frames, num_source_keys;
+  unsigned source_size, parent;
+  bool moved;
+  std::string out;
+  size_t dot;
+  LwsScene scene;
+  std::vector<int> order, index;
+  std::vector<MotionFileBone> bones;
+  std::vector<float> samples;
+  MotionFileData data;
+  MotionFile motion;
+  float last_time, time, *s, position[3], rotation[4], scale[3], d, sign;
+  float error_position, error_rotation, error_scale;
+  double parse_ms, convert_ms, load_ms;
+  std::chrono::high_resolution_clock::time_point start;
+
+  out = filename;
+  dot = out.find_last_of (".");
+  if ((dot != std::string::npos) && (out.find_first_of ("/\\", dot) == std::string::npos))
+    out.erase (dot);
+  out += MOTION_FILE_EXTENSION;
+
+  if ((! force) && MotionFile_Is_Current (out.c_str (), filename)) {
+    printf ("%s: current\n", out.c_str ());
+    return (true);
+  }
+
+/*____________________________________________________________________
+|
+| Read the scene (timed, this is the work the game does at startup)
+|___________________________________________________________________*/
+
+  start = std::chrono::high_resolution_clock::now ();
+  for (i=0; i<NUM_LOAD_TRIALS; i++)
+    if (! Lws_Read (filename, &scene)) {
+      fprintf (stderr, "%s: can't read LWS file\n", filename);
+      return (false);
+    }
+  parse_ms = Time_Ms (start) / NUM_LOAD_TRIALS;
+
+/*____________________________________________________________________
+|
+| Build the bone table, parents before children
+|___________________________________________________________________*/
+
+  start = std::chrono::high_resolution_clock::now ();
+
+  for (i=0; i<(int)scene.items.size (); i++)
+    if (scene.items[i].bone)
+      order.push_back (i);
+  if (order.empty ()) {
+    fprintf (stderr, "%s: no bones\n", filename);
+    return (false);
+  }
+  // Move any bone listed before its parent to after it
+  do {
+    moved = false;
+    for (i=0; i<(int)order.size (); i++) {
+      parent = scene.items[order[i]].parent_id;
+      for (j=i+1; j<(int)order.size (); j++)
+        if (scene.items[order[j]].id == parent) {
+          order.insert (order.begin () + j + 1, order[i]);
+          order.erase (order.begin () + i);
+          moved = true;
+          break;
+        }
+    }
+  } while (moved);
+
+  index.assign (scene.items.size (), -1);
+  for (i=0; i<(int)order.size (); i++)
+    index[order[i]] = i;
+
+  bones.resize (order.size ());
+  for (i=0; i<(int)order.size (); i++) {
+    LwsItem *item = &scene.items[order[i]];
+    memset (&bones[i], 0, sizeof(MotionFileBone));
+    strncpy (bones[i].name, item->name.c_str (), MOTION_FILE_NAME_SIZE-1);
+    bones[i].parent = -1;
+    for (j=0; j<(int)scene.items.size (); j++)
+      if (scene.items[j].bone && (scene.items[j].id == item->parent_id))
+        bones[i].parent = index[j];
+    memcpy (bones[i].rest_position, item->rest_position, sizeof(bones[i].rest_position));
+    Hpb_To_Quaternion (DEGREES_TO_RADIANS (item->rest_direction[0]), DEGREES_TO_RADIANS (item->rest_direction[1]),
+                       DEGREES_TO_RADIANS (item->rest_direction[2]), bones[i].rest_rotation);
+    bones[i].rest_length = item->rest_length;
+  }
+
+/*____________________________________________________________________
+|
+| Sample every channel at every frame
+|___________________________________________________________________*/
+
+  last_time = 0;
+  num_source_keys = 0;
+  for (i=0; i<(int)order.size (); i++)
+    for (c=0; c<scene.items[order[i]].num_channels; c++) {
+      LwsEnvelope *envelope = &scene.items[order[i]].channels[c];
+      num_source_keys += (int) envelope->keys.size ();
+      if ((! envelope->keys.empty ()) && (envelope->keys.back ().time > last_time))
+        last_time = envelope->keys.back ().time;
+    }
+  num_frames = (int) floor (last_time * scene.fps + 0.5f) + 1;
+  if (num_frames > MOTION_FILE_MAX_FRAMES) {
+    fprintf (stderr, "%s: too many frames (%d)\n", filename, num_frames);
+    return (false);
+  }
+
+  samples.resize (order.size () * num_frames * MOTION_FILE_SAMPLE_SIZE);
+  for (i=0; i<(int)order.size (); i++) {
+    LwsItem *item = &scene.items[order[i]];
+    float channel[LWS_MAX_CHANNELS] = { 0, 0, 0, 0, 0, 0, 1, 1, 1 };
+    for (f=0; f<num_frames; f++) {
+      time = f / scene.fps;
+      for (c=0; c<item->num_channels; c++)
+        channel[c] = Lws_Evaluate (&item->channels[c], time);
+      s = &samples[(i * num_frames + f) * MOTION_FILE_SAMPLE_SIZE];
+      s[0] = channel[LWS_CHANNEL_POSITION_X];
+      s[1] = channel[LWS_CHANNEL_POSITION_X + 1];
+      s[2] = channel[LWS_CHANNEL_POSITION_X + 2];
+      Hpb_To_Quaternion (channel[LWS_CHANNEL_HEADING], channel[LWS_CHANNEL_HEADING + 1], channel[LWS_CHANNEL_HEADING + 2], &s[3]);
+      s[7] = channel[LWS_CHANNEL_SCALE_X];
+      s[8] = channel[LWS_CHANNEL_SCALE_X + 1];
+      s[9] = channel[LWS_CHANNEL_SCALE_X + 2];
+    }
+  }
+
+/*____________________________________________________________________
+|
+| Write the file
+|___________________________________________________________________*/
+
+  memset (&data, 0, sizeof(data));
+  MeshFile_Get_Source_Info (filename, &source_size, &data.source_time);
+  data.source_size        = source_size;
+  data.fps                = scene.fps;
+  data.num_frames         = num_frames;
+  data.num_bones          = (int) bones.size ();
+  data.bones              = &bones[0];
+  data.samples            = &samples[0];
+  data.position_tolerance = position_tolerance;
+  data.rotation_tolerance = DEGREES_TO_RADIANS (rotation_tolerance);
+  data.scale_tolerance    = position_tolerance;
+
+  if (! MotionFile_Write (out.c_str (), &data)) {
+    fprintf (stderr, "%s: can't write file\n", out.c_str ());
+    return (false);
+  }
+  convert_ms = Time_Ms (start);
+
+/*____________________________________________________________________
+|
+| Time loading it back and measure the error at every frame
+|___________________________________________________________________*/
+
+  start = std::chrono::high_resolution_clock::now ();
+  for (i=0; i<NUM_LOAD_TRIALS; i++) {
+    if (! MotionFile_Open (out.c_str (), &motion)) {
+      fprintf (stderr, "%s: can't load file just written\n", out.c_str ());
+      return (false);
+    }
+    MotionFile_Close (&motion);
+  }
+  load_ms = Time_Ms (start) / NUM_LOAD_TRIALS;
+
+  MotionFile_Open (out.c_str (), &motion);
+  error_position = error_rotation = error_scale = 0;
+  for (i=0; i<(int)bones.size (); i++)
+    for (f=0; f<num_frames; f++) {
+      MotionFile_Sample (&motion, i, (float) f, position, rotation, scale);
+      s = &samples[(i * num_frames + f) * MOTION_FILE_SAMPLE_SIZE];
+      d = (float) sqrt ((position[0] - s[0]) * (position[0] - s[0]) + (position[1] - s[1]) * (position[1] - s[1]) + (position[2] - s[2]) * (position[2] - s[2]));
+      if (d > error_position)
+        error_position = d;
+      // Angle from the chord between the quaternions
+      sign = ((rotation[0] * s[3] + rotation[1] * s[4] + rotation[2] * s[5] + rotation[3] * s[6]) < 0) ? -1.0f : 1.0f;
+      for (c=0, d=0; c<4; c++)
+        d += (rotation[c] - sign * s[3+c]) * (rotation[c] - sign * s[3+c]);
+      d = (float) sqrt (d) / 2;
+      d = RADIANS_TO_DEGREES (4 * (float) asin ((d < 1) ? d : 1));
+      if (d > error_rotation)
+        error_rotation = d;
+      for (c=0; c<3; c++)
+        if (fabs (scale[c] - s[7+c]) > error_scale)
+          error_scale = (float) fabs (scale[c] - s[7+c]);
+    }
+
+  printf ("%s: %d bones, %d frames at %g fps, lws %u bytes -> %u bytes (%.1f%%)\n",
+          out.c_str (), (int) bones.size (), num_frames, scene.fps, source_size, motion.header->file_size,
+          100.0 * motion.header->file_size / source_size);
+  printf ("  keys: %d in lws, %d sampled, %u stored\n",
+          num_source_keys, (int) bones.size () * num_frames * MOTION_TRACKS_PER_BONE, motion.header->num_keys);
+  printf ("  max error: position %.5f, rotation %.4f degrees, scale %.5f\n", error_position, error_rotation, error_scale);
+  printf ("  parse lws %.3f ms, convert %.2f ms, load gxa %.4f ms\n", parse_ms, convert_ms, load_ms);
+  MotionFile_Close (&motion);
+
+  return (true);
+}
+
+/*____________________________________________________________________
+|
+| Function: Hpb_To_Quaternion
+|
+| Input: Called from Convert()
+| Output: Converts a LightWave heading, pitch and bank (radians) to a
+|   quaternion x,y,z,w.  Bank (about z) is applied first, then pitch
+|   (about x), then heading (about y).
+|___________________________________________________________________*/
+
+static void Hpb_To_Quaternion (float heading, float pitch, float bank, float *q)
+{
+  float ch, sh, cp, sp, cb, sb;
+
+  ch = (float) cos (heading * 0.5f);
+  sh = (float) sin (heading * 0.5f);
+  cp = (float) cos (pitch * 0.5f);
+  sp = (float) sin (pitch * 0.5f);
+  cb = (float) cos (bank * 0.5f);
+  sb = (float) sin (bank * 0.5f);
+
+  // q = heading * pitch * bank
+  q[0] = ch * sp * cb + sh * cp * sb;
+  q[1] = sh * cp * cb - ch * sp * sb;
+  q[2] = ch * cp * sb - sh * sp * cb;
+  q[3] = ch * cp * cb + sh * sp * sb;
+}
+
+/*____________________________________________________________________
+|
+| Function: Time_Ms
+|
+| Input: Called from Convert()
+| Output: Returns milliseconds elapsed since start.
+|___________________________________________________________________*/
+
+static double Time_Ms (std::chrono::high_resolution_clock::time_point start)
+{
+  return (std::chrono::duration<double, std::milli> (std::chrono::high_resolution_clock::now () - start).count ());
+}
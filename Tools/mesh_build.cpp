@@ -0,0 +1,336 @@
+/*____________________________________________________________________
+|
+| File: mesh_build.cpp
+|
+| Description: Builds the vertices and triangles of a mesh file layer
+|   from an LWO2 layer - polygon triangulation, merging of duplicate
+|   vertices and smoothing of normals across discontinuous vertices.
+|   Used by mesh_convert to write .gxm files and by lwo2_check to make
+|   sure damaged files the reader accepts still convert.
+|
+| Functions: Mesh_Build_Layer
+|             Weld
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+/*___________________
+|
+| Include Files
+|__________________*/
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+#include "mesh_build.h"
+
+/*___________________
+|
+| Function Prototypes
+|__________________*/
+
+static void Weld (const void *items, unsigned item_size, unsigned num_items, std::vector<unsigned> *first);
+
+/*___________________
+|
+| Constants
+|__________________*/
+
+#define ID4(a,b,c,d) (((unsigned)(a)<<24) | ((unsigned)(b)<<16) | ((unsigned)(c)<<8) | (unsigned)(d))
+
+/*____________________________________________________________________
+|
+| Function: Mesh_Build_Layer
+|
+| Input: Called from ____
+| Output: Triangulates a layer, smooths normals and welds vertices,
+|   appending the results to vertices and indices.
+|___________________________________________________________________*/
+
+void Mesh_Build_Layer (Lwo2Layer *src, std::vector<std::string> *bones, MeshFileLayer *layer,
+                       std::vector<MeshBuildVertex> *vertices, std::vector<unsigned> *indices)
+{
+  unsigned i, j, k, n, num_points, num_polys, p0, p1, p2;
+  const unsigned *poly;
+  std::vector<unsigned> position, order, remap, triangles;
+  std::vector<float> point_normal, point_uv, corner_uv, point_weight;
+  std::vector<int> point_bone;
+  std::vector<MeshBuildVertex> corners;
+  std::vector<unsigned long long> vmad_key;
+  std::vector<unsigned long long>::iterator found;
+  const Lwo2VMap *uv_map;
+  float min[3], max[3], normal[3], *a, *b, *c, d, r;
+
+  num_points = (unsigned)(src->points.size () / 3);
+  num_polys  = (unsigned) Lwo2_Num_Polys (src);
+
+  memset (layer, 0, sizeof(MeshFileLayer));
+  strncpy (layer->name, src->name.c_str (), MESH_FILE_NAME_SIZE-1);
+  layer->parent       = src->parent;
+  layer->pivot[0]     = src->pivot[0];
+  layer->pivot[1]     = src->pivot[1];
+  layer->pivot[2]     = src->pivot[2];
+  layer->first_vertex = (unsigned) vertices->size ();
+  layer->first_index  = (unsigned) indices->size ();
+
+/*____________________________________________________________________
+|
+| Merge duplicate points - position[i] is the first point with the
+|   same coordinates as point i
+|___________________________________________________________________*/
+
+  Weld (num_points ? &src->points[0] : 0, 12, num_points, &position);
+
+/*____________________________________________________________________
+|
+| Smooth normals - sum face normals at each merged position
+|___________________________________________________________________*/
+
+  point_normal.assign (num_points * 3, 0);
+  for (i=0; i<num_polys; i++) {
+    poly = &src->poly_points[src->poly_start[i]];
+    n    = src->poly_start[i+1] - src->poly_start[i];
+    if (n < 3)
+      continue;
+    // Newell's method handles non-planar polygons (point indices were checked by Lwo2_Read)
+    normal[0] = normal[1] = normal[2] = 0;
+    for (j=0; j<n; j++) {
+      a = &src->points[poly[j]*3];
+      b = &src->points[poly[(j+1) % n]*3];
+      normal[0] += (a[1] - b[1]) * (a[2] + b[2]);
+      normal[1] += (a[2] - b[2]) * (a[0] + b[0]);
+      normal[2] += (a[0] - b[0]) * (a[1] + b[1]);
+    }
+    for (j=0; j<n; j++)
+      for (k=0; k<3; k++)
+        point_normal[position[poly[j]]*3+k] += normal[k];
+  }
+  for (i=0; i<num_points; i++) {
+    float *pn = &point_normal[position[i]*3];
+    d = (float) sqrt (pn[0]*pn[0] + pn[1]*pn[1] + pn[2]*pn[2]);
+    if (d > 0)
+      for (k=0; k<3; k++)
+        pn[k] /= d;
+  }
+
+/*____________________________________________________________________
+|
+| Texture coordinates from the first TXUV map, skin from WGHT maps
+|___________________________________________________________________*/
+
+  uv_map = 0;
+  for (i=0; i<src->vmaps.size (); i++)
+    if ((src->vmaps[i].type == ID4('T','X','U','V')) && (! src->vmaps[i].discontinuous)) {
+      uv_map = &src->vmaps[i];
+      break;
+    }
+  point_uv.assign (num_points * 2, 0);
+  if (uv_map)
+    for (i=0; i<uv_map->point.size (); i++)
+      if (uv_map->point[i] < num_points) {
+        point_uv[uv_map->point[i]*2]   = uv_map->values[i*2];
+        point_uv[uv_map->point[i]*2+1] = uv_map->values[i*2+1];
+      }
+
+  // Index the matching VMAD entries by polygon and point
+  if (uv_map)
+    for (i=0; i<src->vmaps.size (); i++) {
+      const Lwo2VMap *vmad = &src->vmaps[i];
+      if ((vmad->type != ID4('T','X','U','V')) || (! vmad->discontinuous) || (vmad->name != uv_map->name))
+        continue;
+      for (j=0; j<vmad->point.size (); j++) {
+        vmad_key.push_back (((unsigned long long) vmad->poly[j] << 32) | vmad->point[j]);
+        corner_uv.push_back (vmad->values[j*2]);
+        corner_uv.push_back (vmad->values[j*2+1]);
+      }
+    }
+  order.resize (vmad_key.size ());
+  for (i=0; i<order.size (); i++)
+    order[i] = i;
+  std::sort (order.begin (), order.end (), [&](unsigned x, unsigned y) { return (vmad_key[x] < vmad_key[y]); });
+  {
+    std::vector<unsigned long long> key (vmad_key.size ());
+    std::vector<float> uv (corner_uv.size ());
+    for (i=0; i<order.size (); i++) {
+      key[i]     = vmad_key[order[i]];
+      uv[i*2]    = corner_uv[order[i]*2];
+      uv[i*2+1]  = corner_uv[order[i]*2+1];
+    }
+    vmad_key.swap (key);
+    corner_uv.swap (uv);
+  }
+
+  point_bone.assign (num_points * 4, -1);
+  point_weight.assign (num_points * 4, 0);
+  for (i=0; i<src->vmaps.size (); i++) {
+    const Lwo2VMap *vmap = &src->vmaps[i];
+    int bone;
+    if ((vmap->type != ID4('W','G','H','T')) || vmap->discontinuous)
+      continue;
+    bone = (int)(std::find (bones->begin (), bones->end (), vmap->name) - bones->begin ());
+    if (bone == (int) bones->size ())
+      bones->push_back (vmap->name);
+    // Keep the 4 largest weights for each point
+    for (j=0; j<vmap->point.size (); j++) {
+      unsigned pt = vmap->point[j];
+      float w = vmap->values[j];
+      if ((pt >= num_points) || (w <= 0))
+        continue;
+      for (k=0; k<4; k++)
+        if ((point_bone[pt*4+k] < 0) || (w > point_weight[pt*4+k]))
+          break;
+      if (k == 4)
+        continue;
+      memmove (&point_bone[pt*4+k+1],   &point_bone[pt*4+k],   (3-k) * sizeof(int));
+      memmove (&point_weight[pt*4+k+1], &point_weight[pt*4+k], (3-k) * sizeof(float));
+      point_bone[pt*4+k]   = bone;
+      point_weight[pt*4+k] = w;
+    }
+  }
+
+/*____________________________________________________________________
+|
+| Build a vertex for each polygon corner
+|___________________________________________________________________*/
+
+  for (i=0; i<num_polys; i++) {
+    poly = &src->poly_points[src->poly_start[i]];
+    n    = src->poly_start[i+1] - src->poly_start[i];
+    if (n < 3)
+      continue;
+    for (j=0; j<n; j++) {
+      MeshBuildVertex v;
+      unsigned pt = poly[j];
+      memset (&v, 0, sizeof(v));
+      memcpy (v.vertex.position, &src->points[position[pt]*3], 12);
+      memcpy (v.vertex.normal, &point_normal[position[pt]*3], 12);
+      v.vertex.uv[0] = point_uv[pt*2];
+      v.vertex.uv[1] = point_uv[pt*2+1];
+      // A VMAD entry overrides the point's coordinates at this corner
+      found = std::lower_bound (vmad_key.begin (), vmad_key.end (), ((unsigned long long) i << 32) | pt);
+      if ((found != vmad_key.end ()) && (*found == (((unsigned long long) i << 32) | pt))) {
+        v.vertex.uv[0] = corner_uv[(found - vmad_key.begin ())*2];
+        v.vertex.uv[1] = corner_uv[(found - vmad_key.begin ())*2+1];
+      }
+      // LightWave v runs up, Direct3D v runs down
+      v.vertex.uv[1] = 1.0f - v.vertex.uv[1];
+      d = 0;
+      for (k=0; k<4; k++)
+        if (point_bone[pt*4+k] >= 0)
+          d += point_weight[pt*4+k];
+      for (k=0; k<4; k++)
+        if (point_bone[pt*4+k] >= 0) {
+          v.skin.bone[k]   = (unsigned char) point_bone[pt*4+k];
+          v.skin.weight[k] = point_weight[pt*4+k] / d;
+        }
+      corners.push_back (v);
+    }
+  }
+
+/*____________________________________________________________________
+|
+| Weld identical corners (vertices keep the order of first use) and
+|   triangulate
+|___________________________________________________________________*/
+
+  Weld (corners.empty () ? 0 : &corners[0], sizeof(MeshBuildVertex), (unsigned) corners.size (), &order);
+  remap.resize (corners.size ());
+  for (i=0; i<corners.size (); i++) {
+    if (order[i] == i) {
+      remap[i] = layer->num_vertices++;
+      vertices->push_back (corners[i]);
+    }
+    else
+      remap[i] = remap[order[i]];
+  }
+
+  for (i=0, k=0; i<num_polys; i++) {
+    poly = &src->poly_points[src->poly_start[i]];
+    n    = src->poly_start[i+1] - src->poly_start[i];
+    if (n < 3)
+      continue;
+    triangles.clear ();
+    Lwo2_Triangulate (&src->points[0], poly, (int) n, &triangles);
+    for (j=0; j<triangles.size (); j+=3) {
+      p0 = remap[k+triangles[j]];
+      p1 = remap[k+triangles[j+1]];
+      p2 = remap[k+triangles[j+2]];
+      if ((p0 == p1) || (p1 == p2) || (p0 == p2))
+        continue;
+      indices->push_back (p0);
+      indices->push_back (p1);
+      indices->push_back (p2);
+      layer->num_indices += 3;
+    }
+    k += n;
+  }
+
+/*____________________________________________________________________
+|
+| Bounding sphere
+|___________________________________________________________________*/
+
+  for (i=0; i<layer->num_vertices; i++) {
+    c = (*vertices)[layer->first_vertex+i].vertex.position;
+    for (k=0; k<3; k++) {
+      if ((i == 0) || (c[k] < min[k])) min[k] = c[k];
+      if ((i == 0) || (c[k] > max[k])) max[k] = c[k];
+    }
+  }
+  if (layer->num_vertices) {
+    for (k=0; k<3; k++)
+      layer->bound_sphere[k] = (min[k] + max[k]) / 2;
+    for (i=0, r=0; i<layer->num_vertices; i++) {
+      c = (*vertices)[layer->first_vertex+i].vertex.position;
+      d = (c[0]-layer->bound_sphere[0])*(c[0]-layer->bound_sphere[0]) +
+          (c[1]-layer->bound_sphere[1])*(c[1]-layer->bound_sphere[1]) +
+          (c[2]-layer->bound_sphere[2])*(c[2]-layer->bound_sphere[2]);
+      if (d > r)
+        r = d;
+    }
+    layer->bound_sphere[3] = (float) sqrt (r);
+  }
+}
+
+/*____________________________________________________________________
+|
+| Function: Weld
+|
+| Input: Called from Mesh_Build_Layer()
+| Output: Sets first[i] to the first item with the same bytes as item i
+|   (i itself if there is none before it).  Items are found with an
+|   open addressed hash table, so this takes time in proportion to the
+|   number of items.  item_size must be a multiple of 4.
+|___________________________________________________________________*/
+
+static void Weld (const void *items, unsigned item_size, unsigned num_items, std::vector<unsigned> *first)
+{
+  unsigned i, j, h, word, mask;
+  const unsigned char *item;
+  std::vector<unsigned> table;    // item index + 1, 0 = empty
+
+  first->resize (num_items);
+  for (mask=1; mask < num_items*2; mask<<=1)
+    ;
+  table.assign (mask, 0);
+  mask--;
+
+  for (i=0; i<num_items; i++) {
+    item = (const unsigned char *) items + i * item_size;
+    // FNV-1a over 4 byte words
+    h = 2166136261u;
+    for (j=0; j<item_size; j+=4) {
+      memcpy (&word, item + j, 4);
+      h = (h ^ word) * 16777619u;
+    }
+    h ^= h >> 15;
+    for (h&=mask; table[h]; h=(h+1)&mask)
+      if (memcmp ((const unsigned char *) items + (table[h]-1) * item_size, item, item_size) == 0)
+        break;
+    if (table[h] == 0)
+      table[h] = i + 1;
+    (*first)[i] = table[h] - 1;
+  }
+}
@@ -0,0 +1,43 @@
+/*____________________________________________________________________
+|
+| File: mesh_build.h
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+#ifndef _MESH_BUILD_H_
+#define _MESH_BUILD_H_
+
+#include <string>
+#include <vector>
+
+#include "lwo2.h"
+#include "mesh_file.h"
+
+/*___________________
+|
+| Type definitions
+|__________________*/
+
+// A vertex plus its skin, compared bytewise when welding
+struct MeshBuildVertex {
+  MeshFileVertex vertex;
+  MeshFileSkin   skin;
+};
+
+/*___________________
+|
+| Functions
+|__________________*/
+
+// Triangulates a layer, smooths normals and welds vertices, appending the results to vertices
+//   and indices.  Each weight map's name is added to bones the first time it's seen.
+void Mesh_Build_Layer (
+  Lwo2Layer                    *src,
+  std::vector<std::string>     *bones,
+  MeshFileLayer                *layer,     // filled in, parent is src's layer number
+  std::vector<MeshBuildVertex> *vertices,
+  std::vector<unsigned>        *indices );
+
+#endif
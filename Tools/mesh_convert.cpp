@@ -0,0 +1,227 @@
+/*____________________________________________________________________
+|
+| File: mesh_convert.cpp
+|
+| Description: Command line tool that converts LightWave LWO2 objects to
+|   preprocessed binary mesh files (.gxm).  Does the work the game used
+|   to do at every launch - polygon triangulation, merging of duplicate
+|   vertices and smoothing of normals across discontinuous vertices -
+|   and reports conversion and load times.  Polygons of any size are
+|   triangulated (by ear clipping), and duplicates are found with a hash
+|   table in one pass.  The conversion itself is in mesh_build.cpp.
+|
+|   Usage: mesh_convert [-f] file.lwo ...
+|     -f  convert even if the .gxm file is current
+|
+|   Build: g++ -O2 -I../Application -o mesh_convert mesh_convert.cpp lwo2.cpp
+|            mesh_build.cpp ../Application/mesh_file.cpp
+|            ../Application/file_map.cpp
+|
+| Functions: main
+|             Convert
+|             Time_Ms
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+/*___________________
+|
+| Include Files
+|__________________*/
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "mesh_build.h"
+
+/*___________________
+|
+| Function Prototypes
+|__________________*/
+
+static bool   Convert (const char *filename, bool force);
+static double Time_Ms (std::chrono::high_resolution_clock::time_point start);
+
+/*___________________
+|
+| Constants
+|__________________*/
+
+#define NUM_LOAD_TRIALS 100
+
+/*____________________________________________________________________
+|
+| Function: main
+|
+| Input: Called from the command line
+| Output: Converts each file on the command line.
+|___________________________________________________________________*/
+
+int main (int argc, char **argv)
+{
+  int i, errors = 0;
+  bool force = false;
+
+  if (argc < 2) {
+    fprintf (stderr, "usage: mesh_convert [-f] file.lwo ...\n");
+    return (1);
+  }
+  for (i=1; i<argc; i++) {
+    if (strcmp (argv[i], "-f") == 0)
+      force = true;
+    else if (! Convert (argv[i], force))
+      errors++;
+  }
+
+  return (errors ? 1 : 0);
+}
+
+/*____________________________________________________________________
+|
+| Function: Convert
+|
+| Input: Called from main()
+| Output: Converts one LWO2 file to a .gxm file in the same directory.
+|   Returns true on success.
+|___________________________________________________________________*/
+
+static bool Convert (const char *filename, bool force)
+{
+  int i;
+  std::string out;
+  size_t dot;
+  Lwo2Object object;
+  std::vector<MeshFileLayer> layers;
+  std::vector<MeshBuildVertex> welded;
+  std::vector<MeshFileVertex> vertices;
+  std::vector<MeshFileSkin> skin;
+  std::vector<unsigned> indices;
+  std::vector<std::string> bones;
+  std::vector<MeshFileName> bone_names;
+  MeshFileData data;
+  MeshFile mesh;
+  double read_ms, build_ms, write_ms, load_ms;
+  unsigned points, polys;
+  std::chrono::high_resolution_clock::time_point start;
+
+  out = filename;
+  dot = out.find_last_of (".");
+  if ((dot != std::string::npos) && (out.find_first_of ("/\\", dot) == std::string::npos))
+    out.erase (dot);
+  out += MESH_FILE_EXTENSION;
+
+  if ((! force) && MeshFile_Is_Current (out.c_str (), filename)) {
+    printf ("%s: current\n", out.c_str ());
+    return (true);
+  }
+
+/*____________________________________________________________________
+|
+| Read and convert
+|___________________________________________________________________*/
+
+  start = std::chrono::high_resolution_clock::now ();
+  if (! Lwo2_Read (filename, &object)) {
+    fprintf (stderr, "%s: can't read LWO2 file (%s)\n", filename, object.error.c_str ());
+    return (false);
+  }
+  read_ms = Time_Ms (start);
+
+  start = std::chrono::high_resolution_clock::now ();
+  points = 0;
+  polys  = 0;
+  layers.resize (object.layers.size ());
+  for (i=0; i<(int)object.layers.size (); i++) {
+    Mesh_Build_Layer (&object.layers[i], &bones, &layers[i], &welded, &indices);
+    points += (unsigned) object.layers[i].points.size () / 3;
+    polys  += (unsigned) Lwo2_Num_Polys (&object.layers[i]);
+  }
+  // Convert parent layer numbers to layer table indices
+  for (i=0; i<(int)layers.size (); i++) {
+    int j, parent = layers[i].parent;
+    layers[i].parent = -1;
+    for (j=0; j<(int)object.layers.size (); j++)
+      if (object.layers[j].number == parent)
+        layers[i].parent = j;
+  }
+  if (bones.size () > 256) {
+    fprintf (stderr, "%s: too many weight maps (%d)\n", filename, (int) bones.size ());
+    return (false);
+  }
+  vertices.resize (welded.size ());
+  skin.resize (welded.size ());
+  for (i=0; i<(int)welded.size (); i++) {
+    vertices[i] = welded[i].vertex;
+    skin[i]     = welded[i].skin;
+  }
+  bone_names.resize (bones.size ());
+  for (i=0; i<(int)bones.size (); i++) {
+    memset (&bone_names[i], 0, sizeof(MeshFileName));
+    strncpy (bone_names[i].name, bones[i].c_str (), MESH_FILE_NAME_SIZE-1);
+  }
+  build_ms = Time_Ms (start);
+
+/*____________________________________________________________________
+|
+| Write the file
+|___________________________________________________________________*/
+
+  memset (&data, 0, sizeof(data));
+  MeshFile_Get_Source_Info (filename, &data.source_size, &data.source_time);
+  data.num_layers   = (int) layers.size ();
+  data.layers       = layers.empty () ? 0 : &layers[0];
+  data.num_vertices = (int) vertices.size ();
+  data.vertices     = vertices.empty () ? 0 : &vertices[0];
+  data.skin         = (bones.empty () || skin.empty ()) ? 0 : &skin[0];
+  data.num_indices  = (int) indices.size ();
+  data.indices      = indices.empty () ? 0 : &indices[0];
+  data.num_bones    = (int) bone_names.size ();
+  data.bones        = bone_names.empty () ? 0 : &bone_names[0];
+
+  start = std::chrono::high_resolution_clock::now ();
+  if (! MeshFile_Write (out.c_str (), &data)) {
+    fprintf (stderr, "%s: can't write file\n", out.c_str ());
+    return (false);
+  }
+  write_ms = Time_Ms (start);
+
+/*____________________________________________________________________
+|
+| Time loading it back
+|___________________________________________________________________*/
+
+  start = std::chrono::high_resolution_clock::now ();
+  for (i=0; i<NUM_LOAD_TRIALS; i++) {
+    if (! MeshFile_Open (out.c_str (), &mesh)) {
+      fprintf (stderr, "%s: can't load file just written\n", out.c_str ());
+      return (false);
+    }
+    MeshFile_Close (&mesh);
+  }
+  load_ms = Time_Ms (start) / NUM_LOAD_TRIALS;
+
+  MeshFile_Open (out.c_str (), &mesh);
+  printf ("%s: %d layers, %u points, %u polygons -> %u vertices, %u triangles, %d bones, %u bytes\n",
+          out.c_str (), (int) layers.size (), points, polys, mesh.header->num_vertices, mesh.header->num_indices / 3, (int) bones.size (), mesh.header->file_size);
+  printf ("  read lwo %.2f ms, convert %.2f ms, write %.2f ms, load gxm %.4f ms\n", read_ms, build_ms, write_ms, load_ms);
+  MeshFile_Close (&mesh);
+
+  return (true);
+}
+
+/*____________________________________________________________________
+|
+| Function: Time_Ms
+|
+| Input: Called from Convert()
+| Output: Returns milliseconds elapsed since start.
+|___________________________________________________________________*/
+
+static double Time_Ms (std::chrono::high_resolution_clock::time_point start)
+{
+  return (std::chrono::duration<double, std::milli> (std::chrono::high_resolution_clock::now () - start).count ());
+}
@@ -0,0 +1,213 @@
+/*____________________________________________________________________
+|
+| File: pacer_bench.cpp
+|
+| Description: Command line tool that runs the frame pacer
+|   (Application/frame_pacer.cpp) over frames of simulated work and
+|   reports how evenly frames were shown and how much processor time
+|   the loop used, compared to a loop that isn't limited.
+|
+|   Each frame spins for the frame's work, varying by up to half of it
+|   from frame to frame, then "flips".  The runs are:
+|     unlimited  no limit, the way the game loop used to run
+|     paced      limited to the rate, flips return at once
+|     vsync      limited to the rate, flips wait for the next refresh
+|                of a simulated display, like a page flip with vsync
+|
+|   Frames are paced when they start, so with varying work the time
+|   between flips varies too.  A simulated flip spins through the last
+|   millisecond before the refresh, which counts as processor time.
+|
+|   Usage: pacer_bench [-r rate] [-v refresh] [-w work] [-n frames]
+|     -r  frames per second to limit to (default 60)
+|     -v  refresh rate of the simulated display (default 60)
+|     -w  milliseconds of work per frame (default 2)
+|     -n  frames per run (default 300)
+|
+|   Build: g++ -O2 -pthread -I../Application -o pacer_bench
+|            pacer_bench.cpp ../Application/frame_pacer.cpp
+|
+| Functions: main
+|             Run
+|             Flip
+|             Spin_Ms
+|             Time_Ms
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+/*___________________
+|
+| Include Files
+|__________________*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <chrono>
+#include <thread>
+
+#include "frame_pacer.h"
+
+/*___________________
+|
+| Constants
+|__________________*/
+
+#define RUN_UNLIMITED  0
+#define RUN_PACED      1
+#define RUN_VSYNC      2
+#define NUM_RUNS       3
+
+static const char *Run_Names [NUM_RUNS] = { "unlimited", "paced", "vsync" };
+
+/*___________________
+|
+| Function Prototypes
+|__________________*/
+
+static bool   Run (int run, int rate, int refresh, float work_ms, int num_frames);
+static void   Flip (int run, int refresh, std::chrono::high_resolution_clock::time_point start);
+static void   Spin_Ms (double ms);
+static double Time_Ms (std::chrono::high_resolution_clock::time_point start);
+
+/*____________________________________________________________________
+|
+| Function: main
+|
+| Input: Called from the command line
+| Output: Runs each pacing run and prints the results.  Returns 1 if
+|   a paced run's mean frame time is more than 1% from its target.
+|___________________________________________________________________*/
+
+int main (int argc, char **argv)
+{
+  int i, rate = 60, refresh = 60, num_frames = 300;
+  float work_ms = 2;
+  bool ok = true;
+
+  for (i=1; i<argc; i++) {
+    if ((strcmp (argv[i], "-r") == 0) && (i+1 < argc))
+      rate = atoi (argv[++i]);
+    else if ((strcmp (argv[i], "-v") == 0) && (i+1 < argc))
+      refresh = atoi (argv[++i]);
+    else if ((strcmp (argv[i], "-w") == 0) && (i+1 < argc))
+      work_ms = (float) atof (argv[++i]);
+    else if ((strcmp (argv[i], "-n") == 0) && (i+1 < argc))
+      num_frames = atoi (argv[++i]);
+  }
+  if ((rate < 1) || (refresh < 1) || (work_ms < 0) || (num_frames < 2)) {
+    fprintf (stderr, "usage: pacer_bench [-r rate] [-v refresh] [-w work] [-n frames]\n");
+    return (1);
+  }
+
+  printf ("%d frames of %.2f ms work, limited to %d fps, display at %d Hz:\n", num_frames, work_ms, rate, refresh);
+  for (i=0; i<NUM_RUNS; i++)
+    if (! Run (i, rate, refresh, work_ms, num_frames))
+      ok = false;
+
+  return (ok ? 0 : 1);
+}
+
+/*____________________________________________________________________
+|
+| Function: Run
+|
+| Input: Called from main()
+| Output: Runs the frames and prints the pacer's statistics with the
+|   share of the time the loop was using the processor.  Returns false
+|   if limited and the mean frame time is more than 1% from the target.
+|___________________________________________________________________*/
+
+static bool Run (int run, int rate, int refresh, float work_ms, int num_frames)
+{
+  int i;
+  double wall_ms, cpu_ms;
+  clock_t cpu_start;
+  FramePacerStats stats;
+  std::chrono::high_resolution_clock::time_point start;
+
+  srand (1);
+  Frame_Pacer_Init (refresh);
+  Frame_Pacer_Set_Rate (run == RUN_UNLIMITED ? 0 : rate);
+
+  start     = std::chrono::high_resolution_clock::now ();
+  cpu_start = clock ();
+  for (i=0; i<num_frames; i++) {
+    Frame_Pacer_Wait ();
+    Spin_Ms (work_ms * (0.5 + (double) rand () / RAND_MAX));
+    Frame_Pacer_Flip_Begin ();
+    Flip (run, refresh, start);
+    Frame_Pacer_Flip_End ();
+  }
+  cpu_ms  = (clock () - cpu_start) * 1000.0 / CLOCKS_PER_SEC;
+  wall_ms = Time_Ms (start);
+
+  if (! Frame_Pacer_Get_Stats (&stats))
+    return (false);
+  printf ("  %-9s target %6.2f ms  mean %6.2f ms  jitter %5.2f ms  max error %5.2f ms  wait %6.2f ms (%5.2f spinning)  cpu %5.1f%%%s\n",
+          Run_Names[run], stats.target_ms, stats.mean_ms, stats.jitter_ms, stats.max_error_ms, stats.wait_ms, stats.spin_ms,
+          100 * cpu_ms / wall_ms, stats.vsync ? "  vsync" : "");
+
+  if ((run != RUN_UNLIMITED) && ((stats.mean_ms < stats.target_ms * 0.99f) || (stats.mean_ms > stats.target_ms * 1.01f))) {
+    printf ("  %s: mean frame time is off the target\n", Run_Names[run]);
+    return (false);
+  }
+
+  return (true);
+}
+
+/*____________________________________________________________________
+|
+| Function: Flip
+|
+| Input: Called from Run()
+| Output: For a vsync run, waits for the simulated display's next
+|   refresh, sleeping and then spinning like a driver would.
+|___________________________________________________________________*/
+
+static void Flip (int run, int refresh, std::chrono::high_resolution_clock::time_point start)
+{
+  double now, next;
+
+  if (run == RUN_VSYNC) {
+    now  = Time_Ms (start);
+    next = ((int)(now * refresh / 1000) + 1) * 1000.0 / refresh;
+    if (next - now > 1)
+      std::this_thread::sleep_for (std::chrono::microseconds ((long long)((next - now - 1) * 1000)));
+    while (Time_Ms (start) < next)
+      ;
+  }
+}
+
+/*____________________________________________________________________
+|
+| Function: Spin_Ms
+|
+| Input: Called from Run()
+| Output: Keeps the processor busy for ms milliseconds, like a frame's
+|   update and rendering.
+|___________________________________________________________________*/
+
+static void Spin_Ms (double ms)
+{
+  std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now ();
+
+  while (Time_Ms (start) < ms)
+    ;
+}
+
+/*____________________________________________________________________
+|
+| Function: Time_Ms
+|
+| Input: Called from Run(), Flip(), Spin_Ms()
+| Output: Returns milliseconds elapsed since start.
+|___________________________________________________________________*/
+
+static double Time_Ms (std::chrono::high_resolution_clock::time_point start)
+{
+  return (std::chrono::duration<double, std::milli> (std::chrono::high_resolution_clock::now () - start).count ());
+}
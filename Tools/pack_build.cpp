@@ -0,0 +1,265 @@
+/*____________________________________________________________________
+|
+| File: pack_build.cpp
+|
+| Description: Command line tool that builds an asset pack (.pak) from
+|   files and directories (searched recursively).  Paths are stored as
+|   given on the command line, so run it from the game directory.  After
+|   writing, checks every entry against its file and benchmarks loading
+|   all files one by one against finding them in the mapped pack.
+|
+|   Usage: pack_build [-c] [-o file.pak] path ...
+|     -c  compress entries where that saves space
+|     -o  output file (default assets.pak)
+|
+|   Example: pack_build -c Objects wav
+|
+|   Build: g++ -O2 -I../Application -o pack_build pack_build.cpp
+|            ../Application/pack_file.cpp ../Application/file_map.cpp
+|
+| Functions: main
+|             Add_Path
+|             Read_File
+|             Time_Ms
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+/*___________________
+|
+| Include Files
+|__________________*/
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "pack_file.h"
+
+/*___________________
+|
+| Function Prototypes
+|__________________*/
+
+static void   Add_Path (const std::string &path, std::vector<std::string> *files);
+static bool   Read_File (const char *filename, std::vector<unsigned char> *bytes);
+static double Time_Ms (std::chrono::high_resolution_clock::time_point start);
+
+/*___________________
+|
+| Constants
+|__________________*/
+
+#define NUM_LOAD_TRIALS 10
+
+/*____________________________________________________________________
+|
+| Function: main
+|
+| Input: Called from the command line
+| Output: Builds a pack from the files on the command line.
+|___________________________________________________________________*/
+
+int main (int argc, char **argv)
+{
+  int i, t, num_compressed;
+  unsigned total_size, checksum;
+  bool compress = false;
+  const char *out = "assets" PACK_FILE_EXTENSION;
+  std::vector<std::string> files;
+  std::vector< std::vector<unsigned char> > contents;
+  std::vector<PackFileInput> inputs;
+  std::vector<unsigned char> buffer;
+  PackFile pack;
+  const PackFileEntry *entry;
+  double build_ms, loose_ms, find_ms, extract_ms;
+  std::chrono::high_resolution_clock::time_point start;
+
+  for (i=1; i<argc; i++) {
+    if (strcmp (argv[i], "-c") == 0)
+      compress = true;
+    else if ((strcmp (argv[i], "-o") == 0) && (i+1 < argc))
+      out = argv[++i];
+    else
+      Add_Path (argv[i], &files);
+  }
+  if (files.empty ()) {
+    fprintf (stderr, "usage: pack_build [-c] [-o file.pak] path ...\n");
+    return (1);
+  }
+  std::sort (files.begin (), files.end ());
+
+/*____________________________________________________________________
+|
+| Read the files and write the pack
+|___________________________________________________________________*/
+
+  start = std::chrono::high_resolution_clock::now ();
+  contents.resize (files.size ());
+  inputs.resize (files.size ());
+  total_size = 0;
+  for (i=0; i<(int)files.size (); i++) {
+    if (! Read_File (files[i].c_str (), &contents[i])) {
+      fprintf (stderr, "%s: can't read file\n", files[i].c_str ());
+      return (1);
+    }
+    inputs[i].path = files[i].c_str ();
+    inputs[i].data = contents[i].empty () ? 0 : &contents[i][0];
+    inputs[i].size = (unsigned) contents[i].size ();
+    total_size += inputs[i].size;
+  }
+  if (! PackFile_Write (out, &inputs[0], (int) inputs.size (), compress)) {
+    fprintf (stderr, "%s: can't write file (or two paths are the same)\n", out);
+    return (1);
+  }
+  build_ms = Time_Ms (start);
+
+/*____________________________________________________________________
+|
+| Check every entry
+|___________________________________________________________________*/
+
+  if (! PackFile_Open (out, &pack)) {
+    fprintf (stderr, "%s: can't load file just written\n", out);
+    return (1);
+  }
+  num_compressed = 0;
+  for (i=0; i<(int)files.size (); i++) {
+    entry = PackFile_Find (&pack, files[i].c_str ());
+    buffer.resize (contents[i].size () + 1);
+    if ((entry == 0) || (entry->size != contents[i].size ()) || (! PackFile_Extract (&pack, entry, &buffer[0])) ||
+        (memcmp (&buffer[0], inputs[i].data ? inputs[i].data : &buffer[0], entry->size) != 0)) {
+      fprintf (stderr, "%s: entry doesn't match file\n", files[i].c_str ());
+      return (1);
+    }
+    if (entry->flags & PACK_FILE_FLAG_COMPRESSED)
+      num_compressed++;
+  }
+  printf ("%s: %d files, %u bytes -> %u bytes, %d compressed, built in %.1f ms\n",
+          out, (int) files.size (), total_size, pack.header->file_size, num_compressed, build_ms);
+  PackFile_Close (&pack);
+
+/*____________________________________________________________________
+|
+| Benchmark: open and read each file, against map the pack once and
+| find each file (a pointer), or find and extract each file (a copy)
+|___________________________________________________________________*/
+
+  checksum = 0;
+  start = std::chrono::high_resolution_clock::now ();
+  for (t=0; t<NUM_LOAD_TRIALS; t++)
+    for (i=0; i<(int)files.size (); i++) {
+      Read_File (files[i].c_str (), &buffer);
+      checksum += (unsigned) buffer.size ();
+    }
+  loose_ms = Time_Ms (start) / NUM_LOAD_TRIALS;
+
+  start = std::chrono::high_resolution_clock::now ();
+  for (t=0; t<NUM_LOAD_TRIALS; t++) {
+    PackFile_Open (out, &pack);
+    for (i=0; i<(int)files.size (); i++) {
+      entry = PackFile_Find (&pack, files[i].c_str ());
+      checksum += *(const unsigned char *) PackFile_Data (&pack, entry);
+    }
+    PackFile_Close (&pack);
+  }
+  find_ms = Time_Ms (start) / NUM_LOAD_TRIALS;
+
+  start = std::chrono::high_resolution_clock::now ();
+  for (t=0; t<NUM_LOAD_TRIALS; t++) {
+    PackFile_Open (out, &pack);
+    for (i=0; i<(int)files.size (); i++) {
+      entry = PackFile_Find (&pack, files[i].c_str ());
+      buffer.resize (entry->size + 1);
+      PackFile_Extract (&pack, entry, &buffer[0]);
+      checksum += buffer[0];
+    }
+    PackFile_Close (&pack);
+  }
+  extract_ms = Time_Ms (start) / NUM_LOAD_TRIALS;
+
+  printf ("  load all: loose files %.2f ms, pack find %.3f ms, pack find + extract %.2f ms (checksum %u)\n",
+          loose_ms, find_ms, extract_ms, checksum);
+
+  return (0);
+}
+
+/*____________________________________________________________________
+|
+| Function: Add_Path
+|
+| Input: Called from main()
+| Output: Adds a file, or all files in a directory and its
+|   subdirectories, to the list.
+|___________________________________________________________________*/
+
+static void Add_Path (const std::string &path, std::vector<std::string> *files)
+{
+  struct stat st;
+  DIR *dir;
+  struct dirent *de;
+
+  if (stat (path.c_str (), &st) != 0) {
+    fprintf (stderr, "%s: not found\n", path.c_str ());
+    return;
+  }
+  if (! S_ISDIR (st.st_mode)) {
+    files->push_back (path);
+    return;
+  }
+  dir = opendir (path.c_str ());
+  if (dir) {
+    while ((de = readdir (dir)) != 0)
+      if ((strcmp (de->d_name, ".") != 0) && (strcmp (de->d_name, "..") != 0))
+        Add_Path (path + "/" + de->d_name, files);
+    closedir (dir);
+  }
+}
+
+/*____________________________________________________________________
+|
+| Function: Read_File
+|
+| Input: Called from main()
+| Output: Reads an entire file.  Returns true on success.
+|___________________________________________________________________*/
+
+static bool Read_File (const char *filename, std::vector<unsigned char> *bytes)
+{
+  FILE *fp;
+  long size;
+  bool ok;
+
+  fp = fopen (filename, "rb");
+  if (fp == 0)
+    return (false);
+  fseek (fp, 0, SEEK_END);
+  size = ftell (fp);
+  fseek (fp, 0, SEEK_SET);
+  bytes->resize (size);
+  ok = (size == 0) || (fread (&(*bytes)[0], size, 1, fp) == 1);
+  fclose (fp);
+
+  return (ok);
+}
+
+/*____________________________________________________________________
+|
+| Function: Time_Ms
+|
+| Input: Called from main()
+| Output: Returns milliseconds elapsed since start.
+|___________________________________________________________________*/
+
+static double Time_Ms (std::chrono::high_resolution_clock::time_point start)
+{
+  return (std::chrono::duration<double, std::milli> (std::chrono::high_resolution_clock::now () - start).count ());
+}
@@ -0,0 +1,236 @@
+/*____________________________________________________________________
+|
+| File: radix_bench.cpp
+|
+| Description: Command line tool that checks the radix sort
+|   (Application/radix_sort.cpp) and times it sorting random 16-bit
+|   depth keys, the way particle system draws are sorted each frame,
+|   against std::stable_sort of the same entries.
+|
+|   The checks sort the entries and make sure the keys come out in
+|   ascending order and that entries with the same key keep the order
+|   they were added in (their index payload still ascends).
+|
+|   The sort is timed twice: warm, with the entries and scratch array
+|   already in the cache from the last trial, and cold, after writing
+|   a buffer bigger than the processor's L2 cache so both come from
+|   further away, the way they would after the rest of a frame's work.
+|
+|   Usage: radix_bench [-n entries]
+|     -n  entries to sort (default 100000)
+|
+|   Build: g++ -O2 -I../Application -o radix_bench radix_bench.cpp
+|            ../Application/radix_sort.cpp
+|
+| Functions: main
+|             Time_Radix_Sort
+|             Fill
+|             Check
+|             Compare_Keys
+|             Time_Ms
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+/*___________________
+|
+| Include Files
+|__________________*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+
+#include "radix_sort.h"
+
+/*___________________
+|
+| Constants
+|__________________*/
+
+#define NUM_TRIALS  100
+#define EVICT_SIZE  (16 << 20)    // bytes written between cold trials
+
+/*___________________
+|
+| Function Prototypes
+|__________________*/
+
+static double Time_Radix_Sort (RadixSortEntry *input, RadixSortEntry *entries, RadixSortEntry *scratch, int num, char *evict);
+static void   Fill (RadixSortEntry *entries, int num);
+static bool   Check (RadixSortEntry *entries, int num);
+static bool   Compare_Keys (const RadixSortEntry &a, const RadixSortEntry &b);
+static double Time_Ms (std::chrono::high_resolution_clock::time_point start);
+
+/*____________________________________________________________________
+|
+| Function: main
+|
+| Input: Called from the command line
+| Output: Runs the checks, then prints the best time of each sort.
+|   Returns 1 if a check fails.
+|___________________________________________________________________*/
+
+int main (int argc, char **argv)
+{
+  int i, trial, num = 100000;
+  double ms, warm, cold, best_std = 1e30;
+  char *evict;
+  RadixSortEntry *input, *entries, *scratch;
+  std::chrono::high_resolution_clock::time_point start;
+
+  for (i=1; i<argc; i++) {
+    if ((strcmp (argv[i], "-n") == 0) && (i+1 < argc))
+      num = atoi (argv[++i]);
+  }
+  if (num < 1) {
+    fprintf (stderr, "usage: radix_bench [-n entries]\n");
+    return (1);
+  }
+
+  input   = (RadixSortEntry *) malloc (num * sizeof(RadixSortEntry));
+  entries = (RadixSortEntry *) malloc (num * sizeof(RadixSortEntry));
+  scratch = (RadixSortEntry *) malloc (num * sizeof(RadixSortEntry));
+  evict   = (char *) malloc (EVICT_SIZE);
+  if ((input == 0) || (entries == 0) || (scratch == 0) || (evict == 0))
+    return (1);
+  // Touch every page before timing, like the particle queue's arrays that are reused every frame
+  memset (scratch, 0, num * sizeof(RadixSortEntry));
+
+  srand (1);
+  Fill (input, num);
+
+  memcpy (entries, input, num * sizeof(RadixSortEntry));
+  Radix_Sort (entries, scratch, num);
+  if (! Check (entries, num))
+    return (1);
+  printf ("checks passed\n");
+
+  warm = Time_Radix_Sort (input, entries, scratch, num, 0);
+  cold = Time_Radix_Sort (input, entries, scratch, num, evict);
+  for (trial=0; trial<NUM_TRIALS; trial++) {
+    memcpy (entries, input, num * sizeof(RadixSortEntry));
+    start = std::chrono::high_resolution_clock::now ();
+    std::stable_sort (entries, entries + num, Compare_Keys);
+    ms = Time_Ms (start);
+    if (ms < best_std)
+      best_std = ms;
+  }
+
+  printf ("%d entries with 16-bit keys (best of %d):\n", num, NUM_TRIALS);
+  printf ("  Radix_Sort warm   %8.3f ms\n", warm);
+  printf ("  Radix_Sort cold   %8.3f ms\n", cold);
+  printf ("  std::stable_sort  %8.3f ms  %5.1fx warm radix\n", best_std, best_std / warm);
+
+  free (input);
+  free (entries);
+  free (scratch);
+  free (evict);
+
+  return (0);
+}
+
+/*____________________________________________________________________
+|
+| Function: Time_Radix_Sort
+|
+| Input: Called from main()
+| Output: Returns the best time to sort a copy of input.  If evict
+|   isn't 0, it's written before each trial to push the arrays out of
+|   the cache.
+|___________________________________________________________________*/
+
+static double Time_Radix_Sort (RadixSortEntry *input, RadixSortEntry *entries, RadixSortEntry *scratch, int num, char *evict)
+{
+  int trial;
+  double ms, best = 1e30;
+  std::chrono::high_resolution_clock::time_point start;
+
+  for (trial=0; trial<NUM_TRIALS; trial++) {
+    memcpy (entries, input, num * sizeof(RadixSortEntry));
+    if (evict)
+      memset (evict, trial, EVICT_SIZE);
+    start = std::chrono::high_resolution_clock::now ();
+    Radix_Sort (entries, scratch, num);
+    ms = Time_Ms (start);
+    if (ms < best)
+      best = ms;
+  }
+
+  return (best);
+}
+
+/*____________________________________________________________________
+|
+| Function: Fill
+|
+| Input: Called from main()
+| Output: Fills entries with depth keys of random depths and indices
+|   in the order they were added.
+|___________________________________________________________________*/
+
+static void Fill (RadixSortEntry *entries, int num)
+{
+  int i;
+
+  for (i=0; i<num; i++) {
+    entries[i].key   = Radix_Sort_Depth_Key ((float) rand () / RAND_MAX * 1000, 0, 1000);
+    entries[i].index = i;
+  }
+}
+
+/*____________________________________________________________________
+|
+| Function: Check
+|
+| Input: Called from main()
+| Output: Returns true if keys ascend and entries with the same key are
+|   still in the order they were added.
+|___________________________________________________________________*/
+
+static bool Check (RadixSortEntry *entries, int num)
+{
+  int i;
+
+  for (i=1; i<num; i++) {
+    if (entries[i].key < entries[i-1].key) {
+      printf ("entry %d: key %u after %u, not in order\n", i, entries[i].key, entries[i-1].key);
+      return (false);
+    }
+    if ((entries[i].key == entries[i-1].key) && (entries[i].index < entries[i-1].index)) {
+      printf ("entry %d: index %u after %u with the same key, not stable\n", i, entries[i].index, entries[i-1].index);
+      return (false);
+    }
+  }
+
+  return (true);
+}
+
+/*____________________________________________________________________
+|
+| Function: Compare_Keys
+|
+| Input: Called from std::stable_sort()
+| Output: Returns true if a's key is less than b's.
+|___________________________________________________________________*/
+
+static bool Compare_Keys (const RadixSortEntry &a, const RadixSortEntry &b)
+{
+  return (a.key < b.key);
+}
+
+/*____________________________________________________________________
+|
+| Function: Time_Ms
+|
+| Input: Called from main(), Time_Radix_Sort()
+| Output: Returns milliseconds elapsed since start.
+|___________________________________________________________________*/
+
+static double Time_Ms (std::chrono::high_resolution_clock::time_point start)
+{
+  return (std::chrono::duration<double, std::milli> (std::chrono::high_resolution_clock::now () - start).count ());
+}
@@ -0,0 +1,283 @@
+/*____________________________________________________________________
+|
+| File: skin_bench.cpp
+|
+| Description: Command line tool that benchmarks the CPU skinning
+|   kernels on a skinned mesh file (.gxm, see mesh_convert) and on the
+|   same mesh repeated 10 times.  Each kernel is timed skinning every
+|   vertex with random bone matrices and checked against the scalar
+|   kernel.  For comparison, a plain loop over the mesh file's
+|   interleaved vertices is timed too, then the fastest kernel is timed
+|   on more threads.
+|
+|   Usage: skin_bench [-t threads] file.gxm
+|     -t  threads for the threaded test (default 4)
+|
+|   Example: skin_bench ../Objects/tifa.gxm
+|
+|   Build: g++ -O2 -pthread -I../Application -o skin_bench skin_bench.cpp
+|            ../Application/skin.cpp ../Application/mesh_file.cpp
+|            ../Application/file_map.cpp
+|
+| Functions: main
+|             Bench_Mesh
+|             Skin_Interleaved
+|             Max_Difference
+|             Random_Bones
+|             Time_Ms
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+/*___________________
+|
+| Include Files
+|__________________*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+
+#include "mesh_file.h"
+#include "skin.h"
+
+/*___________________
+|
+| Function Prototypes
+|__________________*/
+
+static void   Bench_Mesh (const MeshFileVertex *vertices, const MeshFileSkin *skin, int num_vertices, int num_bones, int num_threads);
+static void   Skin_Interleaved (const MeshFileVertex *vertices, const MeshFileSkin *skin, int num_vertices,
+                                const SkinMatrix *bones, MeshFileVertex *out);
+static float  Max_Difference (const SkinStreams *a, const SkinStreams *b, int num_vertices);
+static void   Random_Bones (SkinMatrix *bones, int num_bones);
+static double Time_Ms (std::chrono::high_resolution_clock::time_point start);
+
+/*___________________
+|
+| Constants
+|__________________*/
+
+#define NUM_TRIALS   200
+#define MESH_REPEATS 10
+
+static const char *kernel_names[] = { "scalar", "sse", "avx2" };
+
+/*____________________________________________________________________
+|
+| Function: main
+|
+| Input: Called from the command line
+| Output: Benchmarks the mesh file on the command line.
+|___________________________________________________________________*/
+
+int main (int argc, char **argv)
+{
+  int i, num_threads = 4;
+  const char *filename = 0;
+  MeshFile mesh;
+  std::vector<MeshFileVertex> vertices;
+  std::vector<MeshFileSkin> skin;
+  unsigned n;
+
+  for (i=1; i<argc; i++) {
+    if ((strcmp (argv[i], "-t") == 0) && (i+1 < argc))
+      num_threads = atoi (argv[++i]);
+    else
+      filename = argv[i];
+  }
+  if (filename == 0) {
+    fprintf (stderr, "usage: skin_bench [-t threads] file.gxm\n");
+    return (1);
+  }
+  if (! MeshFile_Open (filename, &mesh)) {
+    fprintf (stderr, "%s: can't open mesh file\n", filename);
+    return (1);
+  }
+  if ((mesh.skin == 0) || (mesh.header->num_bones == 0)) {
+    fprintf (stderr, "%s: mesh has no skin\n", filename);
+    MeshFile_Close (&mesh);
+    return (1);
+  }
+
+  n = mesh.header->num_vertices;
+  printf ("%s: %u vertices, %u bones, best kernel %s\n", filename, n, mesh.header->num_bones, kernel_names[Skin_Get_Kernel ()]);
+  Bench_Mesh (mesh.vertices, mesh.skin, (int) n, (int) mesh.header->num_bones, num_threads);
+
+  // A mesh MESH_REPEATS times the size
+  for (i=0; i<MESH_REPEATS; i++) {
+    vertices.insert (vertices.end (), mesh.vertices, mesh.vertices + n);
+    skin.insert (skin.end (), mesh.skin, mesh.skin + n);
+  }
+  Bench_Mesh (&vertices[0], &skin[0], (int) vertices.size (), (int) mesh.header->num_bones, num_threads);
+
+  MeshFile_Close (&mesh);
+  return (0);
+}
+
+/*____________________________________________________________________
+|
+| Function: Bench_Mesh
+|
+| Input: Called from main()
+| Output: Times and checks each kernel on a mesh.
+|___________________________________________________________________*/
+
+static void Bench_Mesh (const MeshFileVertex *vertices, const MeshFileSkin *skin, int num_vertices, int num_bones, int num_threads)
+{
+  int i, k, best;
+  double ms;
+  float diff;
+  SkinMesh mesh;
+  SkinStreams reference, out;
+  std::vector<SkinMatrix> bones (num_bones);
+  std::vector<MeshFileVertex> interleaved (num_vertices);
+  std::chrono::high_resolution_clock::time_point start;
+
+  if (! Skin_Init_Mesh (&mesh, vertices, skin, num_vertices, num_bones)) {
+    fprintf (stderr, "can't build mesh\n");
+    return;
+  }
+  Skin_Init_Output (&reference, &mesh);
+  Skin_Init_Output (&out, &mesh);
+  Random_Bones (&bones[0], num_bones);
+  printf ("  %d vertices:\n", num_vertices);
+
+  start = std::chrono::high_resolution_clock::now ();
+  for (i=0; i<NUM_TRIALS; i++)
+    Skin_Interleaved (vertices, skin, num_vertices, &bones[0], &interleaved[0]);
+  ms = Time_Ms (start) / NUM_TRIALS;
+  printf ("    %-12s %8.4f ms  %7.1f M vertices/s\n", "interleaved", ms, num_vertices / (ms * 1000));
+
+  best = Skin_Get_Kernel ();
+  Skin_Set_Kernel (SKIN_KERNEL_SCALAR);
+  Skin_Mesh (&mesh, &bones[0], &reference, 1);
+  for (k=SKIN_KERNEL_SCALAR; k<=best; k++) {
+    Skin_Set_Kernel (k);
+    start = std::chrono::high_resolution_clock::now ();
+    for (i=0; i<NUM_TRIALS; i++)
+      Skin_Mesh (&mesh, &bones[0], &out, 1);
+    ms = Time_Ms (start) / NUM_TRIALS;
+    diff = Max_Difference (&reference, &out, num_vertices);
+    printf ("    %-12s %8.4f ms  %7.1f M vertices/s  max difference from scalar %g\n",
+            kernel_names[k], ms, num_vertices / (ms * 1000), diff);
+  }
+
+  if (num_threads > 1) {
+    start = std::chrono::high_resolution_clock::now ();
+    for (i=0; i<NUM_TRIALS; i++)
+      Skin_Mesh (&mesh, &bones[0], &out, num_threads);
+    ms = Time_Ms (start) / NUM_TRIALS;
+    diff = Max_Difference (&reference, &out, num_vertices);
+    printf ("    %-4s x%-7d %8.4f ms  %7.1f M vertices/s  max difference from scalar %g\n",
+            kernel_names[best], num_threads, ms, num_vertices / (ms * 1000), diff);
+  }
+
+  Skin_Free_Output (&reference);
+  Skin_Free_Output (&out);
+  Skin_Free_Mesh (&mesh);
+}
+
+/*____________________________________________________________________
+|
+| Function: Skin_Interleaved
+|
+| Input: Called from Bench_Mesh()
+| Output: Skins interleaved vertices one at a time, for comparison.
+|___________________________________________________________________*/
+
+static void Skin_Interleaved (const MeshFileVertex *vertices, const MeshFileSkin *skin, int num_vertices,
+                              const SkinMatrix *bones, MeshFileVertex *out)
+{
+  int i, j, k;
+  float w;
+  const float *p, *n;
+  const SkinMatrix *m;
+
+  for (i=0; i<num_vertices; i++) {
+    p = vertices[i].position;
+    n = vertices[i].normal;
+    memset (out[i].position, 0, sizeof(out[i].position));
+    memset (out[i].normal, 0, sizeof(out[i].normal));
+    for (k=0; k<SKIN_MAX_INFLUENCES; k++) {
+      w = skin[i].weight[k];
+      if (w == 0)
+        continue;
+      m = &bones[skin[i].bone[k]];
+      for (j=0; j<3; j++) {
+        out[i].position[j] += w * (p[0]*m->m[0][j] + p[1]*m->m[1][j] + p[2]*m->m[2][j] + m->m[3][j]);
+        out[i].normal[j]   += w * (n[0]*m->m[0][j] + n[1]*m->m[1][j] + n[2]*m->m[2][j]);
+      }
+    }
+    out[i].uv[0] = vertices[i].uv[0];
+    out[i].uv[1] = vertices[i].uv[1];
+  }
+}
+
+/*____________________________________________________________________
+|
+| Function: Max_Difference
+|
+| Input: Called from Bench_Mesh()
+| Output: Returns the largest difference between two outputs.
+|___________________________________________________________________*/
+
+static float Max_Difference (const SkinStreams *a, const SkinStreams *b, int num_vertices)
+{
+  int i, j;
+  float diff = 0;
+  const float *sa[6] = { a->x, a->y, a->z, a->nx, a->ny, a->nz };
+  const float *sb[6] = { b->x, b->y, b->z, b->nx, b->ny, b->nz };
+
+  for (j=0; j<6; j++)
+    for (i=0; i<num_vertices; i++)
+      if (fabsf (sa[j][i] - sb[j][i]) > diff)
+        diff = fabsf (sa[j][i] - sb[j][i]);
+
+  return (diff);
+}
+
+/*____________________________________________________________________
+|
+| Function: Random_Bones
+|
+| Input: Called from Bench_Mesh()
+| Output: Sets bones to random rotations about y plus translations.
+|___________________________________________________________________*/
+
+static void Random_Bones (SkinMatrix *bones, int num_bones)
+{
+  int i;
+  float a;
+
+  srand (1);
+  for (i=0; i<num_bones; i++) {
+    memset (&bones[i], 0, sizeof(SkinMatrix));
+    a = (float) rand () / RAND_MAX * 6.2831853f;
+    bones[i].m[0][0] =  cosf (a);
+    bones[i].m[0][2] = -sinf (a);
+    bones[i].m[1][1] =  1;
+    bones[i].m[2][0] =  sinf (a);
+    bones[i].m[2][2] =  cosf (a);
+    bones[i].m[3][0] = (float) rand () / RAND_MAX - 0.5f;
+    bones[i].m[3][1] = (float) rand () / RAND_MAX - 0.5f;
+    bones[i].m[3][2] = (float) rand () / RAND_MAX - 0.5f;
+  }
+}
+
+/*____________________________________________________________________
+|
+| Function: Time_Ms
+|
+| Input: Called from Bench_Mesh()
+| Output: Returns milliseconds elapsed since start.
+|___________________________________________________________________*/
+
+static double Time_Ms (std::chrono::high_resolution_clock::time_point start)
+{
+  return (std::chrono::duration<double, std::milli> (std::chrono::high_resolution_clock::now () - start).count ());
+}
@@ -0,0 +1,342 @@
+/*____________________________________________________________________
+|
+| File: spsc_bench.cpp
+|
+| Description: Command line tool that stress tests the lock-free event
+|   ring (Framework/spsc_ring.cpp) and benchmarks it against the queue
+|   it replaced: a ring of the same size behind one lock, taken by both
+|   the producer and the consumer the way the event queue's critical
+|   section was.
+|
+|   The stress test pushes numbered entries the size of an event from a
+|   producer thread while the consumer pops them, every so often
+|   flushing one type of entry like EventQueue_Flush() does.  It checks
+|   that entries arrive in order, undamaged, and that no entry of a type
+|   that wasn't flushed is lost.  The ring is kept small so the producer
+|   often finds it full and both sides wrap many times.
+|
+|   Both sides yield when they can't make progress, so on a single core
+|   the times mostly measure thread switches rather than the queues.
+|
+|   Usage: spsc_bench [-n entries]
+|     -n  entries per trial (default 2000000)
+|
+|   Build: g++ -O2 -pthread -I../Framework -o spsc_bench spsc_bench.cpp
+|            ../Framework/spsc_ring.cpp
+|
+| Functions: main
+|             Stress
+|             Run_Ring
+|             Run_Locked
+|             Is_Flush_Type
+|             Make_Entry
+|             Time_Ms
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+/*___________________
+|
+| Include Files
+|__________________*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+#include "spsc_ring.h"
+
+/*___________________
+|
+| Constants
+|__________________*/
+
+#define NUM_TRIALS        5
+#define RING_SIZE         512     // same as the event queue
+#define STRESS_RING_SIZE  16
+#define NUM_TYPES         4
+#define FLUSH_TYPE        3       // type flushed by the stress test
+#define FLUSH_EVERY       1000    // pops between flushes
+
+/*___________________
+|
+| Type definitions
+|__________________*/
+
+// About the size of an event queue entry
+typedef struct {
+  unsigned type;
+  unsigned seq;
+  int      x, y;
+  unsigned check;
+} Entry;
+
+// The queue the ring replaced
+typedef struct {
+  std::mutex mutex;
+  Entry      entries [RING_SIZE];
+  unsigned   head, tail;
+} LockedQueue;
+
+/*___________________
+|
+| Function Prototypes
+|__________________*/
+
+static bool   Stress (unsigned num_entries);
+static double Run_Ring (unsigned num_entries);
+static double Run_Locked (unsigned num_entries);
+static int    Is_Flush_Type (void *entry, void *data);
+static void   Make_Entry (Entry *entry, unsigned seq);
+static double Time_Ms (std::chrono::high_resolution_clock::time_point start);
+
+/*____________________________________________________________________
+|
+| Function: main
+|
+| Input: Called from the command line
+| Output: Runs the stress test, then times both queues.  Returns 1 if
+|   the stress test fails.
+|___________________________________________________________________*/
+
+int main (int argc, char **argv)
+{
+  int i, t;
+  unsigned num_entries = 2000000;
+  double ms, best_ring = 0, best_locked = 0;
+
+  for (i=1; i<argc; i++)
+    if ((strcmp (argv[i], "-n") == 0) && (i+1 < argc))
+      num_entries = (unsigned) atoi (argv[++i]);
+  if (num_entries < 1) {
+    fprintf (stderr, "usage: spsc_bench [-n entries]\n");
+    return (1);
+  }
+
+  if (! Stress (num_entries))
+    return (1);
+
+  for (t=0; t<NUM_TRIALS; t++) {
+    ms = Run_Ring (num_entries);
+    if ((t == 0) || (ms < best_ring))
+      best_ring = ms;
+    ms = Run_Locked (num_entries);
+    if ((t == 0) || (ms < best_locked))
+      best_locked = ms;
+  }
+
+  printf ("%u entries through a %d entry queue, producer and consumer threads (best of %d):\n", num_entries, RING_SIZE, NUM_TRIALS);
+  printf ("  %-8s %9.3f ms  %6.1f ns per entry\n", "locked", best_locked, best_locked * 1e6 / num_entries);
+  printf ("  %-8s %9.3f ms  %6.1f ns per entry\n", "ring", best_ring, best_ring * 1e6 / num_entries);
+
+  return (0);
+}
+
+/*____________________________________________________________________
+|
+| Function: Stress
+|
+| Input: Called from main()
+| Output: Returns true if every entry arrived in order and undamaged,
+|   with only flushed entries missing.
+|___________________________________________________________________*/
+
+static bool Stress (unsigned num_entries)
+{
+  unsigned expected = 0, received = 0, flushed = 0, pops = 0, flush_type = FLUSH_TYPE;
+  bool ok = true;
+  Entry entry, check;
+  SpscRing *ring;
+
+  ring = Spsc_Ring_Create (STRESS_RING_SIZE, sizeof(Entry));
+  if (ring == 0)
+    return (false);
+
+  std::thread producer ([&] {
+    Entry e;
+    for (unsigned seq=0; seq<num_entries; seq++) {
+      Make_Entry (&e, seq);
+      while (! Spsc_Ring_Push (ring, &e))
+        std::this_thread::yield ();
+    }
+  });
+
+  while (ok && (expected < num_entries)) {
+    if (! Spsc_Ring_Pop (ring, &entry)) {
+      std::this_thread::yield ();
+      continue;
+    }
+    Make_Entry (&check, entry.seq);
+    if (memcmp (&entry, &check, sizeof(Entry)) != 0) {
+      printf ("stress: entry %u damaged\n", entry.seq);
+      ok = false;
+    }
+    // Anything skipped must have been flushed
+    for (; ok && (expected < entry.seq); expected++)
+      if (expected % NUM_TYPES != FLUSH_TYPE) {
+        printf ("stress: entry %u lost (got %u)\n", expected, entry.seq);
+        ok = false;
+      }
+    if (entry.seq < expected) {
+      printf ("stress: entry %u out of order (expected %u)\n", entry.seq, expected);
+      ok = false;
+    }
+    expected = entry.seq + 1;
+    received++;
+    if (++pops % FLUSH_EVERY == 0)
+      flushed += Spsc_Ring_Remove_Selected (ring, &flush_type, Is_Flush_Type);
+  }
+
+  producer.join ();
+  Spsc_Ring_Free (ring);
+
+  if (ok && (received + flushed != num_entries)) {
+    printf ("stress: %u received + %u flushed != %u pushed\n", received, flushed, num_entries);
+    ok = false;
+  }
+  printf ("stress: %s, %u entries through a %d entry ring (%u flushed)\n", ok ? "passed" : "FAILED", num_entries, STRESS_RING_SIZE, flushed);
+
+  return (ok);
+}
+
+/*____________________________________________________________________
+|
+| Function: Run_Ring
+|
+| Input: Called from main()
+| Output: Returns milliseconds to pass the entries through the ring.
+|___________________________________________________________________*/
+
+static double Run_Ring (unsigned num_entries)
+{
+  unsigned n = 0;
+  double ms;
+  Entry entry;
+  SpscRing *ring;
+  std::chrono::high_resolution_clock::time_point start;
+
+  ring = Spsc_Ring_Create (RING_SIZE, sizeof(Entry));
+  start = std::chrono::high_resolution_clock::now ();
+
+  std::thread producer ([&] {
+    Entry e;
+    for (unsigned seq=0; seq<num_entries; seq++) {
+      Make_Entry (&e, seq);
+      while (! Spsc_Ring_Push (ring, &e))
+        std::this_thread::yield ();
+    }
+  });
+  while (n < num_entries)
+    if (Spsc_Ring_Pop (ring, &entry))
+      n++;
+    else
+      std::this_thread::yield ();
+  producer.join ();
+
+  ms = Time_Ms (start);
+  Spsc_Ring_Free (ring);
+
+  return (ms);
+}
+
+/*____________________________________________________________________
+|
+| Function: Run_Locked
+|
+| Input: Called from main()
+| Output: Returns milliseconds to pass the entries through the locked
+|   queue.
+|___________________________________________________________________*/
+
+static double Run_Locked (unsigned num_entries)
+{
+  unsigned n = 0;
+  bool added, removed;
+  Entry entry;
+  LockedQueue *queue = new LockedQueue;
+  std::chrono::high_resolution_clock::time_point start;
+
+  queue->head = queue->tail = 0;
+  start = std::chrono::high_resolution_clock::now ();
+
+  std::thread producer ([&] {
+    Entry e;
+    bool full;
+    for (unsigned seq=0; seq<num_entries; seq++) {
+      Make_Entry (&e, seq);
+      do {
+        queue->mutex.lock ();
+        full = (queue->head - queue->tail == RING_SIZE);
+        if (! full)
+          queue->entries[queue->head++ % RING_SIZE] = e;
+        queue->mutex.unlock ();
+        if (full)
+          std::this_thread::yield ();
+      } while (full);
+    }
+  });
+  while (n < num_entries) {
+    queue->mutex.lock ();
+    removed = (queue->tail != queue->head);
+    if (removed)
+      entry = queue->entries[queue->tail++ % RING_SIZE];
+    queue->mutex.unlock ();
+    if (removed)
+      n++;
+    else
+      std::this_thread::yield ();
+  }
+  producer.join ();
+
+  added = (queue->head == num_entries);
+  delete queue;
+
+  return (added ? Time_Ms (start) : 0);
+}
+
+/*____________________________________________________________________
+|
+| Function: Is_Flush_Type
+|
+| Input: Called from Spsc_Ring_Remove_Selected()
+| Output: Returns true if the entry is of the type being flushed.
+|___________________________________________________________________*/
+
+static int Is_Flush_Type (void *entry, void *data)
+{
+  return (((Entry *)entry)->type == *(unsigned *)data);
+}
+
+/*____________________________________________________________________
+|
+| Function: Make_Entry
+|
+| Input: Called from Stress(), Run_Ring(), Run_Locked()
+| Output: Fills in the entry with this sequence number.
+|___________________________________________________________________*/
+
+static void Make_Entry (Entry *entry, unsigned seq)
+{
+  entry->type  = seq % NUM_TYPES;
+  entry->seq   = seq;
+  entry->x     = (int)(seq * 7);
+  entry->y     = -(int)seq;
+  entry->check = (seq * 2654435761u) ^ 0x5bd1e995;
+}
+
+/*____________________________________________________________________
+|
+| Function: Time_Ms
+|
+| Input: Called from Run_Ring(), Run_Locked()
+| Output: Returns milliseconds elapsed since start.
+|___________________________________________________________________*/
+
+static double Time_Ms (std::chrono::high_resolution_clock::time_point start)
+{
+  return (std::chrono::duration<double, std::milli> (std::chrono::high_resolution_clock::now () - start).count ());
+}
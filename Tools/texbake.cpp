@@ -0,0 +1,322 @@
+/*____________________________________________________________________
+|
+| File: texbake.cpp
+|
+| Description: Command line tool that bakes BMP textures into block
+|   compressed, mipmapped texture files (.dds).  For each color BMP, an
+|   alpha BMP with the same name plus _fa is merged in if it exists.
+|   Textures with alpha are stored as BC3, the rest as BC1.  Reports
+|   file sizes, video memory, compression error and load times.
+|
+|   Usage: texbake [-a alpha.bmp] file.bmp ...
+|     -a  alpha file for the next color file, when not named file_fa.bmp
+|
+|   Build: g++ -O2 -I../Application -o texbake texbake.cpp
+|            ../Application/texture_file.cpp
+|
+| Functions: main
+|             Bake
+|             Decode_Level
+|             File_Size
+|             Time_Ms
+|
+| (C) Copyright 2013 Abonvita Software LLC.
+| Licensed under the GX Toolkit License, Version 1.0.
+|___________________________________________________________________*/
+
+/*___________________
+|
+| Include Files
+|__________________*/
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "texture_file.h"
+
+/*___________________
+|
+| Function Prototypes
+|__________________*/
+
+static bool     Bake (const char *filename, const char *alpha_filename);
+static void     Decode_Level (TextureFile *texture, int level, std::vector<unsigned char> *pixels);
+static unsigned File_Size (const char *filename);
+static double   Time_Ms (std::chrono::high_resolution_clock::time_point start);
+
+/*___________________
+|
+| Constants
+|__________________*/
+
+#define NUM_LOAD_TRIALS 20
+
+/*___________________
+|
+| Global variables
+|__________________*/
+
+static unsigned total_bmp_bytes, total_baked_bytes, total_vram_before, total_vram_after;
+static double   total_bmp_ms, total_baked_ms;
+
+/*____________________________________________________________________
+|
+| Function: main
+|
+| Input: Called from the command line
+| Output: Bakes each color BMP on the command line.
+|___________________________________________________________________*/
+
+int main (int argc, char **argv)
+{
+  int i, errors = 0;
+  size_t n;
+  const char *alpha_filename = 0;
+
+  if (argc < 2) {
+    fprintf (stderr, "usage: texbake [-a alpha.bmp] file.bmp ...\n");
+    return (1);
+  }
+  for (i=1; i<argc; i++) {
+    if ((strcmp (argv[i], "-a") == 0) && (i+1 < argc)) {
+      alpha_filename = argv[++i];
+      continue;
+    }
+    // Alpha files are merged with their color file
+    n = strlen (argv[i]);
+    if ((n > 7) && (strcmp (argv[i] + n - 7, "_fa.bmp") == 0) && (alpha_filename == 0))
+      continue;
+    if (! Bake (argv[i], alpha_filename))
+      errors++;
+    alpha_filename = 0;
+  }
+
+  printf ("total: bmp %u bytes -> baked %u bytes, vram %u -> %u bytes, load %.2f ms -> %.2f ms\n",
+          total_bmp_bytes, total_baked_bytes, total_vram_before, total_vram_after, total_bmp_ms, total_baked_ms);
+
+  return (errors ? 1 : 0);
+}
+
+/*____________________________________________________________________
+|
+| Function: Bake
+|
+| Input: Called from main()
+| Output: Bakes one texture.  If alpha_filename is 0, uses file_fa.bmp
+|   if it exists.  Returns true on success.
+|___________________________________________________________________*/
+
+static bool Bake (const char *filename, const char *alpha_filename)
+{
+  std::string base, alpha, out;
+  TextureImage image;
+  TextureFile texture;
+  std::vector<unsigned char> decoded;
+  std::chrono::high_resolution_clock::time_point start;
+  double bake_ms, bmp_ms, baked_ms, error_rgb, error_a, d;
+  unsigned bmp_bytes, baked_bytes, vram_before, vram_after, w, h;
+  int i, level, format;
+
+  base = filename;
+  if ((base.size () > 4) && ((base.compare (base.size () - 4, 4, ".bmp") == 0) || (base.compare (base.size () - 4, 4, ".BMP") == 0)))
+    base.erase (base.size () - 4);
+  alpha = base + "_fa.bmp";
+  out   = base + TEXTURE_FILE_EXTENSION;
+  if ((alpha_filename == 0) && File_Size (alpha.c_str ()))
+    alpha_filename = alpha.c_str ();
+
+/*____________________________________________________________________
+|
+| Bake
+|___________________________________________________________________*/
+
+  start = std::chrono::high_resolution_clock::now ();
+  if (! TextureImage_Read_BMP (filename, alpha_filename, &image)) {
+    fprintf (stderr, "%s: can't read BMP file(s)\n", filename);
+    return (false);
+  }
+  format = TextureImage_Has_Alpha (&image) ? TEXTURE_FORMAT_BC3 : TEXTURE_FORMAT_BC1;
+  if (! TextureFile_Bake (out.c_str (), &image, format)) {
+    fprintf (stderr, "%s: can't write file\n", out.c_str ());
+    TextureImage_Free (&image);
+    return (false);
+  }
+  bake_ms = Time_Ms (start);
+
+/*____________________________________________________________________
+|
+| Time loading the BMP pair (read + merge) against the baked file
+|___________________________________________________________________*/
+
+  start = std::chrono::high_resolution_clock::now ();
+  for (i=0; i<NUM_LOAD_TRIALS; i++) {
+    TextureImage tmp;
+    TextureImage_Read_BMP (filename, alpha_filename, &tmp);
+    TextureImage_Free (&tmp);
+  }
+  bmp_ms = Time_Ms (start) / NUM_LOAD_TRIALS;
+
+  start = std::chrono::high_resolution_clock::now ();
+  for (i=0; i<NUM_LOAD_TRIALS; i++) {
+    TextureFile_Load (out.c_str (), &texture);
+    TextureFile_Free (&texture);
+  }
+  baked_ms = Time_Ms (start) / NUM_LOAD_TRIALS;
+
+  if (! TextureFile_Load (out.c_str (), &texture)) {
+    fprintf (stderr, "%s: can't load file just written\n", out.c_str ());
+    TextureImage_Free (&image);
+    return (false);
+  }
+
+/*____________________________________________________________________
+|
+| Sizes and error
+|___________________________________________________________________*/
+
+  bmp_bytes   = File_Size (filename) + (alpha_filename ? File_Size (alpha_filename) : 0);
+  baked_bytes = texture.size;
+  // Uncompressed textures are 32 bits per texel, plus 1/3 for mipmaps
+  vram_before = (unsigned) image.width * image.height * 4 * 4 / 3;
+  vram_after  = 0;
+  for (level=0, w=image.width, h=image.height; level<texture.num_levels; level++, w=(w>1)?w/2:1, h=(h>1)?h/2:1)
+    vram_after += TextureFile_Level_Size (format, w, h);
+
+  Decode_Level (&texture, 0, &decoded);
+  error_rgb = error_a = 0;
+  for (i=0; i<image.width*image.height; i++) {
+    d = decoded[i*4]   - image.pixels[i*4];   error_rgb += d * d;
+    d = decoded[i*4+1] - image.pixels[i*4+1]; error_rgb += d * d;
+    d = decoded[i*4+2] - image.pixels[i*4+2]; error_rgb += d * d;
+    d = decoded[i*4+3] - image.pixels[i*4+3]; error_a   += d * d;
+  }
+  error_rgb = sqrt (error_rgb / (image.width * image.height * 3));
+  error_a   = sqrt (error_a / (image.width * image.height));
+
+  printf ("%s: %dx%d %s, %d levels, bmp %u -> %u bytes, vram %u -> %u bytes, rmse rgb %.2f a %.2f\n",
+          out.c_str (), image.width, image.height, (format == TEXTURE_FORMAT_BC1) ? "BC1" : "BC3",
+          texture.num_levels, bmp_bytes, baked_bytes, vram_before, vram_after, error_rgb, error_a);
+  printf ("  bake %.1f ms, load bmp %.3f ms, load baked %.3f ms\n", bake_ms, bmp_ms, baked_ms);
+
+  total_bmp_bytes   += bmp_bytes;
+  total_baked_bytes += baked_bytes;
+  total_vram_before += vram_before;
+  total_vram_after  += vram_after;
+  total_bmp_ms      += bmp_ms;
+  total_baked_ms    += baked_ms;
+
+  TextureFile_Free (&texture);
+  TextureImage_Free (&image);
+
+  return (true);
+}
+
+/*____________________________________________________________________
+|
+| Function: Decode_Level
+|
+| Input: Called from Bake()
+| Output: Decompresses one level to rgba pixels, to measure error.
+|___________________________________________________________________*/
+
+static void Decode_Level (TextureFile *texture, int level, std::vector<unsigned char> *pixels)
+{
+  int w, h, bx, by, x, y, i, c, blocks_x, color[4][4], alpha[8];
+  unsigned c0, c1, indices;
+  unsigned long long alpha_indices;
+  const unsigned char *block;
+
+  w = texture->width >> level;
+  h = texture->height >> level;
+  if (w < 1) w = 1;
+  if (h < 1) h = 1;
+  pixels->assign (w * h * 4, 255);
+  blocks_x = (w + 3) / 4;
+
+  for (by=0; by<(h+3)/4; by++)
+    for (bx=0; bx<blocks_x; bx++) {
+      block = texture->level_data[level] + (by * blocks_x + bx) * ((texture->format == TEXTURE_FORMAT_BC1) ? 8 : 16);
+      alpha_indices = 0;
+      for (i=0; i<8; i++)
+        alpha[i] = 255;
+      if (texture->format == TEXTURE_FORMAT_BC3) {
+        alpha[0] = block[0];
+        alpha[1] = block[1];
+        for (i=1; i<7; i++)
+          alpha[i+1] = (alpha[0] > alpha[1]) ? ((7 - i) * alpha[0] + i * alpha[1]) / 7 : alpha[0];
+        for (i=0; i<6; i++)
+          alpha_indices |= (unsigned long long) block[2+i] << (i * 8);
+        block += 8;
+      }
+      c0 = block[0] | (block[1] << 8);
+      c1 = block[2] | (block[3] << 8);
+      indices = block[4] | (block[5] << 8) | (block[6] << 16) | ((unsigned) block[7] << 24);
+      for (i=0; i<2; i++) {
+        unsigned v = i ? c1 : c0;
+        int r = (v >> 11) & 31, g = (v >> 5) & 63, b = v & 31;
+        color[i][0] = (r << 3) | (r >> 2);
+        color[i][1] = (g << 2) | (g >> 4);
+        color[i][2] = (b << 3) | (b >> 2);
+      }
+      for (c=0; c<3; c++) {
+        if (c0 > c1) {
+          color[2][c] = (2 * color[0][c] + color[1][c]) / 3;
+          color[3][c] = (color[0][c] + 2 * color[1][c]) / 3;
+        }
+        else {
+          color[2][c] = (color[0][c] + color[1][c]) / 2;
+          color[3][c] = 0;
+        }
+      }
+      for (y=0; y<4; y++)
+        for (x=0; x<4; x++) {
+          if ((bx*4 + x >= w) || (by*4 + y >= h))
+            continue;
+          i = y * 4 + x;
+          unsigned char *p = &(*pixels)[((by*4 + y) * w + bx*4 + x) * 4];
+          for (c=0; c<3; c++)
+            p[c] = (unsigned char) color[(indices >> (i * 2)) & 3][c];
+          p[3] = (unsigned char) alpha[(alpha_indices >> (i * 3)) & 7];
+        }
+    }
+}
+
+/*____________________________________________________________________
+|
+| Function: File_Size
+|
+| Input: Called from Bake()
+| Output: Returns size of a file, or 0 if it doesn't exist.
+|___________________________________________________________________*/
+
+static unsigned File_Size (const char *filename)
+{
+  FILE *fp;
+  unsigned size = 0;
+
+  fp = fopen (filename, "rb");
+  if (fp) {
+    fseek (fp, 0, SEEK_END);
+    size = (unsigned) ftell (fp);
+    fclose (fp);
+  }
+
+  return (size);
+}
+
+/*____________________________________________________________________
+|
+| Function: Time_Ms
+|
+| Input: Called from Bake()
+| Output: Returns milliseconds elapsed since start.
+|___________________________________________________________________*/
+
+static double Time_Ms (std::chrono::high_resolution_clock::time_point start)
+{
+  return (std::chrono::duration<double, std::milli> (std::chrono::high_resolution_clock::now () - start).count ());
+}